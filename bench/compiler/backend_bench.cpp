@@ -0,0 +1,75 @@
+#include <string>
+
+#include <test/catch.hpp>
+
+#include <compiler/compiler.hpp>
+#include <compiler/evaluate.hpp>
+#include <compiler/interpreter.hpp>
+#include <compiler/parser.hpp>
+#include <compiler/registercode.hpp>
+#include <compiler/registerinterpreter.hpp>
+
+namespace salmon::compiler {
+
+	//! spec/examples/fib.sal, written with the builtins there are so far
+	static constexpr const char *fib = R"(
+(defn fib [a]
+  (if (less a 2)
+    a
+    (add (fib (subtract a 2)) (fib (subtract a 1)))))
+)";
+
+	//! Add 3 to acc n times, with a tail call per step
+	static constexpr const char *int_loop = R"(
+(defn int-loop [n acc]
+  (if (greater n 0)
+    (int-loop (subtract n 1) (add acc 3))
+    acc))
+)";
+
+	static constexpr const char *float_loop = R"(
+(defn float-loop [n acc]
+  (if (greater n 0)
+    (float-loop (subtract n 1) (add (multiply acc 0.5) 1.0))
+    acc))
+)";
+
+	static vm::Box read_form(const std::string &text, Compiler &compiler) {
+		std::optional<vm::Box> form = read_from_string(text, compiler);
+		REQUIRE(form.has_value());
+		return *form;
+	}
+
+	static void define_functions(Compiler &compiler) {
+		for(const char *text : { fib, int_loop, float_loop }) {
+			evaluate(read_form(text, compiler), compiler);
+		}
+	}
+
+	TEST_CASE("Comparing the stack and register backends", "[benchmark][compiler][bytecode]") {
+		Config stack_config;
+		stack_config.backend = Backend::STACK;
+		// Compare the interpreters alone; jit_bench covers machine code
+		stack_config.jit_threshold = 0;
+		Compiler stack_compiler(stack_config);
+		define_functions(stack_compiler);
+
+		Config register_config;
+		register_config.backend = Backend::REGISTER;
+		Compiler register_compiler(register_config);
+		define_functions(register_compiler);
+
+		for(const char *call : { "(fib 20)", "(int-loop 100000 0)", "(float-loop 100000 0.0)" }) {
+			const Chunk stack_chunk = compile(read_form(call, stack_compiler), stack_compiler);
+			const RegisterChunk register_chunk = compile_registers(read_form(call, register_compiler), register_compiler);
+
+			BENCHMARK(std::string("Stack machine: ") + call) {
+				return run(stack_chunk, stack_compiler.vm).bare().type;
+			};
+
+			BENCHMARK(std::string("Register machine: ") + call) {
+				return run(register_chunk, register_compiler.vm).bare().type;
+			};
+		}
+	}
+}
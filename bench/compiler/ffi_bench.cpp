@@ -0,0 +1,76 @@
+#include <cmath>
+#include <memory>
+#include <string>
+
+#include <test/catch.hpp>
+
+#include <compiler/compiler.hpp>
+#include <compiler/evaluate.hpp>
+#include <compiler/interpreter.hpp>
+#include <compiler/parser.hpp>
+#include <vm/builtinfunction.hpp>
+#include <vm/foreignfunction.hpp>
+
+namespace salmon::compiler {
+
+	static vm::Box read_form(const std::string &text, Compiler &compiler) {
+		std::optional<vm::Box> form = read_from_string(text, compiler);
+		REQUIRE(form.has_value());
+		return *form;
+	}
+
+	static vm::Box builtin_fabs(vm::VirtualMachine *vm, vm::InternalBox x) {
+		return vm->make_boxed(std::fabs(std::get<double>(x.elem)));
+	}
+
+	TEST_CASE("Calling a C function and a builtin function", "[benchmark][compiler][ffi]") {
+		Config config;
+		config.jit_threshold = 0;
+		Compiler compiler(config);
+		vm::VirtualMachine &vm = compiler.vm;
+		const vm::vm_ptr<vm::Type> float64 = vm.get_builtin_type<double>();
+
+		const auto libm = std::make_shared<vm::SharedLibrary>("libm.so.6");
+		const vm::vm_ptr<vm::ForeignFunction> foreign = vm::import_function(vm, libm, "fabs", { float64.get() },
+																			float64.get());
+		vm::SpecBuilder arg_spec;
+		arg_spec.add_type(float64);
+		vm::SpecBuilder ret_spec;
+		ret_spec.add_type(float64);
+		const vm::vm_ptr<vm::VmFunction> builtin(vm.mem_manager.allocate_obj<vm::BuiltinFunction<vm::InternalBox>>(
+			&builtin_fabs, vm.type_table.get_fn_type(arg_spec.build(), ret_spec.build()),
+			std::vector<vm::vm_ptr<vm::Symbol>>{ vm.base_package().intern_symbol("x") }));
+
+		std::vector<vm::InternalBox> args = { vm.make_boxed(-1.5).bare() };
+		BENCHMARK("1000 calls to a foreign function") {
+			double total = 0;
+			for(int i = 0; i < 1000; i++) {
+				total += std::get<double>((*foreign)(&vm, args).value());
+			}
+			return total;
+		};
+		BENCHMARK("1000 calls to a builtin function") {
+			double total = 0;
+			for(int i = 0; i < 1000; i++) {
+				total += std::get<double>((*builtin)(&vm, args).value());
+			}
+			return total;
+		};
+
+		// The same loop around each function, so only the calls differ
+		vm.fn_table.add_function(compiler.current_package()->intern_symbol("builtin-fabs"), builtin);
+		evaluate(read_form("(defextern fabs \"libm.so.6\" [float-64] float-64)", compiler), compiler);
+		evaluate(read_form("(defn foreign-loop [n x acc] (if (greater n 0) (foreign-loop (subtract n 1) x (add acc (fabs x))) acc))",
+						   compiler), compiler);
+		evaluate(read_form("(defn builtin-loop [n x acc] (if (greater n 0) (builtin-loop (subtract n 1) x (add acc (builtin-fabs x))) acc))",
+						   compiler), compiler);
+		const Chunk foreign_chunk = compile(read_form("(foreign-loop 1000 -1.5 0.0)", compiler), compiler);
+		const Chunk builtin_chunk = compile(read_form("(builtin-loop 1000 -1.5 0.0)", compiler), compiler);
+		BENCHMARK("Interpreter: 1000 calls to a foreign function") {
+			return run(foreign_chunk, vm).bare().type;
+		};
+		BENCHMARK("Interpreter: 1000 calls to a builtin function") {
+			return run(builtin_chunk, vm).bare().type;
+		};
+	}
+}
@@ -0,0 +1,77 @@
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <test/catch.hpp>
+
+#include <compiler/compiler.hpp>
+#include <compiler/formcache.hpp>
+#include <compiler/parser.hpp>
+
+namespace salmon::compiler {
+
+	static constexpr int num_files = 100;
+	static constexpr int forms_per_file = 500;
+
+	static std::vector<std::filesystem::path> make_project(const std::filesystem::path &dir) {
+		std::vector<std::filesystem::path> files;
+		for(int file = 0; file < num_files; file++) {
+			const std::filesystem::path path = dir / ("file-" + std::to_string(file) + ".sal");
+			std::ofstream out(path);
+			for(int form = 0; form < forms_per_file; form++) {
+				out << "(defn function-" << file << "-" << form << " (a b)\n"
+					<< "  \"Documentation for the function\"\n"
+					<< "  (add a (multiply b " << form << ".5))\n"
+					<< "  [1 2 3 :keyword '(quoted list)] {set of " << form << "})\n";
+			}
+			files.push_back(path);
+		}
+		return files;
+	}
+
+	static size_t read_project(const std::vector<std::filesystem::path> &files,
+							   const std::filesystem::path &cache_dir) {
+		Config config{0, cache_dir, cache_dir, cache_dir};
+		Compiler compiler(config);
+		FormCache cache(cache_dir);
+		size_t forms = 0;
+		for(const auto &file : files) {
+			forms += cache.read_file(file, compiler)->forms.size();
+		}
+		return forms;
+	}
+
+	TEST_CASE("Starting up on a large project", "[benchmark][compiler][cache]") {
+		const std::filesystem::path dir = std::filesystem::temp_directory_path() / "salmon-formcache-bench";
+		std::filesystem::remove_all(dir);
+		std::filesystem::create_directories(dir / "src");
+		const std::vector<std::filesystem::path> files = make_project(dir / "src");
+
+		BENCHMARK("Read 50k forms without a cache") {
+			Config config{0, dir, dir, dir};
+			Compiler compiler(config);
+			size_t forms = 0;
+			for(const auto &file : files) {
+				std::ifstream input(file);
+				CountingStreamBuffer countStreamBuf(input);
+				while(read(countStreamBuf, compiler)) {
+					forms++;
+				}
+			}
+			return forms;
+		};
+
+		BENCHMARK("Read 50k forms, cold cache") {
+			std::filesystem::remove_all(dir / "cold");
+			return read_project(files, dir / "cold");
+		};
+
+		read_project(files, dir / "warm");
+		BENCHMARK("Read 50k forms, warm cache") {
+			return read_project(files, dir / "warm");
+		};
+
+		std::filesystem::remove_all(dir);
+	}
+}
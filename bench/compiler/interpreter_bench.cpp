@@ -0,0 +1,87 @@
+#include <test/catch.hpp>
+
+#include <compiler/bytecode.hpp>
+#include <compiler/compiler.hpp>
+#include <compiler/interpreter.hpp>
+#include <compiler/parser.hpp>
+
+namespace salmon::compiler {
+
+	static constexpr int runs = 100'000;
+
+	TEST_CASE("Running devirtualized bytecode", "[benchmark][compiler][bytecode]") {
+		Config config;
+		Compiler compiler(config);
+		const std::optional<vm::Box> form = read_from_string(
+			"(add (multiply (subtract 10 3) (add 1 2)) (divide 100 (add 3 2)))", compiler);
+		REQUIRE(form.has_value());
+
+		const Chunk dynamic = compile(*form, compiler);
+		Chunk devirtualized = compile(*form, compiler);
+		devirtualize(devirtualized, infer_types(*form, compiler), compiler);
+
+		BENCHMARK("Run 100K chunks with dynamic calls") {
+			int64_t sum = 0;
+			for(int i = 0; i < runs; i++) {
+				sum += std::get<int32_t>(run(dynamic, compiler.vm).value());
+			}
+			return sum;
+		};
+
+		BENCHMARK("Run 100K chunks with devirtualized calls") {
+			int64_t sum = 0;
+			for(int i = 0; i < runs; i++) {
+				sum += std::get<int32_t>(run(devirtualized, compiler.vm).value());
+			}
+			return sum;
+		};
+
+		// Only the implementations of sealed interfaces are folded
+		Config sealed_config;
+		sealed_config.seal_builtins = true;
+		Compiler sealed(sealed_config);
+		const std::optional<vm::Box> sealed_form = read_from_string(
+			"(add (multiply (subtract 10 3) (add 1 2)) (divide 100 (add 3 2)))", sealed);
+		REQUIRE(sealed_form.has_value());
+		const Chunk folded = compile(*sealed_form, sealed);
+
+		BENCHMARK("Run 100K chunks with folded constants") {
+			int64_t sum = 0;
+			for(int i = 0; i < runs; i++) {
+				sum += std::get<int32_t>(run(folded, sealed.vm).value());
+			}
+			return sum;
+		};
+
+		BENCHMARK("Compile the form with constant folding") {
+			return compile(*sealed_form, sealed).constants.size();
+		};
+	}
+
+	TEST_CASE("Running bytecode functions", "[benchmark][compiler][bytecode]") {
+		Config config;
+		Compiler compiler(config);
+		for(const char *text : {
+				"(defn fib [n] (if (less n 2) n (add (fib (subtract n 1)) (fib (subtract n 2)))))",
+				"(defn count-down [n] (if (greater n 0) (count-down (subtract n 1)) n))",
+			}) {
+			const std::optional<vm::Box> defn = read_from_string(text, compiler);
+			REQUIRE(defn.has_value());
+			run(compile(*defn, compiler), compiler.vm);
+		}
+		const std::optional<vm::Box> fib = read_from_string("(fib 20)", compiler);
+		const std::optional<vm::Box> count_down = read_from_string("(count-down 100000)", compiler);
+		REQUIRE(fib.has_value());
+		REQUIRE(count_down.has_value());
+		const Chunk fib_chunk = compile(*fib, compiler);
+		const Chunk count_down_chunk = compile(*count_down, compiler);
+
+		BENCHMARK("Run (fib 20)") {
+			return std::get<int32_t>(run(fib_chunk, compiler.vm).value());
+		};
+
+		BENCHMARK("Run a loop of 100K tail calls") {
+			return std::get<int32_t>(run(count_down_chunk, compiler.vm).value());
+		};
+	}
+}
@@ -0,0 +1,70 @@
+#include <string>
+
+#include <test/catch.hpp>
+
+#include <compiler/compiler.hpp>
+#include <compiler/evaluate.hpp>
+#include <compiler/interpreter.hpp>
+#include <compiler/parser.hpp>
+
+namespace salmon::compiler {
+
+	static constexpr const char *fib = R"(
+(defn fib [a]
+  (if (less a 2)
+    a
+    (add (fib (subtract a 2)) (fib (subtract a 1)))))
+)";
+
+	//! Add 3 to acc n times, with a tail call per step
+	static constexpr const char *int_loop = R"(
+(defn int-loop [n acc]
+  (if (greater n 0)
+    (int-loop (subtract n 1) (add acc 3))
+    acc))
+)";
+
+	static constexpr const char *float_loop = R"(
+(defn float-loop [n acc]
+  (if (greater n 0)
+    (float-loop (subtract n 1) (add (multiply acc 0.5) 1.0))
+    acc))
+)";
+
+	static vm::Box read_form(const std::string &text, Compiler &compiler) {
+		std::optional<vm::Box> form = read_from_string(text, compiler);
+		REQUIRE(form.has_value());
+		return *form;
+	}
+
+	static void define_functions(Compiler &compiler) {
+		for(const char *text : { fib, int_loop, float_loop }) {
+			evaluate(read_form(text, compiler), compiler);
+		}
+	}
+
+	TEST_CASE("Interpreting and running machine code for hot functions", "[benchmark][compiler][jit]") {
+		Config interpreted_config;
+		interpreted_config.jit_threshold = 0;
+		Compiler interpreted(interpreted_config);
+		define_functions(interpreted);
+
+		Config jit_config;
+		jit_config.jit_threshold = 1;
+		Compiler jit(jit_config);
+		define_functions(jit);
+
+		for(const char *call : { "(fib 20)", "(int-loop 100000 0)", "(float-loop 100000 0.0)" }) {
+			const Chunk interpreted_chunk = compile(read_form(call, interpreted), interpreted);
+			const Chunk jit_chunk = compile(read_form(call, jit), jit);
+
+			BENCHMARK(std::string("Interpreter: ") + call) {
+				return run(interpreted_chunk, interpreted.vm).bare().type;
+			};
+
+			BENCHMARK(std::string("Machine code: ") + call) {
+				return run(jit_chunk, jit.vm).bare().type;
+			};
+		}
+	}
+}
@@ -0,0 +1,74 @@
+#include <sstream>
+#include <string>
+
+#include <test/catch.hpp>
+
+#include <compiler/compiler.hpp>
+#include <compiler/incrementalreader.hpp>
+#include <compiler/parser.hpp>
+
+namespace salmon::compiler {
+
+	static constexpr int rows = 10000;
+	static constexpr int columns = 100;
+
+	//! A data file made of vectors of integers and floats
+	static std::string make_numbers() {
+		std::ostringstream out;
+		for(int row = 0; row < rows; row++) {
+			out << '[';
+			for(int column = 0; column < columns; column++) {
+				if(column % 4 == 0) {
+					out << row * columns + column << '.' << column << ' ';
+				} else if(column % 4 == 1) {
+					out << "#x" << std::hex << row * column << std::dec << ' ';
+				} else {
+					out << row * 7919 + column * 104729 << ' ';
+				}
+			}
+			out << "]\n";
+		}
+		return out.str();
+	}
+
+	TEST_CASE("Reading numbers", "[benchmark][compiler][reader]") {
+		Config config;
+		Compiler compiler(config);
+		const std::string numbers = make_numbers();
+
+		BENCHMARK("Read 1M numbers") {
+			std::istringstream input(numbers);
+			CountingStreamBuffer countStreamBuf(input);
+			size_t forms = 0;
+			while(read(countStreamBuf, compiler)) {
+				forms++;
+			}
+			return forms;
+		};
+	}
+
+	TEST_CASE("Re-reading an edited buffer", "[benchmark][compiler][reader]") {
+		Config config;
+		Compiler compiler(config);
+		std::ostringstream out;
+		for(int form = 0; form < rows; form++) {
+			out << "(defn function-" << form << " (a b)\n  (add a (multiply b " << form << ")))\n";
+		}
+		const std::string source = out.str();
+		const size_t middle = source.find("function-5000");
+		IncrementalReader reader(compiler);
+		reader.reset(source);
+
+		BENCHMARK("Read the whole buffer after an edit") {
+			std::istringstream input(source);
+			CountingStreamBuffer countStreamBuf(input);
+			return read_all(countStreamBuf, compiler).forms.size();
+		};
+
+		BENCHMARK("Read only the edited form") {
+			reader.edit(middle, 1, "F");
+			reader.edit(middle, 1, "f");
+			return reader.forms().size();
+		};
+	}
+}
@@ -0,0 +1,73 @@
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <test/catch.hpp>
+
+#include <compiler/compiler.hpp>
+#include <compiler/parser.hpp>
+#include <vm/serialize.hpp>
+
+namespace salmon::compiler {
+
+	static constexpr int num_forms = 10000;
+
+	static std::string make_source() {
+		std::ostringstream out;
+		for(int form = 0; form < num_forms; form++) {
+			out << "(defn function-" << form << " (a b)\n"
+				<< "  \"Documentation for the function\"\n"
+				<< "  (add a (multiply b " << form << ".5))\n"
+				<< "  [1 2 3 :keyword '(quoted list)] {set of " << form << "})\n";
+		}
+		return out.str();
+	}
+
+	static std::vector<vm::Box> read_source(const std::string &source, Compiler &compiler) {
+		std::istringstream input(source);
+		CountingStreamBuffer countStreamBuf(input);
+		std::vector<vm::Box> forms;
+		while(auto form = read(countStreamBuf, compiler)) {
+			forms.push_back(*form);
+		}
+		return forms;
+	}
+
+	TEST_CASE("Round trips through the binary format", "[benchmark][compiler][serialize]") {
+		Config config;
+		Compiler compiler(config);
+		const std::string source = make_source();
+		const std::vector<vm::Box> forms = read_source(source, compiler);
+		const std::vector<std::byte> data = vm::serialize::write_values(forms);
+
+		BENCHMARK("Read 10k forms from text") {
+			return read_source(source, compiler).size();
+		};
+
+		BENCHMARK("Write 10k forms") {
+			return vm::serialize::write_values(forms).size();
+		};
+
+		BENCHMARK("Stream 10k forms") {
+			std::ostringstream out;
+			vm::serialize::Writer writer(out);
+			for(const vm::Box &form : forms) {
+				writer.write(form);
+			}
+			writer.finish();
+			return out.tellp();
+		};
+
+		BENCHMARK("Read 10k forms from the binary format") {
+			return vm::serialize::read_values(data, compiler.vm)->size();
+		};
+
+		BENCHMARK("Open 10k forms as an archive") {
+			return vm::serialize::Archive::open(data)->size();
+		};
+
+		BENCHMARK("Round trip 10k forms") {
+			return vm::serialize::read_values(vm::serialize::write_values(forms), compiler.vm)->size();
+		};
+	}
+}
@@ -0,0 +1,60 @@
+#include <string>
+#include <vector>
+
+#include <test/catch.hpp>
+
+#include <compiler/compiler.hpp>
+#include <compiler/parser.hpp>
+#include <compiler/typeinference.hpp>
+
+namespace salmon::compiler {
+
+	static constexpr int calls = 100'000;
+	static constexpr int depth = 1000;
+
+	//! (add (add ... (add 1 1) ...) 1) nested depth times
+	static std::string make_nested_calls() {
+		std::string text;
+		for(int i = 0; i < depth; i++) {
+			text += "(add ";
+		}
+		text += "1";
+		for(int i = 0; i < depth; i++) {
+			text += " 1)";
+		}
+		return text;
+	}
+
+	TEST_CASE("Calling inferred implementations", "[benchmark][compiler][types]") {
+		Config config;
+		Compiler compiler(config);
+		const std::optional<vm::Box> form = read_from_string(make_nested_calls(), compiler);
+		REQUIRE(form.has_value());
+
+		BENCHMARK("Infer the types of 1000 nested calls") {
+			return infer_types(*form, compiler).call_sites.size();
+		};
+
+		const InferredTypes inferred = infer_types(*form, compiler);
+		REQUIRE(inferred.errors.empty());
+		const CallSite &site = inferred.call_sites[0];
+		REQUIRE(site.target != nullptr);
+		std::vector<vm::InternalBox> args = { compiler.vm.make_boxed(1).bare(), compiler.vm.make_boxed(2).bare() };
+
+		BENCHMARK("Call add 100K times through the interface") {
+			int64_t sum = 0;
+			for(int i = 0; i < calls; i++) {
+				sum += std::get<int32_t>((*site.callee)(&compiler.vm, args).value());
+			}
+			return sum;
+		};
+
+		BENCHMARK("Call add 100K times through the inferred implementation") {
+			int64_t sum = 0;
+			for(int i = 0; i < calls; i++) {
+				sum += std::get<int32_t>((*site.target)(&compiler.vm, args).value());
+			}
+			return sum;
+		};
+	}
+}
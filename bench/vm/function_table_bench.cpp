@@ -0,0 +1,116 @@
+#include <algorithm>
+#include <array>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <test/catch.hpp>
+
+#include <vm/vm.hpp>
+#include <vm/builtinfunction.hpp>
+#include <util/cmpunderlyingtype.hpp>
+
+namespace salmon::vm {
+
+	static constexpr size_t num_functions = 100'000;
+
+	static Box identity(VirtualMachine *vm, InternalBox box) {
+		return Box(box, vm->mem_manager.make_vm_ptr<AllocatedItem>());
+	}
+
+	TEST_CASE("Function lookup by name", "[benchmark][vm][functions]") {
+		Config config;
+		VirtualMachine vm(config, "bench");
+		Package &package = vm.base_package();
+
+		vm_ptr<Symbol> arg = package.intern_symbol("arg");
+		SpecBuilder spec;
+		spec.add_type(vm.get_builtin_type<int32_t>());
+		vm_ptr<Type> fn_type = vm.type_table.get_fn_type(spec.build(), spec.build());
+
+		std::vector<vm_ptr<Symbol>> names;
+		names.reserve(num_functions);
+		std::map<vm_ptr<Symbol>, vm_ptr<VmFunction>, cmpUnderlyingType<Symbol>> by_name;
+		for(size_t i = 0; i < num_functions; i++) {
+			vm_ptr<Symbol> name = package.intern_symbol("function-" + std::to_string(i));
+			vm_ptr<VmFunction> fn(vm.mem_manager.allocate_obj<BuiltinFunction<InternalBox>>(
+									  identity, fn_type, std::vector<vm_ptr<Symbol>>{arg}));
+			REQUIRE(vm.fn_table.add_function(name, fn));
+			by_name.emplace(name, fn);
+			names.push_back(name);
+		}
+		std::shuffle(names.begin(), names.end(), std::mt19937(42));
+
+		BENCHMARK("FunctionTable::get_fn, 100k functions") {
+			size_t found = 0;
+			for(const auto &name : names) {
+				found += vm.fn_table.get_fn(name).has_value();
+			}
+			return found;
+		};
+
+		BENCHMARK("std::map keyed on symbol contents, 100k functions") {
+			size_t found = 0;
+			for(const auto &name : names) {
+				found += by_name.find(name) != by_name.end();
+			}
+			return found;
+		};
+	}
+
+	TEST_CASE("Adding implementations to interfaces", "[benchmark][vm][functions]") {
+		Config config;
+		VirtualMachine vm(config, "bench");
+		Package &package = vm.base_package();
+
+		vm_ptr<Symbol> arg = package.intern_symbol("arg");
+		vm_ptr<Symbol> interface_name = package.intern_symbol("bench-interface");
+		vm_ptr<Symbol> function_name = package.intern_symbol("bench-function");
+		SpecBuilder interface_spec;
+		interface_spec.add_parameter(arg);
+		vm_ptr<Type> interface_type = vm.type_table.get_fn_type(interface_spec.build(),
+																interface_spec.build());
+		vm_ptr<InterfaceFunction> interface = vm.mem_manager.allocate_obj<InterfaceFunction>(
+			interface_type, std::vector<vm_ptr<Symbol>>{arg});
+		REQUIRE(vm.fn_table.new_interface(interface_name, interface));
+
+		const std::array<vm_ptr<Type>, 4> arg_types = {
+			vm.get_builtin_type<int32_t>(), vm.get_builtin_type<int64_t>(),
+			vm.get_builtin_type<double>(), vm.get_builtin_type<float>()
+		};
+		std::vector<vm_ptr<VmFunction>> impls;
+		impls.reserve(num_functions / 10);
+		for(size_t i = 0; i < num_functions / 10; i++) {
+			SpecBuilder spec;
+			spec.add_type(arg_types[i % arg_types.size()]);
+			vm_ptr<Type> fn_type = vm.type_table.get_fn_type(spec.build(), spec.build());
+			impls.push_back(vm_ptr<VmFunction>(vm.mem_manager.allocate_obj<BuiltinFunction<InternalBox>>(
+												   identity, fn_type, std::vector<vm_ptr<Symbol>>{arg})));
+		}
+
+		BENCHMARK("InterfaceFunction::add_impl without the type table, 10k implementations") {
+			size_t added = 0;
+			for(const auto &fn : impls) {
+				added += interface->add_impl(fn);
+			}
+			return added;
+		};
+
+		BENCHMARK("FunctionTable::add_function to an interface, 10k implementations") {
+			size_t added = 0;
+			for(const auto &fn : impls) {
+				added += vm.fn_table.add_function(interface_name, fn);
+			}
+			return added;
+		};
+
+		BENCHMARK("FunctionTable::add_function overwriting a function 10k times") {
+			size_t added = 0;
+			for(const auto &fn : impls) {
+				added += vm.fn_table.add_function(function_name, fn);
+			}
+			return added;
+		};
+	}
+}
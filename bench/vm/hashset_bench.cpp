@@ -0,0 +1,72 @@
+#include <algorithm>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include <test/catch.hpp>
+
+#include <vm/vm.hpp>
+#include <vm/box.hpp>
+#include <util/swisstable.hpp>
+
+namespace salmon::vm {
+
+	static constexpr int32_t num_keys = 1'000'000;
+
+	TEST_CASE("Hash tables keyed on values", "[benchmark][vm][hashset]") {
+		Config config;
+		VirtualMachine vm(config, "bench");
+		Type *int_type = vm.get_builtin_type<int32_t>().get();
+
+		std::vector<InternalBox> keys;
+		keys.reserve(num_keys);
+		for(int32_t i = 0; i < num_keys; i++) {
+			keys.push_back(InternalBox{ int_type, i * 7 });
+		}
+		std::shuffle(keys.begin(), keys.end(), std::mt19937(42));
+		// half of the lookups miss:
+		std::vector<InternalBox> lookups = keys;
+		for(size_t i = 0; i < lookups.size(); i += 2) {
+			lookups[i].elem = std::get<int32_t>(lookups[i].elem) + 1;
+		}
+
+		BENCHMARK("SwissTable insert, 1M values") {
+			SwissTable<InternalBox, InternalBox> table;
+			for(const auto &key : keys) {
+				table.try_emplace(key, key);
+			}
+			return table.size();
+		};
+
+		BENCHMARK("std::unordered_map insert, 1M values") {
+			std::unordered_map<InternalBox, InternalBox> table;
+			for(const auto &key : keys) {
+				table.try_emplace(key, key);
+			}
+			return table.size();
+		};
+
+		SwissTable<InternalBox, InternalBox> swiss;
+		std::unordered_map<InternalBox, InternalBox> standard;
+		for(const auto &key : keys) {
+			swiss.try_emplace(key, key);
+			standard.try_emplace(key, key);
+		}
+
+		BENCHMARK("SwissTable lookup, 1M values") {
+			size_t found = 0;
+			for(const auto &key : lookups) {
+				found += swiss.contains(key);
+			}
+			return found;
+		};
+
+		BENCHMARK("std::unordered_map lookup, 1M values") {
+			size_t found = 0;
+			for(const auto &key : lookups) {
+				found += standard.contains(key);
+			}
+			return found;
+		};
+	}
+}
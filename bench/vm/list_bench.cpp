@@ -0,0 +1,34 @@
+#include <test/catch.hpp>
+
+#include <vm/vm.hpp>
+#include <vm/box.hpp>
+
+namespace salmon::vm {
+
+	static constexpr int32_t list_length = 10'000'000;
+
+	TEST_CASE("Traversing and collecting long lists", "[benchmark][vm][list]") {
+		Config config;
+		VirtualMachine vm(config, "bench");
+
+		vm_ptr<List> head = vm.mem_manager.allocate_obj<List>(vm.make_boxed(0));
+		List *tail = head.get();
+		for(int32_t i = 1; i < list_length; i++) {
+			vm_ptr<List> next = vm.mem_manager.allocate_obj<List>(vm.make_boxed(i));
+			tail->next = next.get();
+			tail = tail->next;
+		}
+
+		BENCHMARK("Walk a 10M element list") {
+			int64_t sum = 0;
+			for(const List *cell = head.get(); cell != nullptr; cell = cell->next) {
+				sum += std::get<int32_t>(cell->itm.elem);
+			}
+			return sum;
+		};
+
+		BENCHMARK("Collect garbage with a live 10M element list") {
+			vm.mem_manager.do_gc();
+		};
+	}
+}
@@ -0,0 +1,47 @@
+#include <array>
+#include <iostream>
+#include <sstream>
+
+#include <test/catch.hpp>
+
+#include <vm/vm.hpp>
+#include <vm/box.hpp>
+
+namespace salmon::vm {
+
+	static constexpr int32_t rows = 1000;
+	static constexpr int32_t columns = 1000;
+
+	TEST_CASE("Printing large values", "[benchmark][vm][print]") {
+		Config config;
+		VirtualMachine vm(config, "bench");
+
+		std::vector<Box> row_boxes;
+		for(int32_t row = 0; row < rows; row++) {
+			vm_ptr<Vector> vector = vm.mem_manager.allocate_obj<Vector>(columns);
+			for(int32_t column = 0; column < columns; column++) {
+				if(column % 2) {
+					vector->push_back(vm.make_boxed(row * column));
+				} else {
+					vector->push_back(vm.make_boxed(row + column / 8.0));
+				}
+			}
+			row_boxes.push_back(vm.make_boxed(vector));
+		}
+		Box table = vm.make_boxed(vm.mem_manager.allocate_list(row_boxes));
+
+		vm_ptr<VmFunction> print_fn = *vm.fn_table.get_fn(vm.base_package().intern_symbol("print"));
+		std::ostringstream out;
+		std::streambuf *stdout_buf = std::cout.rdbuf(out.rdbuf());
+
+		BENCHMARK("Print a 1M element structure") {
+			out.str("");
+			std::array<InternalBox, 1> args = { table.bare() };
+			(*print_fn)(&vm, std::span<InternalBox, 1>(args));
+			vm.printer.flush();
+			return out.tellp();
+		};
+
+		std::cout.rdbuf(stdout_buf);
+	}
+}
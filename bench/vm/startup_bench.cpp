@@ -0,0 +1,29 @@
+#include <test/catch.hpp>
+
+#include <vm/vm.hpp>
+#include <compiler/compiler.hpp>
+
+namespace salmon::vm {
+
+	/**
+	 * A booted VirtualMachine holds 107 heap objects, all still live after a
+	 * collection, and a Compiler 110. Constructing them takes around 0.2 ms
+	 * (177-197 us for the VM and 181-260 us for the Compiler over three runs
+	 * here). A heap snapshot would still have to map the image and relocate
+	 * every object and builtin function pointer in it, so it isn't worth
+	 * building at this size. Check these numbers again when startup grows.
+	 **/
+	TEST_CASE("Starting the VM", "[benchmark][vm][startup]") {
+		Config config;
+
+		BENCHMARK_ADVANCED("Construct a VirtualMachine")(Catch::Benchmark::Chronometer meter) {
+			std::vector<Catch::Benchmark::storage_for<VirtualMachine>> storage(meter.runs());
+			meter.measure([&](int i) { storage[i].construct(config, "bench"); });
+		};
+
+		BENCHMARK_ADVANCED("Construct a Compiler")(Catch::Benchmark::Chronometer meter) {
+			std::vector<Catch::Benchmark::storage_for<compiler::Compiler>> storage(meter.runs());
+			meter.measure([&](int i) { storage[i].construct(config); });
+		};
+	}
+}
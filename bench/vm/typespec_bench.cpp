@@ -0,0 +1,107 @@
+#include <test/catch.hpp>
+
+#include <vm/memory.hpp>
+#include <vm/package.hpp>
+#include <vm/type.hpp>
+
+namespace salmon::vm {
+
+	static constexpr int iterations = 100'000;
+
+	TEST_CASE("Matching and combining type specifications", "[benchmark][vm][type]") {
+		MemoryManager manager;
+		Package base_package("test", manager);
+		vm_ptr<Symbol> f32_name_symb = base_package.intern_symbol("float-32");
+		vm_ptr<Symbol> i32_name_symb = base_package.intern_symbol("int-32");
+		PrimitiveType ptype(f32_name_symb, "documentation", sizeof(float));
+		PrimitiveType p_i32(i32_name_symb, "documentation", sizeof(int));
+		vm_ptr<Type> f32_type = manager.allocate_obj<Type>(ptype);
+		vm_ptr<Type> i32_type = manager.allocate_obj<Type>(p_i32);
+
+		vm_ptr<Symbol> a_symb = base_package.intern_symbol("a");
+		vm_ptr<Symbol> b_symb = base_package.intern_symbol("b");
+
+		// (A float-32 A B)
+		SpecBuilder generic_builder;
+		generic_builder.add_parameter(a_symb);
+		generic_builder.add_type(f32_type);
+		generic_builder.add_parameter(a_symb);
+		generic_builder.add_parameter(b_symb);
+		const TypeSpecification generic = generic_builder.build();
+
+		// (B float-32 B A): the same shape with the names swapped
+		SpecBuilder renamed_builder;
+		renamed_builder.add_parameter(b_symb);
+		renamed_builder.add_type(f32_type);
+		renamed_builder.add_parameter(b_symb);
+		renamed_builder.add_parameter(a_symb);
+		const TypeSpecification renamed = renamed_builder.build();
+
+		SpecBuilder concrete_builder;
+		concrete_builder.add_type(i32_type);
+		concrete_builder.add_type(f32_type);
+		concrete_builder.add_type(i32_type);
+		concrete_builder.add_type(f32_type);
+		const TypeSpecification concrete = concrete_builder.build();
+
+		const std::vector<vm_ptr<Type>> matching = { i32_type, f32_type, i32_type, f32_type };
+		const std::vector<vm_ptr<Type>> mismatched = { i32_type, f32_type, f32_type, f32_type };
+
+		SpecBuilder ret_builder;
+		ret_builder.add_parameter(a_symb);
+		const FunctionType fn_type(ret_builder.build(), generic);
+		const std::vector<vm_ptr<Type>> fn_types = { i32_type, i32_type, f32_type, i32_type, f32_type };
+
+		BENCHMARK("Match 100K type lists") {
+			int count = 0;
+			for(int i = 0; i < iterations; i++) {
+				count += generic.matches(matching);
+				count += generic.matches(mismatched);
+			}
+			return count;
+		};
+
+		BENCHMARK("Match 100K specifications") {
+			int count = 0;
+			for(int i = 0; i < iterations; i++) {
+				count += generic.matches(concrete);
+				count += generic.matches(renamed);
+			}
+			return count;
+		};
+
+		BENCHMARK("Compare 100K specifications for equivalence") {
+			int count = 0;
+			for(int i = 0; i < iterations; i++) {
+				count += generic.equivalentTo(renamed);
+				count += generic.equivalentTo(concrete);
+			}
+			return count;
+		};
+
+		BENCHMARK("Bind the parameters of 100K type lists") {
+			size_t count = 0;
+			for(int i = 0; i < iterations; i++) {
+				auto table = generic.match_symbols(matching);
+				count += table ? table->size() : 0;
+			}
+			return count;
+		};
+
+		BENCHMARK("Combine 100K pairs of specifications") {
+			size_t count = 0;
+			for(int i = 0; i < iterations; i++) {
+				count += TypeSpecification::combine(generic, renamed).size();
+			}
+			return count;
+		};
+
+		BENCHMARK("Match 100K function type lists") {
+			int count = 0;
+			for(int i = 0; i < iterations; i++) {
+				count += fn_type.match(fn_types);
+			}
+			return count;
+		};
+	}
+}
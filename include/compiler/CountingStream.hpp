@@ -2,16 +2,29 @@
 
 #include <streambuf>
 #include <iostream>
+#include <string_view>
 
 #include <compiler/meta.hpp>
 
 namespace salmon::compiler {
 
+	//! Reads the characters of a string from the given offset without copying them
+	class StringViewBuffer : public std::streambuf {
+	public:
+		StringViewBuffer(std::string_view view, size_t offset) {
+			char *data = const_cast<char*>(view.data());
+			setg(data, data + offset, data + view.size());
+		}
+	};
+
 	class CountingStreamBuffer : public std::streambuf {
 	public:
 		// constructor
 		CountingStreamBuffer(std::streambuf* sbuf);
 		explicit CountingStreamBuffer(std::istream& istream);
+		// start counting from a position part way through a file
+		CountingStreamBuffer(std::streambuf* sbuf, const salmon::meta::position_info &start,
+							 std::streamsize file_pos);
 
 		// Get current line number
 		unsigned int        lineNumber() const;
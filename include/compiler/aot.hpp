@@ -0,0 +1,71 @@
+#pragma once
+
+#include <filesystem>
+#include <span>
+#include <string>
+#include <vector>
+
+#include <compiler/compiler.hpp>
+#include <vm/symbol.hpp>
+#include <vm/type.hpp>
+
+namespace salmon::compiler {
+
+	/**
+	 * A function defined with defn, to be compiled ahead of time for one
+	 * choice of types. The types become the function's C prototype, so
+	 * each has to be one of int-32, float-64, bool, const-string or symbol.
+	 **/
+	struct AotFunction {
+		//! The name the function was defined under
+		vm::Symbol *name;
+		std::vector<vm::Type*> arg_types;
+		vm::Type *result_type;
+	};
+
+	/**
+	 * The name a function compiled ahead of time has in C: its name with
+	 * dashes turned into underscores, after a salmon_ prefix.
+	 *
+	 * @throw CompileError if the name has characters C doesn't allow
+	 **/
+	std::string c_name(const vm::Symbol &name);
+
+	/**
+	 * Translate bytecode functions to C source.
+	 *
+	 * The source starts with a prototype for every function, so they can
+	 * call each other in any order. In the bodies, each slot of the value
+	 * stack becomes a local variable with the type of the value in it,
+	 * and jumps become gotos. Values are C scalars, with strings as
+	 * struct salmon_string and symbols as struct salmon_symbol from the
+	 * headers under include/salmon/core. Calls to the other functions
+	 * are direct calls, and a function calling itself in tail position
+	 * jumps back to its start. The builtin arithmetic and comparison
+	 * interfaces become C operators.
+	 *
+	 * @throw CompileError if a function isn't a bytecode function, the
+	 * types of a body don't agree with its signature or each other, or it
+	 * calls something that can't be done without the VM.
+	 **/
+	std::string emit_c(std::span<const AotFunction> functions, Compiler &compiler);
+
+	//! Where the salmon/core headers were when Salmon was built
+	std::filesystem::path core_include_dir();
+
+	//! How to run the system C compiler
+	struct CBuildOptions {
+		std::string compiler = "cc";
+		std::vector<std::string> flags = { "-std=c17", "-O2" };
+		std::filesystem::path include_dir = core_include_dir();
+	};
+
+	/**
+	 * Build C source into a shared library. The source is written next to
+	 * the library, with .c added to its name.
+	 *
+	 * @throw CompileError if the source can't be written or the C compiler fails
+	 **/
+	void build_shared_library(const std::string &source, const std::filesystem::path &library,
+							  const CBuildOptions &options = {});
+}
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <compiler/compiler.hpp>
+#include <compiler/typeinference.hpp>
+#include <vm/box.hpp>
+#include <vm/function.hpp>
+
+namespace salmon::compiler {
+
+	/**
+	 * Instructions for the stack machine described in spec/bytecode.org.
+	 *
+	 * Each instruction is one byte, followed by a four byte operand for the
+	 * ones that take one.
+	 **/
+	enum class Opcode : uint8_t {
+		//! Discard the value on top of the stack
+		POP,
+		//! Push the constant with the given index
+		PUSHI,
+		//! Push the argument of the running function with the given index
+		PUSHL,
+		//! Jump to the given offset in the chunk
+		JMP,
+		//! Pop the value on top of the stack, and jump to the given offset if it is false or empty
+		JMP_F,
+		//! Look up the function for the given call by name and call it with the values on top of the stack
+		INVOKE,
+		/**
+		 * Same as INVOKE, but for a call whose value is returned straight
+		 * away. A call to a bytecode function reuses the caller's frame.
+		 **/
+		TAILCALL,
+		/**
+		 * Call the function the compiler picked for the given call. If the
+		 * interface it was picked from has changed since, or the arguments
+		 * don't have the types it takes, do what INVOKE does.
+		 **/
+		CALL,
+		//! Builtin arithmetic done in place, guarded the same way as CALL
+		ADD_I32,
+		SUBTRACT_I32,
+		MULTIPLY_I32,
+		DIVIDE_I32,
+		ADD_F64,
+		SUBTRACT_F64,
+		MULTIPLY_F64,
+		DIVIDE_F64,
+		//! Give the value on top of the stack back to the caller
+		RETURN,
+	};
+
+	//! The name of the opcode, as used in spec/bytecode.org
+	const char *opcode_name(Opcode op);
+	//! Check if the opcode is followed by an operand
+	bool has_operand(Opcode op);
+
+	//! A call in a chunk. Calling instructions refer to them by index.
+	struct CallInfo {
+		//! The list the call was compiled from
+		const vm::List *form;
+		//! The function named at the call site
+		vm::Symbol *name;
+		uint32_t num_args;
+		//! The function CALL goes to, or nullptr if the call hasn't been devirtualized
+		vm::VmFunction *target;
+		//! The interface the target was picked from
+		vm::InterfaceFunction *interface;
+		//! The version of the interface when the target was picked
+		uint64_t version;
+	};
+
+	//! Code compiled from one top-level form
+	struct Chunk {
+		std::vector<uint8_t> code;
+		//! Values pushed by PUSHI. Boxes keep them alive.
+		std::vector<vm::Box> constants;
+		std::vector<CallInfo> calls;
+
+		void emit(Opcode op);
+		void emit(Opcode op, uint32_t operand);
+		//! Read the operand of the instruction at the given offset
+		uint32_t operand(size_t offset) const;
+		//! Replace the operand of the instruction at the given offset
+		void patch(size_t offset, uint32_t operand);
+	};
+
+	//! Print the instructions of the chunk, one per line
+	std::ostream &operator<<(std::ostream &out, const Chunk &chunk);
+
+	//! Raised for forms that can't be compiled
+	struct CompileError : public std::runtime_error {
+		CompileError(const std::string &msg, const vm::AllocatedItem *form);
+
+		//! The form the error was found in, if it has one
+		const vm::AllocatedItem *form;
+	};
+
+	/**
+	 * Compile a read form to bytecode. Calls are compiled to INVOKE, so they
+	 * are looked up and dispatched when they run.
+	 *
+	 * Two special forms are understood:
+	 * + (defn name [args...] body...) compiles the body into a function and
+	 *   defines it under name straight away. The form itself evaluates to
+	 *   name. Calls in tail position of the body are compiled to TAILCALL.
+	 * + (if test then else) evaluates then unless test is false or empty. The
+	 *   else form can be left out, in which case it is empty.
+	 *
+	 * When fold_constants is set, calls to pure implementations of sealed
+	 * interfaces whose arguments are all constants are made while compiling,
+	 * and their results become constants in turn. Folding works from the
+	 * innermost calls outwards, so with Config::seal_builtins set
+	 * (add 1 (multiply 2 3)) is compiled to a single PUSHI, and only the
+	 * constant parts of (print (add 1 2)) are evaluated ahead of time.
+	 *
+	 * @throw CompileError if the form has something in it that can't be compiled yet.
+	 **/
+	Chunk compile(const vm::Box &form, Compiler &compiler, bool fold_constants = true);
+
+	/**
+	 * Rewrite calls whose argument types are known to skip dynamic dispatch.
+	 *
+	 * Calls that inference resolved to an implementation of an interface
+	 * become CALL. Calls to the builtin arithmetic interfaces on int-32 or
+	 * float-64 become the arithmetic opcodes, as long as the implementation is
+	 * still the one from the stdlib. Both keep the interface's
+	 * version, so they go back to INVOKE if an implementation is redefined.
+	 * They also check the types of their arguments when they run, and go
+	 * back to INVOKE if the arguments aren't the types inference expected.
+	 **/
+	void devirtualize(Chunk &chunk, const InferredTypes &types, Compiler &compiler);
+}
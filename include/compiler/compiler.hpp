@@ -1,7 +1,11 @@
 #ifndef SALMON_COMPILER_COMPILER
 #define SALMON_COMPILER_COMPILER
 
+#include <optional>
+
 #include <salmon/config.hpp>
+#include <compiler/readermacro.hpp>
+#include <compiler/sourcelocations.hpp>
 
 #include <vm/vm.hpp>
 
@@ -15,6 +19,10 @@ namespace salmon::compiler {
 
 		salmon::vm::VirtualMachine vm;
 
+		ReaderMacroTable reader_macros;
+		//! Where the reader records the source of the forms it reads. Off unless emplaced.
+		std::optional<SourceLocations> source_locations;
+
 		bool set_current_package(const std::string &name);
 
 		salmon::vm::Package *current_package();
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <compiler/compiler.hpp>
+#include <vm/box.hpp>
+
+namespace salmon::compiler {
+
+	/**
+	 * Compile a read form for the backend picked in the compiler's config,
+	 * and run it.
+	 *
+	 * @throw CompileError if the form can't be compiled
+	 **/
+	vm::Box evaluate(const vm::Box &form, Compiler &compiler);
+}
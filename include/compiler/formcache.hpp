@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include <compiler/compiler.hpp>
+#include <compiler/parser.hpp>
+
+namespace salmon::compiler {
+
+	/**
+	 * Cache of the forms read from source files, kept under the cache directory.
+	 *
+	 * Entries are keyed by a hash of the file's contents, the package it is
+	 * read into and the reader's version, so edited files miss the cache and are
+	 * read again. A hit maps the entry and decodes it instead of running the reader.
+	 **/
+	class FormCache {
+	public:
+		//! Bump whenever the reader reads the same text into different forms
+		static constexpr uint32_t READER_VERSION = 1;
+
+		explicit FormCache(const std::filesystem::path &cache_dir);
+
+		/**
+		 * Read every form in the file, using the cached copy when the file
+		 * hasn't changed since it was cached.
+		 * Returns std::nullopt if the file can't be opened. Parse errors are
+		 * collected with the forms that could be read, and nothing is cached
+		 * for a file that has them.
+		 **/
+		std::optional<ReadForms> read_file(const std::filesystem::path &file, Compiler &compiler);
+		//! How many reads were answered from the cache
+		uint64_t hits() const;
+
+		//! The key of the entry for the given source read into the given package
+		static uint64_t key(std::span<const std::byte> source, std::string_view package,
+							uint32_t reader_version = READER_VERSION);
+		std::filesystem::path entry_path(uint64_t key) const;
+	private:
+		void store(const std::filesystem::path &entry, std::span<const vm::Box> forms) const;
+
+		std::filesystem::path dir;
+		uint64_t cache_hits;
+	};
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <compiler/compiler.hpp>
+#include <compiler/meta.hpp>
+#include <compiler/parser.hpp>
+
+namespace salmon::compiler {
+
+	/**
+	 * Keeps the top-level forms read from a buffer that is edited over time,
+	 * such as a file open in an editor.
+	 *
+	 * The buffer is split into the stretches each top-level form was read from.
+	 * An edit re-reads from the form before it until reading lines up with the
+	 * start of a form that comes after the edit again. Everything past that
+	 * point is reused, with its offsets and positions moved.
+	 *
+	 * Source locations recorded for reused forms keep the positions they were
+	 * read at.
+	 **/
+	class IncrementalReader {
+	public:
+		struct Form {
+			//! Where reading the form started, including any whitespace before it
+			size_t start;
+			//! Just past the form
+			size_t end;
+			salmon::meta::position_info position;
+			ReadItem item;
+		};
+
+		explicit IncrementalReader(Compiler &compiler);
+		IncrementalReader(const IncrementalReader&) = delete;
+
+		//! Replace the buffer and read it from scratch
+		void reset(std::string text);
+		//! Replace the length characters at offset with the replacement
+		void edit(size_t offset, size_t length, std::string_view replacement);
+
+		const std::string &text() const;
+		const std::vector<Form> &forms() const;
+	private:
+		//! Index of the first form that the edit at offset could have changed
+		size_t first_changed(size_t offset) const;
+
+		Compiler &compiler;
+		std::string buffer;
+		std::vector<Form> read_forms;
+		//! Where the text after the last form starts
+		salmon::meta::position_info tail_position;
+	};
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <memory>
+#include <span>
+#include <vector>
+
+#include <compiler/bytecode.hpp>
+#include <compiler/jit.hpp>
+#include <vm/box.hpp>
+#include <vm/function.hpp>
+#include <vm/vm.hpp>
+
+namespace salmon::compiler {
+
+	//! A function defined with defn, run by the bytecode interpreter
+	class BytecodeFunction : public vm::VmFunction {
+	public:
+		BytecodeFunction(const vm::vm_ptr<vm::Type> &type,
+						 const std::vector<vm::vm_ptr<vm::Symbol>> &lambda_list,
+						 Chunk code);
+		~BytecodeFunction() override;
+
+		//! Run the function in a new interpreter
+		vm::Box operator()(vm::VirtualMachine *vm, std::span<vm::InternalBox> args) override;
+
+		const Chunk &chunk() const;
+		size_t arity() const;
+		//! Throw an ArityException if the function can't be called with num_args arguments
+		void check_arity(vm::VirtualMachine &vm, size_t num_args) const;
+		/**
+		 * Count a call to the function. The call that reaches the VM's
+		 * jit_threshold compiles it to machine code.
+		 **/
+		void count_call(vm::VirtualMachine &vm);
+		//! The machine code for the function, or nullptr if it is only interpreted
+		const JitCode *native_code() const;
+		//! Go back to interpreting the function, counting its calls from zero again
+		void discard_native_code();
+
+		void get_roots(const std::function<void(vm::AllocatedItem*)> &) const override;
+		void print_debug_info() const override;
+		size_t allocated_size() const override;
+	private:
+		Chunk code;
+		uint32_t calls = 0;
+		std::unique_ptr<JitCode> native;
+	};
+
+	/**
+	 * Run a chunk from its first instruction until it returns.
+	 *
+	 * Calls to bytecode functions don't recurse in C++: each one pushes a
+	 * frame onto a call stack kept by the interpreter, and the arguments
+	 * and temporaries of every frame share one value stack. TAILCALL
+	 * replaces the running frame instead of pushing a new one, so tail
+	 * recursion runs in constant space. The VM is checked for interrupts
+	 * before each call.
+	 *
+	 * Functions that have been compiled to machine code run it from the
+	 * instructions it can start at. When the machine code stops, the
+	 * interpreter runs the instruction it stopped at, then goes back to it.
+	 *
+	 * @throw vm::NoSuchFunction if a call names a function that doesn't exist
+	 * @throw vm::ArityException if a bytecode function is given the wrong number of arguments
+	 **/
+	vm::Box run(const Chunk &chunk, vm::VirtualMachine &vm);
+}
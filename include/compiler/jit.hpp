@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <vector>
+
+#include <compiler/bytecode.hpp>
+#include <vm/box.hpp>
+#include <vm/function.hpp>
+#include <vm/vm.hpp>
+
+namespace salmon::compiler {
+
+	//! What the interpreter and machine code hand each other when control passes between them
+	struct JitState {
+		vm::VirtualMachine *vm;
+		//! The first argument of the running frame
+		vm::InternalBox *base;
+		//! One past the value on top of the stack
+		vm::InternalBox *top;
+		//! Offset of the instruction the interpreter runs when the machine code stops
+		size_t pc;
+		//! Set when a builtin called from the machine code threw
+		std::exception_ptr *error;
+	};
+
+	/**
+	 * Machine code for the body of a bytecode function.
+	 *
+	 * The code runs on the interpreter's value stack and stops at every
+	 * instruction it doesn't have a template for, leaving the interpreter to
+	 * run it. It can be entered again after any instruction it stopped at.
+	 **/
+	class JitCode {
+	public:
+		using Entry = void(*)(JitState*);
+
+		JitCode(const JitCode&) = delete;
+		JitCode &operator=(const JitCode&) = delete;
+		~JitCode();
+
+		//! Where to start running at the given offset of the chunk, or nullptr if the code can't start there
+		Entry entry(size_t pc) const {
+			return entries[pc];
+		}
+		//! The most values one run of the code pushes, which the stack needs room for
+		size_t max_growth() const {
+			return growth;
+		}
+		//! Check that the interfaces whose implementations were called directly haven't changed
+		bool still_valid() const;
+		//! Bytes of machine code
+		size_t code_size() const;
+	private:
+		friend class NativeCompiler;
+		JitCode() = default;
+
+		struct Guard {
+			const vm::InterfaceFunction *interface;
+			uint64_t version;
+		};
+
+		void *memory = nullptr;
+		size_t length = 0;
+		std::vector<Entry> entries;
+		size_t growth = 0;
+		std::vector<Guard> guards;
+		//! Copies of the chunk's constants for the code to push
+		std::vector<vm::InternalBox> constants;
+	};
+
+	//! Whether jit_compile can make machine code on this platform
+	bool jit_supported();
+
+	/**
+	 * Compile the chunk of a bytecode function to x86-64 machine code.
+	 *
+	 * Each instruction is copied from a template into memory mapped
+	 * writable, which is made executable once the code is complete.
+	 * Pushes, jumps and conditionals are done in place. Calls to the builtin
+	 * arithmetic interfaces check that both arguments are int-32 or
+	 * float-64 and do the arithmetic natively. Calls to other interfaces
+	 * with int-32 or float-64 builtin implementations check the argument
+	 * types and call the implementation directly. If a check fails, the code
+	 * deoptimizes by stopping at the call, so the interpreter dispatches it.
+	 * Everything else, including calls to bytecode functions and returns,
+	 * is left to the interpreter, so it keeps managing frames.
+	 *
+	 * @return the code, or nullptr if the platform isn't supported or no memory could be mapped.
+	 **/
+	std::unique_ptr<JitCode> jit_compile(const Chunk &chunk, vm::VirtualMachine &vm);
+}
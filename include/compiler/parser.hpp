@@ -2,9 +2,11 @@
 
 #include <sstream>
 #include <string>
+#include <string_view>
 #include <exception>
 #include <filesystem>
 #include <optional>
+#include <vector>
 
 #include <compiler/CountingStream.hpp>
 #include <compiler/compiler.hpp>
@@ -24,6 +26,8 @@ namespace salmon::compiler {
 	public:
 		void add_file_info(const std::filesystem::path &file);
 		std::string build_error_str() const;
+		const salmon::meta::position_info &start() const;
+		const salmon::meta::position_info &end() const;
 	private:
 		const salmon::meta::position_info expression_start;
 		const salmon::meta::position_info expression_end;
@@ -33,6 +37,40 @@ namespace salmon::compiler {
 	//! Read a single form from the input stream.
 	std::optional<salmon::vm::Box> read(CountingStreamBuffer &countStreamBuf, Compiler &compiler);
 
+	//! The forms read from an input, and the errors found while reading it
+	struct ReadForms {
+		std::vector<salmon::vm::Box> forms;
+		std::vector<ParseException> errors;
+	};
+
+	//! A form, or the error found while reading it
+	struct ReadItem {
+		std::optional<salmon::vm::Box> form;
+		std::optional<ParseException> error;
+	};
+
+	/**
+	 * Read a single form from the input stream, returning a parse error instead
+	 * of throwing it. After an error, the stream is left at the next '(' that
+	 * starts a line. Returns std::nullopt at the end of the input.
+	 **/
+	std::optional<ReadItem> read_recovering(CountingStreamBuffer &countStreamBuf, Compiler &compiler);
+
+	/**
+	 * Read every form from the input stream, collecting parse errors instead of
+	 * throwing them. After an error, reading picks up again at the next '(' that
+	 * starts a line. The input is buffered, so when a form runs off the end of
+	 * it, as an unclosed list does, reading goes back to the first '(' starting
+	 * a line after the form's start.
+	 **/
+	ReadForms read_all(CountingStreamBuffer &countStreamBuf, Compiler &compiler);
+
+	/**
+	 * Whether the source ends inside a list, vector, set or string that hasn't
+	 * been closed yet, so reading it needs more input.
+	 **/
+	bool needs_more_input(std::string_view source);
+
 	//! Read a single form from the string
 	std::optional<salmon::vm::Box> read_from_string(const std::string& input, Compiler &compiler);
 
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <array>
+#include <functional>
+#include <istream>
+
+#include <vm/box.hpp>
+
+namespace salmon::compiler {
+
+	struct Compiler;
+
+	/**
+	 * Reads the form written after '#' and a dispatch character, both of which
+	 * have already been consumed. The stream's buffer is the reader's
+	 * CountingStreamBuffer, so it can be read from directly.
+	 **/
+	using ReaderMacro = std::function<vm::Box(std::istream &input, Compiler &compiler)>;
+
+	/**
+	 * The reader macros, indexed by their dispatch character.
+	 *
+	 * Starts out with the builtin macros:
+	 *   #:name   uninterned symbol
+	 *   #x, #o, #b   hex, octal and binary integers
+	 *   #\c      character literal, read as its character code
+	 *   #(...)   vector
+	 **/
+	class ReaderMacroTable {
+	public:
+		ReaderMacroTable();
+		ReaderMacroTable(const ReaderMacroTable&) = delete;
+
+		//! Use the macro for the dispatch character, replacing the one already there
+		void set(char dispatch, ReaderMacro macro);
+		void remove(char dispatch);
+		//! The macro for the dispatch character, or nullptr if there isn't one
+		const ReaderMacro *get(char dispatch) const;
+		//! Whether the table was changed since it was created
+		bool customized() const;
+	private:
+		std::array<ReaderMacro, 256> macros;
+		bool is_customized;
+	};
+}
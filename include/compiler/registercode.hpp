@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+#include <compiler/bytecode.hpp>
+#include <compiler/compiler.hpp>
+#include <vm/box.hpp>
+
+namespace salmon::compiler {
+
+	/**
+	 * Instructions for the register machine, an alternative to the stack
+	 * machine in spec/bytecode.org.
+	 *
+	 * Each function has a frame of registers. Its arguments are in the
+	 * first ones, and the rest hold temporaries. Instructions name their
+	 * inputs directly with operands, which are either a register or an
+	 * entry in the constant table, so values aren't pushed before they are
+	 * used and most forms take one instruction.
+	 **/
+	enum class RegisterOpcode : uint8_t {
+		//! Copy operand b into register a
+		MOVE,
+		//! Jump to instruction b
+		JMP,
+		//! Jump to instruction b if operand a is false or empty
+		JMP_F,
+		//! Make call b, putting the result in register a
+		INVOKE,
+		//! Make call b, and return its result. A call to a register function reuses the frame.
+		TAILCALL,
+		//! Give operand a back to the caller
+		RETURN,
+	};
+
+	//! A register, or an entry in the constant table when constant_bit is set
+	using Operand = uint32_t;
+	constexpr Operand constant_bit = Operand{1} << 31;
+
+	struct Instruction {
+		RegisterOpcode op;
+		uint32_t a;
+		uint32_t b;
+	};
+
+	//! A call in a register chunk
+	struct RegisterCall {
+		//! The list the call was compiled from
+		const vm::List *form;
+		//! The function named at the call site
+		vm::Symbol *name;
+		//! The arguments are call_args[first_arg, first_arg + num_args)
+		uint32_t first_arg;
+		uint32_t num_args;
+	};
+
+	//! Register code compiled from one top-level form or function body
+	struct RegisterChunk {
+		std::vector<Instruction> code;
+		//! Values named by constant operands. Boxes keep them alive.
+		std::vector<vm::Box> constants;
+		std::vector<RegisterCall> calls;
+		std::vector<Operand> call_args;
+		//! The size of the frame the chunk runs in
+		uint32_t num_registers = 0;
+	};
+
+	//! Print the instructions of the chunk, one per line
+	std::ostream &operator<<(std::ostream &out, const RegisterChunk &chunk);
+
+	/**
+	 * Compile a read form to register code.
+	 *
+	 * Understands the same forms as compile(), and folds pure calls on
+	 * constants the same way when fold_constants is set. Functions defined
+	 * in the form are register functions.
+	 *
+	 * @throw CompileError if the form has something in it that can't be compiled yet.
+	 **/
+	RegisterChunk compile_registers(const vm::Box &form, Compiler &compiler, bool fold_constants = true);
+}
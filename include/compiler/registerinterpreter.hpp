@@ -0,0 +1,48 @@
+#pragma once
+
+#include <span>
+#include <vector>
+
+#include <compiler/registercode.hpp>
+#include <vm/box.hpp>
+#include <vm/function.hpp>
+#include <vm/vm.hpp>
+
+namespace salmon::compiler {
+
+	//! A function defined with defn, run by the register interpreter
+	class RegisterFunction : public vm::VmFunction {
+	public:
+		RegisterFunction(const vm::vm_ptr<vm::Type> &type,
+						 const std::vector<vm::vm_ptr<vm::Symbol>> &lambda_list,
+						 RegisterChunk code);
+
+		//! Run the function in a new interpreter
+		vm::Box operator()(vm::VirtualMachine *vm, std::span<vm::InternalBox> args) override;
+
+		const RegisterChunk &chunk() const;
+		size_t arity() const;
+		//! Throw an ArityException if the function can't be called with num_args arguments
+		void check_arity(vm::VirtualMachine &vm, size_t num_args) const;
+
+		void get_roots(const std::function<void(vm::AllocatedItem*)> &) const override;
+		void print_debug_info() const override;
+		size_t allocated_size() const override;
+	private:
+		RegisterChunk code;
+	};
+
+	/**
+	 * Run register code from its first instruction until it returns.
+	 *
+	 * Like the stack interpreter, calls between register functions don't
+	 * recurse in C++. The frames of every call share one register file:
+	 * the callee's frame starts right after the caller's, where the caller
+	 * copies the arguments. TAILCALL moves them to the start of the running
+	 * frame instead.
+	 *
+	 * @throw vm::NoSuchFunction if a call names a function that doesn't exist
+	 * @throw vm::ArityException if a register function is given the wrong number of arguments
+	 **/
+	vm::Box run(const RegisterChunk &chunk, vm::VirtualMachine &vm);
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <compiler/meta.hpp>
+#include <util/swisstable.hpp>
+#include <vm/allocateditem.hpp>
+
+namespace salmon::compiler {
+
+	/**
+	 * Where the forms built by the reader came from, kept to the side so the
+	 * forms themselves don't get any bigger.
+	 *
+	 * Each recorded item gets a dense id, which indexes the columns holding
+	 * its file and positions. Items are looked up by address, so the table
+	 * should be cleared once the forms it describes have been collected.
+	 **/
+	class SourceLocations {
+	public:
+		using FileId = uint32_t;
+		//! The file of forms read from something other than a file
+		static constexpr FileId NO_FILE = UINT32_MAX;
+
+		struct Location {
+			FileId file;
+			salmon::meta::position_info start;
+			salmon::meta::position_info end;
+		};
+
+		SourceLocations();
+
+		//! Record the forms read from now on as coming from the file
+		FileId begin_file(const std::filesystem::path &file);
+		//! Record the forms read from now on as not coming from a file
+		void end_file();
+		//! The path of a file id returned by begin_file
+		const std::filesystem::path &file_path(FileId file) const;
+
+		//! Record the item as read from the current file between start and end
+		void record(const vm::AllocatedItem *item, const salmon::meta::position_info &start,
+					const salmon::meta::position_info &end);
+		std::optional<Location> find(const vm::AllocatedItem *item) const;
+
+		//! The number of items recorded
+		size_t size() const;
+		//! Forget every recorded item. File ids stay valid.
+		void clear();
+	private:
+		SwissTable<const vm::AllocatedItem*, uint32_t> ids;
+		std::vector<FileId> files;
+		std::vector<salmon::meta::position_info> starts;
+		std::vector<salmon::meta::position_info> ends;
+
+		std::vector<std::filesystem::path> paths;
+		SwissTable<std::string, FileId> path_ids;
+		FileId current_file;
+	};
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+#include <compiler/bytecode.hpp>
+#include <compiler/compiler.hpp>
+#include <vm/box.hpp>
+#include <vm/function.hpp>
+
+namespace salmon::compiler {
+
+	//! The symbols naming the special forms, which are interned in the base package
+	struct SpecialForms {
+		explicit SpecialForms(Compiler &compiler);
+
+		vm::Symbol *const defn;
+		vm::Symbol *const defextern;
+		vm::Symbol *const if_form;
+	};
+
+	//! A checked (defn name [args...] body...) form
+	struct Definition {
+		vm::Symbol *name;
+		//! The name as it was read, which is what the defn form evaluates to
+		vm::InternalBox name_form;
+		std::vector<vm::Symbol*> args;
+		std::vector<vm::vm_ptr<vm::Symbol>> lambda_list;
+		//! The cells holding the body forms. Never empty.
+		const vm::List *body;
+		//! Takes one parameter per argument, and returns something unknown
+		vm::vm_ptr<vm::Type> type;
+	};
+
+	/**
+	 * Pull a defn form apart.
+	 *
+	 * @throw CompileError if the form isn't a valid definition
+	 **/
+	Definition parse_defn(const vm::List *form, Compiler &compiler);
+
+	/**
+	 * Define fn under the name of the definition.
+	 *
+	 * @throw CompileError if the name is already defined with a different type
+	 **/
+	void define_function(const Definition &definition, const vm::vm_ptr<vm::VmFunction> &fn,
+						 const vm::List *form, Compiler &compiler);
+
+	//! A checked (defextern name "library" [arg-types...] result-type) form
+	struct ExternDeclaration {
+		vm::Symbol *name;
+		//! The name as it was read, which is what the defextern form evaluates to
+		vm::InternalBox name_form;
+		std::string library;
+		//! The name with dashes turned into underscores
+		std::string c_name;
+		std::vector<vm::Type*> arg_types;
+		vm::Type *result_type;
+	};
+
+	/**
+	 * Pull a defextern form apart.
+	 *
+	 * @throw CompileError if the form isn't a valid declaration, or names a type that doesn't exist
+	 **/
+	ExternDeclaration parse_defextern(const vm::List *form, Compiler &compiler);
+
+	/**
+	 * Load the C function a declaration names, and define it under the name of the declaration.
+	 *
+	 * @throw CompileError if the library or function can't be loaded, or the
+	 * name is already defined with a different type
+	 **/
+	void define_extern(const ExternDeclaration &declaration, const vm::List *form, Compiler &compiler);
+
+	//! A checked (if test then else) form. otherwise is nullptr when there is no else form.
+	struct Conditional {
+		const vm::InternalBox *test;
+		const vm::InternalBox *then;
+		const vm::InternalBox *otherwise;
+	};
+
+	//! Check if an if form takes its else branch for the value: false and empty do
+	bool is_false(const vm::InternalBox &value);
+
+	/**
+	 * Pull an if form apart.
+	 *
+	 * @throw CompileError if the form doesn't have a test and one or two branches
+	 **/
+	Conditional parse_if(const vm::List *form);
+
+	/**
+	 * Make a call to a pure function ahead of time.
+	 *
+	 * Only implementations of sealed interfaces are called, since any other
+	 * function can be replaced before the form runs. Returns nothing if the
+	 * function isn't one of those, isn't pure, or if the call would fail.
+	 * Those calls are left for when the form runs, so the error happens then.
+	 **/
+	std::optional<vm::Box> fold_call(const vm::Symbol &name, std::span<const vm::InternalBox> args,
+									 Compiler &compiler);
+}
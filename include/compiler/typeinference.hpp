@@ -0,0 +1,62 @@
+#pragma once
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <compiler/compiler.hpp>
+#include <vm/box.hpp>
+#include <vm/function.hpp>
+#include <vm/type.hpp>
+
+namespace salmon::compiler {
+
+	//! Raised for a call whose argument types can't be made to agree with the function
+	struct TypeError : public std::runtime_error {
+		TypeError(const std::string &msg, const vm::List *form);
+
+		//! The call the error was found in. Look it up in the source locations to find where it was read.
+		const vm::List *form;
+	};
+
+	//! A list in a form that calls a function in the function table
+	struct CallSite {
+		const vm::List *form;
+		//! The function named at the head of the list
+		vm::VmFunction *callee;
+		//! The concrete type of the call, or nullptr if inference couldn't pin it down
+		const vm::Type *type;
+		/**
+		 * The function the call can go straight to: the implementation the
+		 * argument types select when the callee is an interface, or the
+		 * callee itself. nullptr if the call has to be dispatched when it runs.
+		 **/
+		vm::VmFunction *target;
+	};
+
+	struct InferredTypes {
+		//! The type of the whole form, or nullptr if it isn't known
+		const vm::Type *type;
+		//! Every call in the form, innermost calls first
+		std::vector<CallSite> call_sites;
+		std::vector<TypeError> errors;
+	};
+
+	/**
+	 * Infer the static types of a read form.
+	 *
+	 * Every sub-form gets a type variable. Literals and keywords are bound to
+	 * their types, other symbols are left unknown. A list headed by a symbol
+	 * naming a function is a call: the parameters of the function's type get
+	 * fresh variables, which are unified with the types of the arguments. A
+	 * call returning a parameter that none of its arguments have, like a
+	 * function made by defn, has an unknown result: it isn't given the type
+	 * it is used as. The variables are kept in a union-find forest, so
+	 * unification is close to constant time.
+	 *
+	 * Once the whole form is solved, each call whose argument types are all
+	 * known is given a concrete function type. Calls to interfaces are
+	 * resolved to the implementation for those types.
+	 **/
+	InferredTypes infer_types(const vm::Box &form, Compiler &compiler);
+}
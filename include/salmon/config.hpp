@@ -1,6 +1,7 @@
 #ifndef SALMON_CONFIG
 #define SALMON_CONFIG
 
+#include <cstdint>
 #include <filesystem>
 #include <ostream>
 #include <optional>
@@ -8,11 +9,27 @@
 
 namespace salmon {
 
+	//! The machine compiled code runs on
+	enum class Backend {
+		//! The stack machine from spec/bytecode.org
+		STACK,
+		//! Three-address code over a frame of registers
+		REGISTER,
+	};
+
 	struct Config {
 		int verbosity_level;
 		const std::filesystem::path cache_dir;
 		const std::filesystem::path config_dir;
 		const std::filesystem::path data_dir;
+		Backend backend = Backend::STACK;
+		//! Calls a bytecode function takes before it is compiled to machine code. 0 never compiles them.
+		uint32_t jit_threshold = 1000;
+		/**
+		 * Seal the builtin interfaces, so their implementations can't be
+		 * replaced. Only then are calls to them on constants folded.
+		 **/
+		bool seal_builtins = false;
 
 		static const int max_verbose_lvl = 3;
 		// use static function so CompilerConfig is still a POD class:
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <functional>
+#include <type_traits>
+
+#include <vm/vm_ptr.hpp>
+
+namespace salmon {
+
+	/**
+	 * Order items by the `id` member instead of their contents.
+	 *
+	 * Useful for interned items (i.e. symbols), where identity is equality.
+	 **/
+	template<typename T>
+	struct cmpId {
+		bool operator()(const T* a, const T* b) const {
+			return a->id < b->id;
+		}
+
+		bool operator()(const vm::vm_ptr<T> &a, const vm::vm_ptr<T> &b) const {
+			return a->id < b->id;
+		}
+	};
+
+	//! Hash items using their `id` member. Equality is left to pointer comparison.
+	template<typename T>
+	struct hashId {
+		size_t operator()(const T* a) const {
+			return std::hash<std::remove_cv_t<decltype(a->id)>>{}(a->id);
+		}
+
+		size_t operator()(const vm::vm_ptr<T> &a) const {
+			return std::hash<std::remove_cv_t<decltype(a->id)>>{}(a->id);
+		}
+	};
+}
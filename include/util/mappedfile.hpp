@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <optional>
+#include <span>
+
+namespace salmon {
+
+	//! A file mapped read-only into memory, unmapped when destroyed.
+	class MappedFile {
+	public:
+		/**
+		 * Map the whole file.
+		 * Returns std::nullopt if the file can't be opened or mapped.
+		 **/
+		static std::optional<MappedFile> open(const std::filesystem::path &path);
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile(MappedFile &&other) noexcept;
+		~MappedFile();
+
+		std::span<const std::byte> bytes() const;
+	private:
+		MappedFile(void *data, size_t size);
+
+		void *data;
+		size_t size;
+	};
+}
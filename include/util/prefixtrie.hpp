@@ -155,6 +155,19 @@ namespace salmon {
 			return this->at(prefixes);
 		}
 
+		//! Get the item stored under the prefixes, or nullptr if there isn't one
+		const V *find(const std::vector<K> &prefixes) const {
+			const Node *cur = &tree;
+			for(const auto &item : prefixes) {
+				const auto place = cur->tree.find(item);
+				if(place == cur->tree.end()) {
+					return nullptr;
+				}
+				cur = place->second.get();
+			}
+			return cur->item ? &*cur->item : nullptr;
+		}
+
 		const V &at(const std::vector<K> &prefixes) const {
 			return at_helper(&tree, prefixes);
 		}
@@ -0,0 +1,342 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <utility>
+#include <iterator>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace salmon {
+
+	/**
+	 * Hash map using open addressing with one byte of metadata per slot.
+	 *
+	 * Slots are probed a group of sixteen at a time: the group's metadata is
+	 * matched against the top bits of the hash in one go (with SSE2 when it is
+	 * available), so most lookups only compare one key.
+	 **/
+	template<typename K, typename V, typename Hash = std::hash<K>, typename Equal = std::equal_to<K>>
+	class SwissTable {
+		using ctrl_t = int8_t;
+		static constexpr ctrl_t EMPTY = -128;
+		static constexpr ctrl_t DELETED = -2;
+		static constexpr size_t GROUP_WIDTH = 16;
+		static constexpr size_t MIN_CAPACITY = GROUP_WIDTH;
+
+		//! Metadata of GROUP_WIDTH consecutive slots
+		struct Group {
+#ifdef __SSE2__
+			explicit Group(const ctrl_t *pos) :
+				ctrl{_mm_loadu_si128(reinterpret_cast<const __m128i*>(pos))} {}
+
+			uint32_t match(ctrl_t hash) const {
+				return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(hash), ctrl)));
+			}
+
+			//! Empty and deleted slots are the only ones with the high bit set
+			uint32_t match_empty_or_deleted() const {
+				return static_cast<uint32_t>(_mm_movemask_epi8(ctrl));
+			}
+
+			__m128i ctrl;
+#else
+			explicit Group(const ctrl_t *pos) {
+				std::memcpy(ctrl, pos, GROUP_WIDTH);
+			}
+
+			uint32_t match(ctrl_t hash) const {
+				uint32_t mask = 0;
+				for(size_t i = 0; i < GROUP_WIDTH; i++) {
+					mask |= static_cast<uint32_t>(ctrl[i] == hash) << i;
+				}
+				return mask;
+			}
+
+			uint32_t match_empty_or_deleted() const {
+				uint32_t mask = 0;
+				for(size_t i = 0; i < GROUP_WIDTH; i++) {
+					mask |= static_cast<uint32_t>(ctrl[i] < 0) << i;
+				}
+				return mask;
+			}
+
+			ctrl_t ctrl[GROUP_WIDTH];
+#endif
+			uint32_t match_empty() const {
+				return match(EMPTY);
+			}
+		};
+
+		union Slot {
+			Slot() {}
+			~Slot() {}
+			std::pair<K, V> value;
+		};
+
+	public:
+		using value_type = std::pair<K, V>;
+
+		template<bool Const>
+		class Iterator {
+			using table_type = std::conditional_t<Const, const SwissTable, SwissTable>;
+		public:
+			using iterator_category = std::forward_iterator_tag;
+			using difference_type = std::ptrdiff_t;
+			using value_type = SwissTable::value_type;
+			using reference = std::conditional_t<Const, const value_type&, value_type&>;
+			using pointer = std::conditional_t<Const, const value_type*, value_type*>;
+
+			Iterator(table_type *table, size_t index) :
+				table{table}, index{index} {
+				skip_empty();
+			}
+
+			reference operator*() const {
+				return table->slots[index].value;
+			}
+
+			pointer operator->() const {
+				return &table->slots[index].value;
+			}
+
+			Iterator &operator++() {
+				index++;
+				skip_empty();
+				return *this;
+			}
+
+			bool operator==(const Iterator &other) const {
+				return index == other.index;
+			}
+		private:
+			void skip_empty() {
+				while(index < table->capacity && table->ctrl[index] < 0) {
+					index++;
+				}
+			}
+
+			table_type *table;
+			size_t index;
+		};
+
+		using iterator = Iterator<false>;
+		using const_iterator = Iterator<true>;
+
+		SwissTable() = default;
+		SwissTable(const SwissTable&) = delete;
+
+		~SwissTable() {
+			destroy_slots();
+		}
+
+		//! Find the value stored for the key, or nullptr if there isn't one
+		V *find(const K &key) {
+			const size_t index = find_index(key);
+			return index == capacity ? nullptr : &slots[index].value.second;
+		}
+
+		const V *find(const K &key) const {
+			const size_t index = find_index(key);
+			return index == capacity ? nullptr : &slots[index].value.second;
+		}
+
+		bool contains(const K &key) const {
+			return find_index(key) != capacity;
+		}
+
+		/**
+		 * Store the value for the key if the key isn't present.
+		 * Returns the stored value and whether it was inserted.
+		 **/
+		std::pair<V*, bool> try_emplace(const K &key, const V &value) {
+			const size_t hash = hash_of(key);
+			const size_t found = find_index(key, hash);
+			if(found != capacity) {
+				return std::make_pair(&slots[found].value.second, false);
+			}
+			if(capacity == 0 || (size_ + deleted + 1) * 8 > capacity * 7) {
+				// Only grow when the table is full of live items, otherwise clearing
+				// out the deleted slots makes enough room.
+				rehash(size_ + 1 > capacity / 2 ? std::max(capacity * 2, MIN_CAPACITY) : capacity);
+			}
+			const size_t index = find_free(hash);
+			if(ctrl[index] == DELETED) {
+				deleted--;
+			}
+			set_ctrl(index, h2(hash));
+			new (&slots[index].value) value_type(key, value);
+			size_++;
+			return std::make_pair(&slots[index].value.second, true);
+		}
+
+		//! Remove the key from the table. Returns true if it was present.
+		bool erase(const K &key) {
+			const size_t index = find_index(key);
+			if(index == capacity) {
+				return false;
+			}
+			slots[index].value.~value_type();
+			set_ctrl(index, DELETED);
+			size_--;
+			deleted++;
+			return true;
+		}
+
+		//! Remove every item, keeping the memory for reuse
+		void clear() {
+			if(capacity == 0) {
+				return;
+			}
+			destroy_slots();
+			std::memset(ctrl.get(), EMPTY, capacity + GROUP_WIDTH - 1);
+			size_ = 0;
+			deleted = 0;
+		}
+
+		//! Make room for at least `count` items without rehashing
+		void reserve(size_t count) {
+			size_t wanted = MIN_CAPACITY;
+			while(wanted * 7 < count * 8) {
+				wanted *= 2;
+			}
+			if(wanted > capacity) {
+				rehash(wanted);
+			}
+		}
+
+		size_t size() const {
+			return size_;
+		}
+
+		bool empty() const {
+			return size_ == 0;
+		}
+
+		iterator begin() {
+			return iterator(this, 0);
+		}
+
+		iterator end() {
+			return iterator(this, capacity);
+		}
+
+		const_iterator begin() const {
+			return const_iterator(this, 0);
+		}
+
+		const_iterator end() const {
+			return const_iterator(this, capacity);
+		}
+
+	private:
+		//! Spread the bits of weak hashes (like std::hash<int>) before splitting them
+		size_t hash_of(const K &key) const {
+			size_t hash = hasher(key) * 0x9e3779b97f4a7c15ull;
+			return hash ^ (hash >> 32);
+		}
+
+		static size_t h1(size_t hash) {
+			return hash >> 7;
+		}
+
+		static ctrl_t h2(size_t hash) {
+			return static_cast<ctrl_t>(hash & 0x7f);
+		}
+
+		size_t find_index(const K &key) const {
+			return find_index(key, hash_of(key));
+		}
+
+		//! The slot holding key, or capacity if it isn't present
+		size_t find_index(const K &key, size_t hash) const {
+			if(capacity == 0) {
+				return capacity;
+			}
+			const size_t mask = capacity - 1;
+			size_t pos = h1(hash) & mask;
+			// Triangular probing over groups visits every group when capacity is a power of two
+			for(size_t step = GROUP_WIDTH;; step += GROUP_WIDTH) {
+				const Group group(&ctrl[pos]);
+				for(uint32_t matches = group.match(h2(hash)); matches; matches &= matches - 1) {
+					const size_t index = (pos + std::countr_zero(matches)) & mask;
+					if(equal(slots[index].value.first, key)) {
+						return index;
+					}
+				}
+				if(group.match_empty()) {
+					return capacity;
+				}
+				pos = (pos + step) & mask;
+			}
+		}
+
+		//! The first empty or deleted slot on the probe sequence for hash
+		size_t find_free(size_t hash) const {
+			const size_t mask = capacity - 1;
+			size_t pos = h1(hash) & mask;
+			for(size_t step = GROUP_WIDTH;; step += GROUP_WIDTH) {
+				const uint32_t free = Group(&ctrl[pos]).match_empty_or_deleted();
+				if(free) {
+					return (pos + std::countr_zero(free)) & mask;
+				}
+				pos = (pos + step) & mask;
+			}
+		}
+
+		void set_ctrl(size_t index, ctrl_t value) {
+			ctrl[index] = value;
+			// The first slots are mirrored after the end, so a group can be loaded
+			// from any position without wrapping around.
+			if(index < GROUP_WIDTH - 1) {
+				ctrl[capacity + index] = value;
+			}
+		}
+
+		void rehash(size_t new_capacity) {
+			std::unique_ptr<ctrl_t[]> old_ctrl = std::move(ctrl);
+			std::unique_ptr<Slot[]> old_slots = std::move(slots);
+			const size_t old_capacity = capacity;
+
+			capacity = new_capacity;
+			ctrl = std::make_unique<ctrl_t[]>(capacity + GROUP_WIDTH - 1);
+			std::memset(ctrl.get(), EMPTY, capacity + GROUP_WIDTH - 1);
+			slots = std::make_unique<Slot[]>(capacity);
+			deleted = 0;
+
+			for(size_t i = 0; i < old_capacity; i++) {
+				if(old_ctrl[i] >= 0) {
+					value_type &item = old_slots[i].value;
+					const size_t hash = hash_of(item.first);
+					const size_t index = find_free(hash);
+					set_ctrl(index, h2(hash));
+					new (&slots[index].value) value_type(std::move(item));
+					item.~value_type();
+				}
+			}
+		}
+
+		void destroy_slots() {
+			for(size_t i = 0; i < capacity; i++) {
+				if(ctrl[i] >= 0) {
+					slots[i].value.~value_type();
+				}
+			}
+		}
+
+		std::unique_ptr<ctrl_t[]> ctrl;
+		std::unique_ptr<Slot[]> slots;
+		size_t capacity = 0;
+		size_t size_ = 0;
+		size_t deleted = 0;
+		[[no_unique_address]] Hash hasher;
+		[[no_unique_address]] Equal equal;
+	};
+}
@@ -18,6 +18,7 @@ namespace salmon::vm {
 
 	struct List;
 	struct Vector;
+	struct HashSet;
 
 	using BoxVariant = std::variant<int32_t,
 					double,
@@ -26,7 +27,11 @@ namespace salmon::vm {
 					Vector*,
 					Symbol*,
 					List*,
-					StaticString*>;
+					StaticString*,
+					HashSet*,
+					int64_t,
+					uint64_t,
+					float>;
 
 	struct InternalBox {
 		Type* type;
@@ -36,6 +41,22 @@ namespace salmon::vm {
 	std::partial_ordering operator<=>(const InternalBox &lhs, const InternalBox &rhs);
 	bool operator==(const InternalBox &lhs, const InternalBox &rhs);
 
+	/**
+	 * Structurally compare two values.
+	 *
+	 * Values holding different kinds of items are ordered by kind. Lists are
+	 * compared item by item, vectors by length and then item by item. Sets of
+	 * the same size are either equal or unordered.
+	 * Nested containers are walked with an explicit stack, so deeply nested or
+	 * very long values don't use up the C++ stack.
+	 **/
+	std::partial_ordering compare_values(const InternalBox &lhs, const InternalBox &rhs);
+	std::partial_ordering compare_values(const List &lhs, const List &rhs);
+	std::partial_ordering compare_values(const Vector &lhs, const Vector &rhs);
+	std::partial_ordering compare_values(const HashSet &lhs, const HashSet &rhs);
+	//! Structural hash of a value. Values that compare equal have the same hash.
+	size_t hash_value(const InternalBox &box);
+
 	struct Box {
 
 		template<typename T>
@@ -60,17 +81,8 @@ namespace salmon::vm {
 			salmon_check(internal.type != nullptr, "Type shouldn't be null");
 		}
 
-		Box(InternalBox internal, const vm_ptr<AllocatedItem> &seed) :
-			internal{internal},
-			elem_ptr{seed},
-			type_ptr{seed.from(internal.type)} {
-			std::visit([this](auto &&arg) {
-				using T = std::decay<decltype(arg)>;
-				if constexpr (std::is_pointer<T>::value) {
-					this->elem_ptr = arg;
-				}
-			}, this->internal.elem);
-		}
+		//! Root the contents of internal, using seed to reach the memory manager
+		Box(InternalBox internal, const vm_ptr<AllocatedItem> &seed);
 
 		template <typename T>
 		Box(T scalar, const vm_ptr<Type> &type) :
@@ -95,6 +107,15 @@ namespace salmon::vm {
 			return internal <=> other.internal;
 		}
 
+		bool operator==(const Box &other) const {
+			return internal == other.internal;
+		}
+
+		//! Structural hash of the boxed value
+		size_t hash() const {
+			return hash_value(internal);
+		}
+
 		template<typename T>
 		void set_value(const vm_ptr<T> &value) {
 			internal.elem = value.get();
@@ -146,18 +167,15 @@ namespace salmon::vm {
 
 		size_t size() const;
 
-		auto operator<=>(const Vector &other) const {
-			return other.items <=> this->items;
-		}
-		bool operator==(const Vector &other) const {
-			return this->items == other.items;
-		}
+		std::partial_ordering operator<=>(const Vector &other) const;
+		bool operator==(const Vector &other) const;
 	private:
 		std::vector<InternalBox> items;
 	};
 
 	struct List : public AllocatedItem {
 		List(const Box &itm);
+		List(const InternalBox &itm);
 		List() = delete;
 		~List() = default;
 
@@ -168,28 +186,23 @@ namespace salmon::vm {
 		void get_roots(const std::function<void(AllocatedItem*)>&) const override;
 		size_t allocated_size() const override;
 
-		bool operator==(const List &other) const {
-			if(itm == other.itm) {
-				return next == other.next;
-			} else return false;
-		}
-
-		std::partial_ordering operator<=>(const List &other) const {
-			const auto compare =  itm <=> other.itm;
-			if(compare == 0) {
-				if(next != nullptr && other.next != nullptr) {
-					return *this->next <=> *other.next;
-				} else if(next != nullptr) {
-					return std::strong_ordering::greater;
-				} else if(other.next != nullptr) {
-					return std::strong_ordering::less;
-				} else {
-					std::cout << "Items equal\n";
-					return std::strong_ordering::equal;
-				}
-			} else return compare;
-		}
+		bool operator==(const List &other) const;
+		std::partial_ordering operator<=>(const List &other) const;
 	};
 }
 
+template<>
+struct std::hash<salmon::vm::InternalBox> {
+	size_t operator()(const salmon::vm::InternalBox &box) const {
+		return salmon::vm::hash_value(box);
+	}
+};
+
+template<>
+struct std::hash<salmon::vm::Box> {
+	size_t operator()(const salmon::vm::Box &box) const {
+		return box.hash();
+	}
+};
+
 #endif
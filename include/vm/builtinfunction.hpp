@@ -37,6 +37,11 @@ namespace salmon::vm {
 			return unpack_vector(vm, span);
 		}
 
+		//! The C++ function the builtin calls, for code that has already checked the arguments
+		FunctionType function() const {
+			return actual_function;
+		}
+
 		void print_debug_info() const override {
 			std::cerr << "Built-in function " << actual_function;
 		}
@@ -0,0 +1,67 @@
+#ifndef SALMON_COMPILER_VM_CONSARENA
+#define SALMON_COMPILER_VM_CONSARENA
+
+#include <vector>
+#include <unordered_set>
+#include <utility>
+#include <cstdint>
+#include <cstddef>
+
+namespace salmon::vm {
+
+	struct AllocatedItem;
+	struct List;
+
+	/**
+	 * Storage for list cells.
+	 *
+	 * Cells live in large aligned chunks and are handed out in address order,
+	 * so the cells of a list built in one go sit next to each other in memory.
+	 * Each chunk keeps its own mark bits, so the garbage collector doesn't
+	 * need to track cells in its hash sets.
+	 **/
+	class ConsArena {
+	public:
+		ConsArena() = default;
+		ConsArena(const ConsArena&) = delete;
+		~ConsArena();
+
+		/**
+		 * Get uninitialized storage for up to `count` adjacent cells.
+		 * Returns the first cell and the number of cells granted, which is only
+		 * less than `count` when the run doesn't fit in a single chunk.
+		 **/
+		std::pair<List*, size_t> allocate(size_t count);
+		//! Get uninitialized storage for a single cell
+		List *allocate();
+
+		//! Whether the item is a cell allocated from this arena
+		bool owns(const AllocatedItem *item) const;
+		//! Mark the cell as reachable. Returns false if it was already marked.
+		bool mark(const AllocatedItem *item);
+		/**
+		 * Destroy every cell that wasn't marked since the last sweep, and clear
+		 * the marks of the rest. Returns the number of bytes freed.
+		 **/
+		size_t sweep();
+
+		//! The number of cells currently in use
+		size_t size() const;
+	private:
+		struct Chunk;
+
+		Chunk *new_chunk();
+		Chunk *chunk_of(const void *item) const;
+
+		std::vector<Chunk*> chunks;
+		std::unordered_set<const Chunk*> chunk_set;
+		//! Freed cells below the high water mark, in descending address order
+		std::vector<List*> free_cells;
+		Chunk *current = nullptr;
+		//! Index of the next unused cell in the current chunk
+		size_t bump = 0;
+		size_t in_use = 0;
+	};
+}
+
+#endif
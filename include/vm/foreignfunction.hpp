@@ -0,0 +1,106 @@
+#ifndef SALMON_COMPILER_VM_FOREIGNFUNCTION
+#define SALMON_COMPILER_VM_FOREIGNFUNCTION
+
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <vm/function.hpp>
+
+namespace salmon::vm {
+
+	//! Thrown when a C library or a function in it can't be loaded
+	struct ForeignError : std::runtime_error {
+		explicit ForeignError(const std::string &msg);
+	};
+
+	//! A shared library opened with dlopen, which is closed when the last function from it is gone
+	class SharedLibrary {
+	public:
+		//! @throw ForeignError if the library can't be opened
+		explicit SharedLibrary(const std::string &path);
+		SharedLibrary(const SharedLibrary&) = delete;
+		SharedLibrary &operator=(const SharedLibrary&) = delete;
+		~SharedLibrary();
+
+		//! @throw ForeignError if the library doesn't define the symbol
+		void *symbol(const std::string &name) const;
+		const std::string &path() const;
+	private:
+		std::string _path;
+		void *handle;
+	};
+
+	//! The C types foreign functions can take and return
+	enum class CType : uint8_t {
+		INT32,
+		FLOAT64,
+		BOOL,
+		//! A const char *, which is copied into a const-string when it is returned
+		STRING,
+		//! Only for results, which become empty
+		VOID,
+	};
+
+	//! The most arguments a foreign function can take
+	inline constexpr size_t max_foreign_args = 3;
+
+	//! Calls the C function at address with arguments that have already been checked against its signature
+	using Trampoline = Box(*)(VirtualMachine *vm, void *address, std::span<InternalBox> args);
+
+	/**
+	 * The trampoline for a C signature.
+	 *
+	 * There is one trampoline for every signature of up to max_foreign_args
+	 * arguments, made when Salmon is compiled. Each casts the address to a
+	 * C function pointer of that signature and unboxes the arguments into
+	 * the call, so the platform's calling convention puts them straight
+	 * into registers.
+	 *
+	 * @return the trampoline, or nullptr if there are too many arguments or an argument is VOID
+	 **/
+	Trampoline find_trampoline(CType result, std::span<const CType> args);
+
+	//! A function from a C library
+	class ForeignFunction : public VmFunction {
+	public:
+		ForeignFunction(const vm_ptr<Type> &type, const std::vector<vm_ptr<Symbol>> &lambda_list,
+						std::shared_ptr<SharedLibrary> library, const std::string &c_name,
+						void *address, Trampoline trampoline, const std::vector<Type*> &arg_types);
+
+		/**
+		 * Call the C function.
+		 *
+		 * @throw ArityException if the wrong number of arguments are given
+		 * @throw NoSuchFunction if the arguments don't have the function's types
+		 **/
+		Box operator()(VirtualMachine *vm, std::span<InternalBox> args) override;
+
+		const std::string &c_name() const;
+
+		void print_debug_info() const override;
+		size_t allocated_size() const override;
+	private:
+		std::shared_ptr<SharedLibrary> library;
+		std::string _c_name;
+		void *address;
+		Trampoline trampoline;
+		std::vector<Type*> arg_types;
+	};
+
+	/**
+	 * Make a function calling c_name from the library. The types must be
+	 * int-32, float-64, bool or const-string, and the result may also be Empty
+	 * for a C function returning void.
+	 *
+	 * @throw ForeignError if the library doesn't define c_name, or the signature can't be called
+	 **/
+	vm_ptr<ForeignFunction> import_function(VirtualMachine &vm, const std::shared_ptr<SharedLibrary> &library,
+											const std::string &c_name, const std::vector<Type*> &arg_types,
+											Type *result_type);
+}
+
+#endif
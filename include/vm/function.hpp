@@ -12,10 +12,12 @@
 #include <vm/box.hpp>
 #include <util/prefixtrie.hpp>
 #include <util/cmpunderlyingtype.hpp>
+#include <vm/symbolmap.hpp>
 
 namespace salmon::vm {
 
 	class VirtualMachine;
+	class TypeTable;
 
 	struct ArityException : std::runtime_error {
 
@@ -78,9 +80,13 @@ namespace salmon::vm {
 		const std::optional<std::string> &documentation() const;
 		const std::optional<std::string> &source_file() const;
 		const std::optional<List*> &source_form() const;
+		//! Whether the function only computes its result from its arguments, so calls can be made ahead of time
+		bool pure() const;
+		void pure(bool is_pure);
 	protected:
 		std::vector<Symbol*> _lambda_list;
 		Type *fn_type;
+		bool _pure = false;
 
 		std::optional<std::string> _documentation;
 		std::optional<std::string> _source_file;
@@ -100,23 +106,39 @@ namespace salmon::vm {
 		/**
 		 * Add an implementation for this interface.
 		 *
-		 * This function will overwrite previous implementations
+		 * This function will overwrite previous implementations, unless the
+		 * interface is sealed.
 		 *
 		 * @param fn the new implementation
 		 * @return whether the new implementation was added.
 		 */
 		bool add_impl(const vm_ptr<VmFunction> &fn);
+		//! Same as add_impl(fn), but remembers whether the types match in the given table
+		bool add_impl(const vm_ptr<VmFunction> &fn, TypeTable &types);
+		//! The implementation for the given argument types, or nullptr if there isn't one
+		VmFunction *find_impl(const std::vector<Type*> &arg_types) const;
+		//! Changes every time an implementation is added or replaced
+		uint64_t version() const;
+		//! Stop implementations from being added or replaced, so calls to them can be made ahead of time
+		void seal();
+		bool sealed() const;
 
 		void get_roots(const std::function<void(AllocatedItem*)> &) const override;
 		void print_debug_info() const override;
 		size_t allocated_size() const override;
 	private:
+		//! Add an implementation that has already been checked against the interface
+		void insert_impl(const vm_ptr<VmFunction> &fn);
+
 		PrefixTrie<Type*, VmFunction*, cmpUnderlyingType<Type>> functions;
+		uint64_t impl_version = 0;
+		bool _sealed = false;
 	};
 
 	class FunctionTable {
 	public:
-		FunctionTable();
+		//! Types are compared using the given table, which should outlive this one
+		explicit FunctionTable(TypeTable &types);
 		//TODO: figure out mechanicsm for changing the signature of functions at rutime.
 		/**
 		 * Adds or overwrites the function with the given name.
@@ -143,10 +165,13 @@ namespace salmon::vm {
 		bool new_interface(const vm_ptr<Symbol> &name, const vm_ptr<InterfaceFunction> &fn);
 
 		std::optional<vm_ptr<VmFunction>> get_fn(const vm_ptr<Symbol> &name) const;
+		//! Same as get_fn, but without making a vm_ptr. Returns nullptr if there is no such function.
+		VmFunction *find_fn(const Symbol &name) const;
 
 	private:
-		std::map<vm_ptr<Symbol>, vm_ptr<VmFunction>,cmpUnderlyingType<Symbol>> functions;
-		std::map<vm_ptr<Symbol>, vm_ptr<InterfaceFunction>, cmpUnderlyingType<Symbol>> interfaces;
+		TypeTable &types;
+		SymbolMap<vm_ptr<VmFunction>> functions;
+		SymbolMap<vm_ptr<InterfaceFunction>> interfaces;
 	};
 }
 
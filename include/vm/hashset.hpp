@@ -0,0 +1,41 @@
+#ifndef SALMON_COMPILER_VM_HASHSET
+#define SALMON_COMPILER_VM_HASHSET
+
+#include <compare>
+
+#include <vm/box.hpp>
+#include <vm/empty.hpp>
+#include <util/swisstable.hpp>
+
+namespace salmon::vm {
+
+	//! Set of values, compared and hashed structurally
+	struct HashSet : public AllocatedItem {
+		using Table = SwissTable<InternalBox, Empty>;
+
+		HashSet(size_t size);
+
+		//! Add the item to the set. Returns false if an equal item was already present.
+		bool insert(const Box &item);
+		bool insert(const InternalBox &item);
+		bool contains(const InternalBox &item) const;
+		//! Remove the item from the set. Returns true if it was present.
+		bool erase(const InternalBox &item);
+
+		Table::const_iterator begin() const;
+		Table::const_iterator end() const;
+
+		size_t size() const;
+
+		void print_debug_info() const override;
+		void get_roots(const std::function<void(AllocatedItem*)>&) const override;
+		size_t allocated_size() const override;
+
+		std::partial_ordering operator<=>(const HashSet &other) const;
+		bool operator==(const HashSet &other) const;
+	private:
+		Table items;
+	};
+}
+
+#endif
@@ -2,14 +2,21 @@
 #define SALMON_COMPILER_VM_MEMORY
 
 #include <vector>
+#include <type_traits>
+#include <new>
 
 #include <unordered_set>
 
 #include <vm/allocateditem.hpp>
 #include <vm/vm_ptr.hpp>
+#include <vm/symbolindex.hpp>
+#include <vm/consarena.hpp>
 
 namespace salmon::vm {
 
+	struct Box;
+	struct InternalBox;
+
 	class MemoryManager {
 
 	public:
@@ -33,19 +40,34 @@ namespace salmon::vm {
 
 		template<typename T, typename ... ConstructorArgs>
 		vm_ptr<T> allocate_obj(ConstructorArgs... args) {
-			T *chunk = new T(args...);
+			T *chunk;
+			if constexpr (std::is_same<T, List>::value) {
+				chunk = new (cons_cells.allocate()) T(args...);
+			} else {
+				chunk = new T(args...);
+				this->allocated.insert(chunk);
+			}
 			total_allocated += sizeof(T);
-			this->allocated.insert(chunk);
 			vm_ptr<T> thing(chunk, roots);
 			return thing;
 		}
 
+		//! Allocate a list holding the given items, with its cells next to each other in memory.
+		vm_ptr<List> allocate_list(const std::vector<Box> &items);
+		//! Allocate a list of `count` cells that all hold `fill`, for the caller to fill in.
+		vm_ptr<List> allocate_list(size_t count, const InternalBox &fill);
+
 		void do_gc();
+
+		//! The index of all symbols interned in packages using this memory manager
+		SymbolIndex &symbol_index();
 	private:
 		std::unordered_set<AllocatedItem*> allocated;
 		//! reference count of allocated objects kept track of using vm_ptrs
 		std::unordered_map<AllocatedItem*, unsigned int> roots;
-		size_t total_allocated;
+		size_t total_allocated = 0;
+		SymbolIndex symbols;
+		ConsArena cons_cells;
 	};
 }
 #endif
@@ -26,6 +26,7 @@ namespace salmon::vm {
 		Package& operator=(const Package&) = delete;
 
 		Package(Package&&) = default;
+		~Package();
 
 		const std::string name;
 		//! the memory manager that the package should use to allocate new symbols
@@ -51,6 +52,9 @@ namespace salmon::vm {
 	private:
 		Package();
 
+		//! Create a new symbol in this package and add it to the symbol index
+		vm_ptr<Symbol> new_symbol(const std::string &name);
+
 		std::optional<vm_ptr<Symbol>> find_external_symbol(const std::string_view) const;
 
 		std::map<std::string, vm_ptr<Symbol>,std::less<>> interned;
@@ -0,0 +1,79 @@
+#ifndef SALMON_COMPILER_VM_PRINTER
+#define SALMON_COMPILER_VM_PRINTER
+
+#include <array>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+#include <vm/box.hpp>
+#include <vm/hashset.hpp>
+
+namespace salmon::vm {
+
+	class VirtualMachine;
+
+	/**
+	 * Writes the readable representation of values into a buffer that is
+	 * reused between calls, and hands it to the output stream in large pieces.
+	 *
+	 * Values of builtin types are printed directly, with nested containers
+	 * walked using an explicit stack. Values of any other type go through the
+	 * print interface, which can print with this printer again.
+	 **/
+	class Printer {
+	public:
+		Printer(VirtualMachine &vm, std::ostream &out);
+		Printer(const Printer&) = delete;
+		~Printer();
+
+		/**
+		 * Add the printed value to the buffer. The buffer is written out
+		 * whenever it grows past 64 KiB, and otherwise kept for the next value
+		 * until flush() is called.
+		 * Checks for interrupts between items, and writes out what was printed
+		 * before an exception is passed on.
+		 **/
+		void print(const InternalBox &value);
+		//! Write out everything in the buffer
+		void flush();
+		//! The stream the buffer is written out to
+		std::ostream &output() const;
+		//! Write out what is buffered, then send later output to out, which has to outlive its use
+		void output(std::ostream &out);
+	private:
+		//! A container being printed
+		struct Frame {
+			char close;
+			bool first;
+			const List *cell;
+			const Vector *vector;
+			size_t index;
+			const HashSet *set;
+			std::optional<HashSet::Table::const_iterator> set_pos;
+
+			//! The next item to print, or nullptr when there are none left
+			const InternalBox *next();
+		};
+
+		void print_item(const InternalBox &value);
+		void print_symbol(const Symbol &symbol);
+		void print_through_interface(const InternalBox &value);
+
+		template<typename T>
+		void print_number(T number);
+
+		VirtualMachine &vm;
+		std::ostream *out;
+		std::string buffer;
+		std::vector<Frame> stack;
+		//! The builtin type of each kind of item, by variant index. Looked up on first use.
+		std::array<Type*, std::variant_size_v<BoxVariant>> builtin_types;
+		bool have_types;
+	};
+}
+
+#endif
@@ -0,0 +1,131 @@
+#ifndef SALMON_COMPILER_VM_SERIALIZE
+#define SALMON_COMPILER_VM_SERIALIZE
+
+#include <vector>
+#include <span>
+#include <optional>
+#include <ostream>
+#include <memory>
+#include <string_view>
+#include <cstddef>
+#include <cstdint>
+
+#include <vm/box.hpp>
+
+namespace salmon::vm {
+
+	class VirtualMachine;
+
+	/**
+	 * Compact binary encoding of values, used to cache reader output.
+	 *
+	 * The data is a header followed by one record per top level value, each
+	 * prefixed by its size, and a zero size at the end. A record can be decoded
+	 * on its own: anything that appears more than once in a value (symbols,
+	 * strings, lists, list tails, vectors and sets) is stored the first time it
+	 * is seen, and afterwards as a reference to that offset in the record. This
+	 * keeps shared structure shared, and lets vectors and lists hold themselves.
+	 * Sets are built once their items are complete, so a cycle can't go through
+	 * or be nested in a set, just like in the VM where such a set couldn't hash
+	 * its items.
+	 *
+	 * Symbols are stored by package and name and are re-interned when read back.
+	 * Items are given the VM's builtin type for what they hold when read back.
+	 **/
+	namespace serialize {
+		//! Data written with a different version is rejected when read
+		constexpr uint16_t VERSION = 2;
+
+		class Encoder;
+
+		//! Encodes values one record at a time and writes them to a stream
+		class Writer {
+		public:
+			//! Writes the header to the stream
+			explicit Writer(std::ostream &out);
+			~Writer();
+
+			void write(const Box &value);
+			void write(const InternalBox &value);
+			//! Write the end marker. Without it the data is rejected as truncated.
+			void finish();
+		private:
+			std::ostream &out;
+			std::unique_ptr<Encoder> encoder;
+			std::vector<std::byte> buffer;
+		};
+
+		//! Encode the values into a byte buffer
+		std::vector<std::byte> write_values(std::span<const Box> values);
+
+		/**
+		 * Decode values written by write_values or a Writer.
+		 * Returns std::nullopt if the data is malformed, from another version of
+		 * the format, or refers to a package that doesn't exist in the VM.
+		 **/
+		std::optional<std::vector<Box>> read_values(std::span<const std::byte> data, VirtualMachine &vm);
+
+		/**
+		 * A view of a value in encoded data, which reads it in place.
+		 * References are followed transparently, so a view always looks at the
+		 * value itself. It is only valid as long as the data it points into.
+		 **/
+		class View {
+		public:
+			enum class Kind { INT32, FLOAT64, BOOL, EMPTY, SYMBOL, STRING, LIST, VECTOR, SET, INT64, UINT64, FLOAT32 };
+
+			Kind kind() const;
+			int32_t int32() const;
+			double float64() const;
+			int64_t int64() const;
+			uint64_t uint64() const;
+			float float32() const;
+			bool boolean() const;
+			//! The contents of a string, or the name of a symbol
+			std::string_view string() const;
+			//! The package of a symbol, if it has one
+			std::optional<std::string_view> package() const;
+
+			//! The number of items in a list, vector or set
+			size_t size() const;
+			//! Views of the items in a list, vector or set
+			std::vector<View> items() const;
+
+			/**
+			 * Decode the value into the VM, including whatever it refers to outside
+			 * of itself. Returns std::nullopt if a symbol's package doesn't exist.
+			 **/
+			std::optional<Box> materialize(VirtualMachine &vm) const;
+		private:
+			friend class Archive;
+			View(std::span<const std::byte> record, uint32_t offset, uint32_t index);
+
+			std::span<const std::byte> record;
+			//! Offset of the value's definition in the record
+			uint32_t offset;
+			//! For lists, the number of cells to skip from the start of the definition
+			uint32_t index;
+		};
+
+		/**
+		 * Random access to the records in encoded data, without copying it.
+		 * Every record is checked when the archive is opened, but nothing is
+		 * decoded into the VM until a view is materialized.
+		 **/
+		class Archive {
+		public:
+			//! Returns std::nullopt if the data is malformed or from another version
+			static std::optional<Archive> open(std::span<const std::byte> data);
+
+			size_t size() const;
+			View operator[](size_t index) const;
+		private:
+			Archive() = default;
+			friend std::optional<std::vector<Box>> read_values(std::span<const std::byte>, VirtualMachine&);
+
+			std::vector<std::span<const std::byte>> records;
+		};
+	}
+}
+
+#endif
@@ -4,6 +4,7 @@
 #include <compare>
 #include <string>
 #include <set>
+#include <cstdint>
 #include <ostream>
 #include <optional>
 
@@ -19,7 +20,18 @@ namespace salmon::vm {
 		// as it means packages can't be moved once symbols have
 		// been interned in them *unless* the symbol pointers are updated.
 		Package* package;
-
+		/**
+		 * Unique id given to the symbol when it is created.
+		 *
+		 * Symbols interned in a package get a dense id from the VM's SymbolIndex,
+		 * which can be used to index flat tables. Other symbols get an id with the
+		 * UNINDEXED bit set, which is still unique but can't be used as an index.
+		 **/
+		const uint32_t id;
+
+		static constexpr uint32_t UNINDEXED = 1u << 31;
+
+		Symbol(const std::string&, Package*, uint32_t id);
 		Symbol(const std::string&, Package*);
 		Symbol(const std::string&);
 		Symbol(const std::string&&);
@@ -30,6 +42,9 @@ namespace salmon::vm {
 		~Symbol();
 		void operator=(const Symbol&) = delete;
 
+		//! Check if the symbol's id is an index into the VM's SymbolIndex
+		bool indexed() const;
+
 		size_t allocated_size() const override;
 		void print_debug_info() const override;
 		std::partial_ordering operator<=>(const Symbol &) const;
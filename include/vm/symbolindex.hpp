@@ -0,0 +1,41 @@
+#ifndef SALMON_COMPILER_VM_SYMBOLINDEX
+#define SALMON_COMPILER_VM_SYMBOLINDEX
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace salmon::vm {
+
+	struct Symbol;
+
+	/**
+	 * Maps the dense ids of interned symbols back to the symbols themselves.
+	 *
+	 * Ids are handed out in order and never reused, so tables indexed by
+	 * symbol id stay valid after a symbol is removed.
+	 **/
+	class SymbolIndex {
+	public:
+		SymbolIndex() = default;
+		SymbolIndex(const SymbolIndex&) = delete;
+
+		//! The id the next symbol added to the index will receive
+		uint32_t next_id() const;
+
+		//! Record the symbol in the index. Its id must be next_id().
+		void add(Symbol *symbol);
+		//! Remove the symbol from the index. Its id won't be handed out again.
+		void remove(const Symbol &symbol);
+
+		//! Get the symbol with the given id, or nullptr if it has been removed
+		Symbol *operator[](uint32_t id) const;
+
+		//! the number of ids handed out so far
+		size_t size() const;
+	private:
+		std::vector<Symbol*> symbols;
+	};
+}
+
+#endif
@@ -0,0 +1,100 @@
+#ifndef SALMON_COMPILER_VM_SYMBOLMAP
+#define SALMON_COMPILER_VM_SYMBOLMAP
+
+#include <vector>
+#include <limits>
+#include <utility>
+#include <unordered_map>
+
+#include <vm/vm_ptr.hpp>
+#include <vm/symbol.hpp>
+#include <util/identity.hpp>
+
+namespace salmon::vm {
+
+	/**
+	 * Map from symbols to values, stored as a flat table indexed by symbol id.
+	 *
+	 * Looking up an interned symbol is two array loads. Symbols that aren't in the
+	 * SymbolIndex (i.e. uninterned symbols) fall back to a hash table.
+	 * The map keeps a vm_ptr to each key, so keys stay alive as long as the map does.
+	 **/
+	template<typename V>
+	class SymbolMap {
+	public:
+		V *find(const Symbol &symbol) {
+			const uint32_t pos = position(symbol);
+			return pos == EMPTY ? nullptr : &entries[pos].second;
+		}
+
+		const V *find(const Symbol &symbol) const {
+			const uint32_t pos = position(symbol);
+			return pos == EMPTY ? nullptr : &entries[pos].second;
+		}
+
+		bool contains(const Symbol &symbol) const {
+			return position(symbol) != EMPTY;
+		}
+
+		/**
+		 * Add the value if the symbol isn't in the map.
+		 *
+		 * @return the value stored for the symbol, and whether the given value was added.
+		 **/
+		std::pair<V*, bool> try_emplace(const vm_ptr<Symbol> &symbol, const V &value) {
+			if(V *found = find(*symbol)) {
+				return std::make_pair(found, false);
+			}
+			const uint32_t pos = static_cast<uint32_t>(entries.size());
+			entries.emplace_back(symbol, value);
+			if(symbol->indexed()) {
+				if(symbol->id >= slots.size()) {
+					slots.resize(static_cast<size_t>(symbol->id) + 1, EMPTY);
+				}
+				slots[symbol->id] = pos;
+			} else {
+				unindexed.emplace(symbol.get(), pos);
+			}
+			return std::make_pair(&entries.back().second, true);
+		}
+
+		size_t size() const {
+			return entries.size();
+		}
+
+		typename std::vector<std::pair<vm_ptr<Symbol>, V>>::const_iterator begin() const {
+			return entries.begin();
+		}
+
+		typename std::vector<std::pair<vm_ptr<Symbol>, V>>::const_iterator end() const {
+			return entries.end();
+		}
+
+	private:
+		static constexpr uint32_t EMPTY = std::numeric_limits<uint32_t>::max();
+
+		uint32_t position(const Symbol &symbol) const {
+			uint32_t pos = EMPTY;
+			if(symbol.indexed()) {
+				if(symbol.id < slots.size()) {
+					pos = slots[symbol.id];
+				}
+			} else if(auto place = unindexed.find(const_cast<Symbol*>(&symbol));
+					  place != unindexed.end()) {
+				pos = place->second;
+			}
+			// Ids are only unique within a VM, so make sure it is actually the same symbol:
+			if(pos != EMPTY && entries[pos].first.get() != &symbol) {
+				return EMPTY;
+			}
+			return pos;
+		}
+
+		//! symbol id -> position in entries
+		std::vector<uint32_t> slots;
+		std::unordered_map<Symbol*, uint32_t, hashId<Symbol>> unindexed;
+		std::vector<std::pair<vm_ptr<Symbol>, V>> entries;
+	};
+}
+
+#endif
@@ -15,6 +15,8 @@
 #include <vm/memory.hpp>
 #include <vm/typespec.hpp>
 #include <util/cmpunderlyingtype.hpp>
+#include <util/swisstable.hpp>
+#include <vm/symbolmap.hpp>
 
 namespace salmon::vm {
 
@@ -73,6 +75,8 @@ namespace salmon::vm {
 		bool match_args(const std::vector<vm_ptr<Type>> &type_list) const;
 
 		const std::vector<Type*> arg_types() const;
+		const TypeSpecification &args() const;
+		const TypeSpecification &returns() const;
 		bool equivalent_to(const FunctionType &other) const;
 
 		size_t size() const override;
@@ -130,11 +134,40 @@ namespace salmon::vm {
 
 		TypePtr make_primitive(const vm_ptr<Symbol> &name, const std::string &doc, std::size_t size);
 
+		/**
+		 * Check if the function type specific fits the function type general,
+		 * as FunctionType::match does.
+		 *
+		 * Function types from get_fn_type are only made once, so the result is
+		 * remembered for each pair of types. The table keeps the types alive,
+		 * so an entry can't be reused by a different type at the same address.
+		 **/
+		bool fn_match(const Type *general, const Type *specific);
+		//! Type::equivalent_to, remembered the same way as fn_match
+		bool equivalent(const Type *first, const Type *second);
+
 	private:
+		using TypePair = std::pair<const Type*, const Type*>;
+		struct TypePairHash {
+			size_t operator()(const TypePair &pair) const;
+		};
+		struct MatchResult {
+			TypePtr first;
+			TypePtr second;
+			bool result;
+		};
+		using MatchTable = SwissTable<TypePair, MatchResult, TypePairHash>;
+
+		//! Look up the pair in the table, or compute and remember the result
+		template<typename Check>
+		bool remember(MatchTable &table, const Type *first, const Type *second, Check check);
+
 		MemoryManager &mem_manager;
 
-		std::unordered_map<vm_ptr<Symbol>, vm_ptr<Type>> named_types;
+		SymbolMap<vm_ptr<Type>> named_types;
 		std::set<TypePtr, cmpUnderlyingType<Type>> functions;
+		MatchTable fn_matches;
+		MatchTable equivalences;
 	};
 }
 
@@ -1,15 +1,19 @@
 #ifndef SALMON_VM_TYPESPEC
 #define SALMON_VM_TYPESPEC
 
+#include <cstddef>
+#include <cstdint>
 #include <vector>
 #include <variant>
 #include <optional>
-#include <map>
+#include <span>
+#include <unordered_map>
 #include <memory>
 #include <ostream>
 
 #include <vm/vm_ptr.hpp>
 #include <vm/symbol.hpp>
+#include <util/identity.hpp>
 
 namespace salmon::vm {
 	struct Type;
@@ -29,21 +33,41 @@ namespace salmon::vm {
 		bool operator>=(const VariableProperties &other) const;
 		bool operator<=(const VariableProperties &other) const;
 	private:
+		friend class TypeSpecification;
 		uint8_t properties;
 
 		static const uint8_t CONSTANT_MASK = 1;
 		static const uint8_t STATIC_MASK = 1 << 1;
 	};
 
+	/**
+	 * An immutable list of types and type parameters, such as the argument
+	 * list of a function.
+	 *
+	 * Everything lives in one block: a slot per element, holding either a
+	 * Type* or the number of a parameter, followed by the parameter symbols,
+	 * the position each parameter first appears at, and the property byte of
+	 * each element. Specifications with only a few elements keep the block
+	 * inline, so copying, combining and matching them doesn't touch the heap.
+	 *
+	 * Parameters are numbered in the order they first appear, so two
+	 * specifications with the same shape have the same slots no matter what
+	 * their parameters are called.
+	 **/
 	class TypeSpecification {
 	public:
+		TypeSpecification(const TypeSpecification &other);
+		TypeSpecification(TypeSpecification &&other) noexcept;
+		TypeSpecification &operator=(const TypeSpecification &) = delete;
+		TypeSpecification &operator=(TypeSpecification &&) = delete;
+		~TypeSpecification();
 
 		//! Check if the given types conform to the specifictation
-		bool matches(const std::vector<vm_ptr<Type>> &type_list) const;
+		bool matches(std::span<const vm_ptr<Type>> type_list) const;
 		bool matches(const TypeSpecification &other) const;
 
-		std::optional<std::map<vm_ptr<Symbol>,vm_ptr<Type>>>
-		match_symbols(const std::vector<vm_ptr<Type>> &type_list) const;
+		std::optional<std::unordered_map<vm_ptr<Symbol>,vm_ptr<Type>,hashId<Symbol>>>
+		match_symbols(std::span<const vm_ptr<Type>> type_list) const;
 
 		const std::vector<Type*> types() const;
 
@@ -55,6 +79,21 @@ namespace salmon::vm {
 		//! Get the number of types:
 		size_t size() const;
 
+		//! Get the number of distinct parameters. The accessors below are
+		//! used while matching, so their arguments aren't range checked.
+		size_t parameter_count() const;
+		//! The symbol naming the nth parameter, in order of first appearance
+		Symbol *parameter(size_t index) const;
+		//! The position the nth parameter first appears at
+		size_t parameter_position(size_t index) const;
+		//! The type at the given position, or nullptr if it is a parameter
+		Type *type_at(size_t position) const;
+		//! The number of the parameter at the given position, which must not hold a type
+		size_t parameter_index(size_t position) const;
+
+		//! Hash of the shape of the specification: equivalent specs hash the same
+		size_t hash() const;
+
 		void get_roots(const std::function<void(AllocatedItem*)>&) const;
 
 		bool equivalentTo(const TypeSpecification &other) const;
@@ -69,22 +108,37 @@ namespace salmon::vm {
 		friend std::ostream &operator<<(std::ostream &out, const TypeSpecification& spec);
 	private:
 		friend class SpecBuilder;
-		TypeSpecification(const std::map<vm_ptr<Symbol>, std::vector<size_t>> &params,
-						  const std::vector<std::pair<vm_ptr<Type>, size_t>> &concrete_types,
-						  const std::vector<VariableProperties> &properties);
-		TypeSpecification(std::map<Symbol*, std::vector<size_t>> &&params,
-						  std::vector<std::pair<Type*, size_t>> &&concrete_types,
-						  std::vector<VariableProperties> &&properties);
-		// TODO: investigate how efficent this storage config is:
-
-		//! bare types are specified with specific symbol, i.e. A
-		const std::map<Symbol*,std::vector<size_t>> parameters;
-		// TODO: allow non-concrete types in type specifications
-		//! Indexes of types that must be the same
-		const std::vector<std::pair<Type*,size_t>> concrete_types;
-		const std::vector<VariableProperties> properties;
-
-		const bool is_concrete;
+		//! A Type* when the low bit is clear, otherwise a parameter number shifted left by one
+		using Slot = uintptr_t;
+		//! Blocks up to this size are stored inside the specification
+		static constexpr size_t INLINE_BYTES = 96;
+
+		TypeSpecification(size_t size, size_t num_params);
+
+		static Slot type_slot(const Type *type);
+		static Slot param_slot(size_t index);
+		static bool is_param(Slot slot);
+		static size_t param_index(Slot slot);
+
+		//! Set up the block for the given number of elements and parameters
+		void allocate();
+		//! Fill in is_concrete and the hash once the block is written
+		void finish();
+		//! Order specifications by size, then slots, properties and parameter names
+		int compare(const TypeSpecification &other) const;
+
+		Slot *slots() const;
+		Symbol **symbols() const;
+		uint32_t *firsts() const;
+		VariableProperties *properties() const;
+		size_t block_size() const;
+
+		uint32_t length;
+		uint32_t num_params;
+		size_t shape_hash;
+		bool is_concrete;
+		std::byte *block;
+		alignas(Slot) std::byte inline_block[INLINE_BYTES];
 	};
 
 	class SpecBuilder {
@@ -101,13 +155,8 @@ namespace salmon::vm {
 		TypeSpecification build();
 
 	private:
-		size_t num_elems = 0;
-
-		//! bare types are specified with specific symbol, i.e. A
-		std::map<vm_ptr<Symbol>,std::vector<size_t>> parameters;
-		//! Indexes of types that must be the same
-		std::vector<std::pair<vm_ptr<Type>,size_t>> concrete_types;
-		// TODO: allow non-concrete types in type specifications
+		//! The elements in order; each one is either a parameter or a type
+		std::vector<std::variant<vm_ptr<Symbol>, vm_ptr<Type>>> elements;
 		std::vector<VariableProperties> properties;
 	};
 }
@@ -1,6 +1,8 @@
 #ifndef SALMON_COMPILER_VM_VM
 #define SALMON_COMPILER_VM_VM
 
+#include <atomic>
+#include <stdexcept>
 #include <unordered_map>
 #include <string>
 #include <typeinfo>
@@ -10,10 +12,16 @@
 #include <vm/type.hpp>
 #include <vm/package.hpp>
 #include <vm/function.hpp>
+#include <vm/printer.hpp>
 #include <salmon/config.hpp>
 
 namespace salmon::vm {
 
+	//! Thrown at a safepoint when the VM has been interrupted
+	struct Interrupted : std::runtime_error {
+		Interrupted();
+	};
+
 	class VirtualMachine {
 	public:
 		VirtualMachine(const Config &config, const std::string &base_package);
@@ -61,6 +69,24 @@ namespace salmon::vm {
 			return vm_ptr;
 		}
 
+		/**
+		 * Ask the code running in the VM to stop at its next safepoint.
+		 * Safe to call from other threads and from signal handlers.
+		 **/
+		void interrupt();
+		//! Forget an interrupt that hasn't reached a safepoint yet
+		void clear_interrupt();
+		//! Throw Interrupted if the VM was interrupted since the last safepoint
+		void safepoint() {
+			if(interrupted.load(std::memory_order_relaxed)) [[unlikely]] {
+				stop_at_safepoint();
+			}
+		}
+
+		const Config &config() const {
+			return _config;
+		}
+
 		// //! Call function name with args args:
 		// Box dispatch_function(vm_ptr<Symbol> &name, vm_ptr<List> &args);
 		// //! register the function with the given name.
@@ -72,7 +98,12 @@ namespace salmon::vm {
 		TypeTable type_table;
 		FunctionTable fn_table;
 		std::unordered_map<std::string, Package> packages;
+		//! Used by the print interface, writes to standard output
+		Printer printer;
 	private:
+		[[noreturn]] void stop_at_safepoint();
+
+		std::atomic<bool> interrupted;
 		Config _config;
 		// TODO: store actual package:
 		std::string base_package_name;
@@ -22,6 +22,17 @@ namespace salmon::compiler {
 	CountingStreamBuffer::CountingStreamBuffer(std::istream& istream) :
 		CountingStreamBuffer(istream.rdbuf()) {}
 
+	CountingStreamBuffer::CountingStreamBuffer(std::streambuf* sbuf, const salmon::meta::position_info &start,
+											   std::streamsize file_pos) :
+		streamBuf_(sbuf),
+		lineNumber_(start.line),
+		lastLineNumber_(start.line),
+		column_(start.column),
+		prevColumn_(start.column - 1),
+		filePos_(file_pos)
+	{
+	}
+
 	// Get current line number
 	unsigned int CountingStreamBuffer::lineNumber() const  {
 		return lineNumber_;
@@ -0,0 +1,474 @@
+#include <array>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <optional>
+#include <set>
+#include <sstream>
+
+#include <compiler/aot.hpp>
+#include <compiler/bytecode.hpp>
+#include <compiler/interpreter.hpp>
+#include <vm/builtinfunction.hpp>
+#include <vm/package.hpp>
+#include <vm/vmstdlib.hpp>
+
+namespace salmon::compiler {
+
+	std::string c_name(const vm::Symbol &name) {
+		std::string result = "salmon_";
+		for(const char c : name.name) {
+			if(c == '-') {
+				result += '_';
+			} else if(std::isalnum(static_cast<unsigned char>(c)) || c == '_') {
+				result += c;
+			} else {
+				throw CompileError("The name " + name.name + " can't be used in C", &name);
+			}
+		}
+		return result;
+	}
+
+	namespace {
+		using Builtin2 = vm::BuiltinFunction<vm::InternalBox, vm::InternalBox>;
+
+		//! A builtin interface that is a C operator for the standard library's implementations
+		struct Operator {
+			const char *name;
+			const char *op;
+			bool comparison;
+		};
+
+		constexpr std::array<Operator, 6> operators = {{
+			{ "add", "+", false },
+			{ "subtract", "-", false },
+			{ "multiply", "*", false },
+			{ "divide", "/", false },
+			{ "less", "<", true },
+			{ "greater", ">", true },
+		}};
+
+		template<typename T>
+		bool is_stdlib(const std::string &name, const Builtin2::FunctionType fn) {
+			return (name == "add" && fn == &vm::add<T>)
+				|| (name == "subtract" && fn == &vm::subtract<T>)
+				|| (name == "multiply" && fn == &vm::multiply<T>)
+				|| (name == "divide" && fn == &vm::divide<T>)
+				|| (name == "less" && fn == &vm::less<T>)
+				|| (name == "greater" && fn == &vm::greater<T>);
+		}
+
+		//! The types values can have in C, which each have a letter for the names of the variables holding them
+		class ValueTypes {
+		public:
+			explicit ValueTypes(vm::VirtualMachine &vm) :
+				types{{
+					{ vm.get_builtin_type<int32_t>().get(), "int32_t", 'i' },
+					{ vm.get_builtin_type<double>().get(), "double", 'd' },
+					{ vm.get_builtin_type<bool>().get(), "bool", 'b' },
+					{ vm.get_builtin_type<vm::StaticString>().get(), "struct salmon_string", 's' },
+					{ vm.get_builtin_type<vm::Symbol>().get(), "struct salmon_symbol", 'y' },
+				}} {}
+
+			//! Index of the type, or types.size() if it has no C equivalent
+			size_t index(const vm::Type *type) const {
+				size_t i = 0;
+				while(i < types.size() && types[i].type != type) {
+					i++;
+				}
+				return i;
+			}
+
+			bool supported(const vm::Type *type) const {
+				return index(type) < types.size();
+			}
+
+			const char *c_type(const vm::Type *type) const {
+				return types[index(type)].c_type;
+			}
+
+			char letter(const vm::Type *type) const {
+				return types[index(type)].letter;
+			}
+
+			const vm::Type *int32() const {
+				return types[0].type;
+			}
+			const vm::Type *float64() const {
+				return types[1].type;
+			}
+			const vm::Type *boolean() const {
+				return types[2].type;
+			}
+
+		private:
+			struct Entry {
+				const vm::Type *type;
+				const char *c_type;
+				char letter;
+			};
+			std::array<Entry, 5> types;
+		};
+
+		std::string type_name(const vm::Type *type) {
+			std::ostringstream out;
+			out << *type;
+			return out.str();
+		}
+
+		//! A C string literal, with everything but printable characters escaped
+		std::string string_literal(const std::string &contents) {
+			std::ostringstream out;
+			out << '"';
+			for(const char c : contents) {
+				const unsigned char byte = static_cast<unsigned char>(c);
+				if(std::isprint(byte) && c != '"' && c != '\\' && c != '?') {
+					out << c;
+				} else {
+					// Always three digits, so a digit after it isn't taken as part of the escape
+					out << '\\' << static_cast<char>('0' + (byte >> 6))
+						<< static_cast<char>('0' + ((byte >> 3) & 7)) << static_cast<char>('0' + (byte & 7));
+				}
+			}
+			out << '"';
+			return out.str();
+		}
+
+		std::string salmon_string(const std::string &contents) {
+			return "(struct salmon_string){" + std::to_string(contents.size()) + ", " + string_literal(contents) + "}";
+		}
+
+		struct Signature {
+			const AotFunction *fn;
+			const BytecodeFunction *bytecode;
+			std::string name;
+		};
+
+		class FunctionTranslator {
+		public:
+			FunctionTranslator(const Signature &self, const std::vector<Signature> &signatures,
+							   const ValueTypes &types, Compiler &compiler) :
+				self{self}, signatures{signatures}, types{types}, compiler{compiler},
+				chunk{self.bytecode->chunk()} {}
+
+			void translate(std::ostream &out) {
+				for(size_t offset = 0; offset < chunk.code.size(); ) {
+					const Opcode op = static_cast<Opcode>(chunk.code[offset]);
+					const size_t next = offset + 1 + (has_operand(op) ? sizeof(uint32_t) : 0);
+					if(const auto label = labels.find(offset); label != labels.end()) {
+						if(stack && *stack != label->second) {
+							throw CompileError("The branches of an if in " + self.fn->name->name
+											   + " have different types", self.fn->name);
+						}
+						stack = label->second;
+						body << "L" << offset << ":;\n";
+					}
+					if(stack) {
+						translate_instruction(op, offset);
+					}
+					offset = next;
+				}
+				out << prototype() << " {\n";
+				for(const auto &[slot, type] : variables) {
+					out << '\t' << types.c_type(type) << ' ' << variable(slot, type) << ";\n";
+				}
+				if(loops) {
+					out << "start:\n";
+				}
+				out << body.str() << "}\n";
+			}
+
+			std::string prototype() const {
+				std::ostringstream out;
+				out << types.c_type(self.fn->result_type) << ' ' << self.name << '(';
+				for(size_t i = 0; i < self.fn->arg_types.size(); i++) {
+					out << (i == 0 ? "" : ", ") << types.c_type(self.fn->arg_types[i]) << " a" << i;
+				}
+				out << (self.fn->arg_types.empty() ? "void)" : ")");
+				return out.str();
+			}
+
+		private:
+			using Stack = std::vector<const vm::Type*>;
+
+			void translate_instruction(const Opcode op, const size_t offset) {
+				switch(op) {
+				case Opcode::POP:
+					stack->pop_back();
+					return;
+				case Opcode::PUSHI:
+					push_constant(chunk.constants[chunk.operand(offset)].bare());
+					return;
+				case Opcode::PUSHL: {
+					const uint32_t arg = chunk.operand(offset);
+					assign(push(self.fn->arg_types[arg]), "a" + std::to_string(arg));
+					return;
+				}
+				case Opcode::JMP:
+					jump_to(chunk.operand(offset));
+					body << "\tgoto L" << chunk.operand(offset) << ";\n";
+					stack.reset();
+					return;
+				case Opcode::JMP_F: {
+					const vm::Type *test = stack->back();
+					const size_t slot = stack->size() - 1;
+					stack->pop_back();
+					// Only false and empty are false, and empty has no C type
+					if(test == types.boolean()) {
+						jump_to(chunk.operand(offset));
+						body << "\tif(!" << variable(slot, test) << ") goto L" << chunk.operand(offset) << ";\n";
+					}
+					return;
+				}
+				case Opcode::RETURN:
+					if(stack->back() != self.fn->result_type) {
+						throw CompileError(self.fn->name->name + " returns a " + type_name(stack->back())
+										   + ", but its signature returns a " + type_name(self.fn->result_type),
+										   self.fn->name);
+					}
+					body << "\treturn " << variable(stack->size() - 1, stack->back()) << ";\n";
+					stack.reset();
+					return;
+				default:
+					// Every other instruction is a call
+					call(chunk.calls[chunk.operand(offset)], op == Opcode::TAILCALL);
+					return;
+				}
+			}
+
+			void call(const CallInfo &call, const bool tail) {
+				const size_t first = stack->size() - call.num_args;
+				const Stack arg_types(stack->begin() + static_cast<ptrdiff_t>(first), stack->end());
+				std::string args;
+				for(size_t i = 0; i < call.num_args; i++) {
+					args += (i == 0 ? "" : ", ") + variable(first + i, arg_types[i]);
+				}
+				if(const Signature *callee = find_signature(*call.name)) {
+					check_args(*callee, call, arg_types);
+					if(tail && callee == &self) {
+						// The arguments are all in stack variables, so they can be assigned in any order
+						for(size_t i = 0; i < call.num_args; i++) {
+							body << "\ta" << i << " = " << variable(first + i, arg_types[i]) << ";\n";
+						}
+						body << "\tgoto start;\n";
+						loops = true;
+						stack.reset();
+						return;
+					}
+					stack->resize(first);
+					assign(push(callee->fn->result_type), callee->name + "(" + args + ")");
+					return;
+				}
+				const Operator &op = find_operator(call, arg_types);
+				stack->resize(first);
+				const vm::Type *result = op.comparison ? types.boolean() : arg_types[0];
+				assign(push(result), variable(first, arg_types[0]) + " " + op.op + " " + variable(first + 1, arg_types[1]));
+			}
+
+			const Signature *find_signature(const vm::Symbol &name) const {
+				for(const Signature &signature : signatures) {
+					if(signature.fn->name == &name) {
+						return &signature;
+					}
+				}
+				return nullptr;
+			}
+
+			void check_args(const Signature &callee, const CallInfo &call, const Stack &arg_types) const {
+				if(arg_types.size() != callee.fn->arg_types.size()) {
+					throw CompileError(call.name->name + " takes " + std::to_string(callee.fn->arg_types.size())
+									   + " arguments, but was given " + std::to_string(arg_types.size()), call.form);
+				}
+				for(size_t i = 0; i < arg_types.size(); i++) {
+					if(arg_types[i] != callee.fn->arg_types[i]) {
+						throw CompileError("Argument " + std::to_string(i + 1) + " of " + call.name->name + " is a "
+										   + type_name(arg_types[i]) + ", but its signature takes a "
+										   + type_name(callee.fn->arg_types[i]), call.form);
+					}
+				}
+			}
+
+			//! The operator for a call to a builtin on int-32 or float-64 arguments of the same type
+			const Operator &find_operator(const CallInfo &call, const Stack &arg_types) const {
+				const vm::Symbol &name = *call.name;
+				const bool numbers = arg_types.size() == 2 && arg_types[0] == arg_types[1]
+					&& (arg_types[0] == types.int32() || arg_types[0] == types.float64());
+				vm::InterfaceFunction *interface = dynamic_cast<vm::InterfaceFunction*>(compiler.vm.fn_table.find_fn(name));
+				if(numbers && interface && name.package == &compiler.vm.base_package()) {
+					const std::vector<vm::Type*> impl_types = {
+						const_cast<vm::Type*>(arg_types[0]), const_cast<vm::Type*>(arg_types[1])
+					};
+					const Builtin2 *impl = dynamic_cast<Builtin2*>(interface->find_impl(impl_types));
+					const bool stdlib = impl && (arg_types[0] == types.int32()
+												 ? is_stdlib<int32_t>(name.name, impl->function())
+												 : is_stdlib<double>(name.name, impl->function()));
+					for(const Operator &op : operators) {
+						if(stdlib && name.name == op.name) {
+							return op;
+						}
+					}
+				}
+				throw CompileError("The call to " + name.name + " can't be made without the VM", call.form);
+			}
+
+			void push_constant(const vm::InternalBox &value) {
+				std::ostringstream literal;
+				if(const int32_t *integer = std::get_if<int32_t>(&value.elem)) {
+					literal << (*integer == INT32_MIN ? "INT32_MIN" : std::to_string(*integer));
+				} else if(const double *number = std::get_if<double>(&value.elem)) {
+					if(std::isnan(*number)) {
+						literal << "NAN";
+					} else if(std::isinf(*number)) {
+						literal << (*number < 0 ? "-INFINITY" : "INFINITY");
+					} else {
+						// Hex floats are exact
+						literal << std::hexfloat << *number;
+					}
+				} else if(const bool *boolean = std::get_if<bool>(&value.elem)) {
+					literal << (*boolean ? "true" : "false");
+				} else if(vm::StaticString *const *string = std::get_if<vm::StaticString*>(&value.elem)) {
+					literal << salmon_string((*string)->contents);
+				} else if(vm::Symbol *const *symbol = std::get_if<vm::Symbol*>(&value.elem)) {
+					const std::string package = (*symbol)->package ? (*symbol)->package->name : "";
+					literal << "(struct salmon_symbol){" << salmon_string(package) << ", "
+							<< salmon_string((*symbol)->name) << "}";
+				}
+				if(literal.tellp() == 0 || !types.supported(value.type)) {
+					throw CompileError("A constant in " + self.fn->name->name + " is a " + type_name(value.type)
+									   + ", which has no C type", self.fn->name);
+				}
+				assign(push(value.type), literal.str());
+			}
+
+			size_t push(const vm::Type *type) {
+				stack->push_back(type);
+				variables.emplace(stack->size() - 1, type);
+				return stack->size() - 1;
+			}
+
+			void assign(const size_t slot, const std::string &value) {
+				body << '\t' << variable(slot, stack->at(slot)) << " = " << value << ";\n";
+			}
+
+			void jump_to(const size_t target) {
+				const auto [label, added] = labels.try_emplace(target, *stack);
+				if(!added && label->second != *stack) {
+					throw CompileError("The branches of an if in " + self.fn->name->name
+									   + " have different types", self.fn->name);
+				}
+			}
+
+			std::string variable(const size_t slot, const vm::Type *type) const {
+				return "s" + std::to_string(slot) + "_" + types.letter(type);
+			}
+
+			const Signature &self;
+			const std::vector<Signature> &signatures;
+			const ValueTypes &types;
+			Compiler &compiler;
+			const Chunk &chunk;
+			//! The types on the stack, or nothing while translating code no jump reaches
+			std::optional<Stack> stack = Stack{};
+			//! The stack at each jump target
+			std::map<size_t, Stack> labels;
+			//! Every stack slot and type that needs a variable
+			std::set<std::pair<size_t, const vm::Type*>> variables;
+			std::ostringstream body;
+			//! Set when a tail call jumps back to the start
+			bool loops = false;
+		};
+
+		//! Quote an argument for the shell
+		std::string quote(const std::string &arg) {
+			std::string quoted = "'";
+			for(const char c : arg) {
+				quoted += c == '\'' ? std::string("'\\''") : std::string(1, c);
+			}
+			return quoted + "'";
+		}
+	}
+
+	std::string emit_c(std::span<const AotFunction> functions, Compiler &compiler) {
+		const ValueTypes types(compiler.vm);
+		std::vector<Signature> signatures;
+		std::set<std::string> names;
+		for(const AotFunction &fn : functions) {
+			const BytecodeFunction *bytecode = dynamic_cast<BytecodeFunction*>(compiler.vm.fn_table.find_fn(*fn.name));
+			if(!bytecode) {
+				throw CompileError(fn.name->name + " isn't a function defined with defn", fn.name);
+			}
+			if(bytecode->arity() != fn.arg_types.size()) {
+				throw CompileError(fn.name->name + " takes " + std::to_string(bytecode->arity())
+								   + " arguments, but its signature has " + std::to_string(fn.arg_types.size()), fn.name);
+			}
+			for(const vm::Type *type : fn.arg_types) {
+				if(!types.supported(type)) {
+					throw CompileError("An argument of " + fn.name->name + " is a " + type_name(type)
+									   + ", which has no C type", fn.name);
+				}
+			}
+			if(!types.supported(fn.result_type)) {
+				throw CompileError(fn.name->name + " returns a " + type_name(fn.result_type)
+								   + ", which has no C type", fn.name);
+			}
+			Signature signature{&fn, bytecode, c_name(*fn.name)};
+			if(!names.insert(signature.name).second) {
+				throw CompileError("Two functions are named " + signature.name + " in C", fn.name);
+			}
+			signatures.push_back(std::move(signature));
+		}
+
+		std::ostringstream out;
+		out << "/* Compiled from Salmon bytecode */\n"
+			<< "#include <math.h>\n"
+			<< "#include <stdbool.h>\n"
+			<< "#include <stdint.h>\n\n"
+			<< "#include <salmon/core/salmon_string.h>\n"
+			<< "#include <salmon/core/salmon_symbol.h>\n\n";
+		std::vector<FunctionTranslator> translators;
+		translators.reserve(signatures.size());
+		for(const Signature &signature : signatures) {
+			translators.emplace_back(signature, signatures, types, compiler);
+			out << translators.back().prototype() << ";\n";
+		}
+		for(FunctionTranslator &translator : translators) {
+			out << '\n';
+			translator.translate(out);
+		}
+		return out.str();
+	}
+
+	std::filesystem::path core_include_dir() {
+#ifdef SALMON_CORE_INCLUDE_DIR
+		return SALMON_CORE_INCLUDE_DIR;
+#else
+		return {};
+#endif
+	}
+
+	void build_shared_library(const std::string &source, const std::filesystem::path &library,
+							  const CBuildOptions &options) {
+		std::filesystem::path source_path = library;
+		source_path += ".c";
+		{
+			std::ofstream out(source_path);
+			out << source;
+			if(!out) {
+				throw CompileError("Couldn't write C source to " + source_path.string(), nullptr);
+			}
+		}
+		std::string command = quote(options.compiler);
+		for(const std::string &flag : options.flags) {
+			command += " " + quote(flag);
+		}
+		if(!options.include_dir.empty()) {
+			command += " -I" + quote(options.include_dir.string());
+		}
+		command += " -shared -fPIC -o " + quote(library.string()) + " " + quote(source_path.string());
+		if(std::system(command.c_str()) != 0) {
+			throw CompileError("The C compiler failed: " + command, nullptr);
+		}
+	}
+}
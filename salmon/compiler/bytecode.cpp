@@ -0,0 +1,316 @@
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <optional>
+#include <span>
+
+#include <util/assert.hpp>
+#include <util/swisstable.hpp>
+#include <compiler/bytecode.hpp>
+#include <compiler/interpreter.hpp>
+#include <compiler/specialforms.hpp>
+#include <vm/builtinfunction.hpp>
+#include <vm/vmstdlib.hpp>
+
+namespace salmon::compiler {
+
+	const char *opcode_name(const Opcode op) {
+		switch(op) {
+		case Opcode::POP: return "POP";
+		case Opcode::PUSHI: return "PUSHI";
+		case Opcode::PUSHL: return "PUSHL";
+		case Opcode::JMP: return "JMP";
+		case Opcode::JMP_F: return "JMP_F";
+		case Opcode::INVOKE: return "INVOKE";
+		case Opcode::TAILCALL: return "TAILCALL";
+		case Opcode::CALL: return "CALL";
+		case Opcode::ADD_I32: return "ADD_I32";
+		case Opcode::SUBTRACT_I32: return "SUBTRACT_I32";
+		case Opcode::MULTIPLY_I32: return "MULTIPLY_I32";
+		case Opcode::DIVIDE_I32: return "DIVIDE_I32";
+		case Opcode::ADD_F64: return "ADD_F64";
+		case Opcode::SUBTRACT_F64: return "SUBTRACT_F64";
+		case Opcode::MULTIPLY_F64: return "MULTIPLY_F64";
+		case Opcode::DIVIDE_F64: return "DIVIDE_F64";
+		case Opcode::RETURN: return "RETURN";
+		}
+		salmon_abort("Unknown opcode");
+		return "";
+	}
+
+	bool has_operand(const Opcode op) {
+		return op != Opcode::POP && op != Opcode::RETURN;
+	}
+
+	void Chunk::emit(const Opcode op) {
+		salmon_check(!has_operand(op), "Opcode needs an operand");
+		code.push_back(static_cast<uint8_t>(op));
+	}
+
+	void Chunk::emit(const Opcode op, const uint32_t operand) {
+		salmon_check(has_operand(op), "Opcode doesn't take an operand");
+		code.push_back(static_cast<uint8_t>(op));
+		uint8_t bytes[sizeof(operand)];
+		std::memcpy(bytes, &operand, sizeof(operand));
+		code.insert(code.end(), bytes, bytes + sizeof(operand));
+	}
+
+	uint32_t Chunk::operand(const size_t offset) const {
+		uint32_t value{};
+		std::memcpy(&value, code.data() + offset + 1, sizeof(value));
+		return value;
+	}
+
+	void Chunk::patch(const size_t offset, const uint32_t operand) {
+		std::memcpy(code.data() + offset + 1, &operand, sizeof(operand));
+	}
+
+	//! Offset of the instruction after the one at offset
+	static size_t next_instruction(const Chunk &chunk, const size_t offset) {
+		return offset + 1 + (has_operand(static_cast<Opcode>(chunk.code[offset])) ? sizeof(uint32_t) : 0);
+	}
+
+	std::ostream &operator<<(std::ostream &out, const Chunk &chunk) {
+		for(size_t offset = 0; offset < chunk.code.size(); offset = next_instruction(chunk, offset)) {
+			const Opcode op = static_cast<Opcode>(chunk.code[offset]);
+			out << opcode_name(op);
+			if(has_operand(op)) {
+				out << ' ' << chunk.operand(offset);
+			}
+			out << '\n';
+		}
+		return out;
+	}
+
+	CompileError::CompileError(const std::string &msg, const vm::AllocatedItem *form) :
+		std::runtime_error(msg), form{form} {}
+
+	namespace {
+		class ChunkCompiler {
+		public:
+			//! Compile a top-level form into chunk
+			ChunkCompiler(Compiler &compiler, Chunk &chunk, const bool fold) :
+				ChunkCompiler(compiler, chunk, fold, {}, false) {}
+			//! Compile the body of a function taking params into chunk
+			ChunkCompiler(Compiler &compiler, Chunk &chunk, const bool fold,
+						  std::span<vm::Symbol* const> params) :
+				ChunkCompiler(compiler, chunk, fold, params, true) {}
+
+			/**
+			 * Compile the form, returning true if all it does is push one
+			 * constant. tail is set when the value of the form is returned
+			 * from the function being compiled.
+			 **/
+			bool compile(const vm::InternalBox &form, const bool tail = false) {
+				if(vm::List *const *list = std::get_if<vm::List*>(&form.elem)) {
+					return compile_list(*list, tail);
+				} else if(vm::Symbol *const *symbol = std::get_if<vm::Symbol*>(&form.elem);
+						  symbol && (*symbol)->package != compiler.keyword_package()) {
+					const auto param = std::find(params.begin(), params.end(), *symbol);
+					if(param == params.end()) {
+						throw CompileError("Variables can't be compiled yet: " + (*symbol)->name, *symbol);
+					}
+					chunk.emit(Opcode::PUSHL, static_cast<uint32_t>(param - params.begin()));
+					return false;
+				}
+				push_constant(vm::Box(form, compiler.vm.mem_manager.make_vm_ptr<vm::AllocatedItem>()));
+				return true;
+			}
+
+			//! Compile the body of a function, returning the value of its last form
+			void compile_body(const vm::List *body) {
+				for(; body->next != nullptr; body = body->next) {
+					compile(body->itm);
+					chunk.emit(Opcode::POP);
+				}
+				compile(body->itm, true);
+				chunk.emit(Opcode::RETURN);
+			}
+
+		private:
+			ChunkCompiler(Compiler &compiler, Chunk &chunk, const bool fold,
+						  std::span<vm::Symbol* const> params, const bool in_function) :
+				compiler{compiler}, chunk{chunk}, fold{fold}, params{params}, in_function{in_function},
+				special_forms{compiler} {}
+
+			bool compile_list(vm::List *list, const bool tail) {
+				vm::Symbol *const *name = std::get_if<vm::Symbol*>(&list->itm.elem);
+				if(!name) {
+					throw CompileError("Only calls to named functions can be compiled", list);
+				} else if(*name == special_forms.defn) {
+					compile_defn(list);
+					return false;
+				} else if(*name == special_forms.defextern) {
+					compile_defextern(list);
+					return false;
+				} else if(*name == special_forms.if_form) {
+					compile_if(list, tail);
+					return false;
+				}
+				uint32_t num_args = 0;
+				bool constant_args = true;
+				for(const vm::List *cell = list->next; cell != nullptr; cell = cell->next) {
+					constant_args = compile(cell->itm) && constant_args;
+					num_args++;
+				}
+				if(fold && constant_args && fold_constants(**name, num_args)) {
+					return true;
+				}
+				// Only calls in a function have a frame to reuse
+				const bool tail_call = tail && in_function;
+				chunk.emit(tail_call ? Opcode::TAILCALL : Opcode::INVOKE, static_cast<uint32_t>(chunk.calls.size()));
+				chunk.calls.push_back(CallInfo{list, *name, num_args, nullptr, nullptr, 0});
+				return false;
+			}
+
+			void compile_if(const vm::List *list, const bool tail) {
+				const Conditional conditional = parse_if(list);
+				compile(*conditional.test);
+				const size_t jump_to_else = chunk.code.size();
+				chunk.emit(Opcode::JMP_F, 0);
+				compile(*conditional.then, tail);
+				const size_t jump_to_end = chunk.code.size();
+				chunk.emit(Opcode::JMP, 0);
+				chunk.patch(jump_to_else, static_cast<uint32_t>(chunk.code.size()));
+				if(conditional.otherwise) {
+					compile(*conditional.otherwise, tail);
+				} else {
+					push_constant(compiler.vm.make_boxed(vm::Empty{}));
+				}
+				chunk.patch(jump_to_end, static_cast<uint32_t>(chunk.code.size()));
+			}
+
+			void compile_defn(const vm::List *list) {
+				vm::VirtualMachine &vm = compiler.vm;
+				const Definition definition = parse_defn(list, compiler);
+				Chunk body;
+				ChunkCompiler body_compiler(compiler, body, fold, definition.args);
+				body_compiler.compile_body(definition.body);
+				const vm::vm_ptr<vm::VmFunction> fn(vm.mem_manager.allocate_obj<BytecodeFunction>(
+					definition.type, definition.lambda_list, std::move(body)));
+				define_function(definition, fn, list, compiler);
+				push_constant(vm::Box(definition.name_form, vm.mem_manager.make_vm_ptr<vm::AllocatedItem>()));
+			}
+
+			void compile_defextern(const vm::List *list) {
+				vm::VirtualMachine &vm = compiler.vm;
+				const ExternDeclaration declaration = parse_defextern(list, compiler);
+				define_extern(declaration, list, compiler);
+				push_constant(vm::Box(declaration.name_form, vm.mem_manager.make_vm_ptr<vm::AllocatedItem>()));
+			}
+
+			void push_constant(vm::Box &&value) {
+				chunk.emit(Opcode::PUSHI, static_cast<uint32_t>(chunk.constants.size()));
+				chunk.constants.push_back(std::move(value));
+			}
+
+			/**
+			 * Fold a call whose arguments are the last num_args constants,
+			 * which were the last instructions emitted. The result is pushed
+			 * in their place.
+			 **/
+			bool fold_constants(const vm::Symbol &name, const uint32_t num_args) {
+				std::vector<vm::InternalBox> args;
+				args.reserve(num_args);
+				for(size_t i = chunk.constants.size() - num_args; i < chunk.constants.size(); i++) {
+					args.push_back(chunk.constants[i].bare());
+				}
+				std::optional<vm::Box> result = fold_call(name, args, compiler);
+				if(!result) {
+					return false;
+				}
+				chunk.code.resize(chunk.code.size() - num_args * (1 + sizeof(uint32_t)));
+				for(uint32_t i = 0; i < num_args; i++) {
+					chunk.constants.pop_back();
+				}
+				push_constant(std::move(*result));
+				return true;
+			}
+
+			Compiler &compiler;
+			Chunk &chunk;
+			const bool fold;
+			const std::span<vm::Symbol* const> params;
+			const bool in_function;
+			const SpecialForms special_forms;
+		};
+
+		using Builtin2 = vm::BuiltinFunction<vm::InternalBox, vm::InternalBox>;
+
+		//! The stdlib function each arithmetic opcode does the work of
+		template<typename T>
+		constexpr std::array<Builtin2::FunctionType, 4> stdlib_arithmetic = {
+			&vm::add<T>, &vm::subtract<T>, &vm::multiply<T>, &vm::divide<T>
+		};
+
+		/**
+		 * The opcode doing the arithmetic of the builtin, or CALL if there
+		 * isn't one. An implementation an embedder put in place of the stdlib
+		 * one is always called.
+		 **/
+		Opcode arithmetic_opcode(const CallInfo &call, vm::VirtualMachine &vm) {
+			static constexpr std::array<const char*, 4> names = { "add", "subtract", "multiply", "divide" };
+			static constexpr std::array<Opcode, 4> i32_ops = {
+				Opcode::ADD_I32, Opcode::SUBTRACT_I32, Opcode::MULTIPLY_I32, Opcode::DIVIDE_I32
+			};
+			static constexpr std::array<Opcode, 4> f64_ops = {
+				Opcode::ADD_F64, Opcode::SUBTRACT_F64, Opcode::MULTIPLY_F64, Opcode::DIVIDE_F64
+			};
+			const Builtin2 *builtin = dynamic_cast<const Builtin2*>(call.target);
+			if(call.num_args != 2 || call.name->package != &vm.base_package() || !builtin) {
+				return Opcode::CALL;
+			}
+			const vm::TypeSpecification &args = std::get<vm::FunctionType>(call.target->type()->type).args();
+			const vm::Type *type = args.type_at(0);
+			if(type != args.type_at(1)) {
+				return Opcode::CALL;
+			}
+			for(size_t i = 0; i < names.size(); i++) {
+				if(call.name->name != names[i]) {
+					continue;
+				}
+				if(type == vm.get_builtin_type<int32_t>().get() && builtin->function() == stdlib_arithmetic<int32_t>[i]) {
+					return i32_ops[i];
+				} else if(type == vm.get_builtin_type<double>().get() && builtin->function() == stdlib_arithmetic<double>[i]) {
+					return f64_ops[i];
+				}
+			}
+			return Opcode::CALL;
+		}
+	}
+
+	Chunk compile(const vm::Box &form, Compiler &compiler, const bool fold_constants) {
+		Chunk chunk;
+		ChunkCompiler chunk_compiler(compiler, chunk, fold_constants);
+		chunk_compiler.compile(form.bare());
+		chunk.emit(Opcode::RETURN);
+		return chunk;
+	}
+
+	void devirtualize(Chunk &chunk, const InferredTypes &types, Compiler &compiler) {
+		SwissTable<const vm::List*, const CallSite*> sites;
+		sites.reserve(types.call_sites.size());
+		for(const CallSite &site : types.call_sites) {
+			sites.try_emplace(site.form, &site);
+		}
+		for(size_t offset = 0; offset < chunk.code.size(); offset = next_instruction(chunk, offset)) {
+			if(static_cast<Opcode>(chunk.code[offset]) != Opcode::INVOKE) {
+				continue;
+			}
+			CallInfo &call = chunk.calls[chunk.operand(offset)];
+			const CallSite *const *site = sites.find(call.form);
+			if(!site || !(*site)->target) {
+				continue;
+			}
+			vm::InterfaceFunction *interface = dynamic_cast<vm::InterfaceFunction*>((*site)->callee);
+			if(!interface) {
+				// Plain functions can be replaced by name, so they stay late bound
+				continue;
+			}
+			call.target = (*site)->target;
+			call.interface = interface;
+			call.version = interface->version();
+			chunk.code[offset] = static_cast<uint8_t>(arithmetic_opcode(call, compiler.vm));
+		}
+	}
+}
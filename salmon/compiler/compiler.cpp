@@ -17,11 +17,20 @@ namespace salmon::compiler {
 									 salmon::vm::Package("keyword", compiler.vm.mem_manager));
 	}
 
+	//! Export the special forms, so packages using the base package can read them
+	static void export_special_forms(Compiler &compiler) {
+		salmon::vm::Package &base_package = compiler.vm.base_package();
+		for(const char *name : { "defn", "defextern", "if" }) {
+			base_package.export_symbol(base_package.intern_symbol(name));
+		}
+	}
+
 	Compiler::Compiler(const Config &config) :
 		config{config}, vm{config, "salmon"} {
 
 		// setup default packages:
 		create_default_packages(*this);
+		export_special_forms(*this);
 		set_current_package("sal");
 		auto keyword_pkg = vm.find_package("keyword");
 
@@ -0,0 +1,24 @@
+#include <util/assert.hpp>
+#include <compiler/bytecode.hpp>
+#include <compiler/evaluate.hpp>
+#include <compiler/interpreter.hpp>
+#include <compiler/registercode.hpp>
+#include <compiler/registerinterpreter.hpp>
+#include <compiler/typeinference.hpp>
+
+namespace salmon::compiler {
+
+	vm::Box evaluate(const vm::Box &form, Compiler &compiler) {
+		switch(compiler.config.backend) {
+		case Backend::STACK: {
+			Chunk chunk = compile(form, compiler);
+			devirtualize(chunk, infer_types(form, compiler), compiler);
+			return run(chunk, compiler.vm);
+		}
+		case Backend::REGISTER:
+			return run(compile_registers(form, compiler), compiler.vm);
+		}
+		salmon_abort("Unknown backend");
+		return compiler.vm.make_boxed(vm::Empty{});
+	}
+}
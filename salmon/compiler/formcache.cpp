@@ -0,0 +1,106 @@
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <optional>
+#include <system_error>
+#include <unistd.h>
+
+#include <compiler/formcache.hpp>
+#include <compiler/parser.hpp>
+#include <vm/serialize.hpp>
+#include <util/mappedfile.hpp>
+
+namespace salmon::compiler {
+
+	//! FNV-1a, continuing from the given hash
+	static uint64_t hash_bytes(std::span<const std::byte> bytes, uint64_t hash = 0xcbf29ce484222325ull) {
+		for(std::byte b : bytes) {
+			hash ^= static_cast<uint64_t>(b);
+			hash *= 0x100000001b3ull;
+		}
+		return hash;
+	}
+
+	uint64_t FormCache::key(std::span<const std::byte> source, std::string_view package,
+							uint32_t reader_version) {
+		uint64_t hash = hash_bytes(std::as_bytes(std::span(&reader_version, 1)));
+		hash = hash_bytes(std::as_bytes(std::span(package.data(), package.size())), hash);
+		return hash_bytes(source, hash);
+	}
+
+	FormCache::FormCache(const std::filesystem::path &cache_dir) :
+		dir{cache_dir / "forms"}, cache_hits{0} {}
+
+	std::filesystem::path FormCache::entry_path(uint64_t key) const {
+		std::ostringstream name;
+		name << std::hex << key << ".forms";
+		return dir / name.str();
+	}
+
+	std::optional<ReadForms> FormCache::read_file(const std::filesystem::path &file,
+															  Compiler &compiler) {
+		std::optional<MappedFile> source = MappedFile::open(file);
+		if(!source) {
+			return std::nullopt;
+		}
+		// The entry can't tell which reader macros were used, so only cache what the builtin ones read.
+		// Decoding an entry doesn't give source locations, so skip the cache when they are wanted too.
+		const bool cacheable = !compiler.reader_macros.customized() && !compiler.source_locations;
+		const std::string &package = compiler.current_package()->name;
+		const std::filesystem::path entry = entry_path(key(source->bytes(), package));
+
+		if(std::optional<MappedFile> cached = cacheable ? MappedFile::open(entry) : std::nullopt) {
+			if(auto forms = vm::serialize::read_values(cached->bytes(), compiler.vm)) {
+				cache_hits++;
+				return ReadForms{std::move(*forms), {}};
+			}
+		}
+
+		const auto bytes = source->bytes();
+		std::istringstream input(std::string(reinterpret_cast<const char*>(bytes.data()), bytes.size()));
+		CountingStreamBuffer countStreamBuf(input);
+		if(compiler.source_locations) {
+			compiler.source_locations->begin_file(file);
+		}
+		ReadForms read = read_all(countStreamBuf, compiler);
+		if(compiler.source_locations) {
+			compiler.source_locations->end_file();
+		}
+		if(cacheable && read.errors.empty()) {
+			store(entry, read.forms);
+		}
+		return read;
+	}
+
+	uint64_t FormCache::hits() const {
+		return cache_hits;
+	}
+
+	//! Write the entry next to its final location and move it into place, so readers never see half of it.
+	void FormCache::store(const std::filesystem::path &entry, std::span<const vm::Box> forms) const {
+		std::error_code error;
+		std::filesystem::create_directories(dir, error);
+		if(error) {
+			return;
+		}
+		std::filesystem::path tmp = entry;
+		tmp += "." + std::to_string(getpid()) + ".tmp";
+		{
+			std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+			vm::serialize::Writer writer(out);
+			for(const vm::Box &form : forms) {
+				writer.write(form);
+			}
+			writer.finish();
+			out.flush();
+			if(!out) {
+				std::filesystem::remove(tmp, error);
+				return;
+			}
+		}
+		std::filesystem::rename(tmp, entry, error);
+		if(error) {
+			std::filesystem::remove(tmp, error);
+		}
+	}
+}
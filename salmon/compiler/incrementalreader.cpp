@@ -0,0 +1,127 @@
+#include <algorithm>
+#include <streambuf>
+#include <utility>
+
+#include <util/assert.hpp>
+#include <compiler/incrementalreader.hpp>
+
+namespace salmon::compiler {
+
+	//! Move a position that comes after old_anchor so it is the same distance from new_anchor
+	static salmon::meta::position_info shift(const salmon::meta::position_info &position,
+											 const salmon::meta::position_info &old_anchor,
+											 const salmon::meta::position_info &new_anchor) {
+		if(position.line == old_anchor.line) {
+			return { new_anchor.line, position.column - old_anchor.column + new_anchor.column };
+		}
+		return { position.line - old_anchor.line + new_anchor.line, position.column };
+	}
+
+	IncrementalReader::IncrementalReader(Compiler &compiler) :
+		compiler{compiler}, buffer{}, read_forms{}, tail_position{1, 0} {}
+
+	void IncrementalReader::reset(std::string text) {
+		buffer.clear();
+		read_forms.clear();
+		tail_position = {1, 0};
+		edit(0, 0, text);
+	}
+
+	const std::string &IncrementalReader::text() const {
+		return buffer;
+	}
+
+	const std::vector<IncrementalReader::Form> &IncrementalReader::forms() const {
+		return read_forms;
+	}
+
+	size_t IncrementalReader::first_changed(const size_t offset) const {
+		if(offset == 0 || read_forms.empty()) {
+			return 0;
+		}
+		// The form holding the character before the edit can change too, since an atom
+		// at its end would run into what was inserted.
+		auto after = std::upper_bound(read_forms.begin(), read_forms.end(), offset - 1,
+									  [](size_t pos, const Form &form) { return pos < form.start; });
+		const size_t index = after == read_forms.begin() ? 0 : static_cast<size_t>(after - read_forms.begin()) - 1;
+		if(index == read_forms.size() - 1 && offset - 1 >= read_forms.back().end) {
+			return read_forms.size();
+		}
+		return index;
+	}
+
+	void IncrementalReader::edit(const size_t offset, const size_t length, const std::string_view replacement) {
+		salmon_check(offset + length <= buffer.size(), "Edit is outside of the buffer");
+		const size_t first = first_changed(offset);
+		const size_t edit_end = offset + replacement.size();
+		// Only valid for offsets at or after the end of the replaced text
+		auto moved = [length, &replacement](size_t old_offset) {
+			return old_offset - length + replacement.size();
+		};
+
+		size_t read_from = 0;
+		salmon::meta::position_info read_position = tail_position;
+		if(first < read_forms.size()) {
+			read_from = read_forms[first].start;
+			read_position = read_forms[first].position;
+		} else if(!read_forms.empty()) {
+			read_from = read_forms.back().end;
+		}
+		// Forms starting before the end of the replaced text have to be read again
+		size_t next = first;
+		while(next < read_forms.size() && read_forms[next].start < offset + length) {
+			next++;
+		}
+
+		buffer.replace(offset, length, replacement);
+		StringViewBuffer view(buffer, read_from);
+		CountingStreamBuffer countStreamBuf(&view, read_position, static_cast<std::streamsize>(read_from));
+
+		std::vector<Form> reread;
+		bool lined_up = false;
+		while(true) {
+			const size_t position = static_cast<size_t>(countStreamBuf.filepos());
+			const salmon::meta::position_info position_info = countStreamBuf.positionInfo();
+			if(position >= edit_end) {
+				while(next < read_forms.size() && moved(read_forms[next].start) < position) {
+					next++;
+				}
+				if(next < read_forms.size() && moved(read_forms[next].start) == position) {
+					// The rest of the buffer is unchanged and reads the same as before
+					lined_up = true;
+					break;
+				}
+			}
+			std::optional<ReadItem> item = read_recovering(countStreamBuf, compiler);
+			if(!item) {
+				tail_position = position_info;
+				break;
+			}
+			reread.push_back(Form{position, static_cast<size_t>(countStreamBuf.filepos()),
+								  position_info, std::move(*item)});
+		}
+
+		std::vector<Form> forms;
+		forms.reserve(first + reread.size() + (lined_up ? read_forms.size() - next : 0));
+		std::move(read_forms.begin(), read_forms.begin() + static_cast<std::ptrdiff_t>(first),
+				  std::back_inserter(forms));
+		std::move(reread.begin(), reread.end(), std::back_inserter(forms));
+		if(lined_up) {
+			const salmon::meta::position_info old_anchor = read_forms[next].position;
+			const salmon::meta::position_info new_anchor = countStreamBuf.positionInfo();
+			for(size_t i = next; i < read_forms.size(); i++) {
+				Form &form = read_forms[i];
+				ReadItem item{std::move(form.item.form), std::nullopt};
+				if(form.item.error) {
+					item.error.emplace(form.item.error->what(),
+									   shift(form.item.error->start(), old_anchor, new_anchor),
+									   shift(form.item.error->end(), old_anchor, new_anchor));
+				}
+				forms.push_back(Form{moved(form.start), moved(form.end),
+									 shift(form.position, old_anchor, new_anchor), std::move(item)});
+			}
+			tail_position = shift(tail_position, old_anchor, new_anchor);
+		}
+		read_forms = std::move(forms);
+	}
+}
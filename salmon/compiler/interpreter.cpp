@@ -0,0 +1,360 @@
+#include <algorithm>
+#include <iostream>
+#include <span>
+#include <vector>
+
+#include <util/assert.hpp>
+#include <compiler/interpreter.hpp>
+#include <compiler/specialforms.hpp>
+
+namespace salmon::compiler {
+
+	BytecodeFunction::BytecodeFunction(const vm::vm_ptr<vm::Type> &type,
+									   const std::vector<vm::vm_ptr<vm::Symbol>> &lambda_list,
+									   Chunk code) :
+		VmFunction(type, lambda_list), code{std::move(code)} {}
+
+	BytecodeFunction::~BytecodeFunction() = default;
+
+	const Chunk &BytecodeFunction::chunk() const {
+		return code;
+	}
+
+	size_t BytecodeFunction::arity() const {
+		return _lambda_list.size();
+	}
+
+	void BytecodeFunction::check_arity(vm::VirtualMachine &vm, const size_t num_args) const {
+		if(num_args != arity()) {
+			throw vm::ArityException::build(&vm, _lambda_list, num_args, arity());
+		}
+	}
+
+	void BytecodeFunction::count_call(vm::VirtualMachine &vm) {
+		const uint32_t threshold = vm.config().jit_threshold;
+		if(threshold == 0 || calls >= threshold) {
+			return;
+		}
+		if(++calls == threshold) {
+			native = jit_compile(code, vm);
+		}
+	}
+
+	const JitCode *BytecodeFunction::native_code() const {
+		return native.get();
+	}
+
+	void BytecodeFunction::discard_native_code() {
+		native.reset();
+		calls = 0;
+	}
+
+	void BytecodeFunction::get_roots(const std::function<void(vm::AllocatedItem*)> &inserter) const {
+		for(const CallInfo &call : code.calls) {
+			inserter(call.name);
+			if(call.target) {
+				inserter(call.target);
+				inserter(call.interface);
+			}
+		}
+		VmFunction::get_roots(inserter);
+	}
+
+	void BytecodeFunction::print_debug_info() const {
+		std::cerr << "Bytecode function" << std::endl;
+	}
+
+	size_t BytecodeFunction::allocated_size() const {
+		return sizeof(*this);
+	}
+
+	namespace {
+		//! Where to pick up a call when the function it made returns
+		struct Frame {
+			//! The function the frame runs, or nullptr for a top-level chunk
+			BytecodeFunction *function;
+			const Chunk *chunk;
+			size_t pc;
+			//! Index of the first argument of the frame on the value stack
+			size_t base;
+		};
+
+		class Interpreter {
+		public:
+			Interpreter(vm::VirtualMachine &vm, const Chunk &chunk) :
+				vm{vm}, chunk{&chunk} {}
+			//! Run the body of fn, which has already counted the call
+			Interpreter(vm::VirtualMachine &vm, BytecodeFunction &fn) :
+				vm{vm}, function{&fn}, native{fn.native_code()}, chunk{&fn.chunk()} {}
+
+			//! Push arguments for the chunk, which should be the body of a function
+			void push_args(std::span<const vm::InternalBox> args) {
+				stack.insert(stack.end(), args.begin(), args.end());
+			}
+
+			vm::Box execute() {
+				while(true) {
+					if(native && !left_native) {
+						if(const JitCode::Entry entry = native->entry(pc)) {
+							run_native(entry);
+							continue;
+						}
+					}
+					left_native = false;
+					const Opcode op = static_cast<Opcode>(chunk->code[pc]);
+					const size_t next = pc + (has_operand(op) ? 1 + sizeof(uint32_t) : 1);
+					if(op >= Opcode::CALL && op <= Opcode::DIVIDE_F64 && !still_valid(op, call_at(pc))) {
+						invoke(call_at(pc), next);
+						continue;
+					}
+					switch(op) {
+					case Opcode::POP:
+						stack.pop_back();
+						break;
+					case Opcode::PUSHI:
+						stack.push_back(chunk->constants[chunk->operand(pc)].bare());
+						break;
+					case Opcode::PUSHL:
+						stack.push_back(stack[base + chunk->operand(pc)]);
+						break;
+					case Opcode::JMP:
+						pc = chunk->operand(pc);
+						continue;
+					case Opcode::JMP_F: {
+						const vm::InternalBox test = stack.back();
+						stack.pop_back();
+						if(is_false(test)) {
+							pc = chunk->operand(pc);
+							continue;
+						}
+						break;
+					}
+					case Opcode::INVOKE:
+						invoke(call_at(pc), next);
+						continue;
+					case Opcode::TAILCALL:
+						if(tail_call(call_at(pc))) {
+							continue;
+						}
+						break;
+					case Opcode::CALL: {
+						const CallInfo &call = call_at(pc);
+						call_native(*call.target, call.num_args);
+						break;
+					}
+					case Opcode::ADD_I32:
+						arithmetic<int32_t>(std::plus<int32_t>());
+						break;
+					case Opcode::SUBTRACT_I32:
+						arithmetic<int32_t>(std::minus<int32_t>());
+						break;
+					case Opcode::MULTIPLY_I32:
+						arithmetic<int32_t>(std::multiplies<int32_t>());
+						break;
+					case Opcode::DIVIDE_I32:
+						arithmetic<int32_t>(std::divides<int32_t>());
+						break;
+					case Opcode::ADD_F64:
+						arithmetic<double>(std::plus<double>());
+						break;
+					case Opcode::SUBTRACT_F64:
+						arithmetic<double>(std::minus<double>());
+						break;
+					case Opcode::MULTIPLY_F64:
+						arithmetic<double>(std::multiplies<double>());
+						break;
+					case Opcode::DIVIDE_F64:
+						arithmetic<double>(std::divides<double>());
+						break;
+					case Opcode::RETURN:
+						if(return_from_frame()) {
+							return vm::Box(stack.back(), vm.mem_manager.make_vm_ptr<vm::AllocatedItem>());
+						}
+						continue;
+					}
+					pc = next;
+				}
+			}
+
+		private:
+			const CallInfo &call_at(const size_t offset) const {
+				return chunk->calls[chunk->operand(offset)];
+			}
+
+			/**
+			 * Check if the target picked for a devirtualized call can still be
+			 * used. It can't if an implementation was redefined since, or if
+			 * the arguments don't have the types inference expected.
+			 **/
+			bool still_valid(const Opcode op, const CallInfo &call) const {
+				if(call.interface->version() != call.version) {
+					return false;
+				}
+				const vm::InternalBox *args = stack.data() + stack.size() - call.num_args;
+				switch(op) {
+				case Opcode::ADD_I32:
+				case Opcode::SUBTRACT_I32:
+				case Opcode::MULTIPLY_I32:
+				case Opcode::DIVIDE_I32:
+					return std::holds_alternative<int32_t>(args[0].elem) && std::holds_alternative<int32_t>(args[1].elem);
+				case Opcode::ADD_F64:
+				case Opcode::SUBTRACT_F64:
+				case Opcode::MULTIPLY_F64:
+				case Opcode::DIVIDE_F64:
+					return std::holds_alternative<double>(args[0].elem) && std::holds_alternative<double>(args[1].elem);
+				default: {
+					const vm::TypeSpecification &arg_types = std::get<vm::FunctionType>(call.target->type()->type).args();
+					for(uint32_t i = 0; i < call.num_args; i++) {
+						if(arg_types.type_at(i) != args[i].type) {
+							return false;
+						}
+					}
+					return true;
+				}
+				}
+			}
+
+			vm::VmFunction &find_function(const CallInfo &call) {
+				vm::VmFunction *fn = vm.fn_table.find_fn(*call.name);
+				if(fn == nullptr) {
+					std::vector<vm::vm_ptr<vm::Type>> signature;
+					for(size_t i = stack.size() - call.num_args; i < stack.size(); i++) {
+						signature.push_back(vm.mem_manager.make_vm_ptr(stack[i].type));
+					}
+					vm::NoSuchFunction error(std::move(signature));
+					error.func_name(vm.mem_manager.make_vm_ptr(call.name));
+					throw error;
+				}
+				return *fn;
+			}
+
+			//! Call fn with the top num_args values of the stack, replacing them with its result
+			void call_native(vm::VmFunction &fn, const uint32_t num_args) {
+				vm.safepoint();
+				std::span<vm::InternalBox> args(stack.data() + stack.size() - num_args, num_args);
+				const vm::Box result = fn(&vm, args);
+				stack.resize(stack.size() - num_args);
+				stack.push_back(result.bare());
+			}
+
+			//! Make the call, continuing at next once it returns
+			void invoke(const CallInfo &call, const size_t next) {
+				vm::VmFunction &fn = find_function(call);
+				if(BytecodeFunction *bytecode = dynamic_cast<BytecodeFunction*>(&fn)) {
+					vm.safepoint();
+					bytecode->check_arity(vm, call.num_args);
+					frames.push_back(Frame{function, chunk, next, base});
+					enter(*bytecode, stack.size() - call.num_args);
+				} else {
+					call_native(fn, call.num_args);
+					pc = next;
+				}
+			}
+
+			/**
+			 * Make a call in tail position. Returns true if a bytecode
+			 * function took over the running frame, false if a native function
+			 * was called and its result is on top of the stack.
+			 **/
+			bool tail_call(const CallInfo &call) {
+				vm::VmFunction &fn = find_function(call);
+				BytecodeFunction *bytecode = dynamic_cast<BytecodeFunction*>(&fn);
+				if(!bytecode) {
+					call_native(fn, call.num_args);
+					return false;
+				}
+				vm.safepoint();
+				bytecode->check_arity(vm, call.num_args);
+				// Slide the arguments down over the running frame
+				std::copy(stack.end() - call.num_args, stack.end(), stack.begin() + base);
+				stack.resize(base + call.num_args);
+				enter(*bytecode, base);
+				return true;
+			}
+
+			void enter(BytecodeFunction &fn, const size_t args_start) {
+				fn.count_call(vm);
+				function = &fn;
+				native = fn.native_code();
+				chunk = &fn.chunk();
+				pc = 0;
+				base = args_start;
+			}
+
+			//! Leave the running frame. Returns true if it was the outermost one.
+			bool return_from_frame() {
+				const vm::InternalBox result = stack.back();
+				stack.resize(base);
+				stack.push_back(result);
+				if(frames.empty()) {
+					return true;
+				}
+				const Frame &caller = frames.back();
+				function = caller.function;
+				native = function ? function->native_code() : nullptr;
+				chunk = caller.chunk;
+				pc = caller.pc;
+				base = caller.base;
+				frames.pop_back();
+				return false;
+			}
+
+			/**
+			 * Run the machine code of the running function from entry until it
+			 * stops, then run the instruction it stopped at in the interpreter.
+			 **/
+			void run_native(const JitCode::Entry entry) {
+				if(!native->still_valid()) {
+					// Machine code only calls builtins, so none of it can be running further up
+					function->discard_native_code();
+					native = nullptr;
+					return;
+				}
+				// The machine code pushes without checking for room
+				const size_t top = stack.size();
+				stack.resize(top + native->max_growth());
+				std::exception_ptr error;
+				JitState state{&vm, stack.data() + base, stack.data() + top, pc, &error};
+				entry(&state);
+				stack.resize(static_cast<size_t>(state.top - stack.data()));
+				if(error) {
+					std::rethrow_exception(error);
+				}
+				pc = state.pc;
+				left_native = true;
+			}
+
+			template<typename T, typename Op>
+			void arithmetic(Op op) {
+				const vm::InternalBox second = stack.back();
+				stack.pop_back();
+				vm::InternalBox &first = stack.back();
+				first.elem = static_cast<T>(op(std::get<T>(first.elem), std::get<T>(second.elem)));
+			}
+
+			vm::VirtualMachine &vm;
+			std::vector<vm::InternalBox> stack;
+			std::vector<Frame> frames;
+			BytecodeFunction *function = nullptr;
+			const JitCode *native = nullptr;
+			//! Set when the machine code has stopped at the instruction at pc
+			bool left_native = false;
+			const Chunk *chunk;
+			size_t pc = 0;
+			size_t base = 0;
+		};
+	}
+
+	vm::Box BytecodeFunction::operator()(vm::VirtualMachine *vm, std::span<vm::InternalBox> args) {
+		check_arity(*vm, args.size());
+		count_call(*vm);
+		Interpreter interpreter(*vm, *this);
+		interpreter.push_args(args);
+		return interpreter.execute();
+	}
+
+	vm::Box run(const Chunk &chunk, vm::VirtualMachine &vm) {
+		Interpreter interpreter(vm, chunk);
+		return interpreter.execute();
+	}
+}
@@ -0,0 +1,628 @@
+#include <cstddef>
+#include <cstring>
+#include <string_view>
+
+#include <util/assert.hpp>
+#include <compiler/jit.hpp>
+#include <vm/builtinfunction.hpp>
+#include <vm/vmstdlib.hpp>
+
+#if defined(__x86_64__) && defined(__linux__)
+#define SALMON_JIT_X86_64
+#include <sys/mman.h>
+#endif
+
+namespace salmon::compiler {
+
+	JitCode::~JitCode() {
+#ifdef SALMON_JIT_X86_64
+		if(memory) {
+			munmap(memory, length);
+		}
+#endif
+	}
+
+	bool JitCode::still_valid() const {
+		for(const Guard &guard : guards) {
+			if(guard.interface->version() != guard.version) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	size_t JitCode::code_size() const {
+		return length;
+	}
+
+#ifdef SALMON_JIT_X86_64
+
+	bool jit_supported() {
+		return true;
+	}
+
+	namespace {
+		using Builtin1 = vm::BuiltinFunction<vm::InternalBox>;
+		using Builtin2 = vm::BuiltinFunction<vm::InternalBox, vm::InternalBox>;
+
+		/**
+		 * Builtins called from machine code. Exceptions can't be thrown
+		 * through the machine code, which has no unwind information, so they
+		 * are caught here and rethrown by the interpreter.
+		 **/
+		bool call_builtin_1(JitState *state, Builtin1::FunctionType fn, vm::InternalBox *args) {
+			try {
+				state->vm->safepoint();
+				args[0] = fn(state->vm, args[0]).bare();
+				return true;
+			} catch(...) {
+				*state->error = std::current_exception();
+				return false;
+			}
+		}
+
+		bool call_builtin_2(JitState *state, Builtin2::FunctionType fn, vm::InternalBox *args) {
+			try {
+				state->vm->safepoint();
+				args[0] = fn(state->vm, args[0], args[1]).bare();
+				return true;
+			} catch(...) {
+				*state->error = std::current_exception();
+				return false;
+			}
+		}
+
+		enum Reg : uint8_t {
+			RAX = 0, RCX = 1, RDX = 2, RBX = 3, RSP = 4, RBP = 5, RSI = 6, RDI = 7,
+			R12 = 12, R13 = 13,
+		};
+		//! The xmm register arithmetic is done in
+		constexpr uint8_t XMM0 = 0;
+
+		enum Condition : uint8_t {
+			EQUAL = 0x4,
+			NOT_EQUAL = 0x5,
+		};
+
+		//! Encodes the handful of x86-64 instructions the templates are made of
+		class Assembler {
+		public:
+			std::vector<uint8_t> code;
+
+			size_t size() const {
+				return code.size();
+			}
+
+			void push(const Reg reg) {
+				rex(false, 0, reg);
+				byte(0x50 + (reg & 7));
+			}
+			void pop(const Reg reg) {
+				rex(false, 0, reg);
+				byte(0x58 + (reg & 7));
+			}
+			void ret() {
+				byte(0xC3);
+			}
+			//! mov dst, src
+			void mov(const Reg dst, const Reg src) {
+				rex(true, src, dst);
+				byte(0x89);
+				direct(src, dst);
+			}
+			//! mov dst, imm64
+			void mov(const Reg dst, const uint64_t value) {
+				rex(true, 0, dst);
+				byte(0xB8 + (dst & 7));
+				bytes(&value, sizeof(value));
+			}
+			void mov(const Reg dst, const void *pointer) {
+				mov(dst, reinterpret_cast<uint64_t>(pointer));
+			}
+			//! mov dst, qword [base + disp]
+			void load(const Reg dst, const Reg base, const int32_t disp) {
+				rex(true, dst, base);
+				byte(0x8B);
+				memory(dst, base, disp);
+			}
+			//! mov qword [base + disp], src
+			void store(const Reg base, const int32_t disp, const Reg src) {
+				rex(true, src, base);
+				byte(0x89);
+				memory(src, base, disp);
+			}
+			//! mov qword [base + disp], imm32
+			void store(const Reg base, const int32_t disp, const int32_t value) {
+				rex(true, 0, base);
+				byte(0xC7);
+				memory(0, base, disp);
+				imm32(value);
+			}
+			//! mov dst, dword [base + disp]
+			void load32(const Reg dst, const Reg base, const int32_t disp) {
+				rex(false, dst, base);
+				byte(0x8B);
+				memory(dst, base, disp);
+			}
+			//! mov dword [base + disp], src
+			void store32(const Reg base, const int32_t disp, const Reg src) {
+				rex(false, src, base);
+				byte(0x89);
+				memory(src, base, disp);
+			}
+			//! lea dst, [base + disp]
+			void lea(const Reg dst, const Reg base, const int32_t disp) {
+				rex(true, dst, base);
+				byte(0x8D);
+				memory(dst, base, disp);
+			}
+			void add(const Reg reg, const int32_t value) {
+				rex(true, 0, reg);
+				byte(0x81);
+				direct(0, reg);
+				imm32(value);
+			}
+			void sub(const Reg reg, const int32_t value) {
+				rex(true, 0, reg);
+				byte(0x81);
+				direct(5, reg);
+				imm32(value);
+			}
+			//! add/sub/imul dst, dword [base + disp]
+			void add32(const Reg dst, const Reg base, const int32_t disp) {
+				rex(false, dst, base);
+				byte(0x03);
+				memory(dst, base, disp);
+			}
+			void sub32(const Reg dst, const Reg base, const int32_t disp) {
+				rex(false, dst, base);
+				byte(0x2B);
+				memory(dst, base, disp);
+			}
+			void imul32(const Reg dst, const Reg base, const int32_t disp) {
+				rex(false, dst, base);
+				byte(0x0F);
+				byte(0xAF);
+				memory(dst, base, disp);
+			}
+			//! Sign extend eax into edx, then divide edx:eax by divisor
+			void idiv32(const Reg divisor) {
+				byte(0x99);
+				rex(false, 0, divisor);
+				byte(0xF7);
+				direct(7, divisor);
+			}
+			//! cmp qword [base + disp], reg
+			void cmp(const Reg base, const int32_t disp, const Reg reg) {
+				rex(true, reg, base);
+				byte(0x39);
+				memory(reg, base, disp);
+			}
+			//! cmp byte [base + disp], imm8
+			void cmp8(const Reg base, const int32_t disp, const uint8_t value) {
+				rex(false, 0, base);
+				byte(0x80);
+				memory(7, base, disp);
+				byte(value);
+			}
+			//! cmp reg32, imm8
+			void cmp32(const Reg reg, const int8_t value) {
+				rex(false, 0, reg);
+				byte(0x83);
+				direct(7, reg);
+				byte(static_cast<uint8_t>(value));
+			}
+			//! test al, al
+			void test_al() {
+				byte(0x84);
+				byte(0xC0);
+			}
+			//! Scalar double instruction with xmm as destination, or source for movsd stores
+			void sse(const uint8_t opcode, const uint8_t xmm, const Reg base, const int32_t disp) {
+				byte(0xF2);
+				rex(false, xmm, base);
+				byte(0x0F);
+				byte(opcode);
+				memory(xmm, base, disp);
+			}
+			void call(const Reg reg) {
+				rex(false, 0, reg);
+				byte(0xFF);
+				direct(2, reg);
+			}
+			//! Jump to a place filled in later with bind. Returns the place to bind.
+			size_t jmp() {
+				byte(0xE9);
+				imm32(0);
+				return size() - sizeof(int32_t);
+			}
+			size_t jcc(const Condition condition) {
+				byte(0x0F);
+				byte(0x80 | condition);
+				imm32(0);
+				return size() - sizeof(int32_t);
+			}
+			//! Point the jump whose offset is at fixup to target
+			void bind(const size_t fixup, const size_t target) {
+				const int32_t rel = static_cast<int32_t>(target) - static_cast<int32_t>(fixup + sizeof(int32_t));
+				std::memcpy(code.data() + fixup, &rel, sizeof(rel));
+			}
+			void bind(const size_t fixup) {
+				bind(fixup, size());
+			}
+
+		private:
+			void byte(const uint8_t value) {
+				code.push_back(value);
+			}
+			void bytes(const void *data, const size_t count) {
+				const uint8_t *start = static_cast<const uint8_t*>(data);
+				code.insert(code.end(), start, start + count);
+			}
+			void imm32(const int32_t value) {
+				bytes(&value, sizeof(value));
+			}
+			void rex(const bool wide, const uint8_t reg, const uint8_t base) {
+				const uint8_t prefix = 0x40 | (wide ? 0x8 : 0) | ((reg & 8) ? 0x4 : 0) | ((base & 8) ? 0x1 : 0);
+				if(prefix != 0x40) {
+					byte(prefix);
+				}
+			}
+			//! ModRM for a register operand
+			void direct(const uint8_t reg, const uint8_t rm) {
+				byte(0xC0 | ((reg & 7) << 3) | (rm & 7));
+			}
+			/**
+			 * ModRM for [base + disp32]. The long displacement is always used,
+			 * so r13 doesn't turn into rip relative addressing; rsp and r12
+			 * need a SIB byte.
+			 **/
+			void memory(const uint8_t reg, const uint8_t base, const int32_t disp) {
+				byte(0x80 | ((reg & 7) << 3) | (base & 7));
+				if((base & 7) == RSP) {
+					byte(0x24);
+				}
+				imm32(disp);
+			}
+		};
+
+		//! Where the parts of an InternalBox are, measured instead of assumed for the variant
+		struct BoxLayout {
+			int32_t size;
+			int32_t type;
+			int32_t int32_value;
+			int32_t double_value;
+			int32_t bool_value;
+
+			BoxLayout() {
+				vm::InternalBox box{nullptr, int32_t{0}};
+				const char *start = reinterpret_cast<const char*>(&box);
+				size = sizeof(vm::InternalBox);
+				type = offset(start, &box.type);
+				int32_value = offset(start, std::get_if<int32_t>(&box.elem));
+				box.elem = 0.0;
+				double_value = offset(start, std::get_if<double>(&box.elem));
+				box.elem = false;
+				bool_value = offset(start, std::get_if<bool>(&box.elem));
+				salmon_check(size % 8 == 0, "Boxes are copied eight bytes at a time");
+			}
+
+			static int32_t offset(const char *start, const void *field) {
+				return static_cast<int32_t>(static_cast<const char*>(field) - start);
+			}
+		};
+	}
+
+	class NativeCompiler {
+	public:
+		NativeCompiler(const Chunk &chunk, vm::VirtualMachine &vm) :
+			chunk{chunk}, vm{vm},
+			int32_type{vm.get_builtin_type<int32_t>().get()},
+			double_type{vm.get_builtin_type<double>().get()},
+			bool_type{vm.get_builtin_type<bool>().get()},
+			empty_type{vm.get_builtin_type<vm::Empty>().get()},
+			result{new JitCode()} {}
+
+		std::unique_ptr<JitCode> compile() {
+			result->entries.assign(chunk.code.size(), nullptr);
+			for(const vm::Box &constant : chunk.constants) {
+				result->constants.push_back(constant.bare());
+			}
+			std::vector<size_t> labels(chunk.code.size());
+			std::vector<size_t> resume_at = { 0 };
+			size_t offset = 0;
+			while(offset < chunk.code.size()) {
+				labels[offset] = as.size();
+				const Opcode op = static_cast<Opcode>(chunk.code[offset]);
+				const size_t next = offset + 1 + (has_operand(op) ? sizeof(uint32_t) : 0);
+				if(!compile_instruction(op, offset) && next < chunk.code.size()) {
+					resume_at.push_back(next);
+				}
+				offset = next;
+			}
+			for(const auto &[fixup, target] : jumps) {
+				as.bind(fixup, labels[target]);
+			}
+			// Leave for the interpreter at the offset stored in pc
+			const size_t epilogue = as.size();
+			as.store(RBX, offsetof(JitState, top), R13);
+			as.pop(R13);
+			as.pop(R12);
+			as.pop(RBX);
+			as.ret();
+			for(const size_t fixup : exits) {
+				as.bind(fixup, epilogue);
+			}
+			std::vector<std::pair<size_t, size_t>> entry_offsets;
+			for(const size_t pc : resume_at) {
+				entry_offsets.emplace_back(pc, as.size());
+				// Three pushes on top of the return address keep calls 16 byte aligned
+				as.push(RBX);
+				as.push(R12);
+				as.push(R13);
+				as.mov(RBX, RDI);
+				as.load(R12, RDI, offsetof(JitState, base));
+				as.load(R13, RDI, offsetof(JitState, top));
+				as.bind(as.jmp(), labels[pc]);
+			}
+			if(!install()) {
+				return nullptr;
+			}
+			for(const auto &[pc, native] : entry_offsets) {
+				result->entries[pc] = reinterpret_cast<JitCode::Entry>(static_cast<uint8_t*>(result->memory) + native);
+			}
+			return std::move(result);
+		}
+
+	private:
+		/**
+		 * Copy the template for the instruction. Returns true if the code
+		 * always carries on past it, false if it can stop there.
+		 **/
+		bool compile_instruction(const Opcode op, const size_t offset) {
+			switch(op) {
+			case Opcode::POP:
+				as.sub(R13, layout.size);
+				return true;
+			case Opcode::PUSHI:
+				as.mov(RCX, &result->constants[chunk.operand(offset)]);
+				push_copy(RCX, 0);
+				return true;
+			case Opcode::PUSHL:
+				push_copy(R12, static_cast<int32_t>(chunk.operand(offset)) * layout.size);
+				return true;
+			case Opcode::JMP:
+				jumps.emplace_back(as.jmp(), chunk.operand(offset));
+				return true;
+			case Opcode::JMP_F:
+				jump_if_false(chunk.operand(offset));
+				return true;
+			case Opcode::INVOKE:
+			case Opcode::TAILCALL:
+				// A tail call to a builtin is followed by the RETURN of its result
+				return invoke(chunk.calls[chunk.operand(offset)], offset);
+			default:
+				exit(offset);
+				return false;
+			}
+		}
+
+		void push_copy(const Reg base, const int32_t disp) {
+			for(int32_t i = 0; i < layout.size; i += 8) {
+				as.load(RAX, base, disp + i);
+				as.store(R13, i, RAX);
+			}
+			as.add(R13, layout.size);
+			result->growth++;
+		}
+
+		//! Pop the top value, and jump to target if it is false or empty
+		void jump_if_false(const size_t target) {
+			as.sub(R13, layout.size);
+			as.mov(RCX, bool_type);
+			as.cmp(R13, layout.type, RCX);
+			const size_t not_bool = as.jcc(NOT_EQUAL);
+			as.cmp8(R13, layout.bool_value, 0);
+			jumps.emplace_back(as.jcc(EQUAL), target);
+			const size_t done = as.jmp();
+			as.bind(not_bool);
+			as.mov(RCX, empty_type);
+			as.cmp(R13, layout.type, RCX);
+			jumps.emplace_back(as.jcc(EQUAL), target);
+			as.bind(done);
+		}
+
+		/**
+		 * Compile a call that looks up its function by name. Interfaces with
+		 * builtin implementations for int-32 or float-64 arguments get a
+		 * guarded fast path for each of them, the rest stop at the call.
+		 **/
+		bool invoke(const CallInfo &call, const size_t offset) {
+			vm::InterfaceFunction *interface = dynamic_cast<vm::InterfaceFunction*>(vm.fn_table.find_fn(*call.name));
+			if(!interface || call.num_args == 0 || call.num_args > 2) {
+				exit(offset);
+				return false;
+			}
+			std::vector<size_t> done;
+			bool guarded = false;
+			for(vm::Type *type : { int32_type, double_type }) {
+				const std::vector<vm::Type*> arg_types(call.num_args, type);
+				vm::VmFunction *impl = interface->find_impl(arg_types);
+				if(!impl) {
+					continue;
+				}
+				std::vector<size_t> mismatch;
+				if(Builtin2 *builtin = dynamic_cast<Builtin2*>(impl); builtin && call.num_args == 2) {
+					check_types(type, call.num_args, mismatch);
+					if(!native_arithmetic(call, type, builtin->function(), mismatch)) {
+						call_builtin(reinterpret_cast<const void*>(builtin->function()),
+									 reinterpret_cast<const void*>(&call_builtin_2), call.num_args, offset);
+					}
+				} else if(Builtin1 *builtin = dynamic_cast<Builtin1*>(impl); builtin && call.num_args == 1) {
+					check_types(type, call.num_args, mismatch);
+					call_builtin(reinterpret_cast<const void*>(builtin->function()),
+								 reinterpret_cast<const void*>(&call_builtin_1), call.num_args, offset);
+				} else {
+					continue;
+				}
+				guarded = true;
+				done.push_back(as.jmp());
+				for(const size_t fixup : mismatch) {
+					as.bind(fixup);
+				}
+			}
+			if(guarded) {
+				result->guards.push_back(JitCode::Guard{interface, interface->version()});
+			}
+			// Deoptimize: the interpreter dispatches the call
+			exit(offset);
+			for(const size_t fixup : done) {
+				as.bind(fixup);
+			}
+			return false;
+		}
+
+		//! Check that the top num_args values have the given type, adding a jump to mismatch for each
+		void check_types(vm::Type *type, const uint32_t num_args, std::vector<size_t> &mismatch) {
+			as.mov(RAX, type);
+			for(uint32_t i = 0; i < num_args; i++) {
+				as.cmp(R13, arg(i, num_args) + layout.type, RAX);
+				mismatch.push_back(as.jcc(NOT_EQUAL));
+			}
+		}
+
+		int32_t arg(const uint32_t index, const uint32_t num_args) const {
+			return (static_cast<int32_t>(index) - static_cast<int32_t>(num_args)) * layout.size;
+		}
+
+		/**
+		 * Do the arithmetic in place if fn is the standard library's, which
+		 * the arguments have already been checked for. Integer division
+		 * stops for divisors that would trap.
+		 **/
+		bool native_arithmetic(const CallInfo &call, const vm::Type *type,
+							   const Builtin2::FunctionType fn, std::vector<size_t> &mismatch) {
+			if(call.name->package != &vm.base_package()) {
+				return false;
+			}
+			const int32_t first = arg(0, 2);
+			const int32_t second = arg(1, 2);
+			const std::string_view name = call.name->name;
+			if(type == int32_type) {
+				const int32_t value = layout.int32_value;
+				if(name == "add" && fn == &vm::add<int32_t>) {
+					as.load32(RCX, R13, first + value);
+					as.add32(RCX, R13, second + value);
+				} else if(name == "subtract" && fn == &vm::subtract<int32_t>) {
+					as.load32(RCX, R13, first + value);
+					as.sub32(RCX, R13, second + value);
+				} else if(name == "multiply" && fn == &vm::multiply<int32_t>) {
+					as.load32(RCX, R13, first + value);
+					as.imul32(RCX, R13, second + value);
+				} else if(name == "divide" && fn == &vm::divide<int32_t>) {
+					as.load32(RCX, R13, second + value);
+					as.cmp32(RCX, 0);
+					mismatch.push_back(as.jcc(EQUAL));
+					as.cmp32(RCX, -1);
+					mismatch.push_back(as.jcc(EQUAL));
+					as.load32(RAX, R13, first + value);
+					as.idiv32(RCX);
+					as.mov(RCX, RAX);
+				} else {
+					return false;
+				}
+				as.store32(R13, first + value, RCX);
+			} else {
+				static constexpr uint8_t movsd_load = 0x10;
+				static constexpr uint8_t movsd_store = 0x11;
+				const int32_t value = layout.double_value;
+				uint8_t opcode;
+				if(name == "add" && fn == &vm::add<double>) {
+					opcode = 0x58;
+				} else if(name == "subtract" && fn == &vm::subtract<double>) {
+					opcode = 0x5C;
+				} else if(name == "multiply" && fn == &vm::multiply<double>) {
+					opcode = 0x59;
+				} else if(name == "divide" && fn == &vm::divide<double>) {
+					opcode = 0x5E;
+				} else {
+					return false;
+				}
+				as.sse(movsd_load, XMM0, R13, first + value);
+				as.sse(opcode, XMM0, R13, second + value);
+				as.sse(movsd_store, XMM0, R13, first + value);
+			}
+			as.sub(R13, layout.size);
+			return true;
+		}
+
+		//! Call the builtin fn through helper, leaving its result in place of the arguments
+		void call_builtin(const void *fn, const void *helper, const uint32_t num_args, const size_t offset) {
+			as.mov(RDI, RBX);
+			as.mov(RSI, fn);
+			as.lea(RDX, R13, arg(0, num_args));
+			as.mov(RAX, helper);
+			as.call(RAX);
+			as.test_al();
+			// The interpreter rethrows what the builtin threw
+			const size_t threw = as.jcc(EQUAL);
+			as.sub(R13, static_cast<int32_t>(num_args - 1) * layout.size);
+			const size_t returned = as.jmp();
+			as.bind(threw);
+			exit(offset);
+			as.bind(returned);
+		}
+
+		//! Stop, so the interpreter runs the instruction at offset
+		void exit(const size_t offset) {
+			as.store(RBX, offsetof(JitState, pc), static_cast<int32_t>(offset));
+			exits.push_back(as.jmp());
+		}
+
+		bool install() {
+			void *memory = mmap(nullptr, as.size(), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+			if(memory == MAP_FAILED) {
+				return false;
+			}
+			std::memcpy(memory, as.code.data(), as.size());
+			if(mprotect(memory, as.size(), PROT_READ | PROT_EXEC) != 0) {
+				munmap(memory, as.size());
+				return false;
+			}
+			result->memory = memory;
+			result->length = as.size();
+			return true;
+		}
+
+		const Chunk &chunk;
+		vm::VirtualMachine &vm;
+		vm::Type *const int32_type;
+		vm::Type *const double_type;
+		vm::Type *const bool_type;
+		vm::Type *const empty_type;
+		const BoxLayout layout;
+		Assembler as;
+		std::unique_ptr<JitCode> result;
+		//! Jumps to bytecode offsets, bound once every instruction has been placed
+		std::vector<std::pair<size_t, size_t>> jumps;
+		//! Jumps to the epilogue
+		std::vector<size_t> exits;
+	};
+
+	std::unique_ptr<JitCode> jit_compile(const Chunk &chunk, vm::VirtualMachine &vm) {
+		NativeCompiler compiler(chunk, vm);
+		return compiler.compile();
+	}
+
+#else
+
+	bool jit_supported() {
+		return false;
+	}
+
+	std::unique_ptr<JitCode> jit_compile(const Chunk &, vm::VirtualMachine &) {
+		return nullptr;
+	}
+
+#endif
+}
@@ -7,15 +7,18 @@
 #include <limits>
 #include <climits>
 #include <set>
-#include <list>
+#include <vector>
 #include <iterator>
 #include <utility>
 #include <optional>
 #include <algorithm>
+#include <array>
+#include <charconv>
 
 #include <util/assert.hpp>
 #include <compiler/parser.hpp>
 #include <compiler/CountingStream.hpp>
+#include <vm/hashset.hpp>
 
 namespace salmon::compiler {
 
@@ -55,6 +58,14 @@ namespace salmon::compiler {
 		source_file = file;
 	}
 
+	const salmon::meta::position_info &ParseException::start() const {
+		return expression_start;
+	}
+
+	const salmon::meta::position_info &ParseException::end() const {
+		return expression_end;
+	}
+
 	static std::string build_unmatched_error_str(const std::string_view message, const char ch) {
 		std::stringstream out;
 		out << message;
@@ -71,9 +82,14 @@ namespace salmon::compiler {
 		}
 	}
 
-	static char escape(std::istream &input) {
-		char ch = input.get();
-		switch(ch) {
+	static CountingStreamBuffer *tracker_from_stream(const std::istream &stream) {
+		return static_cast<CountingStreamBuffer*>(stream.std::ios::rdbuf());
+	}
+
+	static char escape(std::istream &input, const salmon::meta::position_info &start_info) {
+		const int read_in = input.get();
+		const char ch = static_cast<char>(read_in);
+		switch(read_in) {
 		case 'a':  return '\a';
 		case 'b':  return '\b';
 		case 'e':  return 27;
@@ -85,17 +101,15 @@ namespace salmon::compiler {
 		case '\\': return '\\';
 		case '\'': return '\'';
 		case '"':  return '"';
+		case EOF:
+			throw ParseException("EOF reached while parsing string",
+								 start_info, tracker_from_stream(input)->positionInfo());
 		default:
-			std::cerr << "Invalid escape character: " << ch << std::endl;
-			std::cerr << "Implement error handling at " << __FILE__ << ":" << __LINE__ << std::endl;
-			exit(-1);
+			throw ParseException(build_unmatched_error_str("Invalid escape character: \\", ch),
+								 start_info, tracker_from_stream(input)->positionInfo());
 		}
 	}
 
-	static CountingStreamBuffer *tracker_from_stream(const std::istream &stream) {
-		return static_cast<CountingStreamBuffer*>(stream.std::ios::rdbuf());
-	}
-
 	static salmon::vm::Box parse_string(std::istream &input, Compiler &compiler) {
 		CountingStreamBuffer *countStreamBuf = tracker_from_stream(input);
 
@@ -124,7 +138,7 @@ namespace salmon::compiler {
 			char ch = static_cast<char>(read_in);
 			if(ch == '\\') {
 				//convert escape sequence to character:
-				token << escape(input);
+				token << escape(input, start_info);
 			} else {
 				if (ch == '"') {
 					curCount++;
@@ -153,44 +167,142 @@ namespace salmon::compiler {
 	enum class NumberType {
 		NOT_A_NUM,
 		FLOAT,
+		FLOAT_32,
 		INTEGER
 	};
 
+	static bool is_digit(char c) {
+		return c >= '0' && c <= '9';
+	}
+
+	/**
+	 * Numbers are an optional sign, digits with at most one '.' among them, and
+	 * an optional exponent. Floats ending in 'f' are 32 bit.
+	 **/
 	static NumberType get_num_type(const std::string_view symbol) {
+		size_t i = 0;
+		auto skip_digits = [&symbol, &i]() {
+			const size_t start = i;
+			while(i < symbol.size() && is_digit(symbol[i])) {
+				i++;
+			}
+			return i - start;
+		};
+
+		if(i < symbol.size() && (symbol[i] == '-' || symbol[i] == '+')) {
+			i++;
+		}
+		size_t digits = skip_digits();
 		NumberType num_type = NumberType::INTEGER;
-		for(size_t i = 0; i < symbol.length(); i++) {
-			auto c = symbol[i];
-			if(c == '.') {
-				if(num_type == NumberType::INTEGER) {
-				    num_type = NumberType::FLOAT;
-				} else {
-					// there are more than two '.', not a number
-					return NumberType::NOT_A_NUM;
-				}
-			} else if(!std::isdigit(static_cast<unsigned char>(c))) {
+		if(i < symbol.size() && symbol[i] == '.') {
+			i++;
+			digits += skip_digits();
+			num_type = NumberType::FLOAT;
+		}
+		if(digits == 0) {
+			return NumberType::NOT_A_NUM;
+		}
+		if(i < symbol.size() && (symbol[i] == 'e' || symbol[i] == 'E')) {
+			i++;
+			if(i < symbol.size() && (symbol[i] == '-' || symbol[i] == '+')) {
+				i++;
+			}
+			if(skip_digits() == 0) {
 				return NumberType::NOT_A_NUM;
 			}
+			num_type = NumberType::FLOAT;
 		}
-		return num_type;
+		if(i + 1 == symbol.size() && symbol[i] == 'f') {
+			return NumberType::FLOAT_32;
+		}
+		return i == symbol.size() ? num_type : NumberType::NOT_A_NUM;
 	}
 
-	static std::string read_atom(std::istream &input) {
-		static const std::set<char> terminating_chars =
-			{ '(', ')', '[', ']', '{', '}', '"'};
-		std::ostringstream token;
-		int read_in;
-		// use peek() so terminating chars aren't consumed:
-		while( (read_in = input.peek()) && read_in != EOF) {
-			char ch = static_cast<char>(read_in);
-			if(std::isspace(static_cast<unsigned char>(ch)) ||
-			   terminating_chars.contains(ch)) {
-				break;
+	//! Box an integer in the smallest of int-32, int-64 and uint-64 it fits in
+	static vm::Box box_integer(uint64_t value, Compiler &compiler) {
+		if(value <= static_cast<uint64_t>(std::numeric_limits<int32_t>::max())) {
+			return compiler.vm.make_boxed(static_cast<int32_t>(value));
+		} else if(value <= static_cast<uint64_t>(std::numeric_limits<int64_t>::max())) {
+			return compiler.vm.make_boxed(static_cast<int64_t>(value));
+		}
+		return compiler.vm.make_boxed(value);
+	}
+
+	static vm::Box box_integer(int64_t value, Compiler &compiler) {
+		if(value >= 0) {
+			return box_integer(static_cast<uint64_t>(value), compiler);
+		} else if(value >= std::numeric_limits<int32_t>::min()) {
+			return compiler.vm.make_boxed(static_cast<int32_t>(value));
+		}
+		return compiler.vm.make_boxed(value);
+	}
+
+	//! Read an atom that get_num_type says is a number of the given type
+	static vm::Box parse_number(const std::string_view atom, const NumberType type, Compiler &compiler,
+								const salmon::meta::position_info &start_info,
+								const salmon::meta::position_info &end_info) {
+		const char *first = atom.data();
+		const char *last = atom.data() + atom.size();
+		// from_chars doesn't accept a leading '+'
+		if(*first == '+') {
+			first++;
+		}
+		auto check = [&](std::from_chars_result result, const char *end, const char *what) {
+			if(result.ec == std::errc::result_out_of_range) {
+				throw ParseException(std::string(what) + " is out of range: " + std::string(atom),
+									 start_info, end_info);
+			}
+			salmon_check(result.ec == std::errc() && result.ptr == end, "Number should have been classified correctly");
+		};
+
+		switch(type) {
+		case NumberType::INTEGER:
+			if(*first == '-') {
+				int64_t value{};
+				check(std::from_chars(first, last, value), last, "Integer");
+				return box_integer(value, compiler);
 			} else {
-				token << ch;
-				input.get();
+				uint64_t value{};
+				check(std::from_chars(first, last, value), last, "Integer");
+				return box_integer(value, compiler);
 			}
+		case NumberType::FLOAT: {
+			double value{};
+			check(std::from_chars(first, last, value), last, "Float");
+			return compiler.vm.make_boxed(value);
+		}
+		case NumberType::FLOAT_32: {
+			float value{};
+			check(std::from_chars(first, last - 1, value), last - 1, "Float");
+			return compiler.vm.make_boxed(value);
 		}
-		return token.str();
+		case NumberType::NOT_A_NUM:
+			break;
+		}
+		salmon_abort("Atom should be a number");
+		return compiler.vm.make_boxed(vm::Empty{});
+	}
+
+	static bool is_terminating(int ch) {
+		switch(ch) {
+		case '(': case ')': case '[': case ']': case '{': case '}': case '"':
+			return true;
+		default:
+			return std::isspace(ch);
+		}
+	}
+
+	static std::string read_atom(std::istream &input) {
+		// Read straight from the buffer, the stream notices the end itself on its next read
+		std::streambuf *buffer = input.rdbuf();
+		std::string token;
+		int read_in;
+		// use sgetc() so terminating chars aren't consumed:
+		while((read_in = buffer->sgetc()) != EOF && !is_terminating(read_in)) {
+			token.push_back(static_cast<char>(read_in));
+			buffer->sbumpc();
+		}
+		return token;
 	}
 
 	static salmon::vm::Box read_uninterned_symbol(std::istream &input, Compiler &compiler) {
@@ -216,33 +328,9 @@ namespace salmon::compiler {
 		}
 	}
 
-	namespace {
-		struct HexTable {
-			unsigned int tab[128];
-			constexpr HexTable() : tab {} {
-				tab[static_cast<int>('1')] = 1; tab[static_cast<int>('2')] = 2;
-				tab[static_cast<int>('3')] = 3; tab[static_cast<int>('4')] = 4;
-				tab[static_cast<int>('5')] = 5; tab[static_cast<int>('6')] = 6;
-				tab[static_cast<int>('7')] = 7; tab[static_cast<int>('8')] = 8;
-				tab[static_cast<int>('9')] = 9; tab[static_cast<int>('a')] = 10;
-				tab[static_cast<int>('A')] = 10; tab[static_cast<int>('b')] = 11;
-				tab[static_cast<int>('B')] = 11; tab[static_cast<int>('c')] = 12;
-				tab[static_cast<int>('C')] = 12; tab[static_cast<int>('d')] = 13;
-				tab[static_cast<int>('D')] = 13; tab[static_cast<int>('e')] = 14;
-				tab[static_cast<int>('E')] = 14; tab[static_cast<int>('f')] = 15;
-				tab[static_cast<int>('F')] = 15;
-			}
-			constexpr unsigned int operator[](char const idx) const {
-				return tab[static_cast<std::size_t>(idx)];
-			}
-		} constexpr table;
-	}
-
-	static constexpr unsigned int hex_to_int(char number) {
-		return table[static_cast<std::size_t>(number)];
-	}
-
-	static salmon::vm::Box read_hex_atom(std::istream &input, Compiler &compiler) {
+	//! Read an integer written in the given base, like the ones after #x
+	static salmon::vm::Box read_radix_atom(std::istream &input, Compiler &compiler,
+										   const int base, const std::string_view macro) {
 		CountingStreamBuffer *countStreamBuf = tracker_from_stream(input);
 
 		const salmon::meta::position_info start_info = countStreamBuf->positionInfo();
@@ -250,38 +338,51 @@ namespace salmon::compiler {
 		std::string chunk = read_atom(input);
 
 		if(chunk.empty()) {
-			throw ParseException("Reached EOF while parsing reader macro #x",
+			throw ParseException("Reached EOF while parsing reader macro " + std::string(macro),
 			 					 start_info, countStreamBuf->positionInfo());
 		}
 
-		bool is_valid_hex = std::all_of(chunk.begin(), chunk.end(), [](const auto c) {
-			salmon_check(c != EOF, "Character in string is EOF char");
-			return std::isxdigit(static_cast<unsigned char>(c));
-		});
-		if(!is_valid_hex)  {
-			// TODO: implement error handling here.
-			std::cerr << "Invalid hex string: " << chunk << '\n';
-			std::cerr << "Implement error handling at " << __FILE__ << ":" << __LINE__ << std::endl;
-			exit(-1);
+		uint64_t value{};
+		const char *last = chunk.data() + chunk.size();
+		const auto [end, error] = std::from_chars(chunk.data(), last, value, base);
+		if(error == std::errc::result_out_of_range) {
+			throw ParseException("Number is too big to fit into a 64 bit integer: " + std::string(macro) + chunk,
+								 start_info, countStreamBuf->positionInfo());
+		} else if(error != std::errc() || end != last) {
+			throw ParseException("Invalid number: " + std::string(macro) + chunk,
+								 start_info, countStreamBuf->positionInfo());
 		}
+		return box_integer(value, compiler);
+	}
+
+	//! Read a character literal like #\a or #\space as its character code
+	static salmon::vm::Box read_character(std::istream &input, Compiler &compiler) {
+		static const std::array<std::pair<std::string_view, char>, 7> names = {{
+			{ "space", ' ' }, { "newline", '\n' }, { "tab", '\t' }, { "return", '\r' },
+			{ "nul", '\0' }, { "escape", 27 }, { "backspace", '\b' }
+		}};
+		CountingStreamBuffer *countStreamBuf = tracker_from_stream(input);
+
+		const salmon::meta::position_info start_info = countStreamBuf->positionInfo();
 
-		// FIXME: check if it needs more than 32 bytes and use the smallest possible type
-		if(chunk.size() > 8) {
-			// value is too big!
-			std::cerr << "Hex string is too big to fit into a 32 bit integer: #x" << chunk << '\n';
-			std::cerr << "Implement error handling at " << __FILE__ << ":" << __LINE__ << std::endl;
-			exit(-1);
+		// The first character is taken as is, even when it would end an atom:
+		const int first = input.get();
+		if(first == EOF) {
+			throw ParseException("Reached EOF while parsing reader macro #\\",
+								 start_info, countStreamBuf->positionInfo());
 		}
-		uint32_t sum = 0;
-		for(const auto c : chunk) {
-		    uint32_t digit = hex_to_int(c);
-			sum <<= 4;
-			sum |= digit;
+		std::string rest = read_atom(input);
+		if(rest.empty()) {
+			return compiler.vm.make_boxed(static_cast<int32_t>(static_cast<unsigned char>(first)));
 		}
-
-		// TODO: add unsigned integers:
-		vm::Box box = compiler.vm.make_boxed(static_cast<int32_t>(sum));
-		return box;
+		const std::string name = static_cast<char>(first) + rest;
+		for(const auto &[char_name, ch] : names) {
+			if(name == char_name) {
+				return compiler.vm.make_boxed(static_cast<int32_t>(ch));
+			}
+		}
+		throw ParseException("Unknown character name: #\\" + name,
+							 start_info, countStreamBuf->positionInfo());
 	}
 
 	static salmon::vm::Box reader_macro(std::istream &input, Compiler &compiler) {
@@ -292,22 +393,16 @@ namespace salmon::compiler {
 		input.get();
 
 		int ch = input.get();
-
-		switch(ch) {
-		case ':':
-			return read_uninterned_symbol(input, compiler);
-		case 'x':
-			return read_hex_atom(input, compiler);
-		case '\n':
-			throw ParseException("Reached EOF while parsing reader macro",
-								 start_info, countStreamBuf->positionInfo());
-		case EOF:
+		if(ch == EOF || ch == '\n') {
 			throw ParseException("Reached EOF while parsing reader macro",
 								 start_info, countStreamBuf->positionInfo());
-		default:
+		}
+		const ReaderMacro *macro = compiler.reader_macros.get(static_cast<char>(ch));
+		if(!macro) {
 			throw ParseException(build_unmatched_error_str("Unkown macro dispatch character: ", ch),
 								 start_info, countStreamBuf->positionInfo());
 		}
+		return (*macro)(input, compiler);
 	}
 
 	static bool isKeyword(const std::string_view symbol) {
@@ -316,22 +411,15 @@ namespace salmon::compiler {
 	}
 
 	static salmon::vm::Box parse_primitive(std::istream &input, Compiler &compiler) {
+		CountingStreamBuffer *countStreamBuf = tracker_from_stream(input);
+		const salmon::meta::position_info start_info = countStreamBuf->positionInfo();
 
 		std::string chunk = read_atom(input);
 		salmon_check(!chunk.empty(), "Atom shouldn't be empty");
 
 		std::optional<vm::Box> box{std::nullopt};
 		if(NumberType type = get_num_type(chunk); type != NumberType::NOT_A_NUM) {
-			switch(type) {
-			case NumberType::FLOAT:
-				box.emplace(compiler.vm.make_boxed(static_cast<double>(std::stod(chunk))));
-				break;
-			case NumberType::INTEGER:
-				box.emplace(compiler.vm.make_boxed(static_cast<int32_t>(std::stoi(chunk))));
-				break;
-			case NumberType::NOT_A_NUM:
-				salmon_abort("Primitive type should always be a number");
-			}
+			box.emplace(parse_number(chunk, type, compiler, start_info, countStreamBuf->positionInfo()));
 		} else if(isKeyword(chunk)) {
 			auto symb = compiler.keyword_package()->intern_symbol(chunk.substr(1));
 			box.emplace(compiler.vm.make_boxed(symb));
@@ -354,14 +442,12 @@ namespace salmon::compiler {
 		// parent function doesn't consume quote char:
 		input.get();
 		vm::vm_ptr<vm::Symbol> quote_symb = compiler.vm.base_package().intern_symbol("quote");
-		vm::vm_ptr<vm::List> list = compiler.vm.mem_manager.allocate_obj<vm::List>(
-			compiler.vm.make_boxed(quote_symb));
 
 		auto [result, cur_item] = read_next(input, compiler);
 		if(result == ReadResult::ITEM) {
 			salmon_check(cur_item != std::nullopt, "Unexpected std::nullopt");
-			vm::vm_ptr<vm::List> cdr = compiler.vm.mem_manager.allocate_obj<vm::List>(*cur_item);
-			list->next = &*cdr;
+			vm::vm_ptr<vm::List> list = compiler.vm.mem_manager.allocate_list(
+				{ compiler.vm.make_boxed(quote_symb), *cur_item });
 			return compiler.vm.make_boxed(list);
 		} else {
 			meta::position_info end_info = countStreamBuf->positionInfo();
@@ -370,17 +456,15 @@ namespace salmon::compiler {
 		}
 	}
 
-	static std::list<salmon::vm::Box> collect_list(std::istream &input, const ReadResult &terminator,
-		Compiler &compiler) {
+	//! Read the items up to the terminator, after the opening character was consumed
+	static std::vector<salmon::vm::Box> collect_items(std::istream &input, const char opening_char,
+													  const ReadResult &terminator, Compiler &compiler) {
 		CountingStreamBuffer *countStreamBuf = tracker_from_stream(input);
 
 		const salmon::meta::position_info start_info = countStreamBuf->positionInfo();
 		salmon::meta::position_info end_info;
 
-		// consume the starting bracket/brace/etc.
-		int opening_char = input.get();
-
-		std::list<salmon::vm::Box> items;
+		std::vector<salmon::vm::Box> items;
 		{
 			auto [result, cur_item] = read_next(input, compiler);
 			while(result != terminator) {
@@ -404,18 +488,25 @@ namespace salmon::compiler {
 		return items;
 	}
 
+	static std::vector<salmon::vm::Box> collect_list(std::istream &input, const ReadResult &terminator,
+		Compiler &compiler) {
+		// consume the starting bracket/brace/etc.
+		const char opening_char = static_cast<char>(input.get());
+		return collect_items(input, opening_char, terminator, compiler);
+	}
+
+	static salmon::vm::Box make_vector(const std::vector<salmon::vm::Box> &items, Compiler &compiler) {
+		vm::vm_ptr<vm::Vector> array = compiler.vm.mem_manager.allocate_obj<vm::Vector>(items.size());
+		for(const salmon::vm::Box &box : items) {
+			array->push_back(box);
+		}
+		return compiler.vm.make_boxed(array);
+	}
+
 	static salmon::vm::Box read_list(std::istream &input, Compiler &compiler) {
-		std::list<salmon::vm::Box> collected_items = collect_list(input, ReadResult::R_PAREN, compiler);
+		std::vector<salmon::vm::Box> collected_items = collect_list(input, ReadResult::R_PAREN, compiler);
 		if (!collected_items.empty()) {
-			vm::Box first = collected_items.front();
-			vm::vm_ptr<vm::List> head = compiler.vm.mem_manager.allocate_obj<vm::List>(first);
-			collected_items.pop_front();
-			vm::vm_ptr<vm::List> tail = head;
-			for(salmon::vm::Box &box : collected_items) {
-				vm::vm_ptr<vm::List> next = compiler.vm.mem_manager.allocate_obj<vm::List>(box);
-				tail->next = &*next;
-				tail = next;
-			}
+			vm::vm_ptr<vm::List> head = compiler.vm.mem_manager.allocate_list(collected_items);
 			vm::Box box = compiler.vm.make_boxed(head);
 			return box;
 		} else {
@@ -426,21 +517,84 @@ namespace salmon::compiler {
 	}
 
 	static salmon::vm::Box read_array(std::istream &input, Compiler &compiler) {
-		std::list<salmon::vm::Box> collected_items = collect_list(input, ReadResult::R_BRACKET, compiler);
-		vm::vm_ptr<vm::Vector> array = compiler.vm.mem_manager.allocate_obj<vm::Vector>(collected_items.size());
+		return make_vector(collect_list(input, ReadResult::R_BRACKET, compiler), compiler);
+	}
+
+	static salmon::vm::Box read_set(std::istream &input, Compiler &compiler) {
+		std::vector<salmon::vm::Box> collected_items = collect_list(input, ReadResult::R_BRACE, compiler);
+		vm::vm_ptr<vm::HashSet> set = compiler.vm.mem_manager.allocate_obj<vm::HashSet>(collected_items.size());
 		for(salmon::vm::Box &box : collected_items) {
-			array->push_back(box);
+			set->insert(box);
 		}
-		vm::Box box = compiler.vm.make_boxed(array);
+		vm::Box box = compiler.vm.make_boxed(set);
 		return box;
 	}
 
+	ReaderMacroTable::ReaderMacroTable() : macros{}, is_customized{false} {
+		auto radix = [](const int base, const std::string_view macro) {
+			return [base, macro](std::istream &input, Compiler &compiler) {
+				return read_radix_atom(input, compiler, base, macro);
+			};
+		};
+		macros[':'] = read_uninterned_symbol;
+		macros['x'] = radix(16, "#x");
+		macros['o'] = radix(8, "#o");
+		macros['b'] = radix(2, "#b");
+		macros['\\'] = read_character;
+		macros['('] = [](std::istream &input, Compiler &compiler) {
+			return make_vector(collect_items(input, '(', ReadResult::R_PAREN, compiler), compiler);
+		};
+	}
+
+	void ReaderMacroTable::set(const char dispatch, ReaderMacro macro) {
+		macros[static_cast<unsigned char>(dispatch)] = std::move(macro);
+		is_customized = true;
+	}
+
+	void ReaderMacroTable::remove(const char dispatch) {
+		macros[static_cast<unsigned char>(dispatch)] = nullptr;
+		is_customized = true;
+	}
+
+	const ReaderMacro *ReaderMacroTable::get(const char dispatch) const {
+		const ReaderMacro &macro = macros[static_cast<unsigned char>(dispatch)];
+		return macro ? &macro : nullptr;
+	}
+
+	bool ReaderMacroTable::customized() const {
+		return is_customized;
+	}
+
+	//! Record where the item was read if the compiler keeps source locations
+	static std::pair<ReadResult, std::optional<salmon::vm::Box>>
+	located(const salmon::meta::position_info &start_info, salmon::vm::Box item,
+			const std::istream &input, Compiler &compiler) {
+		if(compiler.source_locations) {
+			// Only containers and strings are unique to where they were read
+			const vm::AllocatedItem *allocated = std::visit([](auto &&arg) -> const vm::AllocatedItem* {
+				using T = std::decay_t<decltype(arg)>;
+				if constexpr (std::is_same<T, vm::List*>::value || std::is_same<T, vm::Vector*>::value ||
+							  std::is_same<T, vm::HashSet*>::value || std::is_same<T, vm::StaticString*>::value) {
+					return arg;
+				} else {
+					return nullptr;
+				}
+			}, item.value());
+			if(allocated) {
+				compiler.source_locations->record(allocated, start_info,
+												  tracker_from_stream(input)->positionInfo());
+			}
+		}
+		return std::make_pair(ReadResult::ITEM, std::move(item));
+	}
+
 	static std::pair<ReadResult, std::optional<salmon::vm::Box>> read_next(std::istream &input,
 																	   Compiler &compiler) {
 		do {
 			//consume any preceding whitespace:
 			trim_stream(input);
 			int read_in = input.peek();
+			const salmon::meta::position_info start_info = tracker_from_stream(input)->positionInfo();
 
 			if(read_in != EOF) {
 				char ch = static_cast<char>(read_in);
@@ -450,30 +604,26 @@ namespace salmon::compiler {
 					input.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
 					break;
 				case '(':
-					return std::make_pair(ReadResult::ITEM, read_list(input, compiler));
+					return located(start_info, read_list(input, compiler), input, compiler);
 				case ')':
 					input.get();
 					return std::make_pair(ReadResult::R_PAREN, std::nullopt);
 				case '[':
-					return std::make_pair(ReadResult::ITEM, read_array(input, compiler));
+					return located(start_info, read_array(input, compiler), input, compiler);
 				case ']':
 					input.get();
 					return std::make_pair(ReadResult::R_BRACKET, std::nullopt);
 				case '{':
-					std::cerr << "Reading sets aren't implemented yet"
-							  << __FILE__ << ":" << __LINE__ << std::endl;
-					exit(-1);
-					return std::make_pair(ReadResult::R_BRACE, std::nullopt);
+					return located(start_info, read_set(input, compiler), input, compiler);
 				case '}':
 					input.get();
 					return std::make_pair(ReadResult::R_BRACE, std::nullopt);
 				case '#':
-					return std::make_pair(ReadResult::ITEM, reader_macro(input, compiler));
+					return located(start_info, reader_macro(input, compiler), input, compiler);
 				case '"':
-					return std::make_pair(ReadResult::ITEM,
-										  parse_string(input, compiler));
+					return located(start_info, parse_string(input, compiler), input, compiler);
 				case '\'':
-					return std::make_pair(ReadResult::ITEM, quote(input, compiler));
+					return located(start_info, quote(input, compiler), input, compiler);
 				default:
 					return std::make_pair(ReadResult::ITEM,
 										  parse_primitive(input, compiler));
@@ -517,6 +667,183 @@ namespace salmon::compiler {
 		}
 	}
 
+	//! Skip to the next '(' that starts a line, or the end of the input
+	static void skip_to_toplevel(CountingStreamBuffer &countStreamBuf) {
+		int ch;
+		while((ch = countStreamBuf.sgetc()) != EOF) {
+			if(ch == '(' && countStreamBuf.column() == 0) {
+				return;
+			}
+			countStreamBuf.sbumpc();
+		}
+	}
+
+	/**
+	 * Read a single form, returning a parse error instead of throwing it. The
+	 * stream is left where the error was found, or one character on if that
+	 * is where it started, so reading always makes progress.
+	 **/
+	static std::optional<ReadItem> read_or_error(CountingStreamBuffer &countStreamBuf, Compiler &compiler) {
+		const std::streamsize start = countStreamBuf.filepos();
+		try {
+			std::optional<vm::Box> form = read(countStreamBuf, compiler);
+			if(!form) {
+				return std::nullopt;
+			}
+			return ReadItem{std::move(form), std::nullopt};
+		} catch(ParseException &error) {
+			if(countStreamBuf.filepos() == start) {
+				countStreamBuf.sbumpc();
+			}
+			return ReadItem{std::nullopt, std::move(error)};
+		}
+	}
+
+	std::optional<ReadItem> read_recovering(CountingStreamBuffer &countStreamBuf, Compiler &compiler) {
+		std::optional<ReadItem> item = read_or_error(countStreamBuf, compiler);
+		if(item && item->error) {
+			skip_to_toplevel(countStreamBuf);
+		}
+		return item;
+	}
+
+	//! Offset of the first character after offset that isn't whitespace or in a comment
+	static size_t skip_blank(const std::string_view source, size_t offset) {
+		while(offset < source.size()) {
+			if(source[offset] == ';') {
+				offset = std::min(source.find('\n', offset), source.size());
+			} else if(std::isspace(static_cast<unsigned char>(source[offset]))) {
+				offset++;
+			} else {
+				break;
+			}
+		}
+		return offset;
+	}
+
+	//! Offset of the first '(' that starts a line after offset, or npos if there isn't one
+	static size_t find_toplevel(const std::string_view source, const size_t offset) {
+		for(size_t i = source.find('(', offset + 1); i < source.size(); i = source.find('(', i + 1)) {
+			if(source[i - 1] == '\n') {
+				return i;
+			}
+		}
+		return std::string_view::npos;
+	}
+
+	//! The position of the character at offset, given the position of the one at from
+	static salmon::meta::position_info advance(const std::string_view source, const size_t from,
+											   const salmon::meta::position_info &position, const size_t offset) {
+		const std::string_view skipped = source.substr(from, offset - from);
+		const size_t last_line = skipped.rfind('\n');
+		if(last_line == std::string_view::npos) {
+			return { position.line, position.column + static_cast<unsigned int>(skipped.size()) };
+		}
+		const auto lines = std::count(skipped.begin(), skipped.end(), '\n');
+		return { position.line + static_cast<unsigned int>(lines),
+				 static_cast<unsigned int>(skipped.size() - last_line - 1) };
+	}
+
+	ReadForms read_all(CountingStreamBuffer &countStreamBuf, Compiler &compiler) {
+		// The input is kept, so reading can go back into a form that ran off the end of it
+		const salmon::meta::position_info input_start = countStreamBuf.positionInfo();
+		const std::streamsize input_pos = countStreamBuf.filepos();
+		const std::string source{std::istreambuf_iterator<char>(&countStreamBuf), std::istreambuf_iterator<char>()};
+
+		ReadForms result;
+		size_t offset = 0;
+		salmon::meta::position_info position = input_start;
+		while(true) {
+			StringViewBuffer view(source, offset);
+			CountingStreamBuffer buffer(&view, position, input_pos + static_cast<std::streamsize>(offset));
+			while(true) {
+				const size_t form_start = static_cast<size_t>(buffer.filepos() - input_pos);
+				const salmon::meta::position_info form_position = buffer.positionInfo();
+				std::optional<ReadItem> item = read_or_error(buffer, compiler);
+				if(!item) {
+					return result;
+				} else if(item->form) {
+					result.forms.push_back(*item->form);
+					continue;
+				}
+				if(buffer.sgetc() != EOF) {
+					result.errors.push_back(std::move(*item->error));
+					skip_to_toplevel(buffer);
+					continue;
+				}
+				// A form that isn't closed takes up the rest of the input. The
+				// error is put at its start, since the list the reader was in
+				// when the input ran out may be nested in it, and reading starts
+				// again at the first line after that looks like a new form.
+				const size_t opening = skip_blank(source, form_start);
+				result.errors.emplace_back(item->error->what(),
+										   advance(source, form_start, form_position, opening),
+										   item->error->end());
+				offset = find_toplevel(source, opening);
+				if(offset == std::string_view::npos) {
+					return result;
+				}
+				position = advance(source, form_start, form_position, offset);
+				break;
+			}
+		}
+	}
+
+	bool needs_more_input(const std::string_view source) {
+		long depth = 0;
+		for(size_t i = 0; i < source.size(); i++) {
+			switch(source[i]) {
+			case ';':
+				i = source.find('\n', i);
+				if(i == std::string_view::npos) {
+					return depth > 0;
+				}
+				break;
+			case '#':
+				// skip character literals, so #\( doesn't open a list
+				if(i + 1 < source.size() && source[i + 1] == '\\') {
+					i += 2;
+				}
+				break;
+			case '"': {
+				// strings end with as many quotes as they start with
+				size_t quotes = 0;
+				while(i < source.size() && source[i] == '"') {
+					quotes++;
+					i++;
+				}
+				if(quotes == 2) {
+					i--;
+					break;
+				}
+				size_t closing = 0;
+				for(; i < source.size() && closing != quotes; i++) {
+					if(source[i] == '\\') {
+						i++;
+						closing = 0;
+					} else {
+						closing = source[i] == '"' ? closing + 1 : 0;
+					}
+				}
+				if(closing != quotes) {
+					return true;
+				}
+				i--;
+				break;
+			}
+			case '(': case '[': case '{':
+				depth++;
+				break;
+			case ')': case ']': case '}':
+				depth--;
+				break;
+			default:
+				break;
+			}
+		}
+		return depth > 0;
+	}
+
 	std::optional<salmon::vm::Box> read_from_string(const std::string& input, Compiler &compiler) {
 		std::istringstream input_stream(input);
 		CountingStreamBuffer countStreamBuf(input_stream);
@@ -0,0 +1,304 @@
+#include <algorithm>
+#include <optional>
+#include <span>
+
+#include <util/assert.hpp>
+#include <compiler/registercode.hpp>
+#include <compiler/registerinterpreter.hpp>
+#include <compiler/specialforms.hpp>
+
+namespace salmon::compiler {
+
+	static const char *opcode_name(const RegisterOpcode op) {
+		switch(op) {
+		case RegisterOpcode::MOVE: return "MOVE";
+		case RegisterOpcode::JMP: return "JMP";
+		case RegisterOpcode::JMP_F: return "JMP_F";
+		case RegisterOpcode::INVOKE: return "INVOKE";
+		case RegisterOpcode::TAILCALL: return "TAILCALL";
+		case RegisterOpcode::RETURN: return "RETURN";
+		}
+		salmon_abort("Unknown opcode");
+		return "";
+	}
+
+	namespace {
+		//! Prints an operand as rN for registers and kN for constants
+		struct PrintOperand {
+			Operand operand;
+		};
+
+		std::ostream &operator<<(std::ostream &out, const PrintOperand &print) {
+			if(print.operand & constant_bit) {
+				return out << 'k' << (print.operand & ~constant_bit);
+			}
+			return out << 'r' << print.operand;
+		}
+
+		void print_call(std::ostream &out, const RegisterChunk &chunk, const uint32_t index) {
+			const RegisterCall &call = chunk.calls[index];
+			out << call.name->name;
+			for(uint32_t i = 0; i < call.num_args; i++) {
+				out << ' ' << PrintOperand{chunk.call_args[call.first_arg + i]};
+			}
+		}
+	}
+
+	std::ostream &operator<<(std::ostream &out, const RegisterChunk &chunk) {
+		for(const Instruction &instruction : chunk.code) {
+			out << opcode_name(instruction.op);
+			switch(instruction.op) {
+			case RegisterOpcode::MOVE:
+				out << " r" << instruction.a << ' ' << PrintOperand{instruction.b};
+				break;
+			case RegisterOpcode::JMP:
+				out << ' ' << instruction.b;
+				break;
+			case RegisterOpcode::JMP_F:
+				out << ' ' << PrintOperand{instruction.a} << ' ' << instruction.b;
+				break;
+			case RegisterOpcode::INVOKE:
+				out << " r" << instruction.a << " (";
+				print_call(out, chunk, instruction.b);
+				out << ')';
+				break;
+			case RegisterOpcode::TAILCALL:
+				out << " (";
+				print_call(out, chunk, instruction.b);
+				out << ')';
+				break;
+			case RegisterOpcode::RETURN:
+				out << ' ' << PrintOperand{instruction.a};
+				break;
+			}
+			out << '\n';
+		}
+		return out;
+	}
+
+	namespace {
+		class RegisterCompiler {
+		public:
+			//! Compile a top-level form into chunk
+			RegisterCompiler(Compiler &compiler, RegisterChunk &chunk, const bool fold) :
+				RegisterCompiler(compiler, chunk, fold, {}, false) {}
+			//! Compile the body of a function taking params into chunk
+			RegisterCompiler(Compiler &compiler, RegisterChunk &chunk, const bool fold,
+							 std::span<vm::Symbol* const> params) :
+				RegisterCompiler(compiler, chunk, fold, params, true) {}
+
+			/**
+			 * Compile the form, returning the operand its value ends up in.
+			 * A call puts its result in dest if it is given, or else in the
+			 * first free register.
+			 **/
+			Operand compile(const vm::InternalBox &form, const std::optional<uint32_t> dest = std::nullopt) {
+				if(vm::List *const *list = std::get_if<vm::List*>(&form.elem)) {
+					return compile_list(*list, dest);
+				} else if(vm::Symbol *const *symbol = std::get_if<vm::Symbol*>(&form.elem);
+						  symbol && (*symbol)->package != compiler.keyword_package()) {
+					const auto param = std::find(params.begin(), params.end(), *symbol);
+					if(param == params.end()) {
+						throw CompileError("Variables can't be compiled yet: " + (*symbol)->name, *symbol);
+					}
+					return static_cast<Operand>(param - params.begin());
+				}
+				return add_constant(vm::Box(form, compiler.vm.mem_manager.make_vm_ptr<vm::AllocatedItem>()));
+			}
+
+			//! Compile a form whose value is returned from the chunk
+			void compile_return(const vm::InternalBox &form) {
+				vm::List *const *list = std::get_if<vm::List*>(&form.elem);
+				vm::Symbol *const *name = list ? std::get_if<vm::Symbol*>(&(*list)->itm.elem) : nullptr;
+				if(in_function && name && *name == special_forms.if_form) {
+					const Conditional conditional = parse_if(*list);
+					const Operand test = compile(*conditional.test);
+					free_registers(params.size());
+					const size_t jump_to_else = emit(RegisterOpcode::JMP_F, test, 0);
+					compile_return(*conditional.then);
+					chunk.code[jump_to_else].b = static_cast<uint32_t>(chunk.code.size());
+					if(conditional.otherwise) {
+						compile_return(*conditional.otherwise);
+					} else {
+						emit(RegisterOpcode::RETURN, add_constant(compiler.vm.make_boxed(vm::Empty{})), 0);
+					}
+					return;
+				} else if(in_function && name && *name != special_forms.defn && *name != special_forms.defextern) {
+					const std::optional<Operand> folded = compile_call(*list, **name, RegisterOpcode::TAILCALL, 0);
+					if(folded) {
+						emit(RegisterOpcode::RETURN, *folded, 0);
+					}
+					return;
+				}
+				emit(RegisterOpcode::RETURN, compile(form), 0);
+			}
+
+			//! Compile the body of a function, returning the value of its last form
+			void compile_body(const vm::List *body) {
+				for(; body->next != nullptr; body = body->next) {
+					compile(body->itm);
+					free_registers(params.size());
+				}
+				compile_return(body->itm);
+			}
+
+		private:
+			RegisterCompiler(Compiler &compiler, RegisterChunk &chunk, const bool fold,
+							 std::span<vm::Symbol* const> params, const bool in_function) :
+				compiler{compiler}, chunk{chunk}, fold{fold}, params{params}, in_function{in_function},
+				special_forms{compiler}, next_register{static_cast<uint32_t>(params.size())} {
+				chunk.num_registers = next_register;
+			}
+
+			Operand compile_list(vm::List *list, const std::optional<uint32_t> dest) {
+				vm::Symbol *const *name = std::get_if<vm::Symbol*>(&list->itm.elem);
+				if(!name) {
+					throw CompileError("Only calls to named functions can be compiled", list);
+				} else if(*name == special_forms.defn) {
+					return compile_defn(list);
+				} else if(*name == special_forms.defextern) {
+					return compile_defextern(list);
+				} else if(*name == special_forms.if_form) {
+					return compile_if(list, dest);
+				}
+				const uint32_t result = dest ? *dest : next_register;
+				const std::optional<Operand> folded = compile_call(list, **name, RegisterOpcode::INVOKE, result);
+				if(folded) {
+					return *folded;
+				}
+				return result;
+			}
+
+			/**
+			 * Compile the arguments of a call and emit it. Returns the
+			 * constant holding the result instead if the call was folded.
+			 **/
+			std::optional<Operand> compile_call(const vm::List *list, vm::Symbol &name,
+												const RegisterOpcode op, const uint32_t dest) {
+				const uint32_t first_free = next_register;
+				std::vector<Operand> args;
+				bool constant_args = true;
+				for(const vm::List *cell = list->next; cell != nullptr; cell = cell->next) {
+					args.push_back(compile(cell->itm));
+					constant_args = constant_args && (args.back() & constant_bit);
+					if(!(args.back() & constant_bit)) {
+						// Keep the value safe from the arguments compiled after it
+						next_register = std::max(next_register, args.back() + 1);
+						chunk.num_registers = std::max(chunk.num_registers, next_register);
+					}
+				}
+				if(fold && constant_args) {
+					if(std::optional<Operand> folded = fold_constants(name, args)) {
+						return folded;
+					}
+				}
+				chunk.calls.push_back(RegisterCall{list, &name, static_cast<uint32_t>(chunk.call_args.size()),
+												   static_cast<uint32_t>(args.size())});
+				chunk.call_args.insert(chunk.call_args.end(), args.begin(), args.end());
+				emit(op, dest, static_cast<uint32_t>(chunk.calls.size() - 1));
+				free_registers(std::max(first_free, dest + 1));
+				return std::nullopt;
+			}
+
+			Operand compile_if(const vm::List *list, const std::optional<uint32_t> dest) {
+				const Conditional conditional = parse_if(list);
+				const uint32_t result = dest ? *dest : next_register;
+				free_registers(std::max(next_register, result + 1));
+				const Operand test = compile(*conditional.test);
+				free_registers(result + 1);
+				const size_t jump_to_else = emit(RegisterOpcode::JMP_F, test, 0);
+				compile_into(*conditional.then, result);
+				const size_t jump_to_end = emit(RegisterOpcode::JMP, 0, 0);
+				chunk.code[jump_to_else].b = static_cast<uint32_t>(chunk.code.size());
+				if(conditional.otherwise) {
+					compile_into(*conditional.otherwise, result);
+				} else {
+					emit(RegisterOpcode::MOVE, result, add_constant(compiler.vm.make_boxed(vm::Empty{})));
+				}
+				chunk.code[jump_to_end].b = static_cast<uint32_t>(chunk.code.size());
+				return result;
+			}
+
+			void compile_into(const vm::InternalBox &form, const uint32_t dest) {
+				const Operand value = compile(form, dest);
+				if(value != dest) {
+					emit(RegisterOpcode::MOVE, dest, value);
+				}
+				free_registers(dest + 1);
+			}
+
+			Operand compile_defn(const vm::List *list) {
+				vm::VirtualMachine &vm = compiler.vm;
+				const Definition definition = parse_defn(list, compiler);
+				RegisterChunk body;
+				RegisterCompiler body_compiler(compiler, body, fold, definition.args);
+				body_compiler.compile_body(definition.body);
+				const vm::vm_ptr<vm::VmFunction> fn(vm.mem_manager.allocate_obj<RegisterFunction>(
+					definition.type, definition.lambda_list, std::move(body)));
+				define_function(definition, fn, list, compiler);
+				return add_constant(vm::Box(definition.name_form, vm.mem_manager.make_vm_ptr<vm::AllocatedItem>()));
+			}
+
+			Operand compile_defextern(const vm::List *list) {
+				vm::VirtualMachine &vm = compiler.vm;
+				const ExternDeclaration declaration = parse_defextern(list, compiler);
+				define_extern(declaration, list, compiler);
+				return add_constant(vm::Box(declaration.name_form, vm.mem_manager.make_vm_ptr<vm::AllocatedItem>()));
+			}
+
+			/**
+			 * Fold a call on constants. Its arguments are the last entries of
+			 * the constant table, and are replaced by the result.
+			 **/
+			std::optional<Operand> fold_constants(const vm::Symbol &name, const std::vector<Operand> &operands) {
+				std::vector<vm::InternalBox> args;
+				args.reserve(operands.size());
+				for(const Operand operand : operands) {
+					args.push_back(chunk.constants[operand & ~constant_bit].bare());
+				}
+				std::optional<vm::Box> result = fold_call(name, args, compiler);
+				if(!result) {
+					return std::nullopt;
+				}
+				for(size_t i = 0; i < operands.size(); i++) {
+					chunk.constants.pop_back();
+				}
+				return add_constant(std::move(*result));
+			}
+
+			Operand add_constant(vm::Box &&value) {
+				chunk.constants.push_back(std::move(value));
+				return static_cast<Operand>(chunk.constants.size() - 1) | constant_bit;
+			}
+
+			size_t emit(const RegisterOpcode op, const uint32_t a, const uint32_t b) {
+				chunk.code.push_back(Instruction{op, a, b});
+				if(op == RegisterOpcode::INVOKE || op == RegisterOpcode::MOVE) {
+					chunk.num_registers = std::max(chunk.num_registers, a + 1);
+				}
+				return chunk.code.size() - 1;
+			}
+
+			//! Make every register from first on free for temporaries
+			void free_registers(const size_t first) {
+				next_register = static_cast<uint32_t>(first);
+				chunk.num_registers = std::max(chunk.num_registers, next_register);
+			}
+
+			Compiler &compiler;
+			RegisterChunk &chunk;
+			const bool fold;
+			const std::span<vm::Symbol* const> params;
+			const bool in_function;
+			const SpecialForms special_forms;
+			uint32_t next_register;
+		};
+	}
+
+	RegisterChunk compile_registers(const vm::Box &form, Compiler &compiler, const bool fold_constants) {
+		RegisterChunk chunk;
+		RegisterCompiler register_compiler(compiler, chunk, fold_constants);
+		register_compiler.compile_return(form.bare());
+		return chunk;
+	}
+}
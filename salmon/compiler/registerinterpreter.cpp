@@ -0,0 +1,222 @@
+#include <algorithm>
+#include <iostream>
+#include <span>
+#include <vector>
+
+#include <util/assert.hpp>
+#include <compiler/registerinterpreter.hpp>
+#include <compiler/specialforms.hpp>
+
+namespace salmon::compiler {
+
+	RegisterFunction::RegisterFunction(const vm::vm_ptr<vm::Type> &type,
+									   const std::vector<vm::vm_ptr<vm::Symbol>> &lambda_list,
+									   RegisterChunk code) :
+		VmFunction(type, lambda_list), code{std::move(code)} {}
+
+	const RegisterChunk &RegisterFunction::chunk() const {
+		return code;
+	}
+
+	size_t RegisterFunction::arity() const {
+		return _lambda_list.size();
+	}
+
+	void RegisterFunction::check_arity(vm::VirtualMachine &vm, const size_t num_args) const {
+		if(num_args != arity()) {
+			throw vm::ArityException::build(&vm, _lambda_list, num_args, arity());
+		}
+	}
+
+	void RegisterFunction::get_roots(const std::function<void(vm::AllocatedItem*)> &inserter) const {
+		for(const RegisterCall &call : code.calls) {
+			inserter(call.name);
+		}
+		VmFunction::get_roots(inserter);
+	}
+
+	void RegisterFunction::print_debug_info() const {
+		std::cerr << "Register function" << std::endl;
+	}
+
+	size_t RegisterFunction::allocated_size() const {
+		return sizeof(*this);
+	}
+
+	namespace {
+		//! Where to pick up a call when the function it made returns
+		struct Frame {
+			const RegisterChunk *chunk;
+			size_t pc;
+			//! Index of the first register of the frame in the register file
+			size_t base;
+			//! The register of the frame the result goes in
+			uint32_t dest;
+		};
+
+		class RegisterInterpreter {
+		public:
+			RegisterInterpreter(vm::VirtualMachine &vm, const RegisterChunk &chunk) :
+				vm{vm}, registers(chunk.num_registers), chunk{&chunk} {}
+
+			//! Put the arguments for the chunk, which should be the body of a function, in its first registers
+			void set_args(std::span<const vm::InternalBox> args) {
+				std::copy(args.begin(), args.end(), registers.begin());
+			}
+
+			vm::Box execute() {
+				while(true) {
+					const Instruction instruction = chunk->code[pc++];
+					switch(instruction.op) {
+					case RegisterOpcode::MOVE:
+						registers[base + instruction.a] = read(instruction.b);
+						break;
+					case RegisterOpcode::JMP:
+						pc = instruction.b;
+						break;
+					case RegisterOpcode::JMP_F:
+						if(is_false(read(instruction.a))) {
+							pc = instruction.b;
+						}
+						break;
+					case RegisterOpcode::INVOKE:
+						invoke(chunk->calls[instruction.b], instruction.a);
+						break;
+					case RegisterOpcode::TAILCALL:
+						if(std::optional<vm::InternalBox> result = tail_call(chunk->calls[instruction.b])) {
+							if(return_from_frame(*result)) {
+								return vm::Box(*result, vm.mem_manager.make_vm_ptr<vm::AllocatedItem>());
+							}
+						}
+						break;
+					case RegisterOpcode::RETURN: {
+						const vm::InternalBox result = read(instruction.a);
+						if(return_from_frame(result)) {
+							return vm::Box(result, vm.mem_manager.make_vm_ptr<vm::AllocatedItem>());
+						}
+						break;
+					}
+					}
+				}
+			}
+
+		private:
+			vm::InternalBox read(const Operand operand) const {
+				if(operand & constant_bit) {
+					return chunk->constants[operand & ~constant_bit].bare();
+				}
+				return registers[base + operand];
+			}
+
+			//! Make sure the register file reaches size
+			void reserve_registers(const size_t size) {
+				if(registers.size() < size) {
+					registers.resize(std::max(size, registers.size() * 2));
+				}
+			}
+
+			/**
+			 * Copy the arguments of the call to the registers just past the
+			 * running frame, and find the function it names. Returns the
+			 * index of the first argument.
+			 **/
+			size_t prepare_call(const RegisterCall &call, vm::VmFunction *&fn) {
+				const size_t top = base + chunk->num_registers;
+				reserve_registers(top + call.num_args);
+				for(uint32_t i = 0; i < call.num_args; i++) {
+					registers[top + i] = read(chunk->call_args[call.first_arg + i]);
+				}
+				fn = vm.fn_table.find_fn(*call.name);
+				if(fn == nullptr) {
+					std::vector<vm::vm_ptr<vm::Type>> signature;
+					for(uint32_t i = 0; i < call.num_args; i++) {
+						signature.push_back(vm.mem_manager.make_vm_ptr(registers[top + i].type));
+					}
+					vm::NoSuchFunction error(std::move(signature));
+					error.func_name(vm.mem_manager.make_vm_ptr(call.name));
+					throw error;
+				}
+				vm.safepoint();
+				return top;
+			}
+
+			vm::InternalBox call_native(vm::VmFunction &fn, const size_t first_arg, const uint32_t num_args) {
+				std::span<vm::InternalBox> args(registers.data() + first_arg, num_args);
+				return fn(&vm, args).bare();
+			}
+
+			void invoke(const RegisterCall &call, const uint32_t dest) {
+				vm::VmFunction *fn = nullptr;
+				const size_t top = prepare_call(call, fn);
+				if(RegisterFunction *callee = dynamic_cast<RegisterFunction*>(fn)) {
+					callee->check_arity(vm, call.num_args);
+					frames.push_back(Frame{chunk, pc, base, dest});
+					enter(*callee, top);
+				} else {
+					const vm::InternalBox result = call_native(*fn, top, call.num_args);
+					registers[base + dest] = result;
+				}
+			}
+
+			/**
+			 * Make a call in tail position. Returns nothing if a register
+			 * function took over the running frame, or the result of a native
+			 * function, which the caller still has to return.
+			 **/
+			std::optional<vm::InternalBox> tail_call(const RegisterCall &call) {
+				vm::VmFunction *fn = nullptr;
+				const size_t top = prepare_call(call, fn);
+				RegisterFunction *callee = dynamic_cast<RegisterFunction*>(fn);
+				if(!callee) {
+					return call_native(*fn, top, call.num_args);
+				}
+				callee->check_arity(vm, call.num_args);
+				// Move the arguments down to the start of the running frame
+				std::copy(registers.begin() + top, registers.begin() + top + call.num_args,
+						  registers.begin() + base);
+				enter(*callee, base);
+				return std::nullopt;
+			}
+
+			void enter(const RegisterFunction &fn, const size_t frame_start) {
+				chunk = &fn.chunk();
+				pc = 0;
+				base = frame_start;
+				reserve_registers(base + chunk->num_registers);
+			}
+
+			//! Leave the running frame with result. Returns true if it was the outermost one.
+			bool return_from_frame(const vm::InternalBox &result) {
+				if(frames.empty()) {
+					return true;
+				}
+				const Frame &caller = frames.back();
+				chunk = caller.chunk;
+				pc = caller.pc;
+				base = caller.base;
+				registers[base + caller.dest] = result;
+				frames.pop_back();
+				return false;
+			}
+
+			vm::VirtualMachine &vm;
+			std::vector<vm::InternalBox> registers;
+			std::vector<Frame> frames;
+			const RegisterChunk *chunk;
+			size_t pc = 0;
+			size_t base = 0;
+		};
+	}
+
+	vm::Box RegisterFunction::operator()(vm::VirtualMachine *vm, std::span<vm::InternalBox> args) {
+		check_arity(*vm, args.size());
+		RegisterInterpreter interpreter(*vm, code);
+		interpreter.set_args(args);
+		return interpreter.execute();
+	}
+
+	vm::Box run(const RegisterChunk &chunk, vm::VirtualMachine &vm) {
+		RegisterInterpreter interpreter(vm, chunk);
+		return interpreter.execute();
+	}
+}
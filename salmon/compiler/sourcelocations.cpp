@@ -0,0 +1,59 @@
+#include <util/assert.hpp>
+#include <compiler/sourcelocations.hpp>
+
+namespace salmon::compiler {
+
+	SourceLocations::SourceLocations() :
+		ids{}, files{}, starts{}, ends{}, paths{}, path_ids{}, current_file{NO_FILE} {}
+
+	SourceLocations::FileId SourceLocations::begin_file(const std::filesystem::path &file) {
+		const auto [id, inserted] = path_ids.try_emplace(file.string(), static_cast<FileId>(paths.size()));
+		if(inserted) {
+			paths.push_back(file);
+		}
+		current_file = *id;
+		return current_file;
+	}
+
+	void SourceLocations::end_file() {
+		current_file = NO_FILE;
+	}
+
+	const std::filesystem::path &SourceLocations::file_path(const FileId file) const {
+		salmon_check(file < paths.size(), "Unknown file id");
+		return paths[file];
+	}
+
+	void SourceLocations::record(const vm::AllocatedItem *item, const salmon::meta::position_info &start,
+								 const salmon::meta::position_info &end) {
+		const auto [id, inserted] = ids.try_emplace(item, static_cast<uint32_t>(files.size()));
+		if(inserted) {
+			files.push_back(current_file);
+			starts.push_back(start);
+			ends.push_back(end);
+		} else {
+			// The address was reused by a newer item
+			files[*id] = current_file;
+			starts[*id] = start;
+			ends[*id] = end;
+		}
+	}
+
+	std::optional<SourceLocations::Location> SourceLocations::find(const vm::AllocatedItem *item) const {
+		if(const uint32_t *id = ids.find(item)) {
+			return Location{files[*id], starts[*id], ends[*id]};
+		}
+		return std::nullopt;
+	}
+
+	size_t SourceLocations::size() const {
+		return files.size();
+	}
+
+	void SourceLocations::clear() {
+		ids.clear();
+		files.clear();
+		starts.clear();
+		ends.clear();
+	}
+}
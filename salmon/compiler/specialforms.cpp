@@ -0,0 +1,185 @@
+#include <algorithm>
+#include <limits>
+#include <memory>
+#include <type_traits>
+
+#include <compiler/specialforms.hpp>
+#include <vm/foreignfunction.hpp>
+
+namespace salmon::compiler {
+
+	SpecialForms::SpecialForms(Compiler &compiler) :
+		defn{compiler.vm.base_package().intern_symbol("defn").get()},
+		defextern{compiler.vm.base_package().intern_symbol("defextern").get()},
+		if_form{compiler.vm.base_package().intern_symbol("if").get()} {}
+
+	Definition parse_defn(const vm::List *form, Compiler &compiler) {
+		vm::VirtualMachine &vm = compiler.vm;
+		const vm::List *name_cell = form->next;
+		const vm::List *args_cell = name_cell ? name_cell->next : nullptr;
+		if(!args_cell || !args_cell->next) {
+			throw CompileError("defn takes a name, a vector of arguments, and a body", form);
+		}
+		vm::Symbol *const *name = std::get_if<vm::Symbol*>(&name_cell->itm.elem);
+		vm::Vector *const *args = std::get_if<vm::Vector*>(&args_cell->itm.elem);
+		if(!name || (*name)->package == compiler.keyword_package()) {
+			throw CompileError("The name of a function must be a symbol", form);
+		} else if(!args) {
+			throw CompileError("The arguments of " + (*name)->name + " must be a vector", form);
+		}
+
+		Definition definition{*name, name_cell->itm, {}, {}, args_cell->next, vm.mem_manager.make_vm_ptr<vm::Type>()};
+		vm::SpecBuilder arg_spec;
+		for(const vm::InternalBox &arg : **args) {
+			vm::Symbol *const *arg_name = std::get_if<vm::Symbol*>(&arg.elem);
+			if(!arg_name || (*arg_name)->package == compiler.keyword_package()) {
+				throw CompileError("The arguments of " + (*name)->name + " must be symbols", form);
+			} else if(std::find(definition.args.begin(), definition.args.end(), *arg_name) != definition.args.end()) {
+				throw CompileError((*arg_name)->name + " is given twice in the arguments of "
+								   + (*name)->name, form);
+			}
+			definition.args.push_back(*arg_name);
+			definition.lambda_list.push_back(vm.mem_manager.make_vm_ptr(*arg_name));
+			arg_spec.add_parameter(definition.lambda_list.back());
+		}
+		// Nothing is known about what the function returns
+		vm::SpecBuilder ret_spec;
+		ret_spec.add_parameter(vm.base_package().intern_symbol("result"));
+		definition.type = vm.type_table.get_fn_type(arg_spec.build(), ret_spec.build());
+		return definition;
+	}
+
+	void define_function(const Definition &definition, const vm::vm_ptr<vm::VmFunction> &fn,
+						 const vm::List *form, Compiler &compiler) {
+		vm::VirtualMachine &vm = compiler.vm;
+		if(!vm.fn_table.add_function(vm.mem_manager.make_vm_ptr(definition.name), fn)) {
+			throw CompileError(definition.name->name + " is already defined with a different type", form);
+		}
+	}
+
+	//! The type a symbol in a defextern form names
+	static vm::Type *named_type(const vm::InternalBox &form_item, const vm::List *form, Compiler &compiler) {
+		vm::VirtualMachine &vm = compiler.vm;
+		vm::Symbol *const *name = std::get_if<vm::Symbol*>(&form_item.elem);
+		if(!name) {
+			throw CompileError("The types of an extern function must be symbols", form);
+		}
+		const std::optional<vm::TypePtr> type = vm.type_table.get_named(vm.mem_manager.make_vm_ptr(*name));
+		if(!type) {
+			throw CompileError((*name)->name + " isn't a type", form);
+		}
+		return type->get();
+	}
+
+	ExternDeclaration parse_defextern(const vm::List *form, Compiler &compiler) {
+		const vm::List *name_cell = form->next;
+		const vm::List *library_cell = name_cell ? name_cell->next : nullptr;
+		const vm::List *args_cell = library_cell ? library_cell->next : nullptr;
+		const vm::List *result_cell = args_cell ? args_cell->next : nullptr;
+		if(!result_cell || result_cell->next) {
+			throw CompileError("defextern takes a name, a library, a vector of argument types, and a result type",
+							   form);
+		}
+		vm::Symbol *const *name = std::get_if<vm::Symbol*>(&name_cell->itm.elem);
+		vm::StaticString *const *library = std::get_if<vm::StaticString*>(&library_cell->itm.elem);
+		vm::Vector *const *args = std::get_if<vm::Vector*>(&args_cell->itm.elem);
+		if(!name || (*name)->package == compiler.keyword_package()) {
+			throw CompileError("The name of a function must be a symbol", form);
+		} else if(!library) {
+			throw CompileError("The library of " + (*name)->name + " must be a string", form);
+		} else if(!args) {
+			throw CompileError("The argument types of " + (*name)->name + " must be a vector", form);
+		}
+
+		ExternDeclaration declaration{*name, name_cell->itm, (*library)->contents, (*name)->name, {},
+									  named_type(result_cell->itm, form, compiler)};
+		std::replace(declaration.c_name.begin(), declaration.c_name.end(), '-', '_');
+		for(const vm::InternalBox &arg : **args) {
+			declaration.arg_types.push_back(named_type(arg, form, compiler));
+		}
+		return declaration;
+	}
+
+	void define_extern(const ExternDeclaration &declaration, const vm::List *form, Compiler &compiler) {
+		vm::VirtualMachine &vm = compiler.vm;
+		std::optional<vm::vm_ptr<vm::VmFunction>> fn;
+		try {
+			const auto library = std::make_shared<vm::SharedLibrary>(declaration.library);
+			fn.emplace(vm::import_function(vm, library, declaration.c_name, declaration.arg_types,
+										   declaration.result_type));
+		} catch(const vm::ForeignError &error) {
+			throw CompileError(error.what(), form);
+		}
+		if(!vm.fn_table.add_function(vm.mem_manager.make_vm_ptr(declaration.name), *fn)) {
+			throw CompileError(declaration.name->name + " is already defined with a different type", form);
+		}
+	}
+
+	bool is_false(const vm::InternalBox &value) {
+		if(const bool *boolean = std::get_if<bool>(&value.elem)) {
+			return !*boolean;
+		}
+		return std::holds_alternative<vm::Empty>(value.elem);
+	}
+
+	Conditional parse_if(const vm::List *form) {
+		const vm::List *test = form->next;
+		const vm::List *then = test ? test->next : nullptr;
+		const vm::List *otherwise = then ? then->next : nullptr;
+		if(!then || (otherwise && otherwise->next)) {
+			throw CompileError("if takes a test, a form, and an optional else form", form);
+		}
+		return Conditional{&test->itm, &then->itm, otherwise ? &otherwise->itm : nullptr};
+	}
+
+	/**
+	 * Integer division by zero traps, and so does dividing the smallest
+	 * value of a signed type by -1, so both are left for when the form runs
+	 **/
+	static bool division_traps(const vm::Symbol &name, const std::span<const vm::InternalBox> args,
+							   vm::VirtualMachine &vm) {
+		if(name.name != "divide" || name.package != &vm.base_package() || args.size() != 2) {
+			return false;
+		}
+		return std::visit([&args](auto &&divisor) {
+			using T = std::decay_t<decltype(divisor)>;
+			if constexpr (std::is_integral_v<T> && !std::is_same_v<T, bool>) {
+				if(divisor == 0) {
+					return true;
+				}
+				if constexpr (std::is_signed_v<T>) {
+					const T *dividend = std::get_if<T>(&args[0].elem);
+					return divisor == -1 && dividend && *dividend == std::numeric_limits<T>::min();
+				}
+			}
+			return false;
+		}, args[1].elem);
+	}
+
+	std::optional<vm::Box> fold_call(const vm::Symbol &name, const std::span<const vm::InternalBox> args,
+									 Compiler &compiler) {
+		vm::VirtualMachine &vm = compiler.vm;
+		// Plain functions and the implementations of unsealed interfaces can
+		// be replaced after compiling, which the folded result wouldn't see
+		vm::InterfaceFunction *interface = dynamic_cast<vm::InterfaceFunction*>(vm.fn_table.find_fn(name));
+		if(interface == nullptr || !interface->sealed()) {
+			return std::nullopt;
+		}
+		std::vector<vm::Type*> arg_types;
+		arg_types.reserve(args.size());
+		for(const vm::InternalBox &arg : args) {
+			arg_types.push_back(arg.type);
+		}
+		vm::VmFunction *fn = interface->find_impl(arg_types);
+		if(fn == nullptr || !fn->pure() || division_traps(name, args, vm)) {
+			return std::nullopt;
+		}
+		// Functions take their arguments as a mutable span
+		std::vector<vm::InternalBox> arg_copy(args.begin(), args.end());
+		try {
+			return (*fn)(&vm, arg_copy);
+		} catch(const std::runtime_error &) {
+			return std::nullopt;
+		}
+	}
+}
@@ -0,0 +1,272 @@
+#include <sstream>
+
+#include <util/assert.hpp>
+#include <compiler/typeinference.hpp>
+
+namespace salmon::compiler {
+
+	TypeError::TypeError(const std::string &msg, const vm::List *form) :
+		std::runtime_error(msg), form{form} {}
+
+	namespace {
+		using Var = uint32_t;
+
+		/**
+		 * Type variables in a union-find forest. Each class can be bound to
+		 * one concrete type. Unknown variables stand for values whose type
+		 * can only be found when the form runs: they never join a class or
+		 * get bound, so nothing is concluded from how they are used.
+		 **/
+		class TypeVariables {
+		public:
+			Var fresh(const vm::Type *type = nullptr) {
+				const Var var = static_cast<Var>(parent.size());
+				parent.push_back(var);
+				rank.push_back(0);
+				bound.push_back(type);
+				unknown.push_back(false);
+				return var;
+			}
+
+			Var fresh_unknown() {
+				const Var var = fresh();
+				unknown[var] = true;
+				return var;
+			}
+
+			//! Make count unbound variables with consecutive numbers, returning the first
+			Var fresh_many(const size_t count) {
+				const Var first = static_cast<Var>(parent.size());
+				for(size_t i = 0; i < count; i++) {
+					fresh();
+				}
+				return first;
+			}
+
+			Var find(Var var) {
+				while(parent[var] != var) {
+					// Path halving: point every other node at its grandparent
+					parent[var] = parent[parent[var]];
+					var = parent[var];
+				}
+				return var;
+			}
+
+			const vm::Type *type_of(const Var var) {
+				return bound[find(var)];
+			}
+
+			//! Bind the class of var to type. Fails if it is already bound to another type.
+			bool bind(const Var var, const vm::Type *type) {
+				const Var root = find(var);
+				if(unknown[root]) {
+					return true;
+				}
+				if(bound[root] == nullptr) {
+					bound[root] = type;
+					return true;
+				}
+				return bound[root] == type;
+			}
+
+			//! Merge the classes of first and second. Fails if they are bound to different types.
+			bool unify(const Var first, const Var second) {
+				Var a = find(first);
+				Var b = find(second);
+				if(a == b || unknown[a] || unknown[b]) {
+					return true;
+				}
+				if(bound[a] != nullptr && bound[b] != nullptr && bound[a] != bound[b]) {
+					return false;
+				}
+				if(rank[a] < rank[b]) {
+					std::swap(a, b);
+				}
+				parent[b] = a;
+				if(rank[a] == rank[b]) {
+					rank[a]++;
+				}
+				if(bound[a] == nullptr) {
+					bound[a] = bound[b];
+				}
+				return true;
+			}
+
+		private:
+			std::vector<Var> parent;
+			std::vector<uint8_t> rank;
+			std::vector<const vm::Type*> bound;
+			std::vector<bool> unknown;
+		};
+
+		struct PendingCall {
+			const vm::List *form;
+			vm::VmFunction *callee;
+			//! The argument variables are call_args[first_arg, first_arg + num_args)
+			size_t first_arg;
+			size_t num_args;
+			Var result;
+		};
+
+		std::string type_name(const vm::Type *type) {
+			if(const vm::PrimitiveType *primitive = std::get_if<vm::PrimitiveType>(&type->type)) {
+				return primitive->name->name;
+			}
+			std::ostringstream out;
+			out << *type;
+			return out.str();
+		}
+
+		class Inferencer {
+		public:
+			explicit Inferencer(Compiler &compiler) : compiler{compiler} {}
+
+			Var infer(const vm::InternalBox &box) {
+				if(vm::List *const *list = std::get_if<vm::List*>(&box.elem)) {
+					return infer_list(*list);
+				} else if(vm::Vector *const *vector = std::get_if<vm::Vector*>(&box.elem)) {
+					for(const vm::InternalBox &item : **vector) {
+						infer(item);
+					}
+				} else if(vm::Symbol *const *symbol = std::get_if<vm::Symbol*>(&box.elem)) {
+					if((*symbol)->package != compiler.keyword_package()) {
+						// A variable: nothing binds them yet, so its type is unknown
+						return vars.fresh();
+					}
+				}
+				return vars.fresh(box.type);
+			}
+
+			InferredTypes finish(const Var root) {
+				InferredTypes result{vars.type_of(root), {}, std::move(errors)};
+				result.call_sites.reserve(calls.size());
+				std::vector<vm::Type*> arg_types;
+				for(const PendingCall &call : calls) {
+					arg_types.clear();
+					// Calls with the wrong number of arguments can't be resolved
+					bool known = call.num_args == std::get<vm::FunctionType>(call.callee->type()->type).args().size();
+					for(size_t i = 0; i < call.num_args; i++) {
+						const vm::Type *type = vars.type_of(call_args[call.first_arg + i]);
+						known = known && type != nullptr;
+						arg_types.push_back(const_cast<vm::Type*>(type));
+					}
+					result.call_sites.push_back(resolve(call, known ? &arg_types : nullptr));
+				}
+				return result;
+			}
+
+		private:
+			Var infer_list(vm::List *list) {
+				if(vm::Symbol *const *head = std::get_if<vm::Symbol*>(&list->itm.elem)) {
+					const auto fn = compiler.vm.fn_table.get_fn(compiler.vm.mem_manager.make_vm_ptr(*head));
+					if(fn) {
+						return infer_call(list, fn->get(), **head);
+					}
+				}
+				// Not a call we know about, but calls inside it can still be typed
+				for(const vm::List *cell = list; cell != nullptr; cell = cell->next) {
+					infer(cell->itm);
+				}
+				return vars.fresh();
+			}
+
+			Var infer_call(const vm::List *list, vm::VmFunction *callee, const vm::Symbol &name) {
+				const vm::FunctionType &fn_type = std::get<vm::FunctionType>(callee->type()->type);
+				const vm::TypeSpecification &arg_spec = fn_type.args();
+				const vm::TypeSpecification &ret_spec = fn_type.returns();
+
+				// Each call gets its own copy of the function's parameters
+				const Var params = vars.fresh_many(arg_spec.parameter_count());
+
+				const size_t first_arg = call_args.size();
+				size_t num_args = 0;
+				for(const vm::List *cell = list->next; cell != nullptr; cell = cell->next) {
+					const Var arg = infer(cell->itm);
+					call_args.push_back(arg);
+					if(num_args < arg_spec.size()) {
+						const vm::Type *expected = arg_spec.type_at(num_args);
+						const Var param = params + static_cast<Var>(expected ? 0 : arg_spec.parameter_index(num_args));
+						const bool agrees = expected ? vars.bind(arg, expected) : vars.unify(arg, param);
+						if(!agrees) {
+							mismatch(list, name, num_args, arg, expected ? expected : vars.type_of(param));
+						}
+					}
+					num_args++;
+				}
+				if(num_args != arg_spec.size()) {
+					errors.emplace_back(name.name + " takes " + std::to_string(arg_spec.size())
+										+ " arguments, but was given " + std::to_string(num_args), list);
+				}
+
+				Var result = vars.fresh();
+				if(ret_spec.size() == 1) {
+					if(const vm::Type *type = ret_spec.type_at(0)) {
+						vars.bind(result, type);
+					} else {
+						const vm::Symbol *param = ret_spec.parameter(ret_spec.parameter_index(0));
+						bool constrained = false;
+						for(size_t i = 0; i < arg_spec.parameter_count(); i++) {
+							if(arg_spec.parameter(i) == param) {
+								vars.unify(result, params + static_cast<Var>(i));
+								constrained = true;
+							}
+						}
+						if(!constrained) {
+							// No argument says what the function returns, as with
+							// the result of a defn, so its use mustn't decide it
+							result = vars.fresh_unknown();
+						}
+					}
+				}
+				calls.push_back(PendingCall{list, callee, first_arg, num_args, result});
+				return result;
+			}
+
+			void mismatch(const vm::List *list, const vm::Symbol &name, const size_t index,
+						  const Var arg, const vm::Type *expected) {
+				std::ostringstream msg;
+				msg << "Argument " << index + 1 << " of " << name.name << " is a "
+					<< type_name(vars.type_of(arg)) << ", but a " << type_name(expected) << " was expected";
+				errors.emplace_back(msg.str(), list);
+			}
+
+			CallSite resolve(const PendingCall &call, const std::vector<vm::Type*> *arg_types) {
+				CallSite site{call.form, call.callee, nullptr, nullptr};
+				const vm::Type *callee_type = call.callee->type();
+				if(vm::InterfaceFunction *interface = dynamic_cast<vm::InterfaceFunction*>(call.callee)) {
+					if(arg_types) {
+						site.target = interface->find_impl(*arg_types);
+						site.type = site.target ? site.target->type() : nullptr;
+					}
+					return site;
+				}
+				site.target = call.callee;
+				if(callee_type->concrete()) {
+					site.type = callee_type;
+				} else if(arg_types && vars.type_of(call.result)) {
+					// A generic function: build the type of this use of it
+					vm::SpecBuilder args;
+					for(vm::Type *type : *arg_types) {
+						args.add_type(compiler.vm.mem_manager.make_vm_ptr(type));
+					}
+					vm::SpecBuilder ret;
+					ret.add_type(compiler.vm.mem_manager.make_vm_ptr(const_cast<vm::Type*>(vars.type_of(call.result))));
+					site.type = compiler.vm.type_table.get_fn_type(args.build(), ret.build()).get();
+				}
+				return site;
+			}
+
+			Compiler &compiler;
+			TypeVariables vars;
+			std::vector<PendingCall> calls;
+			std::vector<Var> call_args;
+			std::vector<TypeError> errors;
+		};
+	}
+
+	InferredTypes infer_types(const vm::Box &form, Compiler &compiler) {
+		Inferencer inferencer(compiler);
+		const Var root = inferencer.infer(form.bare());
+		return inferencer.finish(root);
+	}
+}
@@ -37,5 +37,8 @@ std::ostream& operator<<(std::ostream &os, const salmon::Config& config) {
 			  << "\nDirectory paths:"
 			  << "\n  Cache:  " << config.cache_dir
 			  << "\n  Config: " << config.config_dir
-			  << "\n  Data:   " << config.data_dir << "\n";
+			  << "\n  Data:   " << config.data_dir
+			  << "\nBackend: " << (config.backend == salmon::Backend::STACK ? "stack" : "register")
+			  << "\nJIT threshold: " << config.jit_threshold
+			  << "\nSealed builtins: " << (config.seal_builtins ? "yes" : "no") << "\n";
 }
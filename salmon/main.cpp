@@ -1,9 +1,19 @@
 #include <iostream>
 #include <fstream>
+#include <sstream>
 #include <stdlib.h>
 #include <string>
+#include <string_view>
+#include <optional>
+#include <cstdint>
+#include <array>
 #include <filesystem>
 #include <span>
+#include <cerrno>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
 #include <unistd.h>
 
 #include <replxx.hxx>
@@ -12,7 +22,10 @@
 #include <util/assert.hpp>
 #include <compiler/parser.hpp>
 #include <salmon/config.hpp>
+#include <compiler/bytecode.hpp>
 #include <compiler/compiler.hpp>
+#include <compiler/evaluate.hpp>
+#include <compiler/formcache.hpp>
 
 static salmon::Config get_config() {
 	return {
@@ -22,38 +35,155 @@ static salmon::Config get_config() {
 
 namespace salmon {
 
-	static void process_files(char **filenames, const int length, compiler::Compiler &engine) {
+	/**
+	 * Evaluate the form and print its result to out, which the VM's printer
+	 * must be writing to. Errors from compiling or calling are reported in its
+	 * place, so the forms after it still run.
+	 **/
+	static void evaluate_and_print(const vm::Box &form, compiler::Compiler &engine, std::ostream &out) {
 		vm::vm_ptr<vm::VmFunction> print_fn =
 			*engine.vm.fn_table.get_fn(*engine.vm.base_package().find_symbol("print"));
+		std::array<vm::Box,1> print_args = { engine.vm.make_boxed(vm::Empty()) };
+		std::span<vm::Box,1> print_span(print_args);
+		try {
+			print_span[0] = compiler::evaluate(form, engine);
+			print_fn->invoke(&engine.vm, print_span);
+			engine.vm.printer.flush();
+			out << '\n';
+		} catch(const compiler::CompileError &error) {
+			engine.vm.printer.flush();
+			out << "Compile error: " << error.what() << '\n';
+		} catch(const vm::NoSuchFunction &error) {
+			engine.vm.printer.flush();
+			out << "Error: " << error.what() << '\n';
+		} catch(const vm::ArityException &error) {
+			engine.vm.printer.flush();
+			out << "Error: " << error.what() << '\n';
+		}
+	}
+
+	static void process_files(char **filenames, const int length, compiler::Compiler &engine) {
+		compiler::FormCache cache(engine.config.cache_dir);
 		for(int i = 0; i < length; i++) {
 			std::filesystem::path filepath(filenames[i]);
 			if(std::filesystem::is_regular_file(filepath)) {
-
-				std::array<vm::Box,1> print_args = { engine.vm.make_boxed(vm::Empty()) };
-				std::span<vm::Box,1> print_span(print_args);
 				std::cout << "Processing file " << filepath.string() << std::endl;
-				try {
-					std::ifstream file;
-					file.open(filepath);
-					compiler::CountingStreamBuffer countStreamBuf(file);
-					while(auto token = salmon::compiler::read(countStreamBuf, engine)) {
-						print_span[0] = *token;
-						print_fn->invoke(&engine.vm, print_span);
-						std::cout << std::endl;
-						// token = salmon::compiler::read(file, engine);
-						engine.vm.mem_manager.do_gc();
-					}
-					file.close();
-				} catch(salmon::compiler::ParseException &error) {
+				std::optional<compiler::ReadForms> read = cache.read_file(filepath, engine);
+				if(!read) {
+					std::cout << "Cannot open file " << filepath.string() << std::endl;
+					continue;
+				}
+				for(const vm::Box &form : read->forms) {
+					evaluate_and_print(form, engine, std::cout);
+				}
+				for(compiler::ParseException &error : read->errors) {
 					error.add_file_info(std::filesystem::canonical(filepath));
-					std::cout << error.build_error_str() << std::endl;
+					std::cout << error.build_error_str() << '\n';
 				}
+				std::cout.flush();
+				read->forms.clear();
+				engine.vm.mem_manager.do_gc();
 			} else {
 				std::cout << "Cannot process file" << filepath.string() << std::endl;
 			}
 		}
 	}
 
+	/**
+	 * Evaluates the input from the REPL on its own thread, so the prompt stays
+	 * responsive while it runs. The VM's printer writes into a stream of the
+	 * worker's own, which is handed to replxx to print above the prompt.
+	 **/
+	class ReplWorker {
+	public:
+		ReplWorker(compiler::Compiler &engine, replxx::Replxx &rx) :
+			engine{engine}, rx{rx}, mutex{}, ready{}, queue{}, busy{false}, done{false},
+			thread{&ReplWorker::run, this} {}
+		ReplWorker(const ReplWorker&) = delete;
+
+		//! Finishes the queued input before returning
+		~ReplWorker() {
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				done = true;
+			}
+			ready.notify_one();
+			thread.join();
+		}
+
+		void submit(std::string source) {
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				queue.push_back(std::move(source));
+			}
+			ready.notify_one();
+		}
+
+		//! Stop what is being evaluated and drop the queued input. Returns false if nothing was running.
+		bool interrupt() {
+			std::lock_guard<std::mutex> lock(mutex);
+			queue.clear();
+			if(busy) {
+				engine.vm.interrupt();
+			}
+			return busy;
+		}
+	private:
+		void run() {
+			std::unique_lock<std::mutex> lock(mutex);
+			while(true) {
+				ready.wait(lock, [this]() { return done || !queue.empty(); });
+				if(queue.empty()) {
+					return;
+				}
+				std::string source = std::move(queue.front());
+				queue.pop_front();
+				// An interrupt from before this input was taken off the queue
+				// isn't meant for it. Clearing it under the lock means one
+				// that comes later always sees busy set and is kept.
+				engine.vm.clear_interrupt();
+				busy = true;
+				lock.unlock();
+				evaluate(source);
+				lock.lock();
+				busy = false;
+			}
+		}
+
+		void evaluate(const std::string &source) {
+			std::ostringstream out;
+			vm::Printer &printer = engine.vm.printer;
+			std::ostream &previous_out = printer.output();
+			printer.output(out);
+			try {
+				std::istringstream input(source);
+				compiler::CountingStreamBuffer countStreamBuf(input);
+				compiler::ReadForms read = compiler::read_all(countStreamBuf, engine);
+				for(const compiler::ParseException &error : read.errors) {
+					out << error.build_error_str() << '\n';
+				}
+				for(const vm::Box &form : read.forms) {
+					evaluate_and_print(form, engine, out);
+				}
+			} catch(const vm::Interrupted &) {
+				printer.flush();
+				out << "\nInterrupted\n";
+			}
+			engine.vm.mem_manager.do_gc();
+			printer.output(previous_out);
+			rx.print("%s", out.str().c_str());
+		}
+
+		compiler::Compiler &engine;
+		replxx::Replxx &rx;
+		std::mutex mutex;
+		std::condition_variable ready;
+		std::deque<std::string> queue;
+		bool busy;
+		bool done;
+		std::thread thread;
+	};
+
 	static void repl(salmon::compiler::Compiler& engine) {
 		using namespace salmon;
 		const std::filesystem::path history_file = engine.config.data_dir / "history.txt";
@@ -64,26 +194,33 @@ namespace salmon {
 		rx.history_load(history_file.string());
 		rx.set_max_history_size(100);
 
-		vm::vm_ptr<vm::VmFunction> print_fn = *engine.vm.fn_table.get_fn(*engine.vm.base_package().find_symbol("print"));
-		std::array<vm::Box,1> print_args = { engine.vm.make_boxed(vm::Empty()) };
-		std::span<vm::Box,1> print_span(print_args);
-		char const* line{nullptr};
-		while((line = rx.input(" > ")) != nullptr) {
-			if(line[0] != '\0') {
-				try {
-					auto token = compiler::read_from_string(line, engine);
-					if(token) {
-						print_span[0] = *token;
-						print_fn->invoke(&engine.vm, print_span);
-						std::cout << std::endl;
+		{
+			ReplWorker worker(engine, rx);
+			// Lines are collected until they make up whole forms
+			std::string pending;
+			while(true) {
+				char const *line = rx.input(pending.empty() ? " > " : " . ");
+				if(line == nullptr) {
+					if(errno == EAGAIN) {
+						// Ctrl-C stops what is running, or else throws away the unfinished input
+						if(!worker.interrupt()) {
+							pending.clear();
+						}
+						continue;
 					}
-					rx.history_add(line);
-					engine.vm.mem_manager.do_gc();
-				} catch(const compiler::ParseException &error) {
-					std::cout << error.build_error_str() << std::endl;
+					break;
 				}
+				pending += line;
+				if(compiler::needs_more_input(pending)) {
+					pending += '\n';
+					continue;
+				}
+				if(pending.find_first_not_of(" \t\n") != std::string::npos) {
+					rx.history_add(pending);
+					worker.submit(std::move(pending));
+				}
+				pending.clear();
 			}
-			line = "";
 		}
 		std::cout << "\n";
 		rx.history_save(history_file);
@@ -95,9 +232,11 @@ int main(int argc ,char **argv) {
 	bool invalid_flag = false;
 
 	int verbosity_level = 0;
+	salmon::Backend backend = salmon::Backend::STACK;
+	std::optional<uint32_t> jit_threshold;
 
 	int read_in;
-	while( (read_in = getopt(argc, argv, "rv")) != -1) {
+	while( (read_in = getopt(argc, argv, "rvb:j:")) != -1) {
 		char c = static_cast<char>(read_in);
 		switch(c) {
 		case 'r':
@@ -114,6 +253,28 @@ int main(int argc ,char **argv) {
 						  << salmon::Config::max_verbose_lvl << std::endl;
 			}
 			break;
+		case 'b':
+			if(std::string_view(optarg) == "stack") {
+				backend = salmon::Backend::STACK;
+			} else if(std::string_view(optarg) == "register") {
+				backend = salmon::Backend::REGISTER;
+			} else {
+				std::cerr << "Unknown backend " << optarg << ", expected stack or register" << std::endl;
+				invalid_flag = true;
+			}
+			break;
+		case 'j': {
+			char *end;
+			errno = 0;
+			const unsigned long threshold = strtoul(optarg, &end, 10);
+			if(*optarg == '\0' || *end != '\0' || errno != 0 || threshold > UINT32_MAX) {
+				std::cerr << "JIT threshold must be a whole number, got " << optarg << std::endl;
+				invalid_flag = true;
+			} else {
+				jit_threshold = static_cast<uint32_t>(threshold);
+			}
+			break;
+		}
 		default:
 			salmon_abort("Unknown option in getopt");
 		}
@@ -125,6 +286,10 @@ int main(int argc ,char **argv) {
 
 	salmon::Config config = get_config();
 	config.verbosity_level = verbosity_level;
+	config.backend = backend;
+	if(jit_threshold) {
+		config.jit_threshold = *jit_threshold;
+	}
 	if(std::optional<std::error_code> errc = salmon::Config::ensure_required_dirs(config)) {
 		std::cerr << "FATAL: Could not create required directories.\n";
 		return errc->value();
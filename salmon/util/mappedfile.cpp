@@ -0,0 +1,53 @@
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <util/mappedfile.hpp>
+
+namespace salmon {
+
+	std::optional<MappedFile> MappedFile::open(const std::filesystem::path &path) {
+		const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+		if(fd < 0) {
+			return std::nullopt;
+		}
+		struct stat info;
+		if(fstat(fd, &info) != 0) {
+			close(fd);
+			return std::nullopt;
+		}
+		const size_t size = static_cast<size_t>(info.st_size);
+		if(size == 0) {
+			// mmap refuses empty mappings
+			close(fd);
+			return MappedFile(nullptr, 0);
+		}
+		void *data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+		// the mapping keeps the file open:
+		close(fd);
+		if(data == MAP_FAILED) {
+			return std::nullopt;
+		}
+		return MappedFile(data, size);
+	}
+
+	MappedFile::MappedFile(void *data, size_t size) :
+		data{data}, size{size} {}
+
+	MappedFile::MappedFile(MappedFile &&other) noexcept :
+		data{other.data}, size{other.size} {
+		other.data = nullptr;
+		other.size = 0;
+	}
+
+	MappedFile::~MappedFile() {
+		if(data) {
+			munmap(data, size);
+		}
+	}
+
+	std::span<const std::byte> MappedFile::bytes() const {
+		return std::span<const std::byte>(static_cast<const std::byte*>(data), size);
+	}
+}
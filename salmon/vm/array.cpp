@@ -60,4 +60,12 @@ namespace salmon::vm {
 	size_t Vector::size() const {
 		return items.size();
 	}
+
+	std::partial_ordering Vector::operator<=>(const Vector &other) const {
+		return compare_values(*this, other);
+	}
+
+	bool Vector::operator==(const Vector &other) const {
+		return compare_values(*this, other) == 0;
+	}
 }
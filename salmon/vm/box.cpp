@@ -2,37 +2,31 @@
 
 #include <util/assert.hpp>
 #include <vm/box.hpp>
+#include <vm/hashset.hpp>
 #include <vm/type.hpp>
 #include <util/assert.hpp>
 
 namespace salmon::vm {
 
+	Box::Box(InternalBox internal, const vm_ptr<AllocatedItem> &seed) :
+		internal{internal},
+		elem_ptr{seed},
+		type_ptr{seed.from(internal.type)} {
+		elem_ptr = nullptr;
+		std::visit([this](auto &&arg) {
+			using T = std::decay_t<decltype(arg)>;
+			if constexpr (std::is_pointer<T>::value) {
+				this->elem_ptr = arg;
+			}
+		}, this->internal.elem);
+	}
+
 	std::partial_ordering operator<=>(const InternalBox &lhs, const InternalBox &rhs) {
-		bool lhs_absent = lhs.elem.valueless_by_exception();
-		bool rhs_absent = rhs.elem.valueless_by_exception();
-		if(lhs_absent && rhs_absent) {
-			return std::strong_ordering::equal;
-		} else if(lhs_absent) {
-			return std::strong_ordering::less;
-		} else if(rhs_absent) {
-			return std::strong_ordering::greater;
-		} else {
-			// both exist, compare either by value or by pointer depending on what it is:
-			return std::visit([&rhs](auto &&arg) -> std::partial_ordering {
-				using T = std::decay_t<decltype(arg)>;
-				if constexpr (std::is_pointer<T>::value) {
-					return *arg <=> *std::get<T>(rhs.elem);
-				} else {
-					static_assert(std::is_fundamental<T>::value || std::is_same<T,Empty>::value);
-					T value = std::get<T>(rhs.elem);
-					return arg <=> value;
-				}
-			}, lhs.elem);
+		return compare_values(lhs, rhs);
 	}
-}
 
 	bool operator==(const InternalBox &lhs, const InternalBox &rhs) {
-		return lhs.elem == rhs.elem;
+		return compare_values(lhs, rhs) == 0;
 	}
 
 	void InternalBox::get_roots(const std::function<void(AllocatedItem*)>& inserter) const {
@@ -0,0 +1,224 @@
+#include <vector>
+#include <functional>
+#include <utility>
+
+#include <vm/box.hpp>
+#include <vm/hashset.hpp>
+#include <vm/package.hpp>
+
+namespace salmon::vm {
+
+	namespace {
+		//! A position in a list or vector that is being walked
+		struct Cursor {
+			const List *cell;
+			const Vector *vector;
+			size_t index;
+
+			explicit Cursor(const List *cell) :
+				cell{cell}, vector{nullptr}, index{0} {}
+			explicit Cursor(const Vector *vector) :
+				cell{nullptr}, vector{vector}, index{0} {}
+
+			bool done() const {
+				return vector ? index == vector->size() : cell == nullptr;
+			}
+
+			const InternalBox &item() const {
+				return vector ? (*vector)[index] : cell->itm;
+			}
+
+			void advance() {
+				if(vector) {
+					index++;
+				} else {
+					cell = cell->next;
+				}
+			}
+		};
+
+		class Comparison {
+		public:
+			/**
+			 * Compare two items. Scalars are compared directly; containers
+			 * are queued on the stack and compare as equal until run() is called.
+			 **/
+			std::partial_ordering push(const BoxVariant &lhs, const BoxVariant &rhs) {
+				if(lhs.index() != rhs.index()) {
+					return lhs.index() <=> rhs.index();
+				} else if(lhs.valueless_by_exception()) {
+					return std::partial_ordering::equivalent;
+				}
+				return std::visit([this, &rhs](auto &&arg) -> std::partial_ordering {
+					using T = std::decay_t<decltype(arg)>;
+					const T other = std::get<T>(rhs);
+					if constexpr (std::is_same<T, List*>::value) {
+						return push(arg, other);
+					} else if constexpr (std::is_same<T, Vector*>::value) {
+						return push(arg, other);
+					} else if constexpr (std::is_same<T, HashSet*>::value) {
+						return compare_values(*arg, *other);
+					} else if constexpr (std::is_pointer<T>::value) {
+						return *arg <=> *other;
+					} else {
+						static_assert(std::is_fundamental<T>::value || std::is_same<T,Empty>::value);
+						return arg <=> other;
+					}
+				}, lhs);
+			}
+
+			std::partial_ordering push(const List *lhs, const List *rhs) {
+				if(lhs != rhs) {
+					stack.emplace_back(Cursor(lhs), Cursor(rhs));
+				}
+				return std::partial_ordering::equivalent;
+			}
+
+			std::partial_ordering push(const Vector *lhs, const Vector *rhs) {
+				if(lhs == rhs) {
+					return std::partial_ordering::equivalent;
+				} else if(lhs->size() != rhs->size()) {
+					return lhs->size() <=> rhs->size();
+				}
+				stack.emplace_back(Cursor(lhs), Cursor(rhs));
+				return std::partial_ordering::equivalent;
+			}
+
+			//! Walk the queued containers until a difference is found
+			std::partial_ordering run() {
+				while(!stack.empty()) {
+					auto &[lhs, rhs] = stack.back();
+					if(lhs.done() || rhs.done()) {
+						if(!lhs.done()) {
+							return std::partial_ordering::greater;
+						} else if(!rhs.done()) {
+							return std::partial_ordering::less;
+						}
+						stack.pop_back();
+						continue;
+					}
+					// The items live in the containers, not on the stack, so they stay
+					// valid when push() grows the stack.
+					const InternalBox &lhs_item = lhs.item();
+					const InternalBox &rhs_item = rhs.item();
+					lhs.advance();
+					rhs.advance();
+					const auto result = push(lhs_item.elem, rhs_item.elem);
+					if(result != 0) {
+						return result;
+					}
+				}
+				return std::partial_ordering::equivalent;
+			}
+
+		private:
+			std::vector<std::pair<Cursor, Cursor>> stack;
+		};
+
+		void mix(size_t &seed, size_t value) {
+			seed ^= value + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2);
+		}
+
+		// Marks the end of a list, so ((1) 2) and ((1 2)) hash differently.
+		constexpr size_t end_of_list = 0x5a1a0d;
+	}
+
+	std::partial_ordering compare_values(const InternalBox &lhs, const InternalBox &rhs) {
+		Comparison comparison;
+		const auto result = comparison.push(lhs.elem, rhs.elem);
+		if(result != 0) {
+			return result;
+		}
+		return comparison.run();
+	}
+
+	std::partial_ordering compare_values(const List &lhs, const List &rhs) {
+		Comparison comparison;
+		comparison.push(&lhs, &rhs);
+		return comparison.run();
+	}
+
+	std::partial_ordering compare_values(const Vector &lhs, const Vector &rhs) {
+		Comparison comparison;
+		const auto result = comparison.push(&lhs, &rhs);
+		if(result != 0) {
+			return result;
+		}
+		return comparison.run();
+	}
+
+	std::partial_ordering compare_values(const HashSet &lhs, const HashSet &rhs) {
+		if(&lhs == &rhs) {
+			return std::partial_ordering::equivalent;
+		} else if(lhs.size() != rhs.size()) {
+			return lhs.size() <=> rhs.size();
+		}
+		for(const auto &[item, _] : lhs) {
+			if(!rhs.contains(item)) {
+				return std::partial_ordering::unordered;
+			}
+		}
+		return std::partial_ordering::equivalent;
+	}
+
+	size_t hash_value(const InternalBox &box) {
+		size_t seed = 0;
+		std::vector<Cursor> stack;
+
+		auto add = [&seed, &stack](const BoxVariant &elem) {
+			mix(seed, elem.index());
+			if(elem.valueless_by_exception()) {
+				return;
+			}
+			std::visit([&seed, &stack](auto &&arg) {
+				using T = std::decay_t<decltype(arg)>;
+				if constexpr (std::is_same<T, List*>::value) {
+					stack.emplace_back(arg);
+				} else if constexpr (std::is_same<T, Vector*>::value) {
+					mix(seed, arg->size());
+					stack.emplace_back(arg);
+				} else if constexpr (std::is_same<T, HashSet*>::value) {
+					// Sets have no order, so combine the hashes of their items with a sum
+					size_t items = 0;
+					for(const auto &[item, _] : *arg) {
+						items += hash_value(item);
+					}
+					mix(seed, arg->size());
+					mix(seed, items);
+				} else if constexpr (std::is_same<T, Symbol*>::value) {
+					// Symbols compare by name and package name, so hash the same way
+					mix(seed, std::hash<std::string>{}(arg->name));
+					if(arg->package) {
+						mix(seed, std::hash<std::string>{}(arg->package->name));
+					}
+				} else if constexpr (std::is_same<T, StaticString*>::value) {
+					mix(seed, std::hash<std::string>{}(arg->contents));
+				} else if constexpr (std::is_same<T, Empty>::value) {
+					// all empty values are equal
+				} else if constexpr (std::is_floating_point<T>::value) {
+					// 0.0 and -0.0 compare equal
+					mix(seed, std::hash<T>{}(arg == 0 ? T{0} : arg));
+				} else {
+					static_assert(std::is_fundamental<T>::value);
+					mix(seed, std::hash<T>{}(arg));
+				}
+			}, elem);
+		};
+
+		add(box.elem);
+		while(!stack.empty()) {
+			Cursor &cursor = stack.back();
+			if(cursor.done()) {
+				if(!cursor.vector) {
+					mix(seed, end_of_list);
+				}
+				stack.pop_back();
+				continue;
+			}
+			const InternalBox &item = cursor.item();
+			cursor.advance();
+			add(item.elem);
+		}
+		return seed;
+	}
+}
@@ -0,0 +1,160 @@
+#include <bitset>
+#include <cstdlib>
+#include <new>
+#include <algorithm>
+
+#include <vm/consarena.hpp>
+#include <vm/box.hpp>
+#include <util/assert.hpp>
+
+namespace salmon::vm {
+
+	// Chunks are aligned to their size so the chunk owning a cell can be found
+	// by masking off the low bits of its address.
+	static constexpr size_t chunk_bytes = 1 << 18;
+	// Each cell needs its storage plus a live and a mark bit. Leave some room for padding.
+	static constexpr size_t cells_per_chunk = (chunk_bytes - 64) * 8 / (sizeof(List) * 8 + 2);
+
+	struct ConsArena::Chunk {
+		std::bitset<cells_per_chunk> live;
+		std::bitset<cells_per_chunk> marked;
+		alignas(List) std::byte storage[cells_per_chunk * sizeof(List)];
+
+		List *cell(size_t index) {
+			return reinterpret_cast<List*>(storage) + index;
+		}
+
+		size_t index_of(const void *item) const {
+			const auto offset = reinterpret_cast<uintptr_t>(item) - reinterpret_cast<uintptr_t>(storage);
+			return offset / sizeof(List);
+		}
+	};
+
+	ConsArena::~ConsArena() {
+		for(Chunk *chunk : chunks) {
+			for(size_t i = 0; i < cells_per_chunk; i++) {
+				if(chunk->live[i]) {
+					chunk->cell(i)->~List();
+				}
+			}
+			chunk->~Chunk();
+			std::free(chunk);
+		}
+	}
+
+	ConsArena::Chunk *ConsArena::new_chunk() {
+		static_assert(sizeof(Chunk) <= chunk_bytes);
+		void *memory = std::aligned_alloc(chunk_bytes, chunk_bytes);
+		if(memory == nullptr) {
+			throw std::bad_alloc();
+		}
+		Chunk *chunk = new (memory) Chunk();
+		chunks.push_back(chunk);
+		chunk_set.insert(chunk);
+		return chunk;
+	}
+
+	ConsArena::Chunk *ConsArena::chunk_of(const void *item) const {
+		const auto base = reinterpret_cast<uintptr_t>(item) & ~(uintptr_t{chunk_bytes} - 1);
+		const auto found = chunk_set.find(reinterpret_cast<const Chunk*>(base));
+		if(found == chunk_set.end()) {
+			return nullptr;
+		}
+		return const_cast<Chunk*>(*found);
+	}
+
+	std::pair<List*, size_t> ConsArena::allocate(size_t count) {
+		salmon_check(count > 0, "Can't allocate zero cells");
+		size_t remaining = current ? cells_per_chunk - bump : 0;
+		// Start a new chunk rather than splitting a run that would fit in one.
+		// The rest of the old chunk is picked up by the free list after the next sweep.
+		if(remaining < count && (remaining == 0 || count <= cells_per_chunk)) {
+			current = new_chunk();
+			bump = 0;
+			remaining = cells_per_chunk;
+		}
+		const size_t granted = std::min(count, remaining);
+		List *first = current->cell(bump);
+		for(size_t i = bump; i < bump + granted; i++) {
+			current->live.set(i);
+		}
+		bump += granted;
+		in_use += granted;
+		return std::make_pair(first, granted);
+	}
+
+	List *ConsArena::allocate() {
+		if(free_cells.empty()) {
+			return allocate(1).first;
+		}
+		List *cell = free_cells.back();
+		free_cells.pop_back();
+		Chunk *chunk = chunk_of(cell);
+		chunk->live.set(chunk->index_of(cell));
+		in_use++;
+		return cell;
+	}
+
+	bool ConsArena::owns(const AllocatedItem *item) const {
+		return chunk_of(item) != nullptr;
+	}
+
+	bool ConsArena::mark(const AllocatedItem *item) {
+		Chunk *chunk = chunk_of(item);
+		salmon_check(chunk != nullptr, "Item was not allocated from this arena");
+		const size_t index = chunk->index_of(item);
+		if(chunk->marked[index]) {
+			return false;
+		}
+		chunk->marked.set(index);
+		return true;
+	}
+
+	size_t ConsArena::sweep() {
+		size_t freed = 0;
+		std::vector<Chunk*> kept;
+		kept.reserve(chunks.size());
+		for(Chunk *chunk : chunks) {
+			const auto dead = chunk->live & ~chunk->marked;
+			if(dead.any()) {
+				for(size_t i = 0; i < cells_per_chunk; i++) {
+					if(dead[i]) {
+						List *cell = chunk->cell(i);
+						freed += cell->allocated_size();
+						cell->~List();
+					}
+				}
+				in_use -= dead.count();
+				chunk->live &= chunk->marked;
+			}
+			chunk->marked.reset();
+
+			if(chunk != current && chunk->live.none()) {
+				chunk_set.erase(chunk);
+				chunk->~Chunk();
+				std::free(chunk);
+			} else {
+				kept.push_back(chunk);
+			}
+		}
+		chunks = std::move(kept);
+
+		// Hand out the lowest addresses first, so cells allocated one at a time
+		// still tend to end up next to each other.
+		free_cells.clear();
+		for(auto itr = chunks.rbegin(); itr != chunks.rend(); ++itr) {
+			Chunk *chunk = *itr;
+			const size_t limit = chunk == current ? bump : cells_per_chunk;
+			for(size_t i = limit; i > 0; i--) {
+				if(!chunk->live[i - 1]) {
+					free_cells.push_back(chunk->cell(i - 1));
+				}
+			}
+		}
+		return freed;
+	}
+
+	size_t ConsArena::size() const {
+		return in_use;
+	}
+}
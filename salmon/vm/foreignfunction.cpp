@@ -0,0 +1,200 @@
+#include <iostream>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+#include <dlfcn.h>
+
+#include <vm/foreignfunction.hpp>
+#include <vm/vm.hpp>
+
+namespace salmon::vm {
+
+	ForeignError::ForeignError(const std::string &msg) : std::runtime_error(msg) {}
+
+	//! The message for the last dlopen or dlsym failure
+	static std::string dl_error(const std::string &fallback) {
+		const char *error = dlerror();
+		return error ? error : fallback;
+	}
+
+	SharedLibrary::SharedLibrary(const std::string &path) :
+		_path{path},
+		handle{dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL)} {
+		if(handle == nullptr) {
+			throw ForeignError(dl_error("Couldn't open " + path));
+		}
+	}
+
+	SharedLibrary::~SharedLibrary() {
+		dlclose(handle);
+	}
+
+	void *SharedLibrary::symbol(const std::string &name) const {
+		// A symbol can be at address 0, so only dlerror tells if it was found
+		dlerror();
+		void *address = dlsym(handle, name.c_str());
+		if(const char *error = dlerror()) {
+			throw ForeignError(error);
+		}
+		return address;
+	}
+
+	const std::string &SharedLibrary::path() const {
+		return _path;
+	}
+
+	template<typename T>
+	static T unbox(const InternalBox &box) {
+		if constexpr (std::is_same_v<T, const char*>) {
+			return std::get<StaticString*>(box.elem)->contents.c_str();
+		} else {
+			return std::get<T>(box.elem);
+		}
+	}
+
+	template<typename R, typename... Args, std::size_t... S>
+	static Box call_c(VirtualMachine *vm, void *address, std::span<InternalBox> args, std::index_sequence<S...>) {
+		R (*fn)(Args...) = reinterpret_cast<R(*)(Args...)>(address);
+		if constexpr (std::is_void_v<R>) {
+			fn(unbox<Args>(args[S])...);
+			return vm->make_boxed(Empty{});
+		} else if constexpr (std::is_same_v<R, const char*>) {
+			const char *result = fn(unbox<Args>(args[S])...);
+			return vm->make_boxed(vm->mem_manager.allocate_obj<StaticString>(std::string(result ? result : "")));
+		} else {
+			return vm->make_boxed(fn(unbox<Args>(args[S])...));
+		}
+	}
+
+	template<typename R, typename... Args>
+	static Box trampoline(VirtualMachine *vm, void *address, std::span<InternalBox> args) {
+		return call_c<R, Args...>(vm, address, args, std::index_sequence_for<Args...>());
+	}
+
+	//! Pick the trampoline by adding the C type of each remaining argument to Args
+	template<typename R, typename... Args>
+	static Trampoline select_trampoline(std::span<const CType> rest) {
+		if(rest.empty()) {
+			return trampoline<R, Args...>;
+		}
+		if constexpr (sizeof...(Args) < max_foreign_args) {
+			switch(rest.front()) {
+			case CType::INT32:
+				return select_trampoline<R, Args..., int32_t>(rest.subspan(1));
+			case CType::FLOAT64:
+				return select_trampoline<R, Args..., double>(rest.subspan(1));
+			case CType::BOOL:
+				return select_trampoline<R, Args..., bool>(rest.subspan(1));
+			case CType::STRING:
+				return select_trampoline<R, Args..., const char*>(rest.subspan(1));
+			case CType::VOID:
+				return nullptr;
+			}
+		}
+		return nullptr;
+	}
+
+	Trampoline find_trampoline(const CType result, const std::span<const CType> args) {
+		switch(result) {
+		case CType::INT32:
+			return select_trampoline<int32_t>(args);
+		case CType::FLOAT64:
+			return select_trampoline<double>(args);
+		case CType::BOOL:
+			return select_trampoline<bool>(args);
+		case CType::STRING:
+			return select_trampoline<const char*>(args);
+		case CType::VOID:
+			return select_trampoline<void>(args);
+		}
+		return nullptr;
+	}
+
+	ForeignFunction::ForeignFunction(const vm_ptr<Type> &type, const std::vector<vm_ptr<Symbol>> &lambda_list,
+									 std::shared_ptr<SharedLibrary> library, const std::string &c_name,
+									 void *address, Trampoline trampoline, const std::vector<Type*> &arg_types) :
+		VmFunction(type, lambda_list, std::nullopt, library->path(), std::nullopt),
+		library{std::move(library)},
+		_c_name{c_name},
+		address{address},
+		trampoline{trampoline},
+		arg_types{arg_types} {}
+
+	Box ForeignFunction::operator()(VirtualMachine *vm, std::span<InternalBox> args) {
+		if(args.size() != arg_types.size()) {
+			throw ArityException::build(vm, _lambda_list, args.size(), arg_types.size());
+		}
+		for(size_t i = 0; i < args.size(); i++) {
+			if(args[i].type != arg_types[i]) {
+				std::vector<vm_ptr<Type>> sig;
+				sig.reserve(args.size());
+				for(const InternalBox &arg : args) {
+					sig.push_back(vm->mem_manager.make_vm_ptr(arg.type));
+				}
+				throw NoSuchFunction(std::move(sig));
+			}
+		}
+		return trampoline(vm, address, args);
+	}
+
+	const std::string &ForeignFunction::c_name() const {
+		return _c_name;
+	}
+
+	void ForeignFunction::print_debug_info() const {
+		std::cerr << "Foreign function " << _c_name << " from " << library->path() << std::endl;
+	}
+
+	size_t ForeignFunction::allocated_size() const {
+		return sizeof(*this);
+	}
+
+	static std::optional<CType> c_type(VirtualMachine &vm, const Type *type) {
+		if(type == vm.get_builtin_type<int32_t>().get()) {
+			return CType::INT32;
+		} else if(type == vm.get_builtin_type<double>().get()) {
+			return CType::FLOAT64;
+		} else if(type == vm.get_builtin_type<bool>().get()) {
+			return CType::BOOL;
+		} else if(type == vm.get_builtin_type<StaticString>().get()) {
+			return CType::STRING;
+		}
+		return std::nullopt;
+	}
+
+	vm_ptr<ForeignFunction> import_function(VirtualMachine &vm, const std::shared_ptr<SharedLibrary> &library,
+											const std::string &c_name, const std::vector<Type*> &arg_types,
+											Type *result_type) {
+		std::vector<CType> c_args;
+		std::vector<vm_ptr<Symbol>> lambda_list;
+		SpecBuilder arg_spec;
+		for(Type *type : arg_types) {
+			const std::optional<CType> arg = c_type(vm, type);
+			if(!arg) {
+				throw ForeignError("Argument " + std::to_string(c_args.size() + 1) + " of " + c_name
+								   + " can't be passed to C");
+			}
+			c_args.push_back(*arg);
+			lambda_list.push_back(vm.base_package().intern_symbol("arg-" + std::to_string(c_args.size() - 1)));
+			arg_spec.add_type(vm.mem_manager.make_vm_ptr(type));
+		}
+		std::optional<CType> result = c_type(vm, result_type);
+		if(!result && result_type == vm.get_builtin_type<Empty>().get()) {
+			result = CType::VOID;
+		} else if(!result) {
+			throw ForeignError("The result of " + c_name + " can't be returned from C");
+		}
+		const Trampoline trampoline = find_trampoline(*result, c_args);
+		if(trampoline == nullptr) {
+			throw ForeignError(c_name + " takes more than " + std::to_string(max_foreign_args) + " arguments");
+		}
+		void *address = library->symbol(c_name);
+
+		SpecBuilder ret_spec;
+		ret_spec.add_type(vm.mem_manager.make_vm_ptr(result_type));
+		const vm_ptr<Type> type = vm.type_table.get_fn_type(arg_spec.build(), ret_spec.build());
+		return vm.mem_manager.allocate_obj<ForeignFunction>(type, lambda_list, library, c_name,
+															  address, trampoline, arg_types);
+	}
+}
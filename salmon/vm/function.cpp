@@ -63,6 +63,14 @@ namespace salmon::vm {
 		return _source_form;
 	}
 
+	bool VmFunction::pure() const {
+		return _pure;
+	}
+
+	void VmFunction::pure(const bool is_pure) {
+		_pure = is_pure;
+	}
+
 	InterfaceFunction::InterfaceFunction(const vm_ptr<Type> &type,
 										 const std::vector<vm_ptr<Symbol>> &lambda_list,
 										 std::optional<std::string> doc,
@@ -100,6 +108,7 @@ namespace salmon::vm {
 	}
 
 	Box InterfaceFunction::operator()(VirtualMachine *vm, std::span<InternalBox> args)  {
+		vm->safepoint();
 		const std::vector<Type*> arg_types = get_signature(args);
 		try {
 			// TODO: fix this to not throw an exception if a value isn't found:
@@ -112,16 +121,47 @@ namespace salmon::vm {
 	}
 
 	bool InterfaceFunction::add_impl(const vm_ptr<VmFunction> &fn) {
-		auto other_fn_type = std::get<FunctionType>(fn->type()->type);
-		if(fn->type()->concrete() && std::get<FunctionType>(fn_type->type).match(other_fn_type)) {
-			const std::vector<Type*> arg_types = other_fn_type.arg_types();
-		    functions.insert_or_assign(arg_types, fn.get());
+		const auto &other_fn_type = std::get<FunctionType>(fn->type()->type);
+		if(!_sealed && fn->type()->concrete() && std::get<FunctionType>(fn_type->type).match(other_fn_type)) {
+			insert_impl(fn);
+			return true;
+		} else {
+			return false;
+		}
+	}
+
+	bool InterfaceFunction::add_impl(const vm_ptr<VmFunction> &fn, TypeTable &types) {
+		if(!_sealed && fn->type()->concrete() && types.fn_match(fn_type, fn->type())) {
+			insert_impl(fn);
 			return true;
 		} else {
 			return false;
 		}
 	}
 
+	VmFunction *InterfaceFunction::find_impl(const std::vector<Type*> &arg_types) const {
+		VmFunction *const *found = functions.find(arg_types);
+		return found ? *found : nullptr;
+	}
+
+	uint64_t InterfaceFunction::version() const {
+		return impl_version;
+	}
+
+	void InterfaceFunction::seal() {
+		_sealed = true;
+	}
+
+	bool InterfaceFunction::sealed() const {
+		return _sealed;
+	}
+
+	void InterfaceFunction::insert_impl(const vm_ptr<VmFunction> &fn) {
+		const std::vector<Type*> arg_types = std::get<FunctionType>(fn->type()->type).arg_types();
+		functions.insert_or_assign(arg_types, fn.get());
+		impl_version++;
+	}
+
 	void InterfaceFunction::get_roots(const std::function<void(AllocatedItem*)> &inserter) const {
 		functions.all_values([&inserter](Type* const&item) {
 			inserter(item);
@@ -137,7 +177,7 @@ namespace salmon::vm {
 
 	size_t InterfaceFunction::allocated_size() const { return sizeof(InterfaceFunction); }
 
-	FunctionTable::FunctionTable() {}
+	FunctionTable::FunctionTable(TypeTable &types) : types{types} {}
 
 	bool FunctionTable::add_function(const vm_ptr<Symbol> &name, const vm_ptr<VmFunction> &fn) {
 		vm_ptr<VmFunction> fn_copy = fn;
@@ -145,16 +185,14 @@ namespace salmon::vm {
 	}
 
 	bool FunctionTable::add_function(const vm_ptr<Symbol> &name, vm_ptr<VmFunction> &&fn) {
-		auto interface_place = interfaces.find(name);
-		if(interface_place != interfaces.end()) {
-			return interface_place->second->add_impl(fn);
+		if(vm_ptr<InterfaceFunction> *interface = interfaces.find(*name)) {
+			return (*interface)->add_impl(fn, types);
 		} else {
-			auto place = functions.lower_bound(name);
-			if(place == functions.end() || *place->first != *name) {
-				functions.emplace_hint(place,name, fn);
+			auto [place, added] = functions.try_emplace(name, fn);
+			if(added) {
 				return true;
-			} else if(place->second->type()->equivalent_to(*fn->type())) {
-				functions.insert_or_assign(name, fn);
+			} else if(types.equivalent((*place)->type(), fn->type())) {
+				*place = fn;
 				return true;
 			} else {
 				return false;
@@ -164,23 +202,29 @@ namespace salmon::vm {
 
 	bool FunctionTable::new_interface(const vm_ptr<Symbol> &name,
 									  const vm_ptr<InterfaceFunction> &fn_type) {
-		auto place = interfaces.lower_bound(name);
-		if(place == interfaces.end() || *(place->first) != *name) {
-			interfaces.emplace(name, fn_type);
+		auto [place, added] = interfaces.try_emplace(name, fn_type);
+		if(added) {
 			return true;
-		} else if(place->second->type()->equivalent_to(*fn_type->type())) {
+		} else if(types.equivalent((*place)->type(), fn_type->type())) {
 			// TODO: update the interface's documenation and other non-important fields
 			return true;
 		} else return false;
 	}
 
 	std::optional<vm_ptr<VmFunction>> FunctionTable::get_fn(const vm_ptr<Symbol> &name) const {
-		auto interface_place = interfaces.find(name);
-		if(interface_place != interfaces.end()) {
-			return std::make_optional(static_cast<vm_ptr<VmFunction>>(interface_place->second));
-		} else if(auto fn_place = functions.find(name);
-				  fn_place != functions.end()) {
-			return std::make_optional(static_cast<vm_ptr<VmFunction>>(fn_place->second));
+		if(const vm_ptr<InterfaceFunction> *interface = interfaces.find(*name)) {
+			return std::make_optional(static_cast<vm_ptr<VmFunction>>(*interface));
+		} else if(const vm_ptr<VmFunction> *fn = functions.find(*name)) {
+			return std::make_optional(*fn);
 		} else return std::nullopt;
 	}
+
+	VmFunction *FunctionTable::find_fn(const Symbol &name) const {
+		if(const vm_ptr<InterfaceFunction> *interface = interfaces.find(name)) {
+			return interface->get();
+		} else if(const vm_ptr<VmFunction> *fn = functions.find(name)) {
+			return fn->get();
+		}
+		return nullptr;
+	}
 }
@@ -0,0 +1,61 @@
+#include <iostream>
+
+#include <vm/hashset.hpp>
+
+namespace salmon::vm {
+
+	HashSet::HashSet(size_t size) :
+		items{} {
+		items.reserve(size);
+	}
+
+	bool HashSet::insert(const Box &item) {
+		return insert(item.bare());
+	}
+
+	bool HashSet::insert(const InternalBox &item) {
+		return items.try_emplace(item, Empty{}).second;
+	}
+
+	bool HashSet::contains(const InternalBox &item) const {
+		return items.contains(item);
+	}
+
+	bool HashSet::erase(const InternalBox &item) {
+		return items.erase(item);
+	}
+
+	HashSet::Table::const_iterator HashSet::begin() const {
+		return items.begin();
+	}
+
+	HashSet::Table::const_iterator HashSet::end() const {
+		return items.end();
+	}
+
+	size_t HashSet::size() const {
+		return items.size();
+	}
+
+	void HashSet::print_debug_info() const {
+		std::cerr << "HashSet " << items.size() << " " << this << std::endl;
+	}
+
+	void HashSet::get_roots(const std::function<void(AllocatedItem*)>& inserter) const {
+		for(const auto &[item, _] : items) {
+			item.get_roots(inserter);
+		}
+	}
+
+	size_t HashSet::allocated_size() const {
+		return sizeof(HashSet);
+	}
+
+	std::partial_ordering HashSet::operator<=>(const HashSet &other) const {
+		return compare_values(*this, other);
+	}
+
+	bool HashSet::operator==(const HashSet &other) const {
+		return compare_values(*this, other) == 0;
+	}
+}
@@ -8,6 +8,11 @@ namespace salmon::vm {
 
 	}
 
+	List::List(const InternalBox &itm) :
+		itm{itm}, next{nullptr} {
+
+	}
+
 	void List::get_roots(const std::function<void(AllocatedItem*)>& inserter) const {
 		itm.get_roots(inserter);
 		if (next != nullptr) {
@@ -22,4 +27,12 @@ namespace salmon::vm {
 	size_t List::allocated_size() const {
 		return sizeof(List);
 	}
+
+	bool List::operator==(const List &other) const {
+		return compare_values(*this, other) == 0;
+	}
+
+	std::partial_ordering List::operator<=>(const List &other) const {
+		return compare_values(*this, other);
+	}
 }
@@ -4,6 +4,8 @@
 
 #include <vm/vm_ptr.hpp>
 #include <vm/memory.hpp>
+#include <vm/box.hpp>
+#include <util/assert.hpp>
 
 namespace salmon::vm {
 
@@ -11,46 +13,70 @@ namespace salmon::vm {
 		do_gc();
 	}
 
-	static AllocatedItem* set_pop(std::unordered_set<AllocatedItem*> &set) {
-		auto itr = set.begin();
-		AllocatedItem *itm = *itr;
-		set.erase(itr);
-		return itm;
+	vm_ptr<List> MemoryManager::allocate_list(const std::vector<Box> &items) {
+		salmon_check(!items.empty(), "Can't allocate an empty list");
+		vm_ptr<List> head = allocate_list(items.size(), items.front().bare());
+		List *cell = head.get();
+		for(const Box &item : items) {
+			cell->itm = item.bare();
+			cell = cell->next;
+		}
+		return head;
 	}
 
-	static void check_item(AllocatedItem *item,
-			   std::unordered_set<AllocatedItem*> &to_check,
-			   std::unordered_set<AllocatedItem*> &marked) {
-		marked.insert(item);
-		std::vector<AllocatedItem*> children;
-		item->get_roots([&to_check, &marked](AllocatedItem *child) {
-			if(!marked.contains(child)) {
-				to_check.insert(child);
+	vm_ptr<List> MemoryManager::allocate_list(size_t count, const InternalBox &fill) {
+		salmon_check(count > 0, "Can't allocate an empty list");
+		List *head = nullptr;
+		List *tail = nullptr;
+		size_t remaining = count;
+		while(remaining > 0) {
+			auto [cells, allocated] = cons_cells.allocate(remaining);
+			for(size_t i = 0; i < allocated; i++) {
+				List *cell = new (cells + i) List(fill);
+				if(tail) {
+					tail->next = cell;
+				} else {
+					head = cell;
+				}
+				tail = cell;
 			}
-		});
+			remaining -= allocated;
+		}
+		total_allocated += sizeof(List) * count;
+		return make_vm_ptr(head);
 	}
 
 	/**
 	 * this function implements mark and sweep garbage collection.
 	 **/
 	void MemoryManager::do_gc() {
-		std::cerr << "Before GC: " << allocated.size() << "\n";
+		std::cerr << "Before GC: " << allocated.size() + cons_cells.size() << "\n";
 		std::unordered_set<AllocatedItem*> marked = {};
-		std::unordered_set<AllocatedItem*> to_check;
+		std::vector<AllocatedItem*> to_check;
 		marked.reserve(allocated.size());
-		to_check.reserve(allocated.size());
+
+		// List cells keep their mark bits in the cons arena, everything else
+		// is tracked in the marked set. Returns true the first time an item is seen.
+		auto mark = [this, &marked](AllocatedItem *item) {
+			if(cons_cells.owns(item)) {
+				return cons_cells.mark(item);
+			}
+			return marked.insert(item).second;
+		};
+		const std::function<void(AllocatedItem*)> visit = [&mark, &to_check](AllocatedItem *item) {
+			if(mark(item)) {
+				to_check.push_back(item);
+			}
+		};
 
 		for(auto [root, count] : roots) {
-			// each root is guaranteed to be unique, so no need to check if it has
-			// already been marked.
-		    check_item(root, to_check, marked);
+			visit(root);
 		}
 
 		while (!to_check.empty()) {
-			AllocatedItem *cur = set_pop(to_check);
-			// check_item ensures that marked union to_check = (),
-			// so no need to check if cur is in marked.
-			check_item(cur, to_check, marked);
+			AllocatedItem *cur = to_check.back();
+			to_check.pop_back();
+			cur->get_roots(visit);
 		}
 
 		std::vector<AllocatedItem*> to_delete;
@@ -65,7 +91,12 @@ namespace salmon::vm {
 			allocated.erase(item);
 			delete item;
 		}
-		std::cerr << "After GC: " << allocated.size() << "\n";
+		total_allocated = total_allocated - cons_cells.sweep();
+		std::cerr << "After GC: " << allocated.size() + cons_cells.size() << "\n";
+	}
+
+	SymbolIndex &MemoryManager::symbol_index() {
+		return symbols;
 	}
 
 }
@@ -26,6 +26,19 @@ namespace salmon::vm {
 		  exported(),
 		  used(used) { }
 
+	Package::~Package() {
+		SymbolIndex &index = mem_manager.symbol_index();
+		for(const auto &[name, symbol] : interned) {
+			index.remove(*symbol);
+		}
+	}
+
+	vm_ptr<Symbol> Package::new_symbol(const std::string &name) {
+		SymbolIndex &index = mem_manager.symbol_index();
+		vm_ptr<Symbol> symbol = mem_manager.allocate_obj<Symbol>(name, this, index.next_id());
+		index.add(symbol.get());
+		return symbol;
+	}
 
 	std::optional<vm_ptr<Symbol>> Package::find_external_symbol(const std::string_view name) const {
 		auto result = this->exported.find(name);
@@ -51,7 +64,7 @@ namespace salmon::vm {
 
 		auto interned_result = interned.lower_bound(name);
 		if(interned_result == interned.end() || (*interned_result).second->name != name) {
-			vm_ptr<Symbol> new_symb = mem_manager.allocate_obj<Symbol>(name, this);
+			vm_ptr<Symbol> new_symb = new_symbol(name);
 			auto final_place = interned.emplace_hint(interned_result, name, std::move(new_symb));
 			salmon_check((*final_place).second->name == name, "Name not added correctly");
 			return (*final_place).second;
@@ -69,7 +82,7 @@ namespace salmon::vm {
 
 		auto interned_result = interned.lower_bound(name);
 		if(interned_result == interned.end() || (*interned_result).second->name != name) {
-			vm_ptr<Symbol> new_symb = mem_manager.allocate_obj<Symbol>(name, this);
+			vm_ptr<Symbol> new_symb = new_symbol(name);
 			auto final_place = interned.emplace_hint(interned_result, name, std::move(new_symb));
 			salmon_check((*final_place).second->name == name, "Name not added correctly");
 			return (*final_place).second;
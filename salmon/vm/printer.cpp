@@ -0,0 +1,148 @@
+#include <charconv>
+#include <utility>
+
+#include <vm/printer.hpp>
+#include <vm/vm.hpp>
+
+namespace salmon::vm {
+
+	//! Buffered output is written out once there is this much of it
+	static constexpr size_t flush_size = 64 * 1024;
+
+	Printer::Printer(VirtualMachine &vm, std::ostream &out) :
+		vm{vm}, out{&out}, buffer{}, stack{}, builtin_types{}, have_types{false} {}
+
+	Printer::~Printer() {
+		flush();
+	}
+
+	const InternalBox *Printer::Frame::next() {
+		if(cell) {
+			const InternalBox *item = &cell->itm;
+			cell = cell->next;
+			return item;
+		} else if(vector) {
+			return index < vector->size() ? &(*vector)[index++] : nullptr;
+		} else if(set && *set_pos != set->end()) {
+			const InternalBox *item = &(**set_pos).first;
+			++*set_pos;
+			return item;
+		}
+		return nullptr;
+	}
+
+	void Printer::print(const InternalBox &value) {
+		// The print interface can call back into the printer, so only finish
+		// the containers started by this call.
+		const size_t base = stack.size();
+		try {
+			print_item(value);
+			while(stack.size() > base) {
+				vm.safepoint();
+				Frame &frame = stack.back();
+				const InternalBox *item = frame.next();
+				if(!item) {
+					buffer.push_back(frame.close);
+					stack.pop_back();
+					continue;
+				}
+				if(!frame.first) {
+					buffer.push_back(' ');
+				}
+				frame.first = false;
+				// print_item may grow the stack, so don't hold on to the frame
+				print_item(*item);
+				if(buffer.size() >= flush_size) {
+					flush();
+				}
+			}
+		} catch(...) {
+			// Write out what was printed so far and leave the printer usable for the next value
+			stack.erase(stack.begin() + static_cast<std::ptrdiff_t>(base), stack.end());
+			flush();
+			throw;
+		}
+		if(buffer.size() >= flush_size) {
+			flush();
+		}
+	}
+
+	void Printer::flush() {
+		out->write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+		buffer.clear();
+	}
+
+	std::ostream &Printer::output() const {
+		return *out;
+	}
+
+	void Printer::output(std::ostream &new_out) {
+		flush();
+		out = &new_out;
+	}
+
+	template<typename T>
+	void Printer::print_number(T number) {
+		std::array<char, 32> chars;
+		const auto result = std::to_chars(chars.begin(), chars.end(), number);
+		buffer.append(chars.data(), result.ptr);
+	}
+
+	void Printer::print_symbol(const Symbol &symbol) {
+		if(symbol.package) {
+			buffer += symbol.package->name;
+			buffer += symbol.package->is_exported(symbol) ? ":" : "::";
+		} else {
+			buffer += "#:";
+		}
+		buffer += symbol.name;
+	}
+
+	void Printer::print_through_interface(const InternalBox &value) {
+		// Whatever the interface prints has to come after what is buffered
+		flush();
+		vm_ptr<VmFunction> print_fn = *vm.fn_table.get_fn(vm.base_package().intern_symbol("print"));
+		std::array<InternalBox, 1> args = { value };
+		(*print_fn)(&vm, std::span<InternalBox, 1>(args));
+	}
+
+	void Printer::print_item(const InternalBox &value) {
+		if(!have_types) {
+			[this]<size_t... I>(std::index_sequence<I...>) {
+				((builtin_types[I] = vm.get_builtin_type<
+				  std::remove_pointer_t<std::variant_alternative_t<I, BoxVariant>>>().get()), ...);
+			}(std::make_index_sequence<std::variant_size_v<BoxVariant>>());
+			have_types = true;
+		}
+		if(value.elem.valueless_by_exception() || value.type != builtin_types[value.elem.index()]) {
+			print_through_interface(value);
+			return;
+		}
+		std::visit([this](auto &&arg) {
+			using T = std::decay_t<decltype(arg)>;
+			if constexpr (std::is_arithmetic<T>::value && !std::is_same<T, bool>::value) {
+				print_number(arg);
+			} else if constexpr (std::is_same<T, bool>::value) {
+				buffer.push_back(arg ? '1' : '0');
+			} else if constexpr (std::is_same<T, Empty>::value) {
+				buffer += "Empty";
+			} else if constexpr (std::is_same<T, Symbol*>::value) {
+				print_symbol(*arg);
+			} else if constexpr (std::is_same<T, StaticString*>::value) {
+				buffer.push_back('"');
+				buffer += arg->contents;
+				buffer.push_back('"');
+			} else if constexpr (std::is_same<T, List*>::value) {
+				buffer.push_back('(');
+				stack.push_back(Frame{')', true, arg, nullptr, 0, nullptr, std::nullopt});
+			} else if constexpr (std::is_same<T, Vector*>::value) {
+				buffer.push_back('[');
+				stack.push_back(Frame{']', true, nullptr, arg, 0, nullptr, std::nullopt});
+			} else {
+				static_assert(std::is_same<T, HashSet*>::value);
+				buffer.push_back('{');
+				stack.push_back(Frame{'}', true, nullptr, nullptr, 0, arg, arg->begin()});
+			}
+		}, value.elem);
+	}
+}
@@ -0,0 +1,1061 @@
+#include <array>
+#include <bit>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+#include <vm/serialize.hpp>
+#include <vm/vm.hpp>
+#include <vm/hashset.hpp>
+#include <util/assert.hpp>
+#include <util/swisstable.hpp>
+
+namespace salmon::vm::serialize {
+
+	/*
+	 * Layout of a record. Offsets are from the start of the record, and every
+	 * integer is little endian.
+	 *
+	 *   INT32    u32
+	 *   FLOAT64  u64 holding the bits of the double
+	 *   TRUE, FALSE, EMPTY
+	 *   SYMBOL   u8 has package, [str package name], str name
+	 *   STRING   str, a u32 length followed by the characters
+	 *   LIST     u32 cell count, u32 size, tail, items
+	 *   VECTOR   u32 item count, u32 size, items
+	 *   SET      u32 item count, u32 size, items
+	 *   REF      u32 offset of the definition, u32 cell index
+	 *   INT64    u64
+	 *   UINT64   u64
+	 *   FLOAT32  u32 holding the bits of the float
+	 *
+	 * The size of a container counts the bytes after it, up to the end of the
+	 * container, so it can be skipped over. The tail of a list is EMPTY, or a
+	 * REF to a cell of a list that was defined before it. The cell index of a
+	 * REF is 0 unless it points into a list. Definitions that are referenced
+	 * have the SHARED bit set in their tag.
+	 */
+	namespace {
+		constexpr std::array<char, 4> MAGIC = { 'S', 'A', 'L', 'V' };
+
+		enum class Tag : uint8_t {
+			INT32,
+			FLOAT64,
+			TRUE,
+			FALSE,
+			EMPTY,
+			SYMBOL,
+			STRING,
+			LIST,
+			VECTOR,
+			SET,
+			REF,
+			INT64,
+			UINT64,
+			FLOAT32,
+		};
+
+		constexpr uint8_t SHARED = 0x80;
+
+		bool is_container(Tag tag) {
+			return tag == Tag::LIST || tag == Tag::VECTOR || tag == Tag::SET;
+		}
+
+		//! Appends little endian integers and length prefixed strings to a buffer
+		class Output {
+		public:
+			explicit Output(std::vector<std::byte> &bytes) :
+				bytes{bytes} {}
+
+			void u8(uint8_t value) {
+				bytes.push_back(static_cast<std::byte>(value));
+			}
+
+			void u16(uint16_t value) {
+				u8(value & 0xff);
+				u8(value >> 8);
+			}
+
+			void u32(uint32_t value) {
+				for(int i = 0; i < 4; i++) {
+					u8((value >> (8 * i)) & 0xff);
+				}
+			}
+
+			void u64(uint64_t value) {
+				for(int i = 0; i < 8; i++) {
+					u8((value >> (8 * i)) & 0xff);
+				}
+			}
+
+			void tag(Tag tag) {
+				u8(static_cast<uint8_t>(tag));
+			}
+
+			void str(std::string_view str) {
+				u32(static_cast<uint32_t>(str.size()));
+				const auto *start = reinterpret_cast<const std::byte*>(str.data());
+				bytes.insert(bytes.end(), start, start + str.size());
+			}
+
+			//! Overwrite a u32 written earlier
+			void patch_u32(size_t pos, uint32_t value) {
+				for(int i = 0; i < 4; i++) {
+					bytes[pos + i] = static_cast<std::byte>((value >> (8 * i)) & 0xff);
+				}
+			}
+
+			size_t size() const {
+				return bytes.size();
+			}
+
+			std::vector<std::byte> &bytes;
+		};
+
+		void write_header(Output &out) {
+			for(char c : MAGIC) {
+				out.u8(static_cast<uint8_t>(c));
+			}
+			out.u16(VERSION);
+		}
+
+		struct Malformed {};
+
+		//! Reads what Output writes, throwing Malformed when running off the end
+		class Input {
+		public:
+			explicit Input(std::span<const std::byte> data, size_t pos = 0) :
+				data{data}, pos{pos} {}
+
+			uint8_t u8() {
+				need(1);
+				return static_cast<uint8_t>(data[pos++]);
+			}
+
+			uint16_t u16() {
+				const uint16_t low = u8();
+				return static_cast<uint16_t>(low | (u8() << 8));
+			}
+
+			uint32_t u32() {
+				uint32_t value = 0;
+				for(int i = 0; i < 4; i++) {
+					value |= static_cast<uint32_t>(u8()) << (8 * i);
+				}
+				return value;
+			}
+
+			uint64_t u64() {
+				uint64_t value = 0;
+				for(int i = 0; i < 8; i++) {
+					value |= static_cast<uint64_t>(u8()) << (8 * i);
+				}
+				return value;
+			}
+
+			std::string_view str() {
+				const uint32_t size = u32();
+				need(size);
+				std::string_view str(reinterpret_cast<const char*>(data.data() + pos), size);
+				pos += size;
+				return str;
+			}
+
+			void skip(uint32_t size) {
+				need(size);
+				pos += size;
+			}
+
+			void seek(size_t to) {
+				pos = to;
+			}
+
+			uint32_t position() const {
+				return static_cast<uint32_t>(pos);
+			}
+
+			bool done() const {
+				return pos == data.size();
+			}
+		private:
+			void need(size_t count) const {
+				if(pos > data.size() || data.size() - pos < count) {
+					throw Malformed{};
+				}
+			}
+
+			std::span<const std::byte> data;
+			size_t pos;
+		};
+
+		//! Split a tag byte into the tag and whether the definition is shared
+		std::pair<Tag, bool> split_tag(uint8_t byte) {
+			return std::make_pair(static_cast<Tag>(byte & ~SHARED), (byte & SHARED) != 0);
+		}
+
+		//! Where a value was defined in the current record
+		struct Seen {
+			uint32_t offset;
+			uint32_t index;
+		};
+	}
+
+	class Encoder {
+	public:
+		//! Append the value to bytes as a record, along with its size
+		void encode(const InternalBox &value, std::vector<std::byte> &bytes) {
+			Output out(bytes);
+			const size_t size_at = out.size();
+			out.u32(0);
+			record = out.size();
+			seen.clear();
+
+			write_item(out, value);
+			while(!stack.empty()) {
+				Frame &frame = stack.back();
+				if(frame.remaining == 0) {
+					out.patch_u32(frame.size_at, static_cast<uint32_t>(out.size() - frame.size_at - 4));
+					stack.pop_back();
+					continue;
+				}
+				frame.remaining--;
+				const InternalBox *item;
+				if(frame.cell) {
+					item = &frame.cell->itm;
+					frame.cell = frame.cell->next;
+				} else if(frame.vector) {
+					item = &(*frame.vector)[frame.index++];
+				} else {
+					item = frame.set_items[frame.index++];
+				}
+				// write_item may grow the stack, so don't hold on to the frame
+				write_item(out, *item);
+			}
+			out.patch_u32(size_at, static_cast<uint32_t>(out.size() - record));
+		}
+	private:
+		struct Frame {
+			size_t size_at;
+			uint32_t remaining;
+			const List *cell;
+			const Vector *vector;
+			std::vector<const InternalBox*> set_items;
+			size_t index;
+		};
+
+		uint32_t position(const Output &out) const {
+			return static_cast<uint32_t>(out.size() - record);
+		}
+
+		//! Write a reference if the value was already written. Returns whether it was.
+		bool write_ref(Output &out, const void *value) {
+			const Seen *target = seen.find(value);
+			if(!target) {
+				return false;
+			}
+			write_ref(out, *target);
+			return true;
+		}
+
+		void write_ref(Output &out, Seen target) {
+			std::byte &tag = out.bytes[record + target.offset];
+			tag |= static_cast<std::byte>(SHARED);
+			out.tag(Tag::REF);
+			out.u32(target.offset);
+			out.u32(target.index);
+		}
+
+		//! Write a container's header and queue its items
+		void push(Output &out, Tag tag, uint32_t count, Frame &&frame) {
+			out.tag(tag);
+			out.u32(count);
+			frame.size_at = out.size();
+			frame.remaining = count;
+			out.u32(0);
+			stack.push_back(std::move(frame));
+		}
+
+		void write_list(Output &out, const List *list) {
+			const uint32_t offset = position(out);
+			// Every cell written here can be shared, up to the first one that
+			// was written before, which becomes the tail.
+			uint32_t count = 0;
+			const List *tail = list;
+			while(tail && seen.try_emplace(tail, Seen{offset, count}).second) {
+				tail = tail->next;
+				count++;
+			}
+			push(out, Tag::LIST, count, Frame{0, 0, list, nullptr, {}, 0});
+			if(tail) {
+				write_ref(out, *seen.find(tail));
+			} else {
+				out.tag(Tag::EMPTY);
+			}
+		}
+
+		void write_item(Output &out, const InternalBox &box) {
+			salmon_check(!box.elem.valueless_by_exception(), "Can't serialize a valueless box");
+			std::visit([this, &out](auto &&arg) {
+				using T = std::decay_t<decltype(arg)>;
+				if constexpr (std::is_pointer<T>::value) {
+					if(write_ref(out, arg)) {
+						return;
+					}
+				}
+				if constexpr (std::is_same<T, int32_t>::value) {
+					out.tag(Tag::INT32);
+					out.u32(static_cast<uint32_t>(arg));
+				} else if constexpr (std::is_same<T, double>::value) {
+					out.tag(Tag::FLOAT64);
+					out.u64(std::bit_cast<uint64_t>(arg));
+				} else if constexpr (std::is_same<T, int64_t>::value) {
+					out.tag(Tag::INT64);
+					out.u64(static_cast<uint64_t>(arg));
+				} else if constexpr (std::is_same<T, uint64_t>::value) {
+					out.tag(Tag::UINT64);
+					out.u64(arg);
+				} else if constexpr (std::is_same<T, float>::value) {
+					out.tag(Tag::FLOAT32);
+					out.u32(std::bit_cast<uint32_t>(arg));
+				} else if constexpr (std::is_same<T, bool>::value) {
+					out.tag(arg ? Tag::TRUE : Tag::FALSE);
+				} else if constexpr (std::is_same<T, Empty>::value) {
+					out.tag(Tag::EMPTY);
+				} else if constexpr (std::is_same<T, Symbol*>::value) {
+					seen.try_emplace(arg, Seen{position(out), 0});
+					out.tag(Tag::SYMBOL);
+					out.u8(arg->package != nullptr);
+					if(arg->package) {
+						out.str(arg->package->name);
+					}
+					out.str(arg->name);
+				} else if constexpr (std::is_same<T, StaticString*>::value) {
+					seen.try_emplace(arg, Seen{position(out), 0});
+					out.tag(Tag::STRING);
+					out.str(arg->contents);
+				} else if constexpr (std::is_same<T, List*>::value) {
+					write_list(out, arg);
+				} else if constexpr (std::is_same<T, Vector*>::value) {
+					seen.try_emplace(arg, Seen{position(out), 0});
+					push(out, Tag::VECTOR, static_cast<uint32_t>(arg->size()), Frame{0, 0, nullptr, arg, {}, 0});
+				} else {
+					static_assert(std::is_same<T, HashSet*>::value);
+					seen.try_emplace(arg, Seen{position(out), 0});
+					std::vector<const InternalBox*> items;
+					items.reserve(arg->size());
+					for(const auto &[item, _] : *arg) {
+						items.push_back(&item);
+					}
+					const auto count = static_cast<uint32_t>(items.size());
+					push(out, Tag::SET, count, Frame{0, 0, nullptr, nullptr, std::move(items), 0});
+				}
+			}, box.elem);
+		}
+
+		//! Offset of the current record in the output
+		size_t record = 0;
+		SwissTable<const void*, Seen> seen;
+		std::vector<Frame> stack;
+	};
+
+	namespace {
+		/**
+		 * Checks that a record is well formed, so that it can be viewed and
+		 * decoded without checking it again.
+		 **/
+		class Checker {
+		public:
+			explicit Checker(std::span<const std::byte> record) :
+				in{record}, open_sets{0} {}
+
+			void check() {
+				check_item();
+				while(!stack.empty()) {
+					Frame &frame = stack.back();
+					if(frame.remaining > 0) {
+						frame.remaining--;
+						check_item();
+						continue;
+					}
+					if(in.position() != frame.end) {
+						throw Malformed{};
+					}
+					if(Definition *def = definitions.find(frame.offset)) {
+						def->open = false;
+					}
+					if(frame.tag == Tag::SET) {
+						open_sets--;
+					}
+					stack.pop_back();
+				}
+				if(!in.done()) {
+					throw Malformed{};
+				}
+			}
+		private:
+			struct Definition {
+				Tag tag;
+				uint32_t count;
+				bool open;
+			};
+
+			struct Frame {
+				Tag tag;
+				uint32_t offset;
+				uint32_t remaining;
+				uint32_t end;
+			};
+
+			void define(uint32_t offset, bool shared, Tag tag, uint32_t count, bool open) {
+				if(shared) {
+					definitions.try_emplace(offset, Definition{tag, count, open});
+				}
+			}
+
+			//! Check a reference and return what it points to
+			const Definition &check_ref() {
+				const uint32_t target = in.u32();
+				const uint32_t index = in.u32();
+				const Definition *def = definitions.find(target);
+				if(!def) {
+					throw Malformed{};
+				}
+				if(def->tag == Tag::LIST ? index >= def->count : index != 0) {
+					throw Malformed{};
+				}
+				// A set would hash a container that isn't finished yet
+				if(def->open && open_sets > 0) {
+					throw Malformed{};
+				}
+				return *def;
+			}
+
+			void check_item() {
+				const uint32_t offset = in.position();
+				const auto [tag, shared] = split_tag(in.u8());
+				if(shared && !(tag == Tag::SYMBOL || tag == Tag::STRING || is_container(tag))) {
+					throw Malformed{};
+				}
+				switch(tag) {
+				case Tag::INT32:
+				case Tag::FLOAT32:
+					in.u32();
+					return;
+				case Tag::FLOAT64:
+				case Tag::INT64:
+				case Tag::UINT64:
+					in.u64();
+					return;
+				case Tag::TRUE:
+				case Tag::FALSE:
+				case Tag::EMPTY:
+					return;
+				case Tag::SYMBOL: {
+					const uint8_t has_package = in.u8();
+					if(has_package > 1) {
+						throw Malformed{};
+					} else if(has_package) {
+						in.str();
+					}
+					in.str();
+					define(offset, shared, tag, 0, false);
+					return;
+				}
+				case Tag::STRING:
+					in.str();
+					define(offset, shared, tag, 0, false);
+					return;
+				case Tag::LIST:
+				case Tag::VECTOR:
+				case Tag::SET: {
+					const uint32_t count = in.u32();
+					const uint32_t size = in.u32();
+					const uint32_t start = in.position();
+					in.skip(size);
+					const uint32_t end = in.position();
+					in.seek(start);
+					if(tag == Tag::LIST) {
+						// empty lists are written as Empty
+						if(count == 0) {
+							throw Malformed{};
+						}
+						// The tail was defined before this list, so tails can't form a loop
+						const auto [tail, tail_shared] = split_tag(in.u8());
+						if(tail_shared || (tail != Tag::EMPTY && tail != Tag::REF)) {
+							throw Malformed{};
+						} else if(tail == Tag::REF && check_ref().tag != Tag::LIST) {
+							throw Malformed{};
+						}
+					} else if(tag == Tag::SET) {
+						open_sets++;
+					}
+					define(offset, shared, tag, count, true);
+					stack.push_back(Frame{tag, offset, count, end});
+					return;
+				}
+				case Tag::REF:
+					check_ref();
+					return;
+				}
+				throw Malformed{};
+			}
+
+			Input in;
+			size_t open_sets;
+			SwissTable<uint32_t, Definition> definitions;
+			std::vector<Frame> stack;
+		};
+
+		//! The builtin types given to items, looked up once
+		struct Types {
+			explicit Types(VirtualMachine &vm) :
+				int_type{vm.get_builtin_type<int32_t>().get()},
+				float_type{vm.get_builtin_type<double>().get()},
+				int64_type{vm.get_builtin_type<int64_t>().get()},
+				uint64_type{vm.get_builtin_type<uint64_t>().get()},
+				float32_type{vm.get_builtin_type<float>().get()},
+				bool_type{vm.get_builtin_type<bool>().get()},
+				empty_type{vm.get_builtin_type<Empty>().get()},
+				symbol_type{vm.get_builtin_type<Symbol>().get()},
+				string_type{vm.get_builtin_type<StaticString>().get()},
+				list_type{vm.get_builtin_type<List>().get()},
+				vector_type{vm.get_builtin_type<Vector>().get()},
+				set_type{vm.get_builtin_type<HashSet>().get()} {}
+
+			Type *int_type;
+			Type *float_type;
+			Type *int64_type;
+			Type *uint64_type;
+			Type *float32_type;
+			Type *bool_type;
+			Type *empty_type;
+			Type *symbol_type;
+			Type *string_type;
+			Type *list_type;
+			Type *vector_type;
+			Type *set_type;
+		};
+
+		/**
+		 * Decodes checked records into the VM.
+		 *
+		 * Values are built as bare boxes: nothing is collected while decoding, and
+		 * the caller roots the result. Containers are allocated before their items
+		 * are read, so references back to them work while they are being filled.
+		 **/
+		class Decoder {
+		public:
+			explicit Decoder(VirtualMachine &vm) :
+				vm{vm}, types{vm}, in{{}} {}
+
+			//! Decode the value defined at offset, skipping index cells if it is a list
+			InternalBox decode(std::span<const std::byte> record, uint32_t offset, uint32_t index) {
+				in = Input(record, offset);
+				values.clear();
+				std::optional<InternalBox> item = read_item();
+				for(;;) {
+					while(item) {
+						if(stack.empty()) {
+							return cell_at(*item, index);
+						}
+						item = deliver(*item);
+					}
+					item = read_item();
+				}
+			}
+		private:
+			enum class Kind { LIST, VECTOR, SET, RETURN };
+
+			struct Frame {
+				Kind kind;
+				InternalBox value;
+				uint32_t remaining;
+				//! For lists, the next cell to fill and what follows the last one
+				List *cell;
+				List *tail;
+				bool tail_read;
+				//! For returns, where to carry on reading and the index to apply
+				uint32_t return_to;
+				uint32_t index;
+			};
+
+			InternalBox cell_at(const InternalBox &list, uint32_t index) const {
+				if(index == 0) {
+					return list;
+				}
+				List *cell = std::get<List*>(list.elem);
+				for(uint32_t i = 0; i < index; i++) {
+					cell = cell->next;
+				}
+				return InternalBox{types.list_type, cell};
+			}
+
+			void remember(uint32_t offset, bool shared, const InternalBox &value) {
+				if(shared) {
+					values.try_emplace(offset, value);
+				}
+			}
+
+			//! Skip over a definition that was already decoded
+			void skip(Tag tag) {
+				if(tag == Tag::SYMBOL) {
+					if(in.u8()) {
+						in.str();
+					}
+					in.str();
+				} else if(tag == Tag::STRING) {
+					in.str();
+				} else {
+					in.u32();
+					in.skip(in.u32());
+				}
+			}
+
+			Symbol *read_symbol() {
+				if(in.u8()) {
+					const std::string_view package_name = in.str();
+					std::optional<Package*> package = vm.find_package(std::string(package_name));
+					if(!package) {
+						throw Malformed{};
+					}
+					return (*package)->intern_symbol(std::string(in.str())).get();
+				}
+				return vm.mem_manager.allocate_obj<Symbol>(std::string(in.str())).get();
+			}
+
+			//! Read a single item. Returns std::nullopt if what it is made of follows.
+			std::optional<InternalBox> read_item() {
+				const uint32_t offset = in.position();
+				const auto [tag, shared] = split_tag(in.u8());
+				if(shared) {
+					if(const InternalBox *known = values.find(offset)) {
+						const InternalBox value = *known;
+						skip(tag);
+						return value;
+					}
+				}
+				switch(tag) {
+				case Tag::INT32:
+					return InternalBox{types.int_type, static_cast<int32_t>(in.u32())};
+				case Tag::FLOAT64:
+					return InternalBox{types.float_type, std::bit_cast<double>(in.u64())};
+				case Tag::INT64:
+					return InternalBox{types.int64_type, static_cast<int64_t>(in.u64())};
+				case Tag::UINT64:
+					return InternalBox{types.uint64_type, in.u64()};
+				case Tag::FLOAT32:
+					return InternalBox{types.float32_type, std::bit_cast<float>(in.u32())};
+				case Tag::TRUE:
+					return InternalBox{types.bool_type, true};
+				case Tag::FALSE:
+					return InternalBox{types.bool_type, false};
+				case Tag::EMPTY:
+					return InternalBox{types.empty_type, Empty{}};
+				case Tag::SYMBOL: {
+					const InternalBox value{types.symbol_type, read_symbol()};
+					remember(offset, shared, value);
+					return value;
+				}
+				case Tag::STRING: {
+					StaticString *string = vm.mem_manager.allocate_obj<StaticString>(std::string(in.str())).get();
+					const InternalBox value{types.string_type, string};
+					remember(offset, shared, value);
+					return value;
+				}
+				case Tag::LIST: {
+					const uint32_t count = in.u32();
+					in.u32();
+					const InternalBox placeholder{types.empty_type, Empty{}};
+					List *head = vm.mem_manager.allocate_list(count, placeholder).get();
+					const InternalBox value{types.list_type, head};
+					remember(offset, shared, value);
+					// The tail comes first, then one item for each cell
+					stack.push_back(Frame{Kind::LIST, value, count + 1, head, nullptr, false, 0, 0});
+					return std::nullopt;
+				}
+				case Tag::VECTOR: {
+					const uint32_t count = in.u32();
+					in.u32();
+					Vector *vector = vm.mem_manager.allocate_obj<Vector>(static_cast<int32_t>(count)).get();
+					return container(offset, shared, Kind::VECTOR, InternalBox{types.vector_type, vector}, count);
+				}
+				case Tag::SET: {
+					const uint32_t count = in.u32();
+					in.u32();
+					HashSet *set = vm.mem_manager.allocate_obj<HashSet>(count).get();
+					return container(offset, shared, Kind::SET, InternalBox{types.set_type, set}, count);
+				}
+				case Tag::REF: {
+					const uint32_t target = in.u32();
+					const uint32_t index = in.u32();
+					if(const InternalBox *known = values.find(target)) {
+						return cell_at(*known, index);
+					}
+					// Defined outside of what has been decoded so far: decode it, then come back
+					stack.push_back(Frame{Kind::RETURN, {}, 0, nullptr, nullptr, false, in.position(), index});
+					in.seek(target);
+					return std::nullopt;
+				}
+				}
+				throw Malformed{};
+			}
+
+			std::optional<InternalBox> container(uint32_t offset, bool shared, Kind kind,
+												 const InternalBox &value, uint32_t count) {
+				remember(offset, shared, value);
+				if(count == 0) {
+					return value;
+				}
+				stack.push_back(Frame{kind, value, count, nullptr, nullptr, false, 0, 0});
+				return std::nullopt;
+			}
+
+			//! Hand an item to the innermost frame. Returns the frame's value once it is complete.
+			std::optional<InternalBox> deliver(const InternalBox &item) {
+				Frame &frame = stack.back();
+				switch(frame.kind) {
+				case Kind::RETURN: {
+					in.seek(frame.return_to);
+					const InternalBox value = cell_at(item, frame.index);
+					stack.pop_back();
+					return value;
+				}
+				case Kind::LIST:
+					if(!frame.tail_read) {
+						frame.tail = std::holds_alternative<List*>(item.elem) ? std::get<List*>(item.elem) : nullptr;
+						frame.tail_read = true;
+					} else {
+						frame.cell->itm = item;
+						if(frame.remaining == 1) {
+							frame.cell->next = frame.tail;
+						} else {
+							frame.cell = frame.cell->next;
+						}
+					}
+					break;
+				case Kind::VECTOR:
+					std::get<Vector*>(frame.value.elem)->push_back(item);
+					break;
+				case Kind::SET:
+					std::get<HashSet*>(frame.value.elem)->insert(item);
+					break;
+				}
+				if(--frame.remaining > 0) {
+					return std::nullopt;
+				}
+				const InternalBox value = frame.value;
+				stack.pop_back();
+				return value;
+			}
+
+			VirtualMachine &vm;
+			Types types;
+			Input in;
+			SwissTable<uint32_t, InternalBox> values;
+			std::vector<Frame> stack;
+		};
+	}
+
+	namespace {
+		//! The offset just past the item at offset
+		uint32_t skip_item(std::span<const std::byte> record, uint32_t offset) {
+			Input in(record, offset);
+			const auto [tag, shared] = split_tag(in.u8());
+			switch(tag) {
+			case Tag::INT32:
+			case Tag::FLOAT32:
+				in.u32();
+				break;
+			case Tag::FLOAT64:
+			case Tag::INT64:
+			case Tag::UINT64:
+				in.u64();
+				break;
+			case Tag::SYMBOL:
+				if(in.u8()) {
+					in.str();
+				}
+				in.str();
+				break;
+			case Tag::STRING:
+				in.str();
+				break;
+			case Tag::LIST:
+			case Tag::VECTOR:
+			case Tag::SET:
+				in.u32();
+				in.skip(in.u32());
+				break;
+			case Tag::REF:
+				in.u32();
+				in.u32();
+				break;
+			default:
+				break;
+			}
+			return in.position();
+		}
+
+		Box to_box(const InternalBox &value, VirtualMachine &vm) {
+			vm_ptr<Type> type = vm.mem_manager.make_vm_ptr(value.type);
+			return std::visit([&vm, &type](auto &&arg) {
+				using T = std::decay_t<decltype(arg)>;
+				if constexpr (std::is_pointer<T>::value) {
+					return Box(vm.mem_manager.make_vm_ptr(arg), type);
+				} else {
+					return Box(arg, type);
+				}
+			}, value.elem);
+		}
+	}
+
+	Writer::Writer(std::ostream &out) :
+		out{out}, encoder{std::make_unique<Encoder>()} {
+		Output header(buffer);
+		write_header(header);
+		out.write(reinterpret_cast<const char*>(buffer.data()), static_cast<std::streamsize>(buffer.size()));
+	}
+
+	Writer::~Writer() = default;
+
+	void Writer::write(const Box &value) {
+		write(value.bare());
+	}
+
+	void Writer::write(const InternalBox &value) {
+		buffer.clear();
+		encoder->encode(value, buffer);
+		out.write(reinterpret_cast<const char*>(buffer.data()), static_cast<std::streamsize>(buffer.size()));
+	}
+
+	void Writer::finish() {
+		buffer.clear();
+		Output end(buffer);
+		end.u32(0);
+		out.write(reinterpret_cast<const char*>(buffer.data()), static_cast<std::streamsize>(buffer.size()));
+	}
+
+	std::vector<std::byte> write_values(std::span<const Box> values) {
+		std::vector<std::byte> bytes;
+		Output out(bytes);
+		write_header(out);
+		Encoder encoder;
+		for(const Box &value : values) {
+			encoder.encode(value.bare(), bytes);
+		}
+		out.u32(0);
+		return bytes;
+	}
+
+	std::optional<std::vector<Box>> read_values(std::span<const std::byte> data, VirtualMachine &vm) {
+		std::optional<Archive> archive = Archive::open(data);
+		if(!archive) {
+			return std::nullopt;
+		}
+		try {
+			Decoder decoder(vm);
+			std::vector<Box> values;
+			values.reserve(archive->size());
+			for(size_t i = 0; i < archive->size(); i++) {
+				values.push_back(to_box(decoder.decode(archive->records[i], 0, 0), vm));
+			}
+			return values;
+		} catch(const Malformed &) {
+			return std::nullopt;
+		}
+	}
+
+	View::View(std::span<const std::byte> record, uint32_t offset, uint32_t index) :
+		record{record}, offset{offset}, index{index} {
+		// References point straight at a definition, never at another reference
+		Input in(record, offset);
+		if(split_tag(in.u8()).first == Tag::REF) {
+			this->offset = in.u32();
+			this->index = in.u32();
+		}
+	}
+
+	View::Kind View::kind() const {
+		switch(split_tag(static_cast<uint8_t>(record[offset])).first) {
+		case Tag::INT32:
+			return Kind::INT32;
+		case Tag::FLOAT64:
+			return Kind::FLOAT64;
+		case Tag::TRUE:
+		case Tag::FALSE:
+			return Kind::BOOL;
+		case Tag::EMPTY:
+			return Kind::EMPTY;
+		case Tag::SYMBOL:
+			return Kind::SYMBOL;
+		case Tag::STRING:
+			return Kind::STRING;
+		case Tag::LIST:
+			return Kind::LIST;
+		case Tag::VECTOR:
+			return Kind::VECTOR;
+		case Tag::SET:
+			return Kind::SET;
+		case Tag::INT64:
+			return Kind::INT64;
+		case Tag::UINT64:
+			return Kind::UINT64;
+		case Tag::FLOAT32:
+			return Kind::FLOAT32;
+		case Tag::REF:
+			break;
+		}
+		salmon_abort("Views don't point at references");
+		return Kind::EMPTY;
+	}
+
+	int32_t View::int32() const {
+		salmon_check(kind() == Kind::INT32, "Value isn't an int32");
+		return static_cast<int32_t>(Input(record, offset + 1).u32());
+	}
+
+	double View::float64() const {
+		salmon_check(kind() == Kind::FLOAT64, "Value isn't a float64");
+		return std::bit_cast<double>(Input(record, offset + 1).u64());
+	}
+
+	int64_t View::int64() const {
+		salmon_check(kind() == Kind::INT64, "Value isn't an int64");
+		return static_cast<int64_t>(Input(record, offset + 1).u64());
+	}
+
+	uint64_t View::uint64() const {
+		salmon_check(kind() == Kind::UINT64, "Value isn't a uint64");
+		return Input(record, offset + 1).u64();
+	}
+
+	float View::float32() const {
+		salmon_check(kind() == Kind::FLOAT32, "Value isn't a float32");
+		return std::bit_cast<float>(Input(record, offset + 1).u32());
+	}
+
+	bool View::boolean() const {
+		salmon_check(kind() == Kind::BOOL, "Value isn't a boolean");
+		return split_tag(static_cast<uint8_t>(record[offset])).first == Tag::TRUE;
+	}
+
+	std::string_view View::string() const {
+		Input in(record, offset + 1);
+		if(kind() == Kind::SYMBOL) {
+			if(in.u8()) {
+				in.str();
+			}
+		} else {
+			salmon_check(kind() == Kind::STRING, "Value isn't a string or symbol");
+		}
+		return in.str();
+	}
+
+	std::optional<std::string_view> View::package() const {
+		salmon_check(kind() == Kind::SYMBOL, "Value isn't a symbol");
+		Input in(record, offset + 1);
+		if(in.u8()) {
+			return in.str();
+		}
+		return std::nullopt;
+	}
+
+	size_t View::size() const {
+		const Kind kind = this->kind();
+		salmon_check(kind == Kind::LIST || kind == Kind::VECTOR || kind == Kind::SET,
+					 "Value isn't a container");
+		if(kind != Kind::LIST) {
+			return Input(record, offset + 1).u32();
+		}
+		// Follow the tails, which always point back to an earlier list
+		size_t size = 0;
+		uint32_t list = offset;
+		uint32_t skipped = index;
+		for(;;) {
+			Input in(record, list + 1);
+			size += in.u32() - skipped;
+			in.u32();
+			if(split_tag(in.u8()).first == Tag::EMPTY) {
+				return size;
+			}
+			list = in.u32();
+			skipped = in.u32();
+		}
+	}
+
+	std::vector<View> View::items() const {
+		const Kind kind = this->kind();
+		salmon_check(kind == Kind::LIST || kind == Kind::VECTOR || kind == Kind::SET,
+					 "Value isn't a container");
+		std::vector<View> items;
+		uint32_t list = offset;
+		uint32_t skipped = index;
+		for(;;) {
+			Input in(record, list + 1);
+			const uint32_t count = in.u32();
+			in.u32();
+			uint32_t item = in.position();
+			std::optional<View> tail;
+			if(kind == Kind::LIST) {
+				tail = View(record, item, 0);
+				item = skip_item(record, item);
+			}
+			for(uint32_t i = 0; i < count; i++) {
+				if(i >= skipped) {
+					items.push_back(View(record, item, 0));
+				}
+				item = skip_item(record, item);
+			}
+			if(!tail || tail->kind() == Kind::EMPTY) {
+				return items;
+			}
+			list = tail->offset;
+			skipped = tail->index;
+		}
+	}
+
+	std::optional<Box> View::materialize(VirtualMachine &vm) const {
+		try {
+			Decoder decoder(vm);
+			return to_box(decoder.decode(record, offset, index), vm);
+		} catch(const Malformed &) {
+			return std::nullopt;
+		}
+	}
+
+	std::optional<Archive> Archive::open(std::span<const std::byte> data) {
+		try {
+			Input in(data);
+			for(char c : MAGIC) {
+				if(in.u8() != static_cast<uint8_t>(c)) {
+					return std::nullopt;
+				}
+			}
+			if(in.u16() != VERSION) {
+				return std::nullopt;
+			}
+			Archive archive;
+			for(uint32_t size = in.u32(); size != 0; size = in.u32()) {
+				const uint32_t start = in.position();
+				in.skip(size);
+				std::span<const std::byte> record = data.subspan(start, size);
+				Checker(record).check();
+				archive.records.push_back(record);
+			}
+			if(!in.done()) {
+				return std::nullopt;
+			}
+			return archive;
+		} catch(const Malformed &) {
+			return std::nullopt;
+		}
+	}
+
+	size_t Archive::size() const {
+		return records.size();
+	}
+
+	View Archive::operator[](size_t index) const {
+		return View(records.at(index), 0, 0);
+	}
+}
@@ -2,6 +2,7 @@
 #include <optional>
 #include <functional>
 #include <iostream>
+#include <atomic>
 
 #include <assert.h>
 
@@ -10,20 +11,32 @@
 
 namespace salmon::vm {
 
+	static uint32_t next_symbol_id() {
+		static std::atomic<uint32_t> counter = 0;
+		return Symbol::UNINDEXED | counter.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	Symbol::Symbol(const std::string &name, Package* package, uint32_t id)
+		: name{name}, package{package}, id{id} {}
+
 	Symbol::Symbol(const std::string &name, Package* package)
-		: name{name}, package{package} {}
+		: name{name}, package{package}, id{next_symbol_id()} {}
 
 	Symbol::Symbol(const std::string &&name, Package* package)
-		: name(name), package{package} {}
+		: name(name), package{package}, id{next_symbol_id()} {}
 
 	Symbol::Symbol(const std::string &name) :
-		name{name}, package{nullptr} {}
+		name{name}, package{nullptr}, id{next_symbol_id()} {}
 
 	Symbol::Symbol(const std::string &&name) :
-		name(name), package{nullptr} {}
+		name(name), package{nullptr}, id{next_symbol_id()} {}
 
 	Symbol::~Symbol() { }
 
+	bool Symbol::indexed() const {
+		return !(id & UNINDEXED);
+	}
+
 	void Symbol::print_debug_info() const {
 		std::cerr << this << " " << *this << std::endl;
 	}
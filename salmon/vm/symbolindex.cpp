@@ -0,0 +1,32 @@
+#include <vm/symbolindex.hpp>
+#include <vm/symbol.hpp>
+#include <util/assert.hpp>
+
+namespace salmon::vm {
+
+	uint32_t SymbolIndex::next_id() const {
+		salmon_ensure(symbols.size() < Symbol::UNINDEXED, "Ran out of symbol ids");
+		return static_cast<uint32_t>(symbols.size());
+	}
+
+	void SymbolIndex::add(Symbol *symbol) {
+		salmon_check(symbol->id == symbols.size(), "Symbol was not given the next id");
+		symbols.push_back(symbol);
+	}
+
+	void SymbolIndex::remove(const Symbol &symbol) {
+		salmon_check(symbol.indexed() && symbol.id < symbols.size(), "Symbol is not in the index");
+		symbols[symbol.id] = nullptr;
+	}
+
+	Symbol *SymbolIndex::operator[](uint32_t id) const {
+		if(id < symbols.size()) {
+			return symbols[id];
+		}
+		return nullptr;
+	}
+
+	size_t SymbolIndex::size() const {
+		return symbols.size();
+	}
+}
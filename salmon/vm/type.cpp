@@ -23,29 +23,28 @@ namespace salmon::vm {
 
 	bool
 	FunctionType::match(const std::vector<vm_ptr<Type>> &type_list) const {
-		const std::vector<vm_ptr<Type>> ret_list(type_list.begin(),
-							 type_list.begin() + arg_spec.size());
-		const std::vector<vm_ptr<Type>> arg_list(type_list.begin() + arg_spec.size(),
-							 type_list.end());
-		auto arg_opt = arg_spec.match_symbols(arg_list);
-		if(!arg_opt) {
+		// The list holds the return types followed by the argument types
+		if(type_list.size() != ret_spec.size() + arg_spec.size()) {
 			return false;
 		}
-		auto arg_matches = *arg_opt;
-		auto ret_opt = ret_spec.match_symbols(ret_list);
-		if(!ret_opt) {
+		const std::span<const vm_ptr<Type>> ret_list(type_list.data(), ret_spec.size());
+		const std::span<const vm_ptr<Type>> arg_list(type_list.data() + ret_spec.size(), arg_spec.size());
+		if(!arg_spec.matches(arg_list) || !ret_spec.matches(ret_list)) {
 			return false;
 		}
-		auto ret_matches = *ret_opt;
 		// The ret unspecified types should be a subset of the argument types:
-		return std::all_of(ret_matches.begin(), ret_matches.end(),
-				   [&arg_matches](const auto &pair) {
-					   auto symb = std::get<0>(pair);
-					   const auto iter = arg_matches.find(symb);
-					   if(iter != arg_matches.end()) {
-						   return *iter == pair;
-					   } else return false;
-				   });
+		for(size_t i = 0; i < ret_spec.parameter_count(); i++) {
+			const Symbol *symb = ret_spec.parameter(i);
+			size_t j = 0;
+			while(j < arg_spec.parameter_count() && arg_spec.parameter(j) != symb) {
+				j++;
+			}
+			if(j == arg_spec.parameter_count()
+			   || ret_list[ret_spec.parameter_position(i)] != arg_list[arg_spec.parameter_position(j)]) {
+				return false;
+			}
+		}
+		return true;
 	}
 
 	bool
@@ -113,6 +112,14 @@ namespace salmon::vm {
 		return arg_spec.types();
 	}
 
+	const TypeSpecification &FunctionType::args() const {
+		return arg_spec;
+	}
+
+	const TypeSpecification &FunctionType::returns() const {
+		return ret_spec;
+	}
+
 	std::ostream &operator<<(std::ostream &out, const FunctionType &fn) {
 		std::ignore = fn;
 		out << "<TYPE: (fn ";
@@ -228,30 +235,24 @@ namespace salmon::vm {
 	TypeTable::TypeTable(MemoryManager &mem_manager) : mem_manager{mem_manager} {}
 
 	std::optional<TypePtr> TypeTable::get_named(const vm_ptr<Symbol> &name) const {
-		auto place = named_types.find(name);
-		if(place == named_types.end()) {
-			return std::nullopt;
+		if(const TypePtr *type = named_types.find(*name)) {
+			return *type;
 		} else {
-			return std::get<TypePtr>(*place);
+			return std::nullopt;
 		}
 	}
 
 	bool TypeTable::make_alias(const vm_ptr<Symbol> &alias, TypePtr &type) {
-		auto place = named_types.find(alias);
-		if(place != named_types.end()) {
-			return false;
-		}
-		named_types.insert({alias, type});
-		return true;
+		return named_types.try_emplace(alias, type).second;
 	}
 
 	TypePtr
 	TypeTable::make_primitive(const vm_ptr<Symbol> &name, const std::string &doc, std::size_t size) {
-		salmon_check(!named_types.contains(name),
+		salmon_check(!named_types.contains(*name),
 			     "We shouldn't be overwriting primitive types with `make_primitive`");
 		PrimitiveType tmp(name, doc,size);
 		auto type_ptr = mem_manager.allocate_obj<Type>(std::move(tmp));
-		named_types.insert({name, type_ptr});
+		named_types.try_emplace(name, type_ptr);
 		return type_ptr;
 	}
 
@@ -266,4 +267,43 @@ namespace salmon::vm {
 		}
 		return *place;
 	}
+
+	size_t TypeTable::TypePairHash::operator()(const TypePair &pair) const {
+		return std::hash<const Type*>{}(pair.first) * 31 + std::hash<const Type*>{}(pair.second);
+	}
+
+	template<typename Check>
+	bool TypeTable::remember(MatchTable &table, const Type *first, const Type *second, Check check) {
+		const TypePair key{first, second};
+		if(const MatchResult *found = table.find(key)) {
+			return found->result;
+		}
+		const bool result = check();
+		table.try_emplace(key, MatchResult{mem_manager.make_vm_ptr(const_cast<Type*>(first)),
+										   mem_manager.make_vm_ptr(const_cast<Type*>(second)),
+										   result});
+		return result;
+	}
+
+	bool TypeTable::fn_match(const Type *general, const Type *specific) {
+		if(general == specific) {
+			return true;
+		}
+		return remember(fn_matches, general, specific, [general, specific]() {
+			return std::get<FunctionType>(general->type).match(std::get<FunctionType>(specific->type));
+		});
+	}
+
+	bool TypeTable::equivalent(const Type *first, const Type *second) {
+		if(first == second) {
+			return true;
+		}
+		// Equivalence goes both ways, so keep one entry per pair
+		if(second < first) {
+			std::swap(first, second);
+		}
+		return remember(equivalences, first, second, [first, second]() {
+			return first->equivalent_to(*second);
+		});
+	}
 }
@@ -1,3 +1,6 @@
+#include <algorithm>
+#include <cstring>
+#include <functional>
 #include <ostream>
 
 #include <vm/typespec.hpp>
@@ -62,14 +65,7 @@ namespace salmon::vm {
 
 	void SpecBuilder::add_parameter(const vm_ptr<Symbol> &param, bool constant,
 					bool is_static) {
-		auto place = parameters.lower_bound(param);
-		if( place == parameters.end() || *(*place).first != *param ) {
-			std::vector<size_t> vec = { num_elems };
-                        parameters.emplace_hint(place, param, std::move(vec));
-                } else {
-			(*place).second.push_back(num_elems);
-                }
-		num_elems += 1;
+		elements.emplace_back(param);
 		properties.emplace_back(constant, is_static);
         }
 
@@ -78,100 +74,165 @@ namespace salmon::vm {
 	}
 
 	void SpecBuilder::add_type(const vm_ptr<Type> &type, bool constant, bool is_static) {
-		concrete_types.emplace_back(type, num_elems);
-		num_elems += 1;
+		elements.emplace_back(type);
 		properties.emplace_back(constant, is_static);
-		salmon_check(properties.size() == num_elems, "didn't increment num_elems");
 	}
 
 	TypeSpecification SpecBuilder::build() {
-		TypeSpecification spec(parameters, concrete_types, properties);
+		size_t num_params = 0;
+		for(size_t i = 0; i < elements.size(); i++) {
+			if(const vm_ptr<Symbol> *param = std::get_if<vm_ptr<Symbol>>(&elements[i])) {
+				const bool seen = std::any_of(elements.begin(), elements.begin() + static_cast<std::ptrdiff_t>(i),
+											  [param](const auto &elem) {
+												  const vm_ptr<Symbol> *other = std::get_if<vm_ptr<Symbol>>(&elem);
+												  return other && *other == *param;
+											  });
+				num_params += !seen;
+			}
+		}
+		TypeSpecification spec(elements.size(), num_params);
+		size_t next_param = 0;
+		for(size_t i = 0; i < elements.size(); i++) {
+			if(const vm_ptr<Symbol> *param = std::get_if<vm_ptr<Symbol>>(&elements[i])) {
+				Symbol **start = spec.symbols();
+				Symbol **found = std::find(start, start + next_param, param->get());
+				const size_t index = static_cast<size_t>(found - start);
+				if(index == next_param) {
+					start[index] = param->get();
+					spec.firsts()[index] = static_cast<uint32_t>(i);
+					next_param++;
+				}
+				spec.slots()[i] = TypeSpecification::param_slot(index);
+			} else {
+				spec.slots()[i] = TypeSpecification::type_slot(std::get<vm_ptr<Type>>(elements[i]).get());
+			}
+			spec.properties()[i] = properties[i];
+		}
+		spec.finish();
 		return spec;
 	}
 
-	static std::map<Symbol *, std::vector<size_t>>
-	copy_args(const std::map<vm_ptr<Symbol>, std::vector<size_t>> &args) {
-		std::map<Symbol*, std::vector<size_t>> ret;
-                for (const auto &val : args) {
-			ret.emplace(val.first.get(), val.second);
-                }
-		return ret;
-        }
+	static_assert(sizeof(VariableProperties) == 1, "Properties are stored one byte each");
 
-        static std::vector<std::pair<Type*, size_t>>
-        copy_args(const std::vector<std::pair<vm_ptr<Type>, size_t>> &args) {
-		std::vector<std::pair<Type*, size_t>> ret;
-		ret.reserve(args.size());
-                for (const auto &val : args) {
-			ret.push_back({val.first.get(), val.second});
-                }
-		return ret;
-        }
+	TypeSpecification::TypeSpecification(const size_t size, const size_t num_params) :
+		length{static_cast<uint32_t>(size)},
+		num_params{static_cast<uint32_t>(num_params)},
+		shape_hash{0},
+		is_concrete{false},
+		block{nullptr} {
+		allocate();
+	}
+
+	TypeSpecification::TypeSpecification(const TypeSpecification &other) :
+		length{other.length},
+		num_params{other.num_params},
+		shape_hash{other.shape_hash},
+		is_concrete{other.is_concrete},
+		block{nullptr} {
+		allocate();
+		std::memcpy(block, other.block, block_size());
+	}
+
+	TypeSpecification::TypeSpecification(TypeSpecification &&other) noexcept :
+		length{other.length},
+		num_params{other.num_params},
+		shape_hash{other.shape_hash},
+		is_concrete{other.is_concrete},
+		block{other.block} {
+		if(other.block == other.inline_block) {
+			block = inline_block;
+			std::memcpy(block, other.block, block_size());
+		} else {
+			// Leave other with an empty inline block so its destructor has nothing to free
+			other.block = other.inline_block;
+			other.length = 0;
+			other.num_params = 0;
+		}
+	}
+
+	TypeSpecification::~TypeSpecification() {
+		if(block != inline_block) {
+			delete[] block;
+		}
+	}
+
+	void TypeSpecification::allocate() {
+		const size_t bytes = block_size();
+		block = bytes <= INLINE_BYTES ? inline_block : new std::byte[bytes];
+	}
+
+	void TypeSpecification::finish() {
+		size_t hash = length;
+		bool all_types = true;
+		for(size_t i = 0; i < length; i++) {
+			all_types = all_types && !is_param(slots()[i]);
+			hash = hash * 31 + std::hash<Slot>{}(slots()[i]);
+			hash = hash * 31 + properties()[i].properties;
+		}
+		shape_hash = hash;
+		is_concrete = all_types;
+	}
+
+	size_t TypeSpecification::block_size() const {
+		return length * sizeof(Slot) + num_params * (sizeof(Symbol*) + sizeof(uint32_t))
+			+ length * sizeof(VariableProperties);
+	}
+
+	TypeSpecification::Slot *TypeSpecification::slots() const {
+		return reinterpret_cast<Slot*>(block);
+	}
+
+	Symbol **TypeSpecification::symbols() const {
+		return reinterpret_cast<Symbol**>(block + length * sizeof(Slot));
+	}
+
+	uint32_t *TypeSpecification::firsts() const {
+		return reinterpret_cast<uint32_t*>(block + length * sizeof(Slot) + num_params * sizeof(Symbol*));
+	}
+
+	VariableProperties *TypeSpecification::properties() const {
+		return reinterpret_cast<VariableProperties*>(block + length * sizeof(Slot)
+													 + num_params * (sizeof(Symbol*) + sizeof(uint32_t)));
+	}
+
+	TypeSpecification::Slot TypeSpecification::type_slot(const Type *type) {
+		static_assert(alignof(Type) > 1, "The low bit of a Type* marks parameters");
+		return reinterpret_cast<Slot>(type);
+	}
+
+	TypeSpecification::Slot TypeSpecification::param_slot(const size_t index) {
+		return (static_cast<Slot>(index) << 1) | 1;
+	}
 
-	TypeSpecification::TypeSpecification(
-		const std::map<vm_ptr<Symbol>, std::vector<size_t>> &params,
-		const std::vector<std::pair<vm_ptr<Type>, size_t>> &concrete_types,
-		const std::vector<VariableProperties> &properties) :
-		parameters{copy_args(params)},
-		concrete_types{copy_args(concrete_types)},
-		properties{properties},
-		is_concrete(concrete_types.size() == properties.size()) {
-
-                #ifndef NDEBUG
-		size_t sum = 0;
-                for (const auto &val : params) {
-			sum += val.second.size();
-                }
-		sum += concrete_types.size();
-		salmon_check(sum == properties.size(), "Property size mismatch");
-		#endif
-	}
-
-	TypeSpecification::TypeSpecification(std::map<Symbol*, std::vector<size_t>> &&params,
-								std::vector<std::pair<Type*, size_t>> &&concrete_types,
-								std::vector<VariableProperties> &&properties) :
-		parameters(params),
-		concrete_types(concrete_types),
-		properties(properties),
-		is_concrete(this->concrete_types.size() == this->properties.size()) {
+	bool TypeSpecification::is_param(const Slot slot) {
+		return slot & 1;
+	}
+
+	size_t TypeSpecification::param_index(const Slot slot) {
+		return static_cast<size_t>(slot >> 1);
+	}
+
+	static bool same_type(const Type *first, const Type *second) {
+		return first == second || *first == *second;
 	}
 
 	bool TypeSpecification::matches(const TypeSpecification &other) const {
 		if(this->size() != other.size()) {
 			return false;
 		}
-		std::vector<Type*> other_concrete_types(other.size(),nullptr);
-		for(const auto &[type, index] : other.concrete_types) {
-			other_concrete_types[index] = type;
-		}
-		// if other doesn't have concrete types where this one does, the two don't match.
-		for(const auto &[type, index] : concrete_types) {
-			if(other_concrete_types[index] == nullptr || type != other_concrete_types[index]) {
+		const Slot *mine = slots();
+		const Slot *theirs = other.slots();
+		for(size_t i = 0; i < length; i++) {
+			if(!is_param(mine[i])) {
+				// if other doesn't have concrete types where this one does, the two don't match.
+				if(mine[i] != theirs[i]) {
+					return false;
+				}
+			} else if(theirs[i] != theirs[firsts()[param_index(mine[i])]]) {
+				// Everywhere a parameter appears, other needs the same type or parameter
 				return false;
-			}
-		}
-		for(const auto &[type, indices] : parameters) {
-			Type *val = other_concrete_types[indices[0]];
-			bool all_same = std::all_of(++indices.begin(), indices.end(),
-										[val,&other_concrete_types](size_t index) {
-											return val == other_concrete_types[index];
-										});
-			if(all_same) {
-				if(val == nullptr) {
-					// check to see if any of other's parameter lists match the current
-					// parameter list:
-					bool found = false;
-					for(const auto &[symbol, other_indicies] : other.parameters) {
-						if(std::equal(indices.begin(), indices.end(), other_indicies.begin())) {
-							found = true;
-							break;
-						}
-					}
-					if(!found) {
-						return false;
-					}
-				} else continue;
-			} else {
+			} else if(is_param(theirs[i]) && mine[i] != mine[other.firsts()[param_index(theirs[i])]]) {
+				// and other's parameters can't appear anywhere this one doesn't
 				return false;
 			}
 		}
@@ -179,101 +240,113 @@ namespace salmon::vm {
 		return true;
 	}
 
-	bool TypeSpecification::matches(const std::vector<vm_ptr<Type>> &type_list) const {
+	bool TypeSpecification::matches(std::span<const vm_ptr<Type>> type_list) const {
 		if(this->size() != type_list.size()) {
 			return false;
 		}
-		// Check to make sure the unspecified types match where they should:
-		for(const auto &[symb, indicies] : parameters) {
-			const vm_ptr<Type> &type = type_list[indicies[0]];
-
-			for(size_t index = 1; index < indicies.size(); index++) {
-				auto cur_type = type_list[indicies[index]];
-				if(*type != *cur_type) {
-					return false;
-				}
-			}
-		}
-		// Now check that the concrete types match the given types:
-		for(const auto &[type, index] : concrete_types) {
-			if(*type != *type_list[index]) {
+		const Slot *mine = slots();
+		for(size_t i = 0; i < length; i++) {
+			const Type *expected = is_param(mine[i])
+				? type_list[firsts()[param_index(mine[i])]].get()
+				: reinterpret_cast<const Type*>(mine[i]);
+			if(!same_type(expected, type_list[i].get())) {
 				return false;
 			}
 		}
 		return true;
 	}
 
-	std::optional<std::map<vm_ptr<Symbol>, vm_ptr<Type>>>
-        TypeSpecification::match_symbols(const std::vector<vm_ptr<Type>> &type_list) const {
-		if(type_list.size() != this->size()) {
+	std::optional<std::unordered_map<vm_ptr<Symbol>,vm_ptr<Type>,hashId<Symbol>>>
+        TypeSpecification::match_symbols(std::span<const vm_ptr<Type>> type_list) const {
+		if(!matches(type_list)) {
 			return std::nullopt;
 		}
-		std::map<vm_ptr<Symbol>,vm_ptr<Type>> table;
-                for (const auto &[symb, indicies] : parameters) {
-			vm_ptr<Type> type = type_list[indicies[0]];
-			for(size_t index = 1; index < indicies.size(); index++) {
-				auto cur_type = type_list[indicies[index]];
-				if(*type != *cur_type) {
-					return std::nullopt;
-				}
-			}
-			vm_ptr<Symbol> ptr = type.from(symb);
-			table.insert(std::make_pair(ptr, type));
-                }
-
-		for(const auto &[type, index] : concrete_types) {
-			if(*type != *type_list[index]) {
-				return std::nullopt;
-			}
+		std::unordered_map<vm_ptr<Symbol>,vm_ptr<Type>,hashId<Symbol>> table;
+		table.reserve(num_params);
+		for(size_t i = 0; i < num_params; i++) {
+			const vm_ptr<Type> &type = type_list[firsts()[i]];
+			table.emplace(type.from(symbols()[i]), type);
 		}
-
-                return std::make_optional(table);
+                return std::make_optional(std::move(table));
 	}
 
 	size_t TypeSpecification::size() const {
-		// Arbitrary container: they all should be the same size.
-		return properties.size();
+		return length;
+	}
+
+	size_t TypeSpecification::parameter_count() const {
+		return num_params;
+	}
+
+	Symbol *TypeSpecification::parameter(const size_t index) const {
+		return symbols()[index];
+	}
+
+	size_t TypeSpecification::parameter_position(const size_t index) const {
+		return firsts()[index];
+	}
+
+	Type *TypeSpecification::type_at(const size_t position) const {
+		const Slot slot = slots()[position];
+		return is_param(slot) ? nullptr : reinterpret_cast<Type*>(slot);
+	}
+
+	size_t TypeSpecification::parameter_index(const size_t position) const {
+		return param_index(slots()[position]);
+	}
+
+	size_t TypeSpecification::hash() const {
+		return shape_hash;
 	}
 
 	const std::vector<Type*> TypeSpecification::types() const {
 		salmon_check(concrete(), "Type spec must be concrete to call arg_types() on it");
-		std::vector<Type*> ret(concrete_types.size(), nullptr);
-		for(const auto &[type, index] : concrete_types) {
-			ret[index] = type;
+		std::vector<Type*> ret;
+		ret.reserve(length);
+		for(size_t i = 0; i < length; i++) {
+			ret.push_back(reinterpret_cast<Type*>(slots()[i]));
 		}
 		return ret;
 	}
 
 	bool TypeSpecification::equivalentTo(const TypeSpecification &other) const {
-		// use equivalent() method for non-concrete types when we get there:
-		if (std::equal(concrete_types.begin(), concrete_types.end(),
-			       other.concrete_types.begin())
-		    && properties == other.properties) {
-			for (const auto &val : parameters) {
-				bool found = false;
-				for (const auto &v_other : other.parameters) {
-					if (val.second == v_other.second) {
-						found = true;
-						break;
-					}
-				}
-				if (!found) {
-					return false;
-				}
+		// Parameters are numbered by where they first appear, so equivalent
+		// specifications have the same slots.
+		return length == other.length
+			&& num_params == other.num_params
+			&& shape_hash == other.shape_hash
+			&& std::equal(slots(), slots() + length, other.slots())
+			&& std::equal(properties(), properties() + length, other.properties());
+        }
+
+	int TypeSpecification::compare(const TypeSpecification &other) const {
+		if(length != other.length) {
+			return length < other.length ? -1 : 1;
+		}
+		for(size_t i = 0; i < length; i++) {
+			if(slots()[i] != other.slots()[i]) {
+				return slots()[i] < other.slots()[i] ? -1 : 1;
 			}
-			return true;
-		} else {
-			return false;
 		}
-        }
+		for(size_t i = 0; i < length; i++) {
+			if(properties()[i] != other.properties()[i]) {
+				return properties()[i] < other.properties()[i] ? -1 : 1;
+			}
+		}
+		// The same slots means the same number of parameters
+		for(size_t i = 0; i < num_params; i++) {
+			if(symbols()[i]->id != other.symbols()[i]->id) {
+				return symbols()[i]->id < other.symbols()[i]->id ? -1 : 1;
+			}
+		}
+		return 0;
+	}
 
 	bool TypeSpecification::operator==(const TypeSpecification &other) const {
-		// There should only be one instance of each of these instances,
-		// so comparing vm_ptrs is okay.
-		return std::equal(concrete_types.begin(), concrete_types.end(),
-				  other.concrete_types.begin())
-			&& parameters == other.parameters
-			&& properties == other.properties;
+		// There should only be one instance of each type and symbol,
+		// so comparing pointers is okay.
+		return equivalentTo(other)
+			&& std::equal(symbols(), symbols() + num_params, other.symbols());
 	}
 
 	bool TypeSpecification::operator!=(const TypeSpecification &other) const {
@@ -281,47 +354,29 @@ namespace salmon::vm {
 	}
 
 	bool TypeSpecification::operator>(const TypeSpecification &other) const {
-		return parameters > other.parameters &&
-			concrete_types > other.concrete_types &&
-			properties > other.properties;
+		return compare(other) > 0;
 	}
 
 	bool TypeSpecification::operator<(const TypeSpecification &other) const {
-		return (parameters < other.parameters)
-			&& concrete_types < other.concrete_types
-			&& (properties < other.properties);
+		return compare(other) < 0;
 	}
 
-	using ItemMask = std::variant<Symbol*, Type*>;
-
 	std::ostream &operator<<(std::ostream &out, const TypeSpecification& spec) {
-		if(spec.size() > 0) {
-			std::vector<ItemMask> to_print;
-			to_print.reserve(spec.size());
-			for (const auto &[symb, array] : spec.parameters) {
-				for (const size_t index : array) {
-					to_print[index] = symb;
-				}
-			}
-			for (const auto &[type, index] : spec.concrete_types) {
-				to_print[index] = type;
+		for (size_t i = 0; i < spec.size(); ++i) {
+			if(i > 0) {
+				out << ' ';
 			}
-
 			out << '(';
-			spec.properties[0].pretty_print(out);
+			spec.properties()[i].pretty_print(out);
 			out << ' ';
-			std::visit([&out](const auto &arg) { out << *arg; },
-				   to_print[0]);
-			out << ')';
-			for (size_t i = 1; i < spec.size(); ++i) {
-				out << " (";
-				spec.properties[i].pretty_print(out);
-				out << ' ';
-				std::visit([&out](const auto &arg) { out << *arg; },
-					   to_print[i]);
-				out << ')';
+			const TypeSpecification::Slot slot = spec.slots()[i];
+			if(TypeSpecification::is_param(slot)) {
+				out << *spec.symbols()[TypeSpecification::param_index(slot)];
+			} else {
+				out << *reinterpret_cast<const Type*>(slot);
 			}
-                }
+			out << ')';
+		}
                 return out;
         }
 
@@ -330,51 +385,57 @@ namespace salmon::vm {
 	}
 
 	void TypeSpecification::get_roots(const std::function<void(AllocatedItem*)>& inserter) const {
-		for (const auto &val : parameters) {
-			inserter(val.first);
+		for (size_t i = 0; i < num_params; i++) {
+			inserter(symbols()[i]);
 		}
 		// If types appear more than once, they will added twice, but that is
 		// (probably) okay.
-		for (const auto &val : concrete_types) {
-			inserter(val.first);
+		for (size_t i = 0; i < length; i++) {
+			if(!is_param(slots()[i])) {
+				inserter(reinterpret_cast<Type*>(slots()[i]));
+			}
 		}
 	}
 
 	TypeSpecification TypeSpecification::combine(const TypeSpecification &first,
 												 const TypeSpecification &second) {
-		const size_t offset = first.size();
-		std::map<Symbol*, std::vector<size_t>> new_params(first.parameters);
-		for(auto &[symb, indicies] : second.parameters) {
-			auto place = new_params.find(symb);
-			if(place == new_params.end()) {
-				std::vector<size_t> new_indicies;
-				new_indicies.reserve(indicies.size());
-				for(int index : indicies) {
-					new_indicies.push_back(index + offset);
-				}
-				new_params.emplace(symb, new_indicies);
-			} else {
-				for(int index : indicies) {
-					place->second.push_back(index + offset);
-				}
+		Symbol **first_symbols = first.symbols();
+		Symbol **first_end = first_symbols + first.num_params;
+		const size_t new_params = static_cast<size_t>(
+			std::count_if(second.symbols(), second.symbols() + second.num_params,
+						  [first_symbols, first_end](Symbol *symb) {
+							  return std::find(first_symbols, first_end, symb) == first_end;
+						  }));
+		TypeSpecification spec(first.length + second.length, first.num_params + new_params);
+		std::copy(first.slots(), first.slots() + first.length, spec.slots());
+		std::copy(first_symbols, first_end, spec.symbols());
+		std::copy(first.firsts(), first.firsts() + first.num_params, spec.firsts());
+		std::copy(first.properties(), first.properties() + first.length, spec.properties());
+		std::copy(second.properties(), second.properties() + second.length,
+				  spec.properties() + first.length);
+
+		// The parameters of second are numbered after first's, except for the
+		// ones first already has. They still appear in order, so each new one
+		// either has been seen already or gets the next number.
+		size_t next_param = first.num_params;
+		for(size_t i = 0; i < second.length; i++) {
+			const Slot slot = second.slots()[i];
+			const size_t position = first.length + i;
+			if(!is_param(slot)) {
+				spec.slots()[position] = slot;
+				continue;
 			}
+			Symbol *symb = second.symbols()[param_index(slot)];
+			Symbol **start = spec.symbols();
+			const size_t index = static_cast<size_t>(std::find(start, start + next_param, symb) - start);
+			if(index == next_param) {
+				start[index] = symb;
+				spec.firsts()[index] = static_cast<uint32_t>(position);
+				next_param++;
+			}
+			spec.slots()[position] = param_slot(index);
 		}
-		std::vector<std::pair<Type*,size_t>> new_concrete_types(first.concrete_types);
-		new_concrete_types.reserve(new_concrete_types.size() + second.concrete_types.size());
-		for(const auto &[type, index] : second.concrete_types) {
-			new_concrete_types.push_back(std::make_pair(type, index + offset));
-		}
-		std::vector<VariableProperties> new_properties;
-		new_properties.reserve(first.properties.size() + second.properties.size());
-		for(const auto &item : first.properties) {
-			new_properties.push_back(item);
-		}
-		for(const auto &item : second.properties) {
-			new_properties.push_back(item);
-		}
-		TypeSpecification spec(std::move(new_params),
-							   std::move(new_concrete_types),
-							   std::move(new_properties));
+		spec.finish();
 		return spec;
 	}
 }
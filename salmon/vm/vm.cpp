@@ -1,9 +1,11 @@
 #include <span>
+#include <iostream>
 
 #include <util/assert.hpp>
 
 #include <vm/vm.hpp>
 #include <vm/string.hpp>
+#include <vm/hashset.hpp>
 #include <vm/builtinfunction.hpp>
 #include <vm/vmstdlib.hpp>
 
@@ -13,6 +15,7 @@ namespace salmon::vm {
 	static void add_interface_fn(VirtualMachine *vm,
 							 const vm_ptr<Symbol> &name,
 							 const std::string &doc,
+							 const bool pure,
 							 const std::vector<vm_ptr<Symbol>> &lambda_list,
 							 vm_ptr<Type> interface_type,
 							 std::span<const std::pair<vm_ptr<Type>,typename BuiltinFunction<Args...>::FunctionType>> impls) {
@@ -21,6 +24,7 @@ namespace salmon::vm {
 		vm_ptr<InterfaceFunction> interface_fn =
 			vm->mem_manager.allocate_obj<InterfaceFunction>(interface_type, lambda_list,
 															doc, std::nullopt);
+		interface_fn->pure(pure);
 		salmon_ensure(fn_table.new_interface(name, interface_fn),
 					  "Interface function not added");
 		Package &base_package = vm->base_package();
@@ -31,8 +35,12 @@ namespace salmon::vm {
 									 .allocate_obj<BuiltinFunction<Args...>>(fn,
 																			 type,
 																			 lambda_list));
+			vm_fn->pure(pure);
 			salmon_ensure(vm->fn_table.add_function(name, vm_fn), "Function not added");
 		}
+		if(vm->config().seal_builtins) {
+			interface_fn->seal();
+		}
 	}
 
 	static void init_print_fns(VirtualMachine *vm) {
@@ -47,15 +55,19 @@ namespace salmon::vm {
 		vm_ptr<Type> p_interface_type = type_table.get_fn_type(interfaceBuilder.build(),
 															   interfaceBuilder.build());
 
-		std::array<std::pair<vm_ptr<Type>,BuiltinFunction<InternalBox>::FunctionType>,8> to_add = {
-			std::make_pair(vm->get_builtin_type<Symbol>(),       print_pointer_primitive<Symbol>),
-			std::make_pair(vm->get_builtin_type<StaticString>(), print_pointer_primitive<StaticString>),
-			std::make_pair(vm->get_builtin_type<double>(),       print_primitive<double>),
-			std::make_pair(vm->get_builtin_type<int32_t>(),      print_primitive<int32_t>),
-			std::make_pair(vm->get_builtin_type<bool>(),         print_primitive<bool>),
-			std::make_pair(vm->get_builtin_type<Empty>(),        print_primitive<Empty>),
-            std::make_pair(vm->get_builtin_type<Vector>(),        print_array),
-			std::make_pair(vm->get_builtin_type<List>(),         print_list),
+		std::array<std::pair<vm_ptr<Type>,BuiltinFunction<InternalBox>::FunctionType>,12> to_add = {
+			std::make_pair(vm->get_builtin_type<Symbol>(),       print_builtin<Symbol>),
+			std::make_pair(vm->get_builtin_type<StaticString>(), print_builtin<StaticString>),
+			std::make_pair(vm->get_builtin_type<double>(),       print_builtin<double>),
+			std::make_pair(vm->get_builtin_type<int32_t>(),      print_builtin<int32_t>),
+			std::make_pair(vm->get_builtin_type<int64_t>(),      print_builtin<int64_t>),
+			std::make_pair(vm->get_builtin_type<uint64_t>(),     print_builtin<uint64_t>),
+			std::make_pair(vm->get_builtin_type<float>(),        print_builtin<float>),
+			std::make_pair(vm->get_builtin_type<bool>(),         print_builtin<bool>),
+			std::make_pair(vm->get_builtin_type<Empty>(),        print_builtin<Empty>),
+			std::make_pair(vm->get_builtin_type<Vector>(),       print_builtin<Vector>),
+			std::make_pair(vm->get_builtin_type<List>(),         print_builtin<List>),
+			std::make_pair(vm->get_builtin_type<HashSet>(),      print_builtin<HashSet>),
 		};
 
 		for(auto &[type, fn] : to_add) {
@@ -66,7 +78,7 @@ namespace salmon::vm {
 		}
 
 		add_interface_fn<InternalBox>(vm, print_symb,
-								  "Print the readable representation of an object",
+								  "Print the readable representation of an object", false,
 								  lambda_list, p_interface_type,
 								  to_add);
 	}
@@ -93,49 +105,122 @@ namespace salmon::vm {
 		interface_ret_builder.add_parameter(obj_symb);
 		const vm_ptr<Type> interface_type = type_table.get_fn_type(interface_arg_builder.build(),
 															 interface_ret_builder.build());
-		const std::array<vm_ptr<Type>,2> fn_signatures = {
+		const std::array<vm_ptr<Type>,5> fn_signatures = {
 			init_numeric_fn_sig(vm, vm->get_builtin_type<double>()),
-			init_numeric_fn_sig(vm, vm->get_builtin_type<int32_t>())
+			init_numeric_fn_sig(vm, vm->get_builtin_type<int32_t>()),
+			init_numeric_fn_sig(vm, vm->get_builtin_type<int64_t>()),
+			init_numeric_fn_sig(vm, vm->get_builtin_type<uint64_t>()),
+			init_numeric_fn_sig(vm, vm->get_builtin_type<float>())
 		};
 
-		std::array<std::pair<vm_ptr<Type>,BuiltinFunction<InternalBox,InternalBox>::FunctionType>,2>
+		std::array<std::pair<vm_ptr<Type>,BuiltinFunction<InternalBox,InternalBox>::FunctionType>,5>
 			fn_list = {
 			std::make_pair(fn_signatures[0], add<double>),
 			std::make_pair(fn_signatures[1], add<int32_t>),
+			std::make_pair(fn_signatures[2], add<int64_t>),
+			std::make_pair(fn_signatures[3], add<uint64_t>),
+			std::make_pair(fn_signatures[4], add<float>),
 		};
 		const vm_ptr<Symbol> add_symb = base_package.intern_symbol("add");
 		add_interface_fn<InternalBox,InternalBox>(vm, add_symb,
-								  "Add two numbers",
+								  "Add two numbers", true,
 								  lambda_list, interface_type,
 								  fn_list);
 
 		fn_list = {
 			std::make_pair(fn_signatures[0], subtract<double>),
 			std::make_pair(fn_signatures[1], subtract<int32_t>),
+			std::make_pair(fn_signatures[2], subtract<int64_t>),
+			std::make_pair(fn_signatures[3], subtract<uint64_t>),
+			std::make_pair(fn_signatures[4], subtract<float>),
 		};
 		const vm_ptr<Symbol> sub_symb = base_package.intern_symbol("subtract");
 		add_interface_fn<InternalBox,InternalBox>(vm, sub_symb,
-								  "Subtract two numbers",
+								  "Subtract two numbers", true,
 								  lambda_list, interface_type,
 								  fn_list);
 
 		fn_list = {
 			std::make_pair(fn_signatures[0], multiply<double>),
 			std::make_pair(fn_signatures[1], multiply<int32_t>),
+			std::make_pair(fn_signatures[2], multiply<int64_t>),
+			std::make_pair(fn_signatures[3], multiply<uint64_t>),
+			std::make_pair(fn_signatures[4], multiply<float>),
 		};
 		const vm_ptr<Symbol> mult_symb = base_package.intern_symbol("multiply");
 		add_interface_fn<InternalBox,InternalBox>(vm, mult_symb,
-								  "Multiply two numbers",
+								  "Multiply two numbers", true,
 								  lambda_list, interface_type,
 								  fn_list);
 
 		fn_list = {
 			std::make_pair(fn_signatures[0], divide<double>),
 			std::make_pair(fn_signatures[1], divide<int32_t>),
+			std::make_pair(fn_signatures[2], divide<int64_t>),
+			std::make_pair(fn_signatures[3], divide<uint64_t>),
+			std::make_pair(fn_signatures[4], divide<float>),
 		};
 		const vm_ptr<Symbol> div_symb = base_package.intern_symbol("divide");
 		add_interface_fn<InternalBox,InternalBox>(vm, div_symb,
-								  "Divide two numbers",
+								  "Divide two numbers", true,
+								  lambda_list, interface_type,
+								  fn_list);
+	}
+
+	static vm_ptr<Type> init_comparison_fn_sig(VirtualMachine *vm, const vm_ptr<Type> &type) {
+		SpecBuilder arg_spec;
+		arg_spec.add_type(type);
+		arg_spec.add_type(type);
+		SpecBuilder ret_spec;
+		ret_spec.add_type(vm->get_builtin_type<bool>());
+		return vm->type_table.get_fn_type(arg_spec.build(), ret_spec.build());
+	}
+
+	static void init_comparison_fns(VirtualMachine *vm) {
+		Package &base_package = vm->base_package();
+		TypeTable &type_table = vm->type_table;
+
+		const vm_ptr<Symbol> obj_symb = base_package.intern_symbol("num");
+		std::vector<vm_ptr<Symbol>> lambda_list = { obj_symb, obj_symb };
+		SpecBuilder interface_arg_builder;
+		interface_arg_builder.add_parameter(obj_symb);
+		interface_arg_builder.add_parameter(obj_symb);
+		SpecBuilder interface_ret_builder;
+		interface_ret_builder.add_type(vm->get_builtin_type<bool>());
+		const vm_ptr<Type> interface_type = type_table.get_fn_type(interface_arg_builder.build(),
+																   interface_ret_builder.build());
+		const std::array<vm_ptr<Type>,5> fn_signatures = {
+			init_comparison_fn_sig(vm, vm->get_builtin_type<double>()),
+			init_comparison_fn_sig(vm, vm->get_builtin_type<int32_t>()),
+			init_comparison_fn_sig(vm, vm->get_builtin_type<int64_t>()),
+			init_comparison_fn_sig(vm, vm->get_builtin_type<uint64_t>()),
+			init_comparison_fn_sig(vm, vm->get_builtin_type<float>())
+		};
+
+		std::array<std::pair<vm_ptr<Type>,BuiltinFunction<InternalBox,InternalBox>::FunctionType>,5>
+			fn_list = {
+			std::make_pair(fn_signatures[0], less<double>),
+			std::make_pair(fn_signatures[1], less<int32_t>),
+			std::make_pair(fn_signatures[2], less<int64_t>),
+			std::make_pair(fn_signatures[3], less<uint64_t>),
+			std::make_pair(fn_signatures[4], less<float>),
+		};
+		const vm_ptr<Symbol> less_symb = base_package.intern_symbol("less");
+		add_interface_fn<InternalBox,InternalBox>(vm, less_symb,
+								  "Check if the first number is less than the second", true,
+								  lambda_list, interface_type,
+								  fn_list);
+
+		fn_list = {
+			std::make_pair(fn_signatures[0], greater<double>),
+			std::make_pair(fn_signatures[1], greater<int32_t>),
+			std::make_pair(fn_signatures[2], greater<int64_t>),
+			std::make_pair(fn_signatures[3], greater<uint64_t>),
+			std::make_pair(fn_signatures[4], greater<float>),
+		};
+		const vm_ptr<Symbol> greater_symb = base_package.intern_symbol("greater");
+		add_interface_fn<InternalBox,InternalBox>(vm, greater_symb,
+								  "Check if the first number is greater than the second", true,
 								  lambda_list, interface_type,
 								  fn_list);
 	}
@@ -143,6 +228,7 @@ namespace salmon::vm {
 	static void init_stdlib(VirtualMachine *vm) {
 		init_print_fns(vm);
 		init_arithmetic_fns(vm);
+		init_comparison_fns(vm);
 	}
 
 	template<typename T>
@@ -177,12 +263,20 @@ namespace salmon::vm {
 							 "list", "Linked List used by the vm");
         init_primitive_type<Vector>(base_package, t_table, builtin_map,
 							   "dyn-array", "Dynamic array used by the vm");
+		init_primitive_type<HashSet>(base_package, t_table, builtin_map,
+								 "hash-set", "Hash set used by the vm");
 		init_primitive_type<Symbol>(base_package, t_table, builtin_map,
 								"symbol", "symbol");
 		init_primitive_type<int32_t>(base_package, t_table, builtin_map,
 								 "int-32", "32 bit signed integer type");
+		init_primitive_type<int64_t>(base_package, t_table, builtin_map,
+								 "int-64", "64 bit signed integer type");
+		init_primitive_type<uint64_t>(base_package, t_table, builtin_map,
+								  "uint-64", "64 bit unsigned integer type");
 		init_primitive_type<double>(base_package, t_table, builtin_map,
 								"float-64", "64 bit floating type");
+		init_primitive_type<float>(base_package, t_table, builtin_map,
+							   "float-32", "32 bit floating type");
 		init_primitive_type<bool>(base_package, t_table, builtin_map,
 							  "bool", "Boolean type");
 		init_primitive_type<Empty>(base_package, t_table, builtin_map,
@@ -192,8 +286,10 @@ namespace salmon::vm {
 	VirtualMachine::VirtualMachine(const Config &config, const std::string &base_package) :
 		mem_manager{},
 		type_table{mem_manager},
-		fn_table{},
+		fn_table{type_table},
 		packages{},
+		printer{*this, std::cout},
+		interrupted{false},
 		_config{config},
 		base_package_name(base_package),
 		builtin_map{} {
@@ -204,6 +300,22 @@ namespace salmon::vm {
 		init_stdlib(this);
 	}
 
+	Interrupted::Interrupted() :
+		std::runtime_error("Interrupted") {}
+
+	void VirtualMachine::interrupt() {
+		interrupted.store(true, std::memory_order_relaxed);
+	}
+
+	void VirtualMachine::clear_interrupt() {
+		interrupted.store(false, std::memory_order_relaxed);
+	}
+
+	void VirtualMachine::stop_at_safepoint() {
+		interrupted.store(false, std::memory_order_relaxed);
+		throw Interrupted();
+	}
+
 	Package &VirtualMachine::base_package() {
 		return packages.find(base_package_name)->second;
 	}
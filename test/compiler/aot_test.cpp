@@ -0,0 +1,120 @@
+#include <cstdlib>
+#include <filesystem>
+
+#include <dlfcn.h>
+
+#include <compiler/aot.hpp>
+#include <compiler/bytecode.hpp>
+#include <compiler/compiler.hpp>
+#include <compiler/evaluate.hpp>
+#include <compiler/parser.hpp>
+#include <salmon/core/salmon_string.h>
+#include <salmon/core/salmon_symbol.h>
+
+#include <test/catch.hpp>
+
+#include "helpers.hpp"
+
+namespace salmon::compiler {
+
+	static vm::Symbol *symbol(const std::string &name, Compiler &compiler) {
+		return compiler.current_package()->intern_symbol(name).get();
+	}
+
+	static bool contains(const std::string &text, const std::string &part) {
+		return text.find(part) != std::string::npos;
+	}
+
+	SCENARIO("Bytecode functions are translated to C") {
+		Config config;
+		Compiler compiler(config);
+		vm::Type *int32 = compiler.vm.get_builtin_type<int32_t>().get();
+		vm::Type *float64 = compiler.vm.get_builtin_type<double>().get();
+		vm::Type *string = compiler.vm.get_builtin_type<vm::StaticString>().get();
+		vm::Type *symbol_type = compiler.vm.get_builtin_type<vm::Symbol>().get();
+		eval_string("(defn fib [n] (if (less n 2) n (add (fib (subtract n 1)) (fib (subtract n 2)))))", compiler);
+		eval_string("(defn int-loop [n acc] (if (greater n 0) (int-loop (subtract n 1) (add acc 3)) acc))", compiler);
+		eval_string("(defn halves [n acc] (if (greater n 0) (halves (subtract n 1) (add (multiply acc 0.5) 1.0)) acc))",
+					compiler);
+		eval_string("(defn greeting [] \"hello \\\"world\\\"\")", compiler);
+		eval_string("(defn tag [] :done)", compiler);
+		const std::vector<AotFunction> functions = {
+			{ symbol("fib", compiler), { int32 }, int32 },
+			{ symbol("int-loop", compiler), { int32, int32 }, int32 },
+			{ symbol("halves", compiler), { int32, float64 }, float64 },
+			{ symbol("greeting", compiler), {}, string },
+			{ symbol("tag", compiler), {}, symbol_type },
+		};
+
+		WHEN("Functions are translated") {
+			const std::string source = emit_c(functions, compiler);
+			THEN("Each has a prototype from its signature") {
+				REQUIRE(contains(source, "int32_t salmon_fib(int32_t a0);\n"));
+				REQUIRE(contains(source, "int32_t salmon_int_loop(int32_t a0, int32_t a1);\n"));
+				REQUIRE(contains(source, "double salmon_halves(int32_t a0, double a1);\n"));
+				REQUIRE(contains(source, "struct salmon_string salmon_greeting(void);\n"));
+				REQUIRE(contains(source, "#include <salmon/core/salmon_string.h>\n"));
+			}
+			THEN("Calls to builtins are operators, and calls between the functions are direct") {
+				REQUIRE(contains(source, "s0_b = s0_i < s1_i;\n"));
+				REQUIRE(contains(source, "s0_i = salmon_fib(s0_i);\n"));
+			}
+			THEN("Tail calls to the function itself are loops") {
+				REQUIRE(contains(source, "\ta0 = s0_i;\n\ta1 = s1_i;\n\tgoto start;\n"));
+			}
+			THEN("Strings are escaped") {
+				REQUIRE(contains(source, "(struct salmon_string){13, \"hello \\042world\\042\"}"));
+			}
+		}
+
+		WHEN("A signature doesn't agree with the function") {
+			THEN("It can't be translated") {
+				const std::vector<AotFunction> wrong_result = { { symbol("fib", compiler), { int32 }, float64 } };
+				REQUIRE_THROWS_AS(emit_c(wrong_result, compiler), CompileError);
+				const std::vector<AotFunction> wrong_arity = { { symbol("fib", compiler), {}, int32 } };
+				REQUIRE_THROWS_AS(emit_c(wrong_arity, compiler), CompileError);
+				const std::vector<AotFunction> missing_callee = { { symbol("int-loop", compiler), { float64, int32 }, int32 } };
+				REQUIRE_THROWS_AS(emit_c(missing_callee, compiler), CompileError);
+			}
+		}
+
+		WHEN("A function needs the VM") {
+			eval_string("(defn show [x] (print x))", compiler);
+			eval_string("(defn mixed [x] (if (less x 0) 1 2.5))", compiler);
+			THEN("It can't be translated") {
+				const std::vector<AotFunction> show = { { symbol("show", compiler), { int32 }, int32 } };
+				REQUIRE_THROWS_AS(emit_c(show, compiler), CompileError);
+				const std::vector<AotFunction> mixed = { { symbol("mixed", compiler), { int32 }, int32 } };
+				REQUIRE_THROWS_AS(emit_c(mixed, compiler), CompileError);
+				const std::vector<AotFunction> builtin = { { symbol("add", compiler), { int32, int32 }, int32 } };
+				REQUIRE_THROWS_AS(emit_c(builtin, compiler), CompileError);
+			}
+		}
+
+		WHEN("The C is built into a shared library") {
+			if(std::system("cc --version > /dev/null 2>&1") != 0) {
+				WARN("No C compiler to build with");
+				return;
+			}
+			const std::filesystem::path library = std::filesystem::temp_directory_path() / "salmon_aot_test.so";
+			build_shared_library(emit_c(functions, compiler), library);
+			void *handle = dlopen(library.c_str(), RTLD_NOW | RTLD_LOCAL);
+			REQUIRE(handle != nullptr);
+			THEN("Its functions give the same results as the VM") {
+				auto fib = reinterpret_cast<int32_t(*)(int32_t)>(dlsym(handle, "salmon_fib"));
+				auto int_loop = reinterpret_cast<int32_t(*)(int32_t, int32_t)>(dlsym(handle, "salmon_int_loop"));
+				auto halves = reinterpret_cast<double(*)(int32_t, double)>(dlsym(handle, "salmon_halves"));
+				auto greeting = reinterpret_cast<salmon_string(*)()>(dlsym(handle, "salmon_greeting"));
+				auto tag = reinterpret_cast<salmon_symbol(*)()>(dlsym(handle, "salmon_tag"));
+				REQUIRE(fib(20) == std::get<int32_t>(eval_string("(fib 20)", compiler).value()));
+				REQUIRE(int_loop(1000, 0) == std::get<int32_t>(eval_string("(int-loop 1000 0)", compiler).value()));
+				REQUIRE(halves(1000, 0.0) == std::get<double>(eval_string("(halves 1000 0.0)", compiler).value()));
+				REQUIRE(std::string(greeting().data, greeting().length) == "hello \"world\"");
+				REQUIRE(std::string(tag().name.data, tag().name.length) == "done");
+			}
+			dlclose(handle);
+			std::filesystem::remove(library);
+			std::filesystem::remove(library.string() + ".c");
+		}
+	}
+}
@@ -0,0 +1,354 @@
+#include <array>
+#include <limits>
+#include <sstream>
+
+#include <compiler/bytecode.hpp>
+#include <compiler/compiler.hpp>
+#include <compiler/interpreter.hpp>
+#include <compiler/parser.hpp>
+#include <compiler/specialforms.hpp>
+#include <vm/builtinfunction.hpp>
+#include <vm/vmstdlib.hpp>
+
+#include <test/catch.hpp>
+
+#include "helpers.hpp"
+
+namespace salmon::compiler {
+
+	static std::string disassemble(const Chunk &chunk) {
+		std::ostringstream out;
+		out << chunk;
+		return out.str();
+	}
+
+	static Chunk compile_devirtualized(const std::string &text, Compiler &compiler) {
+		const vm::Box form = read_form(text, compiler);
+		Chunk chunk = compile(form, compiler);
+		devirtualize(chunk, infer_types(form, compiler), compiler);
+		return chunk;
+	}
+
+	//! An int-32 implementation of an arithmetic interface that subtracts
+	static vm::vm_ptr<vm::VmFunction> int32_subtract(vm::VirtualMachine &vm) {
+		const vm::vm_ptr<vm::Symbol> num = vm.base_package().intern_symbol("num");
+		vm::SpecBuilder args;
+		args.add_type(vm.get_builtin_type<int32_t>());
+		args.add_type(vm.get_builtin_type<int32_t>());
+		vm::SpecBuilder ret;
+		ret.add_type(vm.get_builtin_type<int32_t>());
+		return vm::vm_ptr<vm::VmFunction>(vm.mem_manager.allocate_obj<vm::BuiltinFunction<vm::InternalBox, vm::InternalBox>>(
+			vm::subtract<int32_t>, vm.type_table.get_fn_type(args.build(), ret.build()),
+			std::vector<vm::vm_ptr<vm::Symbol>>{ num, num }));
+	}
+
+	SCENARIO("Forms are compiled to bytecode and run") {
+		Config config;
+		Compiler compiler(config);
+
+		WHEN("A call is compiled") {
+			const Chunk chunk = compile(read_form("(add 1 (multiply 2 3))", compiler), compiler);
+			THEN("The arguments are pushed before each dynamic call") {
+				REQUIRE(disassemble(chunk) == "PUSHI 0\nPUSHI 1\nPUSHI 2\nINVOKE 0\nINVOKE 1\nRETURN\n");
+				REQUIRE(chunk.calls[0].num_args == 2);
+				REQUIRE(chunk.calls[1].target == nullptr);
+			}
+			THEN("Running it gives the value of the form") {
+				REQUIRE(std::get<int32_t>(run(chunk, compiler.vm).value()) == 7);
+			}
+		}
+
+		WHEN("A literal is compiled") {
+			const Chunk chunk = compile(read_form("2.5", compiler), compiler);
+			THEN("It is a constant") {
+				REQUIRE(disassemble(chunk) == "PUSHI 0\nRETURN\n");
+				REQUIRE(std::get<double>(run(chunk, compiler.vm).value()) == 2.5);
+			}
+		}
+
+		WHEN("A form uses a variable") {
+			THEN("It can't be compiled yet") {
+				REQUIRE_THROWS_AS(compile(read_form("(add x 1)", compiler), compiler), CompileError);
+			}
+		}
+
+		WHEN("The head of a list isn't a symbol") {
+			THEN("It can't be compiled") {
+				REQUIRE_THROWS_AS(compile(read_form("(1 2)", compiler), compiler), CompileError);
+			}
+		}
+
+		WHEN("A called function doesn't exist") {
+			const Chunk chunk = compile(read_form("(frobnicate 1)", compiler), compiler);
+			THEN("Running it reports the name") {
+				REQUIRE_THROWS_AS(run(chunk, compiler.vm), vm::NoSuchFunction);
+			}
+		}
+	}
+
+	SCENARIO("Calls with known argument types are devirtualized") {
+		Config config;
+		Compiler compiler(config);
+
+		WHEN("Builtin arithmetic is called on int-32s") {
+			const Chunk chunk = compile_devirtualized("(add 1 (multiply 2 3))", compiler);
+			THEN("The calls become arithmetic opcodes") {
+				REQUIRE(disassemble(chunk) == "PUSHI 0\nPUSHI 1\nPUSHI 2\nMULTIPLY_I32 0\nADD_I32 1\nRETURN\n");
+				REQUIRE(std::get<int32_t>(run(chunk, compiler.vm).value()) == 7);
+			}
+		}
+
+		WHEN("Builtin arithmetic is called on float-64s") {
+			const Chunk chunk = compile_devirtualized("(divide (subtract 5.0 2.0) 2.0)", compiler);
+			THEN("The float-64 opcodes are used") {
+				REQUIRE(disassemble(chunk) == "PUSHI 0\nPUSHI 1\nSUBTRACT_F64 0\nPUSHI 2\nDIVIDE_F64 1\nRETURN\n");
+				REQUIRE(std::get<double>(run(chunk, compiler.vm).value()) == 1.5);
+			}
+		}
+
+		WHEN("An interface without an opcode is called") {
+			const Chunk chunk = compile_devirtualized("(print 1)", compiler);
+			THEN("The call goes straight to the implementation") {
+				REQUIRE(disassemble(chunk) == "PUSHI 0\nCALL 0\nRETURN\n");
+				REQUIRE(chunk.calls[0].target != nullptr);
+				REQUIRE(chunk.calls[0].target != chunk.calls[0].interface);
+			}
+		}
+
+		WHEN("The argument types aren't consistent") {
+			const Chunk chunk = compile_devirtualized("(add 1 2.0)", compiler);
+			THEN("The call stays dynamic") {
+				REQUIRE(disassemble(chunk) == "PUSHI 0\nPUSHI 1\nINVOKE 0\nRETURN\n");
+			}
+		}
+
+		WHEN("A call is devirtualized for arguments it isn't given") {
+			const vm::Box form = read_form("(add 1.5 (multiply 2 3))", compiler);
+			Chunk chunk = compile(form, compiler);
+			InferredTypes types = infer_types(form, compiler);
+			// Pretend inference took the result of multiply to be a float-64
+			vm::InterfaceFunction *add = dynamic_cast<vm::InterfaceFunction*>(types.call_sites[1].callee);
+			REQUIRE(add != nullptr);
+			vm::Type *double_type = compiler.vm.get_builtin_type<double>().get();
+			types.call_sites[1].target = add->find_impl({ double_type, double_type });
+			devirtualize(chunk, types, compiler);
+			REQUIRE(disassemble(chunk) == "PUSHI 0\nPUSHI 1\nPUSHI 2\nMULTIPLY_I32 0\nADD_F64 1\nRETURN\n");
+
+			THEN("The guard sends it through dynamic dispatch") {
+				REQUIRE_THROWS_AS(run(chunk, compiler.vm), vm::NoSuchFunction);
+			}
+		}
+
+		WHEN("An implementation is replaced before compiling") {
+			REQUIRE(compiler.vm.fn_table.add_function(compiler.vm.base_package().intern_symbol("add"),
+													  int32_subtract(compiler.vm)));
+			const Chunk chunk = compile_devirtualized("(add 1 2)", compiler);
+			THEN("The replacement is called instead of doing the arithmetic inline") {
+				REQUIRE(disassemble(chunk) == "PUSHI 0\nPUSHI 1\nCALL 0\nRETURN\n");
+				REQUIRE(std::get<int32_t>(run(chunk, compiler.vm).value()) == -1);
+			}
+		}
+
+		WHEN("An implementation is redefined after compiling") {
+			const Chunk chunk = compile_devirtualized("(add 1 2)", compiler);
+			REQUIRE(std::get<int32_t>(run(chunk, compiler.vm).value()) == 3);
+
+			vm::VirtualMachine &vm = compiler.vm;
+			const vm::vm_ptr<vm::Symbol> add_symb = vm.base_package().intern_symbol("add");
+			const vm::vm_ptr<vm::Symbol> num = vm.base_package().intern_symbol("num");
+			vm::SpecBuilder args;
+			args.add_type(vm.get_builtin_type<int32_t>());
+			args.add_type(vm.get_builtin_type<int32_t>());
+			vm::SpecBuilder ret;
+			ret.add_type(vm.get_builtin_type<int32_t>());
+			const vm::vm_ptr<vm::VmFunction> replacement(vm.mem_manager.allocate_obj<vm::BuiltinFunction<vm::InternalBox, vm::InternalBox>>(
+				vm::subtract<int32_t>, vm.type_table.get_fn_type(args.build(), ret.build()),
+				std::vector<vm::vm_ptr<vm::Symbol>>{ num, num }));
+			REQUIRE(vm.fn_table.add_function(add_symb, replacement));
+
+			THEN("The guard sends the call to the new implementation") {
+				REQUIRE(std::get<int32_t>(run(chunk, compiler.vm).value()) == -1);
+			}
+		}
+	}
+
+	SCENARIO("Pure calls on constants are folded while compiling") {
+		Config config;
+		config.seal_builtins = true;
+		Compiler compiler(config);
+		vm::VirtualMachine &vm = compiler.vm;
+
+		WHEN("Builtins are registered") {
+			THEN("Arithmetic is pure and printing isn't") {
+				REQUIRE(vm.fn_table.find_fn(*vm.base_package().intern_symbol("add"))->pure());
+				REQUIRE(vm.fn_table.find_fn(*vm.base_package().intern_symbol("divide"))->pure());
+				REQUIRE_FALSE(vm.fn_table.find_fn(*vm.base_package().intern_symbol("print"))->pure());
+			}
+		}
+
+		WHEN("Arithmetic is nested on literals") {
+			const Chunk chunk = compile(read_form("(add 1 (multiply 2 3))", compiler), compiler);
+			THEN("The whole form becomes one constant") {
+				REQUIRE(disassemble(chunk) == "PUSHI 0\nRETURN\n");
+				REQUIRE(chunk.constants.size() == 1);
+				REQUIRE(chunk.calls.empty());
+				REQUIRE(std::get<int32_t>(run(chunk, vm).value()) == 7);
+			}
+		}
+
+		WHEN("Arithmetic is done on float-64s") {
+			const Chunk chunk = compile(read_form("(divide (add 1.5 2.5) 2.0)", compiler), compiler);
+			THEN("It is folded too") {
+				REQUIRE(disassemble(chunk) == "PUSHI 0\nRETURN\n");
+				REQUIRE(std::get<double>(chunk.constants[0].value()) == 2.0);
+			}
+		}
+
+		WHEN("The result of a pure call is given to an impure one") {
+			const Chunk chunk = compile(read_form("(print (add 1 2))", compiler), compiler);
+			THEN("Only the pure call is folded") {
+				REQUIRE(disassemble(chunk) == "PUSHI 0\nINVOKE 0\nRETURN\n");
+				REQUIRE(std::get<int32_t>(chunk.constants[0].value()) == 3);
+			}
+		}
+
+		WHEN("No implementation matches the constants") {
+			const Chunk chunk = compile(read_form("(add 1 2.0)", compiler), compiler);
+			THEN("The call is left for when the form runs") {
+				REQUIRE(disassemble(chunk) == "PUSHI 0\nPUSHI 1\nINVOKE 0\nRETURN\n");
+			}
+		}
+
+		WHEN("An implementation of a sealed interface is replaced") {
+			const vm::vm_ptr<vm::Symbol> add_symb = vm.base_package().intern_symbol("add");
+			THEN("It isn't added, so folded results stay right") {
+				REQUIRE_FALSE(vm.fn_table.add_function(add_symb, int32_subtract(vm)));
+				REQUIRE(std::get<int32_t>(run(compile(read_form("(add 1 2)", compiler), compiler), vm).value()) == 3);
+			}
+		}
+
+		WHEN("The builtins aren't sealed") {
+			Config unsealed_config;
+			Compiler unsealed(unsealed_config);
+			const Chunk chunk = compile(read_form("(add 1 2)", unsealed), unsealed);
+			THEN("Calls to them are left for when the form runs") {
+				REQUIRE(disassemble(chunk) == "PUSHI 0\nPUSHI 1\nINVOKE 0\nRETURN\n");
+			}
+		}
+
+		WHEN("An int-32 is divided by zero") {
+			const Chunk chunk = compile(read_form("(add 1 (divide 1 0))", compiler), compiler);
+			THEN("The division isn't done while compiling") {
+				REQUIRE(disassemble(chunk) == "PUSHI 0\nPUSHI 1\nPUSHI 2\nINVOKE 0\nINVOKE 1\nRETURN\n");
+			}
+		}
+
+		WHEN("The smallest int-32 is divided by -1") {
+			const Chunk chunk = compile(read_form("(divide -2147483648 -1)", compiler), compiler);
+			THEN("The division isn't done while compiling") {
+				REQUIRE(disassemble(chunk) == "PUSHI 0\nPUSHI 1\nINVOKE 0\nRETURN\n");
+			}
+		}
+
+		WHEN("The smallest int-64 is divided by -1") {
+			const std::array<vm::InternalBox, 2> args = {
+				vm.make_boxed(std::numeric_limits<int64_t>::min()).bare(),
+				vm.make_boxed(int64_t{-1}).bare(),
+			};
+			THEN("The call isn't folded") {
+				REQUIRE_FALSE(fold_call(*vm.base_package().intern_symbol("divide"), args, compiler).has_value());
+			}
+		}
+	}
+
+	//! Run the form on the stack machine without devirtualizing it
+	static vm::Box run_string(const std::string &text, Compiler &compiler) {
+		return run(compile(read_form(text, compiler), compiler), compiler.vm);
+	}
+
+	SCENARIO("Functions are defined and called without growing the C++ stack") {
+		Config config;
+		Compiler compiler(config);
+
+		WHEN("A recursive function is defined") {
+			const vm::Box name = run_string(
+				"(defn fib [n] (if (less n 2) n (add (fib (subtract n 1)) (fib (subtract n 2)))))", compiler);
+			THEN("The defn form gives back its name") {
+				REQUIRE(std::get<vm::Symbol*>(name.value())->name == "fib");
+			}
+			THEN("It can be called") {
+				REQUIRE(std::get<int32_t>(run_string("(fib 20)", compiler).value()) == 6765);
+			}
+			THEN("Its type takes one argument") {
+				REQUIRE(find_bytecode_fn("fib", compiler).arity() == 1);
+				REQUIRE_FALSE(find_bytecode_fn("fib", compiler).type()->concrete());
+			}
+			THEN("It can be called from C++") {
+				vm::VmFunction &fn = const_cast<BytecodeFunction&>(find_bytecode_fn("fib", compiler));
+				std::vector<vm::InternalBox> args = { compiler.vm.make_boxed(10).bare() };
+				REQUIRE(std::get<int32_t>(fn(&compiler.vm, args).value()) == 55);
+			}
+		}
+
+		WHEN("A function calls itself in tail position") {
+			run_string("(defn count-down [n] (if (greater n 0) (count-down (subtract n 1)) n))", compiler);
+			THEN("The call reuses the frame") {
+				REQUIRE(disassemble(find_bytecode_fn("count-down", compiler).chunk()) ==
+						"PUSHL 0\nPUSHI 0\nINVOKE 0\nJMP_F 45\nPUSHL 0\nPUSHI 1\nINVOKE 1\n"
+						"TAILCALL 2\nJMP 50\nPUSHL 0\nRETURN\n");
+			}
+			THEN("A million calls deep runs") {
+				REQUIRE(std::get<int32_t>(run_string("(count-down 1000000)", compiler).value()) == 0);
+			}
+		}
+
+		WHEN("Deep recursion isn't in tail position") {
+			run_string("(defn depth [n] (if (greater n 0) (add 1 (depth (subtract n 1))) 0))", compiler);
+			THEN("The frames are kept by the interpreter") {
+				REQUIRE(std::get<int32_t>(run_string("(depth 200000)", compiler).value()) == 200000);
+			}
+		}
+
+		WHEN("A function has several body forms and no arguments") {
+			run_string("(defn two [] 1 2)", compiler);
+			THEN("It returns the last one") {
+				REQUIRE(std::get<int32_t>(run_string("(two)", compiler).value()) == 2);
+			}
+		}
+
+		WHEN("An if has no else form") {
+			THEN("It is empty when the test is false") {
+				REQUIRE(std::holds_alternative<vm::Empty>(run_string("(if (less 2 1) 1)", compiler).value()));
+				REQUIRE(std::get<int32_t>(run_string("(if (less 1 2) 1)", compiler).value()) == 1);
+			}
+		}
+
+		WHEN("A function is given the wrong number of arguments") {
+			run_string("(defn one [x] x)", compiler);
+			THEN("An arity error is raised") {
+				REQUIRE_THROWS_AS(run_string("(one 1 2)", compiler), vm::ArityException);
+			}
+		}
+
+		WHEN("A function is redefined") {
+			run_string("(defn one [x] x)", compiler);
+			run_string("(defn one [x] (add x 1))", compiler);
+			THEN("Calls use the new definition") {
+				REQUIRE(std::get<int32_t>(run_string("(one 1)", compiler).value()) == 2);
+			}
+			THEN("Its number of arguments can't change") {
+				REQUIRE_THROWS_AS(run_string("(defn one [x y] x)", compiler), CompileError);
+			}
+		}
+
+		WHEN("A definition is malformed") {
+			THEN("It isn't compiled") {
+				REQUIRE_THROWS_AS(run_string("(defn bad [x x] x)", compiler), CompileError);
+				REQUIRE_THROWS_AS(run_string("(defn bad (x) x)", compiler), CompileError);
+				REQUIRE_THROWS_AS(run_string("(defn bad [x])", compiler), CompileError);
+				REQUIRE_THROWS_AS(run_string("(defn bad [x] y)", compiler), CompileError);
+				REQUIRE_THROWS_AS(run_string("(if 1 2 3 4)", compiler), CompileError);
+			}
+		}
+	}
+}
@@ -0,0 +1,85 @@
+#include <cmath>
+
+#include <compiler/bytecode.hpp>
+#include <compiler/compiler.hpp>
+#include <compiler/evaluate.hpp>
+#include <compiler/parser.hpp>
+#include <vm/foreignfunction.hpp>
+
+#include <test/catch.hpp>
+
+#include "helpers.hpp"
+
+namespace salmon::compiler {
+
+	SCENARIO("C functions are imported from shared libraries") {
+		Config config;
+		Compiler compiler(config);
+
+		WHEN("Functions are declared with defextern") {
+			eval_string("(defextern cos \"libm.so.6\" [float-64] float-64)", compiler);
+			eval_string("(defextern pow \"libm.so.6\" [float-64 float-64] float-64)", compiler);
+			eval_string("(defextern abs \"libc.so.6\" [int-32] int-32)", compiler);
+			eval_string("(defextern atoi \"libc.so.6\" [const-string] int-32)", compiler);
+			eval_string("(defextern getenv \"libc.so.6\" [const-string] const-string)", compiler);
+			THEN("They can be called like other functions") {
+				REQUIRE(std::get<double>(eval_string("(cos 0.5)", compiler).value()) == std::cos(0.5));
+				REQUIRE(std::get<double>(eval_string("(pow 2.0 10.0)", compiler).value()) == 1024.0);
+				REQUIRE(std::get<int32_t>(eval_string("(abs -7)", compiler).value()) == 7);
+				REQUIRE(std::get<int32_t>(eval_string("(atoi \"42\")", compiler).value()) == 42);
+				REQUIRE(std::get<int32_t>(eval_string("(add (abs -2) 1)", compiler).value()) == 3);
+			}
+			THEN("A returned null string becomes an empty string") {
+				vm::Box result = eval_string("(getenv \"SALMON_NOT_SET_ANYWHERE\")", compiler);
+				REQUIRE(std::get<vm::StaticString*>(result.value())->contents == "");
+			}
+			THEN("They can be called from defined functions") {
+				eval_string("(defn hypotenuse [a b] (pow (add (multiply a a) (multiply b b)) 0.5))", compiler);
+				REQUIRE(std::get<double>(eval_string("(hypotenuse 3.0 4.0)", compiler).value()) == 5.0);
+			}
+			THEN("Calls with the wrong arguments fail") {
+				REQUIRE_THROWS_AS(eval_string("(abs 1.5)", compiler), vm::NoSuchFunction);
+				REQUIRE_THROWS_AS(eval_string("(abs 1 2)", compiler), vm::ArityException);
+			}
+		}
+
+		WHEN("A name has dashes") {
+			THEN("They become underscores in C") {
+				REQUIRE_THROWS_WITH(eval_string("(defextern no-such-fn \"libc.so.6\" [] int-32)", compiler),
+									Catch::Contains("no_such_fn"));
+			}
+		}
+
+		WHEN("A declaration can't be loaded") {
+			THEN("It is a compile error") {
+				REQUIRE_THROWS_AS(eval_string("(defextern cos \"libsalmon-missing.so\" [float-64] float-64)", compiler),
+								  CompileError);
+				REQUIRE_THROWS_AS(eval_string("(defextern cos \"libm.so.6\" [list] float-64)", compiler),
+								  CompileError);
+				REQUIRE_THROWS_WITH(eval_string("(defextern pow \"libm.so.6\" [float-64 list] float-64)", compiler),
+									Catch::Contains("Argument 2 of pow"));
+				REQUIRE_THROWS_AS(eval_string("(defextern cos \"libm.so.6\" [not-a-type] float-64)", compiler),
+								  CompileError);
+				REQUIRE_THROWS_AS(eval_string("(defextern cos \"libm.so.6\" float-64)", compiler),
+								  CompileError);
+				REQUIRE_THROWS_AS(eval_string(
+									  "(defextern fma \"libm.so.6\" [float-64 float-64 float-64 float-64] float-64)",
+									  compiler),
+								  CompileError);
+			}
+		}
+	}
+
+	SCENARIO("Trampolines exist for the supported signatures") {
+		using vm::CType;
+		const std::vector<CType> three = { CType::INT32, CType::FLOAT64, CType::STRING };
+		REQUIRE(vm::find_trampoline(CType::VOID, three) != nullptr);
+		REQUIRE(vm::find_trampoline(CType::BOOL, {}) != nullptr);
+		REQUIRE(vm::find_trampoline(CType::INT32, three) != vm::find_trampoline(CType::FLOAT64, three));
+
+		const std::vector<CType> four(4, CType::INT32);
+		REQUIRE(vm::find_trampoline(CType::INT32, four) == nullptr);
+		const std::vector<CType> void_arg = { CType::VOID };
+		REQUIRE(vm::find_trampoline(CType::INT32, void_arg) == nullptr);
+	}
+}
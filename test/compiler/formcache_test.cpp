@@ -0,0 +1,109 @@
+#include <filesystem>
+#include <fstream>
+#include <span>
+#include <string>
+
+#include <compiler/compiler.hpp>
+#include <compiler/formcache.hpp>
+#include <compiler/parser.hpp>
+#include <vm/serialize.hpp>
+
+#include <test/catch.hpp>
+
+namespace salmon::compiler {
+
+	static std::filesystem::path make_temp_dir() {
+		std::filesystem::path dir = std::filesystem::temp_directory_path() / "salmon-formcache-test";
+		std::filesystem::remove_all(dir);
+		std::filesystem::create_directories(dir);
+		return dir;
+	}
+
+	static void write_file(const std::filesystem::path &path, const std::string &contents) {
+		std::ofstream out(path);
+		out << contents;
+	}
+
+	SCENARIO("Forms read from a file are cached") {
+		const std::filesystem::path dir = make_temp_dir();
+		const std::filesystem::path source = dir / "source.sal";
+		const std::filesystem::path cache_dir = dir / "cache";
+		Config config{0, cache_dir, dir, dir};
+		Compiler compiler(config);
+		FormCache cache(cache_dir);
+
+		WHEN("A file is read twice") {
+			write_file(source, "(print \"hello\") [1 2.5 :key] {a b}");
+			std::optional<ReadForms> first = cache.read_file(source, compiler);
+			THEN("The first read stores an entry in the cache") {
+				REQUIRE(first.has_value());
+				REQUIRE(cache.hits() == 0);
+				REQUIRE(first->forms.size() == 3);
+				REQUIRE(first->errors.empty());
+				REQUIRE(std::distance(std::filesystem::directory_iterator(cache_dir / "forms"),
+									  std::filesystem::directory_iterator{}) == 1);
+			}
+			std::optional<ReadForms> second = cache.read_file(source, compiler);
+			THEN("The second read is answered from the cache with the same forms") {
+				REQUIRE(cache.hits() == 1);
+				REQUIRE(second.has_value());
+				REQUIRE(second->forms == first->forms);
+			}
+		}
+
+		WHEN("The file is edited") {
+			write_file(source, "(a b)");
+			cache.read_file(source, compiler);
+			write_file(source, "(a c)");
+			std::optional<ReadForms> read = cache.read_file(source, compiler);
+			THEN("The new contents are read") {
+				REQUIRE(cache.hits() == 0);
+				REQUIRE(read.has_value());
+				REQUIRE(read->forms.size() == 1);
+				vm::Box expected = *read_from_string("(a c)", compiler);
+				REQUIRE(read->forms[0] == expected);
+			}
+		}
+
+		WHEN("The cache holds an entry written by an older reader") {
+			const std::string text = "(a b)";
+			write_file(source, text);
+			const uint64_t old_key = FormCache::key(std::as_bytes(std::span(text.data(), text.size())),
+													compiler.current_package()->name,
+													FormCache::READER_VERSION - 1);
+			std::filesystem::create_directories(cache_dir / "forms");
+			{
+				std::ofstream out(cache.entry_path(old_key), std::ios::binary);
+				vm::serialize::Writer writer(out);
+				writer.write(*read_from_string("(stale)", compiler));
+				writer.finish();
+			}
+			std::optional<ReadForms> read = cache.read_file(source, compiler);
+			THEN("The entry is ignored and the file is read again") {
+				REQUIRE(cache.hits() == 0);
+				REQUIRE(read.has_value());
+				REQUIRE(read->forms.size() == 1);
+				REQUIRE(read->forms[0] == *read_from_string(text, compiler));
+			}
+		}
+
+		WHEN("The file can't be parsed") {
+			write_file(source, "(a b");
+			std::optional<ReadForms> read = cache.read_file(source, compiler);
+			THEN("The error is reported and nothing is cached") {
+				REQUIRE(read.has_value());
+				REQUIRE(read->errors.size() == 1);
+				const bool cached = std::filesystem::exists(cache_dir / "forms")
+					&& !std::filesystem::is_empty(cache_dir / "forms");
+				REQUIRE_FALSE(cached);
+			}
+		}
+
+		WHEN("The file doesn't exist") {
+			THEN("Nothing is read") {
+				REQUIRE_FALSE(cache.read_file(dir / "missing.sal", compiler).has_value());
+			}
+		}
+		std::filesystem::remove_all(dir);
+	}
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <optional>
+#include <string>
+
+#include <compiler/compiler.hpp>
+#include <compiler/evaluate.hpp>
+#include <compiler/interpreter.hpp>
+#include <compiler/parser.hpp>
+
+#include <test/catch.hpp>
+
+//! Helpers shared by the compiler tests
+namespace salmon::compiler {
+
+	//! Read the first form in the text, which must have one
+	inline vm::Box read_form(const std::string &text, Compiler &compiler) {
+		std::optional<vm::Box> form = read_from_string(text, compiler);
+		REQUIRE(form.has_value());
+		return *form;
+	}
+
+	//! Read the first form in the text and evaluate it with the configured backend
+	inline vm::Box eval_string(const std::string &text, Compiler &compiler) {
+		return evaluate(read_form(text, compiler), compiler);
+	}
+
+	//! The function defined under the name, which must be compiled to bytecode
+	inline BytecodeFunction &find_bytecode_fn(const std::string &name, Compiler &compiler) {
+		vm::VmFunction *fn = compiler.vm.fn_table.find_fn(*compiler.current_package()->intern_symbol(name));
+		REQUIRE(fn != nullptr);
+		BytecodeFunction *bytecode = dynamic_cast<BytecodeFunction*>(fn);
+		REQUIRE(bytecode != nullptr);
+		return *bytecode;
+	}
+}
@@ -0,0 +1,111 @@
+#include <array>
+#include <random>
+#include <sstream>
+#include <string>
+
+#include <compiler/compiler.hpp>
+#include <compiler/incrementalreader.hpp>
+#include <compiler/parser.hpp>
+
+#include <test/catch.hpp>
+
+namespace salmon::compiler {
+
+	//! Check the reader has what reading its whole buffer again would give
+	static void require_matches_full_read(const IncrementalReader &reader, Compiler &compiler) {
+		std::istringstream input(reader.text());
+		CountingStreamBuffer countStreamBuf(input);
+		size_t index = 0;
+		while(true) {
+			const size_t start = static_cast<size_t>(countStreamBuf.filepos());
+			const salmon::meta::position_info position = countStreamBuf.positionInfo();
+			std::optional<ReadItem> item = read_recovering(countStreamBuf, compiler);
+			if(!item) {
+				break;
+			}
+			REQUIRE(index < reader.forms().size());
+			const IncrementalReader::Form &form = reader.forms()[index];
+			REQUIRE(form.start == start);
+			REQUIRE(form.end == static_cast<size_t>(countStreamBuf.filepos()));
+			REQUIRE(form.position.line == position.line);
+			REQUIRE(form.position.column == position.column);
+			REQUIRE(form.item.form.has_value() == item->form.has_value());
+			if(item->form) {
+				REQUIRE(*form.item.form == *item->form);
+			} else {
+				REQUIRE(std::string(form.item.error->what()) == item->error->what());
+				REQUIRE(form.item.error->start().line == item->error->start().line);
+				REQUIRE(form.item.error->end().line == item->error->end().line);
+				REQUIRE(form.item.error->end().column == item->error->end().column);
+			}
+			index++;
+		}
+		REQUIRE(index == reader.forms().size());
+	}
+
+	SCENARIO("An edited buffer is read incrementally") {
+		Config config;
+		Compiler compiler(config);
+		IncrementalReader reader(compiler);
+		reader.reset("(a 1)\n(b [2 3])\n(c \"four\")\n");
+
+		WHEN("The buffer is first read") {
+			THEN("Every top-level form is read") {
+				REQUIRE(reader.forms().size() == 3);
+				require_matches_full_read(reader, compiler);
+			}
+		}
+
+		WHEN("A form in the middle is edited") {
+			const vm::List *first = std::get<vm::List*>(reader.forms()[0].item.form->value());
+			const vm::List *last = std::get<vm::List*>(reader.forms()[2].item.form->value());
+			reader.edit(10, 1, "[20 21]\n");
+			THEN("Only that form is read again") {
+				REQUIRE(reader.forms().size() == 3);
+				require_matches_full_read(reader, compiler);
+				REQUIRE(std::get<vm::List*>(reader.forms()[0].item.form->value()) == first);
+				REQUIRE(std::get<vm::List*>(reader.forms()[2].item.form->value()) == last);
+				REQUIRE(reader.forms()[2].position.line == 3);
+			}
+		}
+
+		WHEN("An edit leaves a form open") {
+			reader.edit(4, 1, "");
+			THEN("The following forms are swallowed until it is closed again") {
+				REQUIRE(reader.forms().size() == 1);
+				REQUIRE(reader.forms()[0].item.error.has_value());
+				require_matches_full_read(reader, compiler);
+			}
+			reader.edit(4, 0, ")");
+			THEN("Closing it reads the forms again") {
+				REQUIRE(reader.forms().size() == 3);
+				require_matches_full_read(reader, compiler);
+			}
+		}
+
+		WHEN("An atom is extended at the end of the buffer") {
+			reader.reset("(a) b");
+			reader.edit(5, 0, "c");
+			THEN("The atom is read again") {
+				require_matches_full_read(reader, compiler);
+			}
+		}
+
+		WHEN("Random edits are made") {
+			static const std::array<std::string_view, 12> pieces = {
+				"(a b)", "\n", " ", "(", ")", "\"", "[1 2]", "x", "; c\n", "#x1f", "{d}", "'e"
+			};
+			std::mt19937 gen(42);
+			for(int i = 0; i < 500; i++) {
+				const size_t size = reader.text().size();
+				const size_t offset = std::uniform_int_distribution<size_t>(0, size)(gen);
+				const size_t length = std::uniform_int_distribution<size_t>(0, std::min<size_t>(size - offset, 4))(gen);
+				const std::string_view piece = pieces[std::uniform_int_distribution<size_t>(0, pieces.size() - 1)(gen)];
+				reader.edit(offset, length, piece);
+			}
+			THEN("The forms are the same as reading the buffer from scratch") {
+				require_matches_full_read(reader, compiler);
+			}
+		}
+	}
+}
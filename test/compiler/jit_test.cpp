@@ -0,0 +1,106 @@
+#include <compiler/compiler.hpp>
+#include <compiler/evaluate.hpp>
+#include <compiler/interpreter.hpp>
+#include <compiler/jit.hpp>
+#include <compiler/parser.hpp>
+
+#include <test/catch.hpp>
+
+#include "helpers.hpp"
+
+namespace salmon::compiler {
+
+	SCENARIO("Hot bytecode functions are compiled to machine code") {
+		Config config;
+		config.jit_threshold = 2;
+		Compiler compiler(config);
+
+		WHEN("A function is called as often as the threshold") {
+			eval_string("(defn fib [n] (if (less n 2) n (add (fib (subtract n 1)) (fib (subtract n 2)))))", compiler);
+			eval_string("(fib 0)", compiler);
+			THEN("It isn't compiled before then") {
+				REQUIRE(find_bytecode_fn("fib", compiler).native_code() == nullptr);
+			}
+			THEN("It is compiled, and gives the same results") {
+				REQUIRE(std::get<int32_t>(eval_string("(fib 1)", compiler).value()) == 1);
+				REQUIRE((find_bytecode_fn("fib", compiler).native_code() != nullptr) == jit_supported());
+				REQUIRE(std::get<int32_t>(eval_string("(fib 20)", compiler).value()) == 6765);
+			}
+		}
+
+		WHEN("A loop does float-64 arithmetic") {
+			eval_string("(defn halves [n acc] (if (greater n 0) (halves (subtract n 1) (add (multiply acc 0.5) 1.0)) acc))",
+						compiler);
+			THEN("It gives the same result as C++") {
+				double expected = 0.0;
+				for(int i = 0; i < 1000; i++) {
+					expected = expected * 0.5 + 1.0;
+				}
+				REQUIRE(std::get<double>(eval_string("(halves 1000 0.0)", compiler).value()) == expected);
+			}
+		}
+
+		WHEN("Compiled code is given arguments its guards don't expect") {
+			eval_string("(defn twice [x] (add x x))", compiler);
+			eval_string("(defn ratio [x y] (divide x y))", compiler);
+			for(int i = 0; i < 2; i++) {
+				eval_string("(twice 1)", compiler);
+				eval_string("(ratio 1 1)", compiler);
+			}
+			THEN("The interpreter makes the call instead") {
+				REQUIRE(std::get<int32_t>(eval_string("(twice 2)", compiler).value()) == 4);
+				REQUIRE(std::get<double>(eval_string("(twice 1.5)", compiler).value()) == 3.0);
+				REQUIRE(std::get<int32_t>(eval_string("(ratio 7 2)", compiler).value()) == 3);
+				REQUIRE(std::get<int32_t>(eval_string("(ratio 7 -1)", compiler).value()) == -7);
+				REQUIRE_THROWS_AS(eval_string("(twice :a)", compiler), vm::NoSuchFunction);
+			}
+			THEN("The machine code is kept") {
+				eval_string("(twice 1.5)", compiler);
+				REQUIRE((find_bytecode_fn("twice", compiler).native_code() != nullptr) == jit_supported());
+			}
+		}
+
+		WHEN("A builtin called from compiled code throws") {
+			eval_string("(defn small [x] (less x 1))", compiler);
+			BytecodeFunction &fn = find_bytecode_fn("small", compiler);
+			std::vector<vm::InternalBox> args = { compiler.vm.make_boxed(0).bare() };
+			fn(&compiler.vm, args);
+			fn(&compiler.vm, args);
+			compiler.vm.interrupt();
+			THEN("The exception reaches the caller") {
+				REQUIRE_THROWS_AS(fn(&compiler.vm, args), vm::Interrupted);
+				REQUIRE(std::get<bool>(fn(&compiler.vm, args).value()));
+			}
+		}
+
+		WHEN("An interface the compiled code calls into changes") {
+			eval_string("(defn twice [x] (add x x))", compiler);
+			eval_string("(twice 1)", compiler);
+			eval_string("(twice 1)", compiler);
+			vm::VirtualMachine &vm = compiler.vm;
+			vm::InterfaceFunction *add = dynamic_cast<vm::InterfaceFunction*>(
+				vm.fn_table.find_fn(*vm.base_package().intern_symbol("add")));
+			REQUIRE(add != nullptr);
+			const std::vector<vm::Type*> ints = { vm.get_builtin_type<int32_t>().get(), vm.get_builtin_type<int32_t>().get() };
+			REQUIRE(add->add_impl(vm.mem_manager.make_vm_ptr(add->find_impl(ints))));
+			THEN("The machine code is thrown away, and made again once the function is hot") {
+				REQUIRE(std::get<int32_t>(eval_string("(twice 3)", compiler).value()) == 6);
+				REQUIRE(find_bytecode_fn("twice", compiler).native_code() == nullptr);
+				eval_string("(twice 3)", compiler);
+				eval_string("(twice 3)", compiler);
+				REQUIRE((find_bytecode_fn("twice", compiler).native_code() != nullptr) == jit_supported());
+			}
+		}
+	}
+
+	SCENARIO("The JIT can be turned off") {
+		Config config;
+		config.jit_threshold = 0;
+		Compiler compiler(config);
+		eval_string("(defn one [] 1)", compiler);
+		for(int i = 0; i < 10; i++) {
+			eval_string("(one)", compiler);
+		}
+		REQUIRE(find_bytecode_fn("one", compiler).native_code() == nullptr);
+	}
+}
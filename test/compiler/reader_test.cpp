@@ -0,0 +1,211 @@
+#include <cstdint>
+#include <limits>
+#include <sstream>
+
+#include <compiler/compiler.hpp>
+#include <compiler/parser.hpp>
+
+#include <test/catch.hpp>
+
+namespace salmon::compiler {
+
+	template<typename T>
+	static T read_number(const std::string &text, Compiler &compiler) {
+		std::optional<vm::Box> box = read_from_string(text, compiler);
+		REQUIRE(box.has_value());
+		REQUIRE(std::holds_alternative<T>(box->value()));
+		return std::get<T>(box->value());
+	}
+
+	SCENARIO("The reader reads numbers") {
+		Config config;
+		Compiler compiler(config);
+
+		WHEN("Integers are read") {
+			THEN("They are put in the smallest type that fits them") {
+				REQUIRE(read_number<int32_t>("42", compiler) == 42);
+				REQUIRE(read_number<int32_t>("2147483647", compiler) == std::numeric_limits<int32_t>::max());
+				REQUIRE(read_number<int64_t>("2147483648", compiler) == 2147483648);
+				REQUIRE(read_number<int64_t>("9223372036854775807", compiler) == std::numeric_limits<int64_t>::max());
+				REQUIRE(read_number<uint64_t>("18446744073709551615", compiler) == std::numeric_limits<uint64_t>::max());
+			}
+			THEN("Signs are read as part of the number") {
+				REQUIRE(read_number<int32_t>("-5", compiler) == -5);
+				REQUIRE(read_number<int32_t>("+5", compiler) == 5);
+				REQUIRE(read_number<int32_t>("-2147483648", compiler) == std::numeric_limits<int32_t>::min());
+				REQUIRE(read_number<int64_t>("-2147483649", compiler) == -2147483649);
+			}
+		}
+
+		WHEN("Hex numbers are read") {
+			THEN("They are put in the smallest type that fits them") {
+				REQUIRE(read_number<int32_t>("#xff", compiler) == 255);
+				REQUIRE(read_number<int64_t>("#xFFFFFFFF", compiler) == 0xFFFFFFFF);
+				REQUIRE(read_number<uint64_t>("#xFFFFFFFFFFFFFFFF", compiler) == std::numeric_limits<uint64_t>::max());
+			}
+		}
+
+		WHEN("Floats are read") {
+			THEN("They are doubles unless they end in 'f'") {
+				REQUIRE(read_number<double>("2.5", compiler) == 2.5);
+				REQUIRE(read_number<double>("-.5", compiler) == -0.5);
+				REQUIRE(read_number<double>("1e3", compiler) == 1000.0);
+				REQUIRE(read_number<double>("1.5E-2", compiler) == 0.015);
+				REQUIRE(read_number<float>("2.5f", compiler) == 2.5f);
+				REQUIRE(read_number<float>("3f", compiler) == 3.0f);
+			}
+		}
+
+		WHEN("Atoms only look like numbers") {
+			THEN("They are read as symbols") {
+				for(const char *text : { "-", "+", "1.2.3", "1e", "e5", "1ff", "12abc" }) {
+					std::optional<vm::Box> box = read_from_string(text, compiler);
+					REQUIRE(box.has_value());
+					REQUIRE(std::holds_alternative<vm::Symbol*>(box->value()));
+				}
+			}
+		}
+
+		WHEN("A number is too big for any integer type") {
+			THEN("An exception is thrown") {
+				REQUIRE_THROWS_AS(read_from_string("18446744073709551616", compiler), ParseException);
+				REQUIRE_THROWS_AS(read_from_string("-9223372036854775809", compiler), ParseException);
+				REQUIRE_THROWS_AS(read_from_string("#x10000000000000000", compiler), ParseException);
+				REQUIRE_THROWS_AS(read_from_string("1e999", compiler), ParseException);
+			}
+		}
+
+		WHEN("A hex number has invalid digits") {
+			THEN("An exception is thrown") {
+				REQUIRE_THROWS_AS(read_from_string("#xfg", compiler), ParseException);
+				REQUIRE_THROWS_AS(read_from_string("#x-1", compiler), ParseException);
+			}
+		}
+	}
+
+	SCENARIO("The reader dispatches on the character after '#'") {
+		Config config;
+		Compiler compiler(config);
+
+		WHEN("The builtin reader macros are used") {
+			THEN("Binary and octal numbers are read") {
+				REQUIRE(read_number<int32_t>("#b101", compiler) == 5);
+				REQUIRE(read_number<int32_t>("#o17", compiler) == 15);
+				REQUIRE(read_number<int64_t>("#b11111111111111111111111111111111", compiler) == 0xFFFFFFFF);
+				REQUIRE_THROWS_AS(read_from_string("#b102", compiler), ParseException);
+			}
+			THEN("Character literals are read as their character code") {
+				REQUIRE(read_number<int32_t>("#\\a", compiler) == 'a');
+				REQUIRE(read_number<int32_t>("#\\(", compiler) == '(');
+				REQUIRE(read_number<int32_t>("#\\space", compiler) == ' ');
+				REQUIRE(read_number<int32_t>("#\\newline", compiler) == '\n');
+				REQUIRE_THROWS_AS(read_from_string("#\\nothing", compiler), ParseException);
+			}
+			THEN("#(...) is read as a vector") {
+				std::optional<vm::Box> box = read_from_string("#(1 #(2) 3)", compiler);
+				REQUIRE(box.has_value());
+				vm::Vector *vector = std::get<vm::Vector*>(box->value());
+				REQUIRE(vector->size() == 3);
+				REQUIRE(std::holds_alternative<vm::Vector*>((*vector)[1].elem));
+				REQUIRE_THROWS_AS(read_from_string("#(1 2", compiler), ParseException);
+			}
+			THEN("The table isn't customized") {
+				REQUIRE(!compiler.reader_macros.customized());
+			}
+		}
+
+		WHEN("A reader macro is registered") {
+			compiler.reader_macros.set('!', [](std::istream &input, Compiler &compiler) {
+				input.get();
+				return compiler.vm.make_boxed(static_cast<int32_t>(input.get()));
+			});
+			THEN("It reads the forms using its dispatch character") {
+				REQUIRE(read_number<int32_t>("#!ab", compiler) == 'b');
+				REQUIRE(compiler.reader_macros.customized());
+			}
+			THEN("Removing it makes the dispatch character an error again") {
+				compiler.reader_macros.remove('!');
+				REQUIRE(compiler.reader_macros.get('!') == nullptr);
+				REQUIRE_THROWS_AS(read_from_string("#!ab", compiler), ParseException);
+			}
+		}
+	}
+
+	SCENARIO("The reader keeps going after errors") {
+		Config config;
+		Compiler compiler(config);
+
+		WHEN("A source with several errors is read") {
+			std::istringstream input("(a \"bad \\q escape\")\n"
+									 "(b 1) )\n"
+									 "(c #xzz (d))\n"
+									 "(e [2 3])\n"
+									 "(f");
+			CountingStreamBuffer countStreamBuf(input);
+			ReadForms read = read_all(countStreamBuf, compiler);
+			THEN("Every error is collected") {
+				REQUIRE(read.errors.size() == 4);
+			}
+			THEN("The forms between the errors are read") {
+				REQUIRE(read.forms.size() == 2);
+				REQUIRE(read.forms[0] == *read_from_string("(b 1)", compiler));
+				REQUIRE(read.forms[1] == *read_from_string("(e [2 3])", compiler));
+			}
+		}
+
+		WHEN("A list isn't closed") {
+			std::istringstream input("(print \"a\"\n"
+									 "(add 1 2)\n"
+									 "(add 3 4)\n"
+									 "  ; (not a form)\n"
+									 "(add 5 6)\n");
+			CountingStreamBuffer countStreamBuf(input);
+			ReadForms read = read_all(countStreamBuf, compiler);
+			THEN("Reading starts again at the next line starting with a list") {
+				REQUIRE(read.errors.size() == 1);
+				REQUIRE(read.errors[0].start().line == 1);
+				REQUIRE(read.forms.size() == 3);
+				REQUIRE(read.forms[0] == *read_from_string("(add 1 2)", compiler));
+				REQUIRE(read.forms[2] == *read_from_string("(add 5 6)", compiler));
+			}
+		}
+
+		WHEN("Several lists aren't closed") {
+			std::istringstream input("\n(a\n(b 1)\n  (c 2\n(d 3)");
+			CountingStreamBuffer countStreamBuf(input);
+			ReadForms read = read_all(countStreamBuf, compiler);
+			THEN("Each one is reported once, and the forms after them are read") {
+				REQUIRE(read.errors.size() == 2);
+				REQUIRE(read.errors[0].start().line == 2);
+				REQUIRE(read.errors[1].start().line == 4);
+				REQUIRE(read.errors[1].start().column == 2);
+				REQUIRE(read.forms.size() == 2);
+				REQUIRE(read.forms[0] == *read_from_string("(b 1)", compiler));
+				REQUIRE(read.forms[1] == *read_from_string("(d 3)", compiler));
+			}
+		}
+
+		WHEN("A string has an invalid escape") {
+			THEN("An exception is thrown") {
+				REQUIRE_THROWS_AS(read_from_string("\"\\q\"", compiler), ParseException);
+				REQUIRE_THROWS_AS(read_from_string("\"\\", compiler), ParseException);
+			}
+		}
+	}
+
+	SCENARIO("Unfinished input is recognized") {
+		THEN("Open lists, vectors, sets and strings need more input") {
+			REQUIRE(needs_more_input("(defn foo (a)"));
+			REQUIRE(needs_more_input("[1 {2"));
+			REQUIRE(needs_more_input("(print \"hello"));
+			REQUIRE(needs_more_input("\"\"\"a \" b"));
+		}
+		THEN("Closed forms don't") {
+			REQUIRE_FALSE(needs_more_input("(defn foo (a)\n  a)"));
+			REQUIRE_FALSE(needs_more_input("(print \")\\\"(\")"));
+			REQUIRE_FALSE(needs_more_input("(a \"\" b)"));
+			REQUIRE_FALSE(needs_more_input("(a #\\( b) ; comment ("));
+			REQUIRE_FALSE(needs_more_input("a)"));
+		}
+	}
+}
@@ -0,0 +1,145 @@
+#include <algorithm>
+#include <sstream>
+
+#include <compiler/bytecode.hpp>
+#include <compiler/compiler.hpp>
+#include <compiler/evaluate.hpp>
+#include <compiler/interpreter.hpp>
+#include <compiler/parser.hpp>
+#include <compiler/registercode.hpp>
+#include <compiler/registerinterpreter.hpp>
+
+#include <test/catch.hpp>
+
+#include "helpers.hpp"
+
+namespace salmon::compiler {
+
+	template<typename T>
+	static std::string disassemble(const T &chunk) {
+		std::ostringstream out;
+		out << chunk;
+		return out.str();
+	}
+
+	SCENARIO("Forms are compiled to register code") {
+		Config config;
+		Compiler compiler(config);
+
+		WHEN("Nested calls are compiled") {
+			const RegisterChunk chunk = compile_registers(read_form("(add 1 (multiply 2 3))", compiler), compiler, false);
+			THEN("Constants are used in place, and results go in registers") {
+				REQUIRE(disassemble(chunk) == "INVOKE r0 (multiply k1 k2)\nINVOKE r0 (add k0 r0)\nRETURN r0\n");
+				REQUIRE(chunk.num_registers == 1);
+				REQUIRE(std::get<int32_t>(run(chunk, compiler.vm).value()) == 7);
+			}
+		}
+
+		WHEN("Calls to sealed builtins on constants are folded") {
+			Config sealed_config;
+			sealed_config.seal_builtins = true;
+			Compiler sealed(sealed_config);
+			const RegisterChunk chunk = compile_registers(read_form("(print (add 1 (multiply 2 3)))", sealed), sealed);
+			THEN("Only the impure call is left") {
+				REQUIRE(disassemble(chunk) == "INVOKE r0 (print k0)\nRETURN r0\n");
+				REQUIRE(std::get<int32_t>(chunk.constants[0].value()) == 7);
+			}
+		}
+
+		WHEN("Sibling calls are compiled") {
+			const RegisterChunk chunk = compile_registers(
+				read_form("(add (multiply 2 3) (subtract 5 1))", compiler), compiler, false);
+			THEN("Each result keeps its own register until the call using them") {
+				REQUIRE(disassemble(chunk) ==
+						"INVOKE r0 (multiply k0 k1)\nINVOKE r1 (subtract k2 k3)\nINVOKE r0 (add r0 r1)\nRETURN r0\n");
+				REQUIRE(std::get<int32_t>(run(chunk, compiler.vm).value()) == 10);
+			}
+		}
+
+		WHEN("A recursive function is defined") {
+			const char *fib = "(defn fib [n] (if (less n 2) n (add (fib (subtract n 1)) (fib (subtract n 2)))))";
+			compile_registers(read_form(fib, compiler), compiler);
+			vm::VmFunction *fn = compiler.vm.fn_table.find_fn(*compiler.current_package()->intern_symbol("fib"));
+			const RegisterFunction *register_fn = dynamic_cast<RegisterFunction*>(fn);
+			REQUIRE(register_fn != nullptr);
+			THEN("Its arguments are used straight from their registers, and the last call is a tail call") {
+				REQUIRE(disassemble(register_fn->chunk()) ==
+						"INVOKE r1 (less r0 k0)\n"
+						"JMP_F r1 3\n"
+						"RETURN r0\n"
+						"INVOKE r1 (subtract r0 k1)\n"
+						"INVOKE r1 (fib r1)\n"
+						"INVOKE r2 (subtract r0 k2)\n"
+						"INVOKE r2 (fib r2)\n"
+						"TAILCALL (add r1 r2)\n");
+			}
+			THEN("It takes fewer instructions than on the stack machine") {
+				Config stack_config;
+				Compiler stack_compiler(stack_config);
+				compile(read_form(fib, stack_compiler), stack_compiler);
+				vm::VmFunction *stack_fn =
+					stack_compiler.vm.fn_table.find_fn(*stack_compiler.current_package()->intern_symbol("fib"));
+				const std::string stack_code = disassemble(dynamic_cast<BytecodeFunction*>(stack_fn)->chunk());
+				const std::string register_code = disassemble(register_fn->chunk());
+				const auto lines = [](const std::string &code) { return std::count(code.begin(), code.end(), '\n'); };
+				REQUIRE(lines(register_code) * 2 <= lines(stack_code));
+			}
+		}
+
+		WHEN("An if is compiled") {
+			const RegisterChunk chunk = compile_registers(read_form("(if (less 1 2) (add 1 2))", compiler), compiler, false);
+			THEN("Both branches put their value in the same register") {
+				REQUIRE(disassemble(chunk) ==
+						"INVOKE r1 (less k0 k1)\n"
+						"JMP_F r1 4\n"
+						"INVOKE r0 (add k2 k3)\n"
+						"JMP 5\n"
+						"MOVE r0 k4\n"
+						"RETURN r0\n");
+				REQUIRE(std::get<int32_t>(run(chunk, compiler.vm).value()) == 3);
+			}
+		}
+	}
+
+	SCENARIO("Both backends give the same results") {
+		for(const Backend backend : { Backend::STACK, Backend::REGISTER }) {
+			Config config;
+			config.backend = backend;
+			Compiler compiler(config);
+
+			GIVEN((backend == Backend::STACK ? "The stack backend" : "The register backend")) {
+				eval_string("(defn fib [n] (if (less n 2) n (add (fib (subtract n 1)) (fib (subtract n 2)))))", compiler);
+				eval_string("(defn count-up [n acc] (if (greater n 0) (count-up (subtract n 1) (add acc 1)) acc))", compiler);
+				eval_string("(defn depth [n] (if (greater n 0) (add 1 (depth (subtract n 1))) 0))", compiler);
+				eval_string("(defn pick [a b] (if (less a b) (multiply a 2) (if (greater a b) b)))", compiler);
+
+				THEN("Recursive calls work") {
+					REQUIRE(std::get<int32_t>(eval_string("(fib 20)", compiler).value()) == 6765);
+				}
+				THEN("Tail calls run in constant space") {
+					REQUIRE(std::get<int32_t>(eval_string("(count-up 1000000 0)", compiler).value()) == 1000000);
+				}
+				THEN("Deep recursion doesn't use the C++ stack") {
+					REQUIRE(std::get<int32_t>(eval_string("(depth 200000)", compiler).value()) == 200000);
+				}
+				THEN("Nested ifs pick the right value") {
+					REQUIRE(std::get<int32_t>(eval_string("(pick 1 2)", compiler).value()) == 2);
+					REQUIRE(std::get<int32_t>(eval_string("(pick 3 2)", compiler).value()) == 2);
+					REQUIRE(std::holds_alternative<vm::Empty>(eval_string("(pick 2 2)", compiler).value()));
+				}
+				THEN("Float-64 arithmetic works") {
+					REQUIRE(std::get<double>(eval_string("(divide (add 1.5 2.5) 2.0)", compiler).value()) == 2.0);
+				}
+				THEN("Calls with the wrong number of arguments fail") {
+					REQUIRE_THROWS_AS(eval_string("(fib 1 2)", compiler), vm::ArityException);
+				}
+				THEN("Calls to missing functions fail") {
+					REQUIRE_THROWS_AS(eval_string("(frobnicate 1)", compiler), vm::NoSuchFunction);
+				}
+				THEN("Unknown variables aren't compiled") {
+					REQUIRE_THROWS_AS(eval_string("(defn bad [x] y)", compiler), CompileError);
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,91 @@
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+#include <compiler/compiler.hpp>
+#include <compiler/formcache.hpp>
+#include <compiler/parser.hpp>
+
+#include <test/catch.hpp>
+
+namespace salmon::compiler {
+
+	static std::optional<SourceLocations::Location> location_of(const vm::Box &box, Compiler &compiler) {
+		const vm::AllocatedItem *item = std::visit([](auto &&arg) -> const vm::AllocatedItem* {
+			if constexpr (std::is_pointer<std::decay_t<decltype(arg)>>::value) {
+				return arg;
+			} else {
+				return nullptr;
+			}
+		}, box.value());
+		return compiler.source_locations->find(item);
+	}
+
+	SCENARIO("The reader records where forms came from") {
+		Config config;
+		Compiler compiler(config);
+
+		WHEN("Source locations are off") {
+			read_from_string("(a b)", compiler);
+			THEN("Nothing is recorded") {
+				REQUIRE(!compiler.source_locations);
+			}
+		}
+
+		WHEN("Forms are read with source locations on") {
+			compiler.source_locations.emplace();
+			std::istringstream input("(a\n  [b \"c\"])\n{d}");
+			CountingStreamBuffer countStreamBuf(input);
+			ReadForms read = read_all(countStreamBuf, compiler);
+			REQUIRE(read.forms.size() == 2);
+
+			THEN("Each container and string has its start and end") {
+				std::optional<SourceLocations::Location> list = location_of(read.forms[0], compiler);
+				REQUIRE(list.has_value());
+				REQUIRE(list->file == SourceLocations::NO_FILE);
+				REQUIRE(list->start.line == 1);
+				REQUIRE(list->start.column == 0);
+				REQUIRE(list->end.line == 2);
+				REQUIRE(list->end.column == 10);
+
+				vm::List *cell = std::get<vm::List*>(read.forms[0].value());
+				vm::Vector *vector = std::get<vm::Vector*>(cell->next->itm.elem);
+				std::optional<SourceLocations::Location> nested = compiler.source_locations->find(vector);
+				REQUIRE(nested.has_value());
+				REQUIRE(nested->start.line == 2);
+				REQUIRE(nested->start.column == 2);
+
+				std::optional<SourceLocations::Location> set = location_of(read.forms[1], compiler);
+				REQUIRE(set.has_value());
+				REQUIRE(set->start.line == 3);
+			}
+			THEN("Symbols aren't recorded") {
+				REQUIRE(compiler.source_locations->size() == 4);
+			}
+			THEN("Clearing the table forgets the forms") {
+				compiler.source_locations->clear();
+				REQUIRE(!location_of(read.forms[0], compiler).has_value());
+			}
+		}
+
+		WHEN("A file is read with source locations on") {
+			const std::filesystem::path dir = std::filesystem::temp_directory_path() / "salmon-locations-test";
+			std::filesystem::create_directories(dir);
+			const std::filesystem::path source = dir / "source.sal";
+			{
+				std::ofstream out(source);
+				out << "(a b)";
+			}
+			compiler.source_locations.emplace();
+			FormCache cache(dir / "cache");
+			std::optional<ReadForms> read = cache.read_file(source, compiler);
+			THEN("The forms are recorded with the file") {
+				REQUIRE(read.has_value());
+				std::optional<SourceLocations::Location> location = location_of(read->forms[0], compiler);
+				REQUIRE(location.has_value());
+				REQUIRE(compiler.source_locations->file_path(location->file) == source);
+			}
+			std::filesystem::remove_all(dir);
+		}
+	}
+}
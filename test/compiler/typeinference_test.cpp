@@ -0,0 +1,122 @@
+#include <compiler/bytecode.hpp>
+#include <compiler/compiler.hpp>
+#include <compiler/interpreter.hpp>
+#include <compiler/parser.hpp>
+#include <compiler/typeinference.hpp>
+
+#include <test/catch.hpp>
+
+namespace salmon::compiler {
+
+	static InferredTypes infer_string(const std::string &text, Compiler &compiler) {
+		std::optional<vm::Box> form = read_from_string(text, compiler);
+		REQUIRE(form.has_value());
+		return infer_types(*form, compiler);
+	}
+
+	static vm::VmFunction *implementation(const std::string &name, vm::Type *arg_type, Compiler &compiler) {
+		vm::vm_ptr<vm::VmFunction> fn = *compiler.vm.fn_table.get_fn(compiler.vm.base_package().intern_symbol(name));
+		vm::InterfaceFunction *interface = dynamic_cast<vm::InterfaceFunction*>(fn.get());
+		REQUIRE(interface != nullptr);
+		std::vector<vm::Type*> arg_types(std::get<vm::FunctionType>(fn->type()->type).arity(), arg_type);
+		return interface->find_impl(arg_types);
+	}
+
+	SCENARIO("Types are inferred for calls in read forms") {
+		Config config;
+		Compiler compiler(config);
+		vm::Type *int_type = compiler.vm.get_builtin_type<int32_t>().get();
+		vm::Type *double_type = compiler.vm.get_builtin_type<double>().get();
+
+		WHEN("An interface is called with literals") {
+			InferredTypes inferred = infer_string("(add 1 2)", compiler);
+			THEN("The call goes straight to the implementation for their types") {
+				REQUIRE(inferred.errors.empty());
+				REQUIRE(inferred.call_sites.size() == 1);
+				const CallSite &site = inferred.call_sites[0];
+				REQUIRE(site.target != nullptr);
+				REQUIRE(site.target == implementation("add", int_type, compiler));
+				REQUIRE(site.type == site.target->type());
+				REQUIRE(inferred.type == int_type);
+			}
+		}
+
+		WHEN("Calls are nested") {
+			InferredTypes inferred = infer_string("(multiply (add 1.0 2.0) 3.0)", compiler);
+			THEN("The inner result types the outer call") {
+				REQUIRE(inferred.errors.empty());
+				REQUIRE(inferred.call_sites.size() == 2);
+				REQUIRE(inferred.call_sites[0].target == implementation("add", double_type, compiler));
+				REQUIRE(inferred.call_sites[1].target == implementation("multiply", double_type, compiler));
+				REQUIRE(inferred.type == double_type);
+			}
+		}
+
+		WHEN("A variable is passed next to a literal") {
+			InferredTypes inferred = infer_string("(subtract x 1)", compiler);
+			THEN("Unification gives the variable the literal's type") {
+				REQUIRE(inferred.errors.empty());
+				REQUIRE(inferred.call_sites[0].target == implementation("subtract", int_type, compiler));
+			}
+		}
+
+		WHEN("Nothing fixes the argument types") {
+			InferredTypes inferred = infer_string("(add x y)", compiler);
+			THEN("The call is left to dynamic dispatch") {
+				REQUIRE(inferred.errors.empty());
+				REQUIRE(inferred.call_sites[0].target == nullptr);
+				REQUIRE(inferred.call_sites[0].type == nullptr);
+				REQUIRE(inferred.type == nullptr);
+			}
+		}
+
+		WHEN("The result of a defined function is used") {
+			const std::optional<vm::Box> defn = read_from_string("(defn one [x] x)", compiler);
+			REQUIRE(defn.has_value());
+			run(compile(*defn, compiler), compiler.vm);
+			InferredTypes inferred = infer_string("(add 1.5 (one 1))", compiler);
+			THEN("It isn't given the type it is used as") {
+				REQUIRE(inferred.errors.empty());
+				REQUIRE(inferred.call_sites.size() == 2);
+				REQUIRE(inferred.call_sites[0].type == nullptr);
+				REQUIRE(inferred.call_sites[1].target == nullptr);
+			}
+		}
+
+		WHEN("A keyword is printed") {
+			InferredTypes inferred = infer_string("(print :key)", compiler);
+			THEN("The symbol implementation is picked") {
+				vm::Type *symbol_type = compiler.vm.get_builtin_type<vm::Symbol>().get();
+				REQUIRE(inferred.call_sites[0].target == implementation("print", symbol_type, compiler));
+			}
+		}
+
+		WHEN("A call is inside a list that isn't a call") {
+			InferredTypes inferred = infer_string("(not-a-function (add 1 2) 3)", compiler);
+			THEN("It is still found and typed") {
+				REQUIRE(inferred.call_sites.size() == 1);
+				REQUIRE(inferred.call_sites[0].target != nullptr);
+				REQUIRE(inferred.type == nullptr);
+			}
+		}
+
+		WHEN("The argument types disagree") {
+			InferredTypes inferred = infer_string("(add 1 2.0)", compiler);
+			THEN("A type error is reported for the call") {
+				REQUIRE(inferred.errors.size() == 1);
+				REQUIRE(inferred.errors[0].form == inferred.call_sites[0].form);
+				REQUIRE(std::string(inferred.errors[0].what()) ==
+						"Argument 2 of add is a float-64, but a int-32 was expected");
+			}
+		}
+
+		WHEN("A call has the wrong number of arguments") {
+			InferredTypes inferred = infer_string("(add 1)", compiler);
+			THEN("The arity is reported") {
+				REQUIRE(inferred.errors.size() == 1);
+				REQUIRE(std::string(inferred.errors[0].what()) == "add takes 2 arguments, but was given 1");
+				REQUIRE(inferred.call_sites[0].target == nullptr);
+			}
+		}
+	}
+}
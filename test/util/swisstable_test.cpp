@@ -0,0 +1,85 @@
+#include <string>
+#include <map>
+#include <random>
+
+#include <test/catch.hpp>
+#include <util/swisstable.hpp>
+
+namespace salmon {
+
+	SCENARIO("Items can be added to and found in a SwissTable") {
+		SwissTable<std::string, int> table;
+		WHEN("An item is added") {
+			auto [value, inserted] = table.try_emplace("a", 1);
+			THEN("It is reported as new and can be found") {
+				REQUIRE(inserted);
+				REQUIRE(*value == 1);
+				REQUIRE(table.contains("a"));
+				REQUIRE(*table.find("a") == 1);
+				REQUIRE(table.size() == 1);
+			}
+		}
+
+		WHEN("The same key is added twice") {
+			table.try_emplace("a", 1);
+			auto [value, inserted] = table.try_emplace("a", 2);
+			THEN("The original value is kept") {
+				REQUIRE_FALSE(inserted);
+				REQUIRE(*value == 1);
+				REQUIRE(table.size() == 1);
+			}
+		}
+
+		WHEN("A missing key is looked up") {
+			table.try_emplace("a", 1);
+			THEN("It isn't found") {
+				REQUIRE(table.find("b") == nullptr);
+				REQUIRE_FALSE(table.contains("b"));
+			}
+		}
+
+		WHEN("The table is cleared") {
+			for(int i = 0; i < 100; i++) {
+				table.try_emplace(std::to_string(i), i);
+			}
+			table.clear();
+			THEN("It is empty and can be filled again") {
+				REQUIRE(table.empty());
+				REQUIRE_FALSE(table.contains("1"));
+				REQUIRE(table.begin() == table.end());
+				table.try_emplace("1", 2);
+				REQUIRE(*table.find("1") == 2);
+			}
+		}
+	}
+
+	SCENARIO("A SwissTable agrees with std::map under many operations") {
+		SwissTable<int, int> table;
+		std::map<int, int> expected;
+		std::mt19937 random(7);
+		std::uniform_int_distribution<int> keys(0, 5000);
+
+		WHEN("Items are inserted and erased at random") {
+			for(int i = 0; i < 100'000; i++) {
+				const int key = keys(random);
+				if(i % 3 == 0) {
+					REQUIRE(table.erase(key) == (expected.erase(key) == 1));
+				} else {
+					REQUIRE(table.try_emplace(key, i).second == expected.try_emplace(key, i).second);
+				}
+			}
+			THEN("They hold the same items") {
+				REQUIRE(table.size() == expected.size());
+				size_t visited = 0;
+				for(const auto &[key, value] : table) {
+					REQUIRE(expected.at(key) == value);
+					visited++;
+				}
+				REQUIRE(visited == expected.size());
+				for(int key = 0; key <= 5000; key++) {
+					REQUIRE(table.contains(key) == expected.contains(key));
+				}
+			}
+		}
+	}
+}
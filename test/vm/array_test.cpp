@@ -52,5 +52,21 @@ namespace salmon::vm {
 				REQUIRE(second > first);
 			}
 		}
+
+		WHEN("[1 2] and [1 3] are compared") {
+			Box one = vm.make_boxed(1);
+			Box two = vm.make_boxed(2);
+			Box three = vm.make_boxed(3);
+			Vector first(2);
+			first.push_back(one);
+			first.push_back(two);
+			Vector second(2);
+			second.push_back(one);
+			second.push_back(three);
+			THEN("Arrays of the same length are compared item by item") {
+				REQUIRE(first < second);
+				REQUIRE(first != second);
+			}
+		}
 	}
 }
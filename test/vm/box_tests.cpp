@@ -77,4 +77,65 @@ namespace salmon::vm {
 			}
 		}
 	}
+
+	SCENARIO( "InternalBoxes are hashed structurally", "[box, vm]") {
+
+		WHEN("Two boxes holding equal lists are hashed") {
+			Box one(1, type);
+			Box two(2, type);
+			List first(one);
+			List first_tail(two);
+			first.next = &first_tail;
+			List second(one);
+			List second_tail(two);
+			second.next = &second_tail;
+			InternalBox lhs = { type.get(), &first };
+			InternalBox rhs = { type.get(), &second };
+			THEN("They are equal and have the same hash") {
+				REQUIRE(lhs == rhs);
+				REQUIRE(hash_value(lhs) == hash_value(rhs));
+			}
+		}
+
+		WHEN("A list and its nested version are hashed") {
+			Box one(1, type);
+			Box two(2, type);
+			// ((1 2))
+			List inner(one);
+			List inner_tail(two);
+			inner.next = &inner_tail;
+			List outer(one);
+			outer.itm = { type.get(), &inner };
+			// ((1) 2)
+			List nested(one);
+			List nested_outer(one);
+			nested_outer.itm = { type.get(), &nested };
+			List nested_tail(two);
+			nested_outer.next = &nested_tail;
+
+			InternalBox lhs = { type.get(), &outer };
+			InternalBox rhs = { type.get(), &nested_outer };
+			THEN("They are not equal and have different hashes") {
+				REQUIRE(lhs != rhs);
+				REQUIRE(hash_value(lhs) != hash_value(rhs));
+			}
+		}
+
+		WHEN("0.0 and -0.0 are hashed") {
+			InternalBox zero = { type.get(), 0.0 };
+			InternalBox negative_zero = { type.get(), -0.0 };
+			THEN("They are equal and have the same hash") {
+				REQUIRE(zero == negative_zero);
+				REQUIRE(hash_value(zero) == hash_value(negative_zero));
+			}
+		}
+
+		WHEN("Boxes holding different kinds of values are compared") {
+			InternalBox integer = { type.get(), 1 };
+			InternalBox boolean = { type.get(), true };
+			THEN("They are not equal") {
+				REQUIRE(integer != boolean);
+			}
+		}
+	}
 }
@@ -0,0 +1,74 @@
+#include <vm/vm.hpp>
+#include <vm/box.hpp>
+#include <vm/hashset.hpp>
+
+#include <test/catch.hpp>
+
+namespace salmon::vm {
+
+	SCENARIO("Items can be added to a HashSet") {
+		Config fakeConfig;
+		VirtualMachine vm(fakeConfig, "set-test");
+		MemoryManager &manager = vm.mem_manager;
+		vm_ptr<HashSet> set = manager.allocate_obj<HashSet>(0);
+
+		WHEN("The same number is added twice") {
+			REQUIRE(set->insert(vm.make_boxed(1)));
+			THEN("It is only stored once") {
+				REQUIRE_FALSE(set->insert(vm.make_boxed(1)));
+				REQUIRE(set->size() == 1);
+			}
+		}
+
+		WHEN("Two structurally equal lists are added") {
+			vm_ptr<List> first = manager.allocate_list({ vm.make_boxed(1), vm.make_boxed(2) });
+			vm_ptr<List> second = manager.allocate_list({ vm.make_boxed(1), vm.make_boxed(2) });
+			set->insert(vm.make_boxed(first));
+			THEN("The second one is found in the set") {
+				REQUIRE(set->contains(vm.make_boxed(second).bare()));
+				REQUIRE_FALSE(set->insert(vm.make_boxed(second)));
+			}
+		}
+
+		WHEN("The set is the only thing referencing its items") {
+			{
+				vm_ptr<List> list = manager.allocate_list({ vm.make_boxed(1), vm.make_boxed(2) });
+				set->insert(vm.make_boxed(list));
+			}
+			manager.do_gc();
+			THEN("The items survive garbage collection") {
+				vm_ptr<List> other = manager.allocate_list({ vm.make_boxed(1), vm.make_boxed(2) });
+				REQUIRE(set->contains(vm.make_boxed(other).bare()));
+			}
+		}
+	}
+
+	SCENARIO("HashSets are compared structurally") {
+		Config fakeConfig;
+		VirtualMachine vm(fakeConfig, "set-test");
+		MemoryManager &manager = vm.mem_manager;
+		vm_ptr<HashSet> first = manager.allocate_obj<HashSet>(2);
+		vm_ptr<HashSet> second = manager.allocate_obj<HashSet>(2);
+
+		WHEN("Two sets hold the same items") {
+			first->insert(vm.make_boxed(1));
+			first->insert(vm.make_boxed(2));
+			second->insert(vm.make_boxed(2));
+			second->insert(vm.make_boxed(1));
+			THEN("They are equal and hash the same") {
+				REQUIRE(*first == *second);
+				REQUIRE(vm.make_boxed(first).hash() == vm.make_boxed(second).hash());
+			}
+		}
+
+		WHEN("Two sets of the same size hold different items") {
+			first->insert(vm.make_boxed(1));
+			second->insert(vm.make_boxed(2));
+			THEN("They are neither equal nor ordered") {
+				REQUIRE(*first != *second);
+				REQUIRE_FALSE(*first < *second);
+				REQUIRE_FALSE(*first > *second);
+			}
+		}
+	}
+}
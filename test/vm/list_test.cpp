@@ -81,4 +81,89 @@ namespace salmon::vm {
 			}
 		}
 	}
+
+	SCENARIO("Lists are allocated from the cons arena") {
+		Config fakeConfig;
+		VirtualMachine vm(fakeConfig, "list-test");
+		MemoryManager &manager = vm.mem_manager;
+
+		WHEN("A list is allocated in one go") {
+			std::vector<Box> items;
+			for(int32_t i = 0; i < 100; i++) {
+				items.push_back(vm.make_boxed(i));
+			}
+			vm_ptr<List> list = manager.allocate_list(items);
+			THEN("Its cells hold the items in order") {
+				int32_t expected = 0;
+				for(List *cell = list.get(); cell != nullptr; cell = cell->next) {
+					REQUIRE(std::get<int32_t>(cell->itm.elem) == expected);
+					expected++;
+				}
+				REQUIRE(expected == 100);
+			}
+			THEN("Its cells are next to each other") {
+				for(List *cell = list.get(); cell->next != nullptr; cell = cell->next) {
+					REQUIRE(cell->next == cell + 1);
+				}
+			}
+			THEN("It survives garbage collection while referenced") {
+				manager.do_gc();
+				int32_t count = 0;
+				for(List *cell = list.get(); cell != nullptr; cell = cell->next) {
+					REQUIRE(std::get<int32_t>(cell->itm.elem) == count);
+					count++;
+				}
+				REQUIRE(count == 100);
+			}
+		}
+
+		WHEN("An unreferenced list is collected") {
+			List *old_head;
+			{
+				vm_ptr<List> list = manager.allocate_list({ vm.make_boxed(1), vm.make_boxed(2) });
+				old_head = list.get();
+			}
+			manager.do_gc();
+			THEN("Its cells are handed out again") {
+				vm_ptr<List> first = manager.allocate_obj<List>(vm.make_boxed(3));
+				vm_ptr<List> second = manager.allocate_obj<List>(vm.make_boxed(4));
+				REQUIRE(first.get() == old_head);
+				REQUIRE(second.get() == old_head + 1);
+			}
+		}
+	}
+
+	SCENARIO("Large lists are compared without recursion") {
+		Config fakeConfig;
+		VirtualMachine vm(fakeConfig, "list-test");
+		MemoryManager &manager = vm.mem_manager;
+		constexpr int32_t length = 1'000'000;
+
+		WHEN("Two long lists that differ at the end are compared") {
+			std::vector<Box> items;
+			for(int32_t i = 0; i < length; i++) {
+				items.push_back(vm.make_boxed(i));
+			}
+			vm_ptr<List> first = manager.allocate_list(items);
+			items.back() = vm.make_boxed(length);
+			vm_ptr<List> second = manager.allocate_list(items);
+			THEN("The difference is found") {
+				REQUIRE(*first < *second);
+				REQUIRE(*first != *second);
+			}
+		}
+
+		WHEN("Two deeply nested lists are compared") {
+			vm_ptr<List> first = manager.allocate_list({ vm.make_boxed(0) });
+			vm_ptr<List> second = manager.allocate_list({ vm.make_boxed(0) });
+			for(int32_t i = 0; i < length; i++) {
+				first = manager.allocate_list({ vm.make_boxed(first) });
+				second = manager.allocate_list({ vm.make_boxed(second) });
+			}
+			THEN("They are equal and hash the same") {
+				REQUIRE(*first == *second);
+				REQUIRE(vm.make_boxed(first).hash() == vm.make_boxed(second).hash());
+			}
+		}
+	}
 }
@@ -102,6 +102,53 @@ namespace salmon::vm {
 		manager.do_gc();
 	}
 
+	SCENARIO( "Interned symbols get dense ids", "[package]") {
+		GIVEN( "A package with no symbols") {
+			Package package("ids", manager);
+			SymbolIndex &index = manager.symbol_index();
+
+			WHEN( "Two symbols are interned") {
+				const uint32_t first_id = index.next_id();
+				vm_ptr<Symbol> foo = package.intern_symbol("foo");
+				vm_ptr<Symbol> bar = package.intern_symbol("bar");
+
+				THEN( "They get consecutive ids") {
+					REQUIRE(foo->indexed());
+					REQUIRE(foo->id == first_id);
+					REQUIRE(bar->id == first_id + 1);
+				}
+				THEN( "They can be found in the index") {
+					REQUIRE(index[foo->id] == foo.get());
+					REQUIRE(index[bar->id] == bar.get());
+				}
+				THEN( "Interning a symbol again doesn't use a new id") {
+					vm_ptr<Symbol> other = package.intern_symbol("foo");
+					REQUIRE(other->id == foo->id);
+					REQUIRE(index.next_id() == first_id + 2);
+				}
+			}
+		}
+		GIVEN( "An uninterned symbol") {
+			vm_ptr<Symbol> symb = manager.allocate_obj<Symbol>("uninterned");
+			THEN( "It isn't in the index") {
+				REQUIRE(!symb->indexed());
+			}
+		}
+		manager.do_gc();
+	}
+
+	SCENARIO( "Symbols are removed from the index with their package", "[package]") {
+		SymbolIndex &index = manager.symbol_index();
+		uint32_t id;
+		{
+			Package package("temporary", manager);
+			id = package.intern_symbol("foo")->id;
+			REQUIRE(index[id] != nullptr);
+		}
+		REQUIRE(index[id] == nullptr);
+		manager.do_gc();
+	}
+
 	SCENARIO( "Searching for symbols", "[vm, package]") {
 		Package parent("parent", manager);
 		GIVEN( "A package with no symbols") {
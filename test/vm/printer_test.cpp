@@ -0,0 +1,136 @@
+#include <array>
+#include <iostream>
+#include <sstream>
+
+#include <vm/vm.hpp>
+#include <vm/box.hpp>
+#include <vm/hashset.hpp>
+#include <vm/printer.hpp>
+
+#include <test/catch.hpp>
+
+namespace salmon::vm {
+
+	static std::string print_to_string(VirtualMachine &vm, const Box &value) {
+		std::ostringstream out;
+		Printer printer(vm, out);
+		printer.print(value.bare());
+		printer.flush();
+		return out.str();
+	}
+
+	SCENARIO("Values are printed in their readable form") {
+		Config fakeConfig;
+		VirtualMachine vm(fakeConfig, "printer-test");
+		MemoryManager &manager = vm.mem_manager;
+		Package &package = vm.base_package();
+
+		WHEN("Scalars are printed") {
+			THEN("Numbers, strings and symbols are written out") {
+				REQUIRE(print_to_string(vm, vm.make_boxed(-42)) == "-42");
+				REQUIRE(print_to_string(vm, vm.make_boxed(2.5)) == "2.5");
+				REQUIRE(print_to_string(vm, vm.make_boxed(0.1)) == "0.1");
+				REQUIRE(print_to_string(vm, vm.make_boxed(Empty{})) == "Empty");
+				REQUIRE(print_to_string(vm, vm.make_boxed(manager.allocate_obj<StaticString>(std::string("hi")))) == "\"hi\"");
+				REQUIRE(print_to_string(vm, vm.make_boxed(package.intern_symbol("foo"))) == "printer-test::foo");
+				REQUIRE(print_to_string(vm, vm.make_boxed(manager.allocate_obj<Symbol>(std::string("bar")))) == "#:bar");
+			}
+		}
+
+		WHEN("Nested containers are printed") {
+			vm_ptr<Vector> vector = manager.allocate_obj<Vector>(2);
+			vector->push_back(vm.make_boxed(1));
+			vector->push_back(vm.make_boxed(manager.allocate_list({ vm.make_boxed(2), vm.make_boxed(3) })));
+			vm_ptr<HashSet> set = manager.allocate_obj<HashSet>(1);
+			set->insert(vm.make_boxed(4));
+			Box value = vm.make_boxed(manager.allocate_list({
+				vm.make_boxed(vector), vm.make_boxed(manager.allocate_obj<Vector>(0)), vm.make_boxed(set)
+			}));
+			THEN("Items are separated by spaces inside their brackets") {
+				REQUIRE(print_to_string(vm, value) == "([1 (2 3)] [] {4})");
+			}
+		}
+
+		WHEN("A very deeply nested list is printed") {
+			constexpr int depth = 1'000'000;
+			vm_ptr<List> list = manager.allocate_list({ vm.make_boxed(0) });
+			for(int i = 0; i < depth; i++) {
+				list = manager.allocate_list({ vm.make_boxed(list) });
+			}
+			const std::string printed = print_to_string(vm, vm.make_boxed(list));
+			THEN("It doesn't run out of stack") {
+				REQUIRE(printed.size() == 2 * (depth + 1) + 1);
+				REQUIRE(printed.substr(depth - 1, 5) == "((0))");
+			}
+		}
+
+		WHEN("A value bigger than the buffer is printed") {
+			constexpr size_t length = 100'000;
+			vm_ptr<Vector> vector = manager.allocate_obj<Vector>(length);
+			for(size_t i = 0; i < length; i++) {
+				vector->push_back(vm.make_boxed(static_cast<int32_t>(i)));
+			}
+			std::ostringstream out;
+			Printer printer(vm, out);
+			printer.print(vm.make_boxed(vector).bare());
+			const size_t written = out.str().size();
+			printer.flush();
+			THEN("It is written out in pieces while it is printed") {
+				REQUIRE(written >= 64 * 1024);
+				REQUIRE(written < out.str().size());
+			}
+		}
+
+		WHEN("Values are printed through the print interface") {
+			std::ostringstream out;
+			vm.printer.output(out);
+			vm_ptr<VmFunction> print_fn = *vm.fn_table.get_fn(vm.base_package().intern_symbol("print"));
+			std::array<InternalBox, 1> args = { vm.make_boxed(1).bare() };
+			(*print_fn)(&vm, std::span<InternalBox, 1>(args));
+			(*print_fn)(&vm, std::span<InternalBox, 1>(args));
+			const std::string before_flush = out.str();
+			vm.printer.flush();
+			vm.printer.output(std::cout);
+			THEN("They stay in the buffer until it is flushed") {
+				REQUIRE(before_flush.empty());
+				REQUIRE(out.str() == "11");
+			}
+		}
+
+		WHEN("The output stream is changed") {
+			std::ostringstream first;
+			std::ostringstream second;
+			Printer printer(vm, first);
+			printer.print(vm.make_boxed(1).bare());
+			printer.output(second);
+			printer.print(vm.make_boxed(2).bare());
+			printer.flush();
+			THEN("What was printed before goes to the old stream") {
+				REQUIRE(first.str() == "1");
+				REQUIRE(second.str() == "2");
+				REQUIRE(&printer.output() == &second);
+			}
+		}
+
+		WHEN("The VM is interrupted while a value is printed") {
+			vm_ptr<List> list = manager.allocate_list({ vm.make_boxed(1), vm.make_boxed(2) });
+			std::ostringstream out;
+			Printer printer(vm, out);
+			vm.interrupt();
+			THEN("Printing stops at the next item") {
+				REQUIRE_THROWS_AS(printer.print(vm.make_boxed(list).bare()), Interrupted);
+				REQUIRE(out.str() == "(");
+			}
+			THEN("The interrupt is only acted on once") {
+				REQUIRE_THROWS_AS(printer.print(vm.make_boxed(list).bare()), Interrupted);
+				printer.print(vm.make_boxed(list).bare());
+				printer.flush();
+				REQUIRE(out.str() == "((1 2)");
+			}
+			THEN("A cleared interrupt isn't acted on") {
+				vm.clear_interrupt();
+				REQUIRE(print_to_string(vm, vm.make_boxed(list)) == "(1 2)");
+			}
+		}
+	}
+}
@@ -0,0 +1,212 @@
+#include <vm/vm.hpp>
+#include <vm/box.hpp>
+#include <vm/hashset.hpp>
+#include <vm/serialize.hpp>
+
+#include <sstream>
+
+#include <test/catch.hpp>
+
+namespace salmon::vm {
+
+	SCENARIO("Values survive a round trip through the binary format") {
+		Config fakeConfig;
+		VirtualMachine vm(fakeConfig, "serialize-test");
+		MemoryManager &manager = vm.mem_manager;
+		Package &package = vm.base_package();
+
+		WHEN("Scalars and symbols are written and read back") {
+			vm_ptr<Symbol> foo = package.intern_symbol("foo");
+			std::vector<Box> values = {
+				vm.make_boxed(42), vm.make_boxed(-1.5), vm.make_boxed(true),
+				vm.make_boxed(Empty{}), vm.make_boxed(foo),
+				vm.make_boxed(manager.allocate_obj<StaticString>(std::string("a string")))
+			};
+			std::vector<std::byte> data = serialize::write_values(values);
+			std::optional<std::vector<Box>> read = serialize::read_values(data, vm);
+			THEN("The same values are read") {
+				REQUIRE(read.has_value());
+				REQUIRE(*read == values);
+			}
+			THEN("Symbols are interned again instead of copied") {
+				REQUIRE(std::get<Symbol*>((*read)[4].value()) == foo.get());
+			}
+			THEN("Items get the builtin type of what they hold") {
+				REQUIRE((*read)[0].elem_type() == vm.get_builtin_type<int32_t>());
+				REQUIRE((*read)[5].elem_type() == vm.get_builtin_type<StaticString>());
+			}
+		}
+
+		WHEN("Nested containers are written and read back") {
+			vm_ptr<Vector> vector = manager.allocate_obj<Vector>(2);
+			vector->push_back(vm.make_boxed(1));
+			vector->push_back(vm.make_boxed(manager.allocate_list({ vm.make_boxed(2), vm.make_boxed(3) })));
+			vm_ptr<HashSet> set = manager.allocate_obj<HashSet>(2);
+			set->insert(vm.make_boxed(vector));
+			set->insert(vm.make_boxed(4));
+			std::vector<Box> values = {
+				vm.make_boxed(manager.allocate_list({ vm.make_boxed(set), vm.make_boxed(vector) }))
+			};
+			std::vector<std::byte> data = serialize::write_values(values);
+			std::optional<std::vector<Box>> read = serialize::read_values(data, vm);
+			THEN("A structurally equal value is read") {
+				REQUIRE(read.has_value());
+				REQUIRE(read->size() == 1);
+				REQUIRE((*read)[0] == values[0]);
+				REQUIRE((*read)[0].hash() == values[0].hash());
+			}
+		}
+
+		WHEN("Truncated or corrupted data is read") {
+			std::vector<Box> values = {
+				vm.make_boxed(manager.allocate_list({ vm.make_boxed(1), vm.make_boxed(2) }))
+			};
+			std::vector<std::byte> data = serialize::write_values(values);
+			THEN("It is rejected") {
+				for(size_t size = 0; size < data.size(); size++) {
+					REQUIRE_FALSE(serialize::read_values(std::span(data.data(), size), vm).has_value());
+				}
+				data[0] = std::byte{'X'};
+				REQUIRE_FALSE(serialize::read_values(data, vm).has_value());
+			}
+		}
+	}
+
+	SCENARIO("Shared and cyclic values keep their shape through the binary format") {
+		Config fakeConfig;
+		VirtualMachine vm(fakeConfig, "serialize-test");
+		MemoryManager &manager = vm.mem_manager;
+
+		WHEN("A vector appears twice in a value") {
+			vm_ptr<Vector> shared = manager.allocate_obj<Vector>(1);
+			shared->push_back(vm.make_boxed(1));
+			std::vector<Box> values = {
+				vm.make_boxed(manager.allocate_list({ vm.make_boxed(shared), vm.make_boxed(shared) }))
+			};
+			std::optional<std::vector<Box>> read = serialize::read_values(serialize::write_values(values), vm);
+			THEN("Both items are the same vector when read back") {
+				REQUIRE(read.has_value());
+				REQUIRE((*read)[0] == values[0]);
+				List *list = std::get<List*>((*read)[0].value());
+				REQUIRE(std::get<Vector*>(list->itm.elem) == std::get<Vector*>(list->next->itm.elem));
+				REQUIRE(std::get<Vector*>(list->itm.elem) != shared.get());
+			}
+		}
+
+		WHEN("Two lists share a tail") {
+			vm_ptr<List> tail = manager.allocate_list({ vm.make_boxed(2), vm.make_boxed(3) });
+			vm_ptr<List> list = manager.allocate_list({ vm.make_boxed(1) });
+			list->next = tail.get();
+			vm_ptr<Vector> both = manager.allocate_obj<Vector>(2);
+			both->push_back(vm.make_boxed(list));
+			both->push_back(vm.make_boxed(manager.make_vm_ptr(tail->next)));
+			std::vector<Box> values = { vm.make_boxed(both) };
+			std::optional<std::vector<Box>> read = serialize::read_values(serialize::write_values(values), vm);
+			THEN("The tail is shared when read back") {
+				REQUIRE(read.has_value());
+				REQUIRE((*read)[0] == values[0]);
+				Vector *vector = std::get<Vector*>((*read)[0].value());
+				List *read_list = std::get<List*>((*vector)[0].elem);
+				REQUIRE(read_list->next->next == std::get<List*>((*vector)[1].elem));
+			}
+		}
+
+		WHEN("A vector holds itself") {
+			vm_ptr<Vector> vector = manager.allocate_obj<Vector>(2);
+			vector->push_back(vm.make_boxed(1));
+			vector->push_back(vm.make_boxed(vector));
+			std::vector<Box> values = { vm.make_boxed(vector) };
+			std::optional<std::vector<Box>> read = serialize::read_values(serialize::write_values(values), vm);
+			THEN("The vector read back holds itself") {
+				REQUIRE(read.has_value());
+				Vector *read_vector = std::get<Vector*>((*read)[0].value());
+				REQUIRE(read_vector->size() == 2);
+				REQUIRE(std::get<int32_t>((*read_vector)[0].elem) == 1);
+				REQUIRE(std::get<Vector*>((*read_vector)[1].elem) == read_vector);
+			}
+		}
+
+		WHEN("A list holds a vector that holds the list") {
+			vm_ptr<Vector> vector = manager.allocate_obj<Vector>(1);
+			vm_ptr<List> list = manager.allocate_list({ vm.make_boxed(vector), vm.make_boxed(2) });
+			vector->push_back(vm.make_boxed(list));
+			std::vector<Box> values = { vm.make_boxed(list) };
+			std::optional<std::vector<Box>> read = serialize::read_values(serialize::write_values(values), vm);
+			THEN("The cycle is kept") {
+				REQUIRE(read.has_value());
+				List *read_list = std::get<List*>((*read)[0].value());
+				Vector *read_vector = std::get<Vector*>(read_list->itm.elem);
+				REQUIRE(std::get<List*>((*read_vector)[0].elem) == read_list);
+				REQUIRE(std::get<int32_t>(read_list->next->itm.elem) == 2);
+				REQUIRE(read_list->next->next == nullptr);
+			}
+		}
+	}
+
+	SCENARIO("Values can be streamed out and viewed in place") {
+		Config fakeConfig;
+		VirtualMachine vm(fakeConfig, "serialize-test");
+		MemoryManager &manager = vm.mem_manager;
+		Package &package = vm.base_package();
+
+		vm_ptr<Vector> shared = manager.allocate_obj<Vector>(1);
+		shared->push_back(vm.make_boxed(manager.allocate_obj<StaticString>(std::string("text"))));
+		std::vector<Box> values = {
+			vm.make_boxed(package.intern_symbol("name")),
+			vm.make_boxed(manager.allocate_list({
+				vm.make_boxed(shared), vm.make_boxed(manager.allocate_list({ vm.make_boxed(shared) }))
+			}))
+		};
+
+		WHEN("The values are written with a Writer") {
+			std::ostringstream out;
+			serialize::Writer writer(out);
+			for(const Box &value : values) {
+				writer.write(value);
+			}
+			const std::string written = out.str();
+			writer.finish();
+			const std::string finished = out.str();
+			THEN("They can be read back once the writer is finished") {
+				auto read = serialize::read_values(std::as_bytes(std::span(finished.data(), finished.size())), vm);
+				REQUIRE(read.has_value());
+				REQUIRE(*read == values);
+				REQUIRE_FALSE(serialize::read_values(std::as_bytes(std::span(written.data(), written.size())), vm));
+			}
+		}
+
+		WHEN("The values are opened as an archive") {
+			const std::vector<std::byte> data = serialize::write_values(values);
+			std::optional<serialize::Archive> archive = serialize::Archive::open(data);
+			REQUIRE(archive.has_value());
+			REQUIRE(archive->size() == 2);
+
+			THEN("They can be looked at without decoding them") {
+				serialize::View symbol = (*archive)[0];
+				REQUIRE(symbol.kind() == serialize::View::Kind::SYMBOL);
+				REQUIRE(symbol.string() == "name");
+				REQUIRE(symbol.package() == "serialize-test");
+
+				serialize::View list = (*archive)[1];
+				REQUIRE(list.kind() == serialize::View::Kind::LIST);
+				REQUIRE(list.size() == 2);
+				std::vector<serialize::View> items = list.items();
+				REQUIRE(items[0].kind() == serialize::View::Kind::VECTOR);
+				serialize::View text = items[0].items()[0];
+				REQUIRE(text.string() == "text");
+				const auto *start = reinterpret_cast<const char*>(data.data());
+				REQUIRE(text.string().data() > start);
+				REQUIRE(text.string().data() < start + data.size());
+			}
+
+			THEN("Part of a value can be decoded by itself") {
+				// The inner list refers to the vector defined before it
+				serialize::View inner = (*archive)[1].items()[1];
+				REQUIRE(inner.items()[0].kind() == serialize::View::Kind::VECTOR);
+				std::optional<Box> decoded = inner.materialize(vm);
+				REQUIRE(decoded.has_value());
+				REQUIRE(*decoded == vm.make_boxed(manager.allocate_list({ vm.make_boxed(shared) })));
+			}
+		}
+	}
+}
@@ -0,0 +1,59 @@
+#include <test/catch.hpp>
+
+#include <vm/memory.hpp>
+#include <vm/package.hpp>
+#include <vm/symbolmap.hpp>
+
+namespace salmon::vm {
+
+	SCENARIO("Symbols are looked up in a SymbolMap", "[vm]") {
+		MemoryManager manager;
+		Package package("symbol-map", manager);
+		vm_ptr<Symbol> foo = package.intern_symbol("foo");
+		vm_ptr<Symbol> bar = package.intern_symbol("bar");
+		vm_ptr<Symbol> uninterned = manager.allocate_obj<Symbol>("foo");
+
+		MemoryManager other_manager;
+		Package other_package("other", other_manager);
+		vm_ptr<Symbol> other = other_package.intern_symbol("foo");
+
+		SymbolMap<int> map;
+
+		WHEN("Nothing has been added") {
+			THEN("No symbols are found") {
+				REQUIRE(map.find(*foo) == nullptr);
+				REQUIRE(map.find(*uninterned) == nullptr);
+				REQUIRE(map.size() == 0);
+			}
+		}
+
+		WHEN("An interned and uninterned symbol are added") {
+			REQUIRE(map.try_emplace(foo, 1).second);
+			REQUIRE(map.try_emplace(uninterned, 2).second);
+
+			THEN("Both can be found") {
+				REQUIRE(map.contains(*foo));
+				REQUIRE(*map.find(*foo) == 1);
+				REQUIRE(*map.find(*uninterned) == 2);
+				REQUIRE(map.size() == 2);
+			}
+			THEN("Symbols that weren't added aren't found") {
+				REQUIRE(!map.contains(*bar));
+			}
+			THEN("Adding the same symbol again keeps the old value") {
+				auto [value, added] = map.try_emplace(foo, 3);
+				REQUIRE(!added);
+				REQUIRE(*value == 1);
+			}
+		}
+
+		WHEN("A symbol from another VM has the same id") {
+			REQUIRE(map.try_emplace(other, 1).second);
+
+			THEN("It isn't confused with the added symbol") {
+				REQUIRE(other->id == foo->id);
+				REQUIRE(map.find(*foo) == nullptr);
+			}
+		}
+	}
+}
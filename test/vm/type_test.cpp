@@ -56,4 +56,41 @@ namespace salmon::vm {
 		}
 	}
 
+	SCENARIO("The type table remembers which function types match") {
+		TypeTable table(manager);
+		auto int_type = table.make_primitive(a_symb, "Some doc", sizeof(int));
+		vm_ptr<Symbol> param = base_package.intern_symbol("param");
+
+		SpecBuilder generic;
+		generic.add_parameter(param);
+		SpecBuilder concrete;
+		concrete.add_type(int_type);
+		auto generic_fn = table.get_fn_type(generic.build(), generic.build());
+		auto concrete_fn = table.get_fn_type(concrete.build(), concrete.build());
+
+		WHEN("Two function types are checked more than once") {
+			const bool first = table.fn_match(generic_fn.get(), concrete_fn.get());
+			const bool second = table.fn_match(generic_fn.get(), concrete_fn.get());
+			THEN("The answer is the same as matching them directly") {
+				const bool direct = std::get<FunctionType>(generic_fn->type)
+					.match(std::get<FunctionType>(concrete_fn->type));
+				REQUIRE(first == direct);
+				REQUIRE(second == direct);
+				REQUIRE(!table.fn_match(concrete_fn.get(), generic_fn.get()));
+			}
+		}
+
+		WHEN("Function types are compared for equivalence") {
+			vm_ptr<Symbol> other_param = base_package.intern_symbol("other-param");
+			SpecBuilder renamed;
+			renamed.add_parameter(other_param);
+			auto renamed_fn = table.get_fn_type(renamed.build(), renamed.build());
+			THEN("It doesn't depend on the order they are given in") {
+				REQUIRE(table.equivalent(generic_fn.get(), renamed_fn.get()));
+				REQUIRE(table.equivalent(renamed_fn.get(), generic_fn.get()));
+				REQUIRE(!table.equivalent(concrete_fn.get(), generic_fn.get()));
+				REQUIRE(!table.equivalent(generic_fn.get(), concrete_fn.get()));
+			}
+		}
+	}
 }
@@ -457,4 +457,112 @@ namespace salmon::vm {
 			}
 		}
 	}
+
+	SCENARIO("TypeSpecifications number their parameters by where they first appear") {
+		MemoryManager manager;
+		Package base_package("test", manager);
+		vm_ptr<Symbol> f32_name_symb = base_package.intern_symbol("float-32");
+		vm_ptr<Symbol> i32_name_symb = base_package.intern_symbol("int-32");
+		PrimitiveType ptype(f32_name_symb, "documentation", sizeof(float));
+		PrimitiveType p_i32(i32_name_symb, "documentation", sizeof(int));
+		auto f32_type = manager.allocate_obj<Type>(ptype);
+		auto i32_type = manager.allocate_obj<Type>(p_i32);
+
+		vm_ptr<Symbol> a_symb = base_package.intern_symbol("a");
+		vm_ptr<Symbol> b_symb = base_package.intern_symbol("b");
+
+		SpecBuilder builder;
+		builder.add_parameter(b_symb);
+		builder.add_type(f32_type);
+		builder.add_parameter(a_symb);
+		builder.add_parameter(b_symb);
+		TypeSpecification spec = builder.build();
+
+		THEN("The parameters are listed in order") {
+			REQUIRE(spec.parameter_count() == 2);
+			REQUIRE(spec.parameter(0) == b_symb.get());
+			REQUIRE(spec.parameter_position(0) == 0);
+			REQUIRE(spec.parameter(1) == a_symb.get());
+			REQUIRE(spec.parameter_position(1) == 2);
+			REQUIRE(spec.type_at(1) == f32_type.get());
+			REQUIRE(spec.type_at(0) == nullptr);
+		}
+
+		WHEN("The same shape is built with the names swapped") {
+			SpecBuilder other;
+			other.add_parameter(a_symb);
+			other.add_type(f32_type);
+			other.add_parameter(b_symb);
+			other.add_parameter(a_symb);
+			TypeSpecification renamed = other.build();
+			THEN("They are equivalent, hash the same, and match each other") {
+				REQUIRE(renamed.equivalentTo(spec));
+				REQUIRE(renamed.hash() == spec.hash());
+				REQUIRE(renamed.matches(spec));
+				REQUIRE(spec.matches(renamed));
+			}
+			THEN("They are ordered one way or the other") {
+				REQUIRE(renamed != spec);
+				REQUIRE((renamed < spec) != (spec < renamed));
+				REQUIRE((renamed < spec) == (spec > renamed));
+			}
+		}
+
+		WHEN("A spec is too long to be stored inline") {
+			SpecBuilder long_builder;
+			for(int i = 0; i < 32; i++) {
+				long_builder.add_type(i % 2 ? f32_type : i32_type);
+				long_builder.add_parameter(i % 3 ? a_symb : b_symb);
+			}
+			TypeSpecification long_spec = long_builder.build();
+			TypeSpecification copy(long_spec);
+			TypeSpecification moved(std::move(copy));
+			THEN("Copies and moves are the same spec") {
+				REQUIRE(moved == long_spec);
+				REQUIRE(moved.size() == 64);
+				REQUIRE(moved.parameter_count() == 2);
+			}
+			THEN("Combining it keeps every element") {
+				TypeSpecification combined = TypeSpecification::combine(spec, long_spec);
+				REQUIRE(combined.size() == 68);
+				REQUIRE(combined.parameter_count() == 2);
+				REQUIRE(combined.parameter_position(0) == 0);
+			}
+		}
+	}
+
+	SCENARIO("Function types match lists of return and argument types") {
+		MemoryManager manager;
+		Package base_package("test", manager);
+		vm_ptr<Symbol> f32_name_symb = base_package.intern_symbol("float-32");
+		vm_ptr<Symbol> i32_name_symb = base_package.intern_symbol("int-32");
+		PrimitiveType ptype(f32_name_symb, "documentation", sizeof(float));
+		PrimitiveType p_i32(i32_name_symb, "documentation", sizeof(int));
+		auto f32_type = manager.allocate_obj<Type>(ptype);
+		auto i32_type = manager.allocate_obj<Type>(p_i32);
+		vm_ptr<Symbol> a_symb = base_package.intern_symbol("a");
+
+		GIVEN("The function type (fn [A float-32 A] (A))") {
+			SpecBuilder arg_builder;
+			arg_builder.add_parameter(a_symb);
+			arg_builder.add_type(f32_type);
+			arg_builder.add_parameter(a_symb);
+			SpecBuilder ret_builder;
+			ret_builder.add_parameter(a_symb);
+			FunctionType fn_type(ret_builder.build(), arg_builder.build());
+
+			THEN("The return type is bound by the arguments") {
+				std::vector<vm_ptr<Type>> lst = { i32_type, i32_type, f32_type, i32_type };
+				REQUIRE(fn_type.match(lst));
+			}
+			THEN("A return type that disagrees with the arguments doesn't match") {
+				std::vector<vm_ptr<Type>> lst = { f32_type, i32_type, f32_type, i32_type };
+				REQUIRE(!fn_type.match(lst));
+			}
+			THEN("A list of the wrong length doesn't match") {
+				std::vector<vm_ptr<Type>> lst = { i32_type, f32_type, i32_type };
+				REQUIRE(!fn_type.match(lst));
+			}
+		}
+	}
 }